@@ -80,3 +80,8 @@ void BuiltinFuncArg::PrintBroValConstructor(FILE* fp)
 	{
 	fprintf(fp, builtin_func_arg_type[type].constructor, name);
 	}
+
+bool BuiltinFuncArg::IsBroVal() const
+	{
+	return strcmp(builtin_func_arg_type[type].constructor, "%s") == 0;
+	}
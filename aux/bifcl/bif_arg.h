@@ -41,6 +41,10 @@ public:
 	void PrintCArg(FILE* fp, int n);
 	void PrintBroValConstructor(FILE* fp);
 
+	// Returns true if the argument's C type is a Val that the caller
+	// passes in, rather than a value that gets converted into one.
+	bool IsBroVal() const;
+
 protected:
 	const char* name;
 	int type;
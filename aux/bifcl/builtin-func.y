@@ -222,12 +222,21 @@ void print_event_c_prototype(FILE *fp, bool is_header)
 void print_event_c_body(FILE *fp)
 	{
 	fprintf(fp, "\t{\n");
-	fprintf(fp, "\t// Note that it is intentional that here we do not\n");
-	fprintf(fp, "\t// check if %s is NULL, which should happen *before*\n",
+	fprintf(fp, "\t// Callers should still check %s before\n",
 		decl.c_fullname.c_str());
-	fprintf(fp, "\t// %s is called to avoid unnecessary Val\n",
-		decl.generate_c_fullname.c_str());
-	fprintf(fp, "\t// allocation.\n");
+	fprintf(fp, "\t// building any Val arguments, but the other arguments\n");
+	fprintf(fp, "\t// are only converted if there's a handler.\n");
+	fprintf(fp, "\tif ( ! %s )\n", decl.c_fullname.c_str());
+	fprintf(fp, "\t\t{\n");
+
+	for ( int i = 0; i < (int) args.size(); ++i )
+		{
+		if ( args[i]->IsBroVal() )
+			fprintf(fp, "\t\tUnref(%s);\n", args[i]->Name());
+		}
+
+	fprintf(fp, "\t\treturn;\n");
+	fprintf(fp, "\t\t}\n");
 	fprintf(fp, "\n");
 
 	BuiltinFuncArg* connection_arg = 0;
@@ -14,6 +14,12 @@ typedef PList<ID> id_list;
 class Val;
 typedef PList<Val> val_list;
 
+// Small val_lists, mostly the arguments of events and function calls,
+// come and go all the time, so they recycle their arrays (see Val.cc).
+template<> Val** List<Val*>::AllocEntries(int n);
+template<> Val** List<Val*>::ReallocEntries(Val** e, int old_n, int new_n);
+template<> void List<Val*>::FreeEntries(Val** e, int n);
+
 class Stmt;
 typedef PList<Stmt> stmt_list;
 
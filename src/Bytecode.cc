@@ -0,0 +1,1214 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek-config.h"
+
+#include "Bytecode.h"
+#include "Attr.h"
+#include "Expr.h"
+#include "Stmt.h"
+#include "Frame.h"
+#include "Reporter.h"
+
+// Instructions refer to two register files: "v" registers hold (a
+// reference to) a Val, "n" registers hold unboxed numbers.  The suffixes
+// _I, _U and _D denote operations on bro_int_t, bro_uint_t and double,
+// respectively; booleans are ints.
+enum BytecodeOp {
+	// Control flow.
+	BC_ACCESS,		// x.s->RegisterAccess()
+	BC_JMP,			// goto a
+	BC_JMP_IF_FALSE,	// if ( ! n[a].i ) goto b
+	BC_JMP_IF_TRUE,		// if ( n[a].i ) goto b
+	BC_EXEC,		// x.s->Exec(); "break" goes to a, "next" to b
+	BC_FLOW,		// leave the body with flow x.flow
+	BC_RETURN,		// return v[a]
+
+	// Boxed values.  c is the target to go to if a value turns out
+	// to be missing, which ends the current statement.
+	BC_EVAL,		// v[a] = e->Eval()
+	BC_CONST,		// v[a] = x.v
+	BC_LOCAL,		// v[a] = frame[b]
+	BC_GLOBAL,		// v[a] = x.id
+	BC_STORE_LOCAL,		// frame[a] = v[b]
+	BC_STORE_GLOBAL,	// x.id = v[b]
+	BC_DISCARD,		// v[a] = 0
+	BC_FIELD,		// v[a] = v[b]$x.field
+	BC_HAS_FIELD,		// n[a] = v[b]?$x.field
+	BC_ADD_STR,		// v[a] = v[b] + v[c]
+	BC_CMP_STR,		// n[a] = v[b] x.expr_tag v[c]
+	BC_CMP_ADDR,		// n[a] = v[b] x.expr_tag v[c]
+
+	// Moving between the register files.
+	BC_UNBOX_I, BC_UNBOX_U, BC_UNBOX_D,		// n[a] = v[b]
+	BC_BOX_INT, BC_BOX_COUNT, BC_BOX_BOOL,		// v[a] = n[b]
+	BC_BOX_DOUBLE,		// v[a] = n[b] as type x.tag
+	BC_BOX_INTERVAL,	// v[a] = n[b]
+
+	// Unboxed values.
+	BC_CONST_N,		// n[a] = x.n
+	BC_MOVE_N,		// n[a] = n[b]
+	BC_LOCAL_I, BC_LOCAL_U, BC_LOCAL_D,		// n[a] = frame[b]
+	BC_GLOBAL_I, BC_GLOBAL_U, BC_GLOBAL_D,		// n[a] = x.id
+
+	// Arithmetic, n[a] = n[b] op n[c].
+	BC_ADD_I, BC_ADD_U, BC_ADD_D,
+	BC_SUB_I, BC_SUB_U, BC_SUB_D,
+	BC_MUL_I, BC_MUL_U, BC_MUL_D,
+	BC_DIV_I, BC_DIV_U, BC_DIV_D,
+	BC_MOD_I, BC_MOD_U,
+	BC_AND_U, BC_OR_U, BC_XOR_U,
+	BC_LT_I, BC_LT_U, BC_LT_D,
+	BC_LE_I, BC_LE_U, BC_LE_D,
+	BC_EQ_I, BC_EQ_U, BC_EQ_D,
+	BC_NE_I, BC_NE_U, BC_NE_D,
+	BC_GE_I, BC_GE_U, BC_GE_D,
+	BC_GT_I, BC_GT_U, BC_GT_D,
+
+	// Unary operations and coercions, n[a] = op n[b].
+	BC_NEG_I, BC_NEG_D,
+	BC_NOT,
+	BC_I2U, BC_I2D, BC_U2I, BC_U2D, BC_D2I, BC_D2U,
+};
+
+// The values the arithmetic opcodes are based on; the _U and _D variants
+// follow the _I one.
+static int arith_op(BroExprTag tag)
+	{
+	switch ( tag ) {
+	case EXPR_ADD:		return BC_ADD_I;
+	case EXPR_SUB:		return BC_SUB_I;
+	case EXPR_TIMES:	return BC_MUL_I;
+	case EXPR_DIVIDE:	return BC_DIV_I;
+	case EXPR_MOD:		return BC_MOD_I;
+	case EXPR_LT:		return BC_LT_I;
+	case EXPR_LE:		return BC_LE_I;
+	case EXPR_EQ:		return BC_EQ_I;
+	case EXPR_NE:		return BC_NE_I;
+	case EXPR_GE:		return BC_GE_I;
+	case EXPR_GT:		return BC_GT_I;
+	default:		return -1;
+	}
+	}
+
+static int internal_offset(InternalTypeTag it)
+	{
+	return it == TYPE_INTERNAL_INT ? 0 :
+		(it == TYPE_INTERNAL_UNSIGNED ? 1 : 2);
+	}
+
+// Returns true if values of the given type are kept unboxed.
+static bool is_numeric(const BroType* t)
+	{
+	if ( ! t || t->Tag() == TYPE_VECTOR )
+		return false;
+
+	InternalTypeTag it = t->InternalType();
+	return it == TYPE_INTERNAL_INT || it == TYPE_INTERNAL_UNSIGNED ||
+		it == TYPE_INTERNAL_DOUBLE;
+	}
+
+static bool is_comparison(BroExprTag tag)
+	{
+	return tag == EXPR_LT || tag == EXPR_LE || tag == EXPR_EQ ||
+		tag == EXPR_NE || tag == EXPR_GE || tag == EXPR_GT;
+	}
+
+static bool is_scalar_of(const BroType* t, InternalTypeTag it)
+	{
+	return t->Tag() != TYPE_VECTOR && t->InternalType() == it;
+	}
+
+class BytecodeCompiler {
+public:
+	explicit BytecodeCompiler(BytecodeBody* arg_body)
+		{
+		body = arg_body;
+		vtop = ntop = 0;
+		num_native = 0;
+		failed = false;
+		}
+
+	void CompileStmt(const Stmt* s);
+	void Finish()	{ Emit(BC_FLOW)->x.flow = FLOW_NEXT; }
+
+	bool Failed() const	{ return failed; }
+	int NumNative() const	{ return num_native; }
+
+private:
+	// Returns the v register holding the value of e.
+	int CompileBoxed(const Expr* e);
+
+	// Returns the n register holding the value of e, which must be of
+	// a numeric type.
+	int CompileUnboxed(const Expr* e);
+
+	// True if CompileUnboxed() computes e itself rather than
+	// unboxing the value of a boxed expression.
+	bool IsNative(const Expr* e) const;
+
+	int CompileNative(const Expr* e);
+	int CompileComparison(const BinaryExpr* e);
+	int CompileEval(const Expr* e);
+	int BoxOp(const Expr* e) const;
+
+	// Returns false if the expression is merely evaluated by the AST.
+	bool CompileExprStmt(const Expr* e);
+	void CompileFallback(const Stmt* s);
+
+	BytecodeInstr* Emit(int op, int a = 0, int b = 0, int c = 0,
+				const Expr* e = 0);
+	int Here() const	{ return body->code.size(); }
+	void SetTarget(const std::vector<int>& instrs, int target);
+
+	int AllocV();
+	int AllocN();
+
+	// Notes an instruction that leaves the current statement if a
+	// value is missing.
+	void AddNullExit()	{ null_exits.push_back(Here() - 1); }
+
+	struct Loop {
+		int top;
+		std::vector<int> breaks;
+	};
+
+	BytecodeBody* body;
+	int vtop, ntop;
+	std::vector<int> null_exits;
+	std::vector<Loop> loops;
+	int num_native;
+	bool failed;
+};
+
+BytecodeInstr* BytecodeCompiler::Emit(int op, int a, int b, int c,
+					const Expr* e)
+	{
+	BytecodeInstr in;
+	in.op = op;
+	in.a = a;
+	in.b = b;
+	in.c = c;
+	in.x.n.u = 0;
+	in.e = e;
+
+	body->code.push_back(in);
+	return &body->code.back();
+	}
+
+void BytecodeCompiler::SetTarget(const std::vector<int>& instrs, int target)
+	{
+	for ( auto i : instrs )
+		{
+		BytecodeInstr& in = body->code[i];
+
+		switch ( in.op ) {
+		case BC_JMP:
+		case BC_EXEC:
+			in.a = target;
+			break;
+
+		default:
+			in.c = target;
+			break;
+		}
+		}
+	}
+
+int BytecodeCompiler::AllocV()
+	{
+	if ( vtop == BytecodeBody::MAX_REGS )
+		{
+		failed = true;
+		return 0;
+		}
+
+	if ( vtop == body->num_vregs )
+		++body->num_vregs;
+
+	return vtop++;
+	}
+
+int BytecodeCompiler::AllocN()
+	{
+	if ( ntop == BytecodeBody::MAX_REGS )
+		{
+		failed = true;
+		return 0;
+		}
+
+	return ntop++;
+	}
+
+void BytecodeCompiler::CompileStmt(const Stmt* s)
+	{
+	switch ( s->Tag() ) {
+	case STMT_LIST:
+		Emit(BC_ACCESS)->x.s = s;
+
+		for ( const auto& stmt : s->AsStmtList()->Stmts() )
+			CompileStmt(stmt);
+		break;
+
+	case STMT_NULL:
+		Emit(BC_ACCESS)->x.s = s;
+		break;
+
+	case STMT_EXPR:
+		{
+		Emit(BC_ACCESS)->x.s = s;
+		if ( CompileExprStmt(((const ExprStmt*) s)->StmtExpr()) )
+			++num_native;
+
+		SetTarget(null_exits, Here());
+		null_exits.clear();
+		}
+		break;
+
+	case STMT_IF:
+		{
+		const IfStmt* is = (const IfStmt*) s;
+
+		Emit(BC_ACCESS)->x.s = s;
+		int cond = CompileUnboxed(is->StmtExpr());
+		std::vector<int> cond_exits;
+		cond_exits.swap(null_exits);
+		vtop = ntop = 0;
+
+		Emit(BC_JMP_IF_FALSE, cond);
+		int jmp_else = Here() - 1;
+
+		CompileStmt(is->TrueBranch());
+		Emit(BC_JMP);
+		int jmp_end = Here() - 1;
+
+		body->code[jmp_else].b = Here();
+		CompileStmt(is->FalseBranch());
+
+		body->code[jmp_end].a = Here();
+		SetTarget(cond_exits, Here());
+		++num_native;
+		}
+		break;
+
+	case STMT_WHILE:
+		{
+		const WhileStmt* ws = (const WhileStmt*) s;
+
+		Emit(BC_ACCESS)->x.s = s;
+
+		Loop l;
+		l.top = Here();
+		int cond = CompileUnboxed(ws->Condition());
+		l.breaks.swap(null_exits);
+		vtop = ntop = 0;
+
+		Emit(BC_JMP_IF_FALSE, cond);
+		int jmp_exit = Here() - 1;
+
+		loops.push_back(l);
+		CompileStmt(ws->Body());
+		Emit(BC_JMP, loops.back().top);
+
+		body->code[jmp_exit].b = Here();
+		SetTarget(loops.back().breaks, Here());
+		loops.pop_back();
+		++num_native;
+		}
+		break;
+
+	case STMT_NEXT:
+		Emit(BC_ACCESS)->x.s = s;
+
+		if ( loops.empty() )
+			Emit(BC_FLOW)->x.flow = FLOW_LOOP;
+		else
+			Emit(BC_JMP, loops.back().top);
+		break;
+
+	case STMT_BREAK:
+		Emit(BC_ACCESS)->x.s = s;
+
+		if ( loops.empty() )
+			Emit(BC_FLOW)->x.flow = FLOW_BREAK;
+		else
+			{
+			Emit(BC_JMP);
+			loops.back().breaks.push_back(Here() - 1);
+			}
+		break;
+
+	case STMT_RETURN:
+		{
+		const Expr* e = ((const ExprStmt*) s)->StmtExpr();
+
+		Emit(BC_ACCESS)->x.s = s;
+
+		if ( e )
+			{
+			Emit(BC_RETURN, CompileBoxed(e));
+			vtop = ntop = 0;
+			++num_native;
+			}
+
+		// A missing value returns nothing.
+		SetTarget(null_exits, Here());
+		null_exits.clear();
+		Emit(BC_FLOW)->x.flow = FLOW_RETURN;
+		}
+		break;
+
+	default:
+		CompileFallback(s);
+		break;
+	}
+	}
+
+void BytecodeCompiler::CompileFallback(const Stmt* s)
+	{
+	BytecodeInstr* in = Emit(BC_EXEC, -1, -1);
+	in->x.s = s;
+
+	if ( ! loops.empty() )
+		{
+		in->b = loops.back().top;
+		loops.back().breaks.push_back(Here() - 1);
+		}
+	}
+
+bool BytecodeCompiler::CompileExprStmt(const Expr* e)
+	{
+	if ( e->Tag() == EXPR_ASSIGN )
+		{
+		const AssignExpr* ae = e->AsAssignExpr();
+		const Expr* lhs = ae->Op1();
+
+		if ( lhs->Tag() == EXPR_REF )
+			lhs = ((const RefExpr*) lhs)->Op();
+
+		ID* id = lhs->Tag() == EXPR_NAME ? lhs->AsNameExpr()->Id() : 0;
+
+		if ( id && ! id->AsType() && ! ae->IsInit() &&
+		     ! ae->ResultVal() && ! ae->IsError() )
+			{
+			int r = CompileBoxed(ae->Op2());
+
+			if ( id->IsGlobal() )
+				Emit(BC_STORE_GLOBAL, 0, r)->x.id = id;
+			else
+				Emit(BC_STORE_LOCAL, id->Offset(), r);
+
+			vtop = ntop = 0;
+			return true;
+			}
+		}
+
+	int start = Here();
+
+	if ( is_numeric(e->Type()) && IsNative(e) )
+		CompileUnboxed(e);
+	else
+		Emit(BC_DISCARD, CompileBoxed(e));
+
+	vtop = ntop = 0;
+	return ! (Here() - start == 2 && body->code[start].op == BC_EVAL);
+	}
+
+int BytecodeCompiler::CompileEval(const Expr* e)
+	{
+	int r = AllocV();
+	Emit(BC_EVAL, r, 0, 0, e);
+	AddNullExit();
+	return r;
+	}
+
+int BytecodeCompiler::CompileBoxed(const Expr* e)
+	{
+	if ( e->IsError() )
+		return CompileEval(e);
+
+	int v0 = vtop, n0 = ntop;
+
+	switch ( e->Tag() ) {
+	case EXPR_CONST:
+		{
+		Val* v = ((const ConstExpr*) e)->Value();
+		body->constants.push_back(v->Ref());
+		int r = AllocV();
+		Emit(BC_CONST, r)->x.v = v;
+		return r;
+		}
+
+	case EXPR_NAME:
+		{
+		ID* id = e->AsNameExpr()->Id();
+
+		if ( id->AsType() )
+			break;
+
+		int r = AllocV();
+
+		if ( id->IsGlobal() )
+			Emit(BC_GLOBAL, r, 0, 0, e)->x.id = id;
+		else
+			Emit(BC_LOCAL, r, id->Offset(), 0, e);
+
+		return r;
+		}
+
+	case EXPR_FIELD:
+		{
+		const FieldExpr* fe = (const FieldExpr*) e;
+
+		if ( fe->Field() < 0 || ! IsRecord(fe->Op()->Type()->Tag()) )
+			break;
+
+		int rec = CompileBoxed(fe->Op());
+		vtop = v0;
+		int r = AllocV();
+		Emit(BC_FIELD, r, rec, 0, e)->x.n.i = fe->Field();
+		AddNullExit();
+		return r;
+		}
+
+	case EXPR_ADD:
+		{
+		const BinaryExpr* be = (const BinaryExpr*) e;
+
+		if ( ! is_scalar_of(e->Type(), TYPE_INTERNAL_STRING) ||
+		     ! is_scalar_of(be->Op1()->Type(), TYPE_INTERNAL_STRING) ||
+		     ! is_scalar_of(be->Op2()->Type(), TYPE_INTERNAL_STRING) )
+			break;
+
+		int r1 = CompileBoxed(be->Op1());
+		int r2 = CompileBoxed(be->Op2());
+		vtop = v0;
+		int r = AllocV();
+		Emit(BC_ADD_STR, r, r1, r2);
+		return r;
+		}
+
+	default:
+		break;
+	}
+
+	if ( is_numeric(e->Type()) && IsNative(e) )
+		{
+		int n = CompileUnboxed(e);
+		ntop = n0;
+		int r = AllocV();
+		BytecodeInstr* in = Emit(BoxOp(e), r, n);
+
+		// Coercions to floating point always yield a double.
+		in->x.tag = e->Tag() == EXPR_ARITH_COERCE ?
+				TYPE_DOUBLE : e->Type()->Tag();
+		return r;
+		}
+
+	return CompileEval(e);
+	}
+
+int BytecodeCompiler::BoxOp(const Expr* e) const
+	{
+	const BroType* t = e->Type();
+	InternalTypeTag it = t->InternalType();
+
+	if ( e->Tag() == EXPR_ARITH_COERCE )
+		{
+		// Coercions always yield one of the basic types.
+		if ( it == TYPE_INTERNAL_DOUBLE )
+			return BC_BOX_DOUBLE;
+		else if ( it == TYPE_INTERNAL_UNSIGNED )
+			return BC_BOX_COUNT;
+		else
+			return BC_BOX_INT;
+		}
+
+	if ( t->Tag() == TYPE_INTERVAL )
+		return BC_BOX_INTERVAL;
+	else if ( it == TYPE_INTERNAL_DOUBLE )
+		return BC_BOX_DOUBLE;
+	else if ( it == TYPE_INTERNAL_UNSIGNED )
+		return BC_BOX_COUNT;
+	else if ( t->Tag() == TYPE_BOOL )
+		return BC_BOX_BOOL;
+	else
+		return BC_BOX_INT;
+	}
+
+bool BytecodeCompiler::IsNative(const Expr* e) const
+	{
+	if ( e->IsError() )
+		return false;
+
+	BroExprTag tag = e->Tag();
+
+	if ( tag == EXPR_NOT || tag == EXPR_NEGATE ||
+	     tag == EXPR_ARITH_COERCE || tag == EXPR_HAS_FIELD )
+		{
+		const BroType* t = ((const UnaryExpr*) e)->Op()->Type();
+
+		switch ( tag ) {
+		case EXPR_NOT:
+			return t->Tag() == TYPE_BOOL;
+
+		case EXPR_NEGATE:
+			return is_numeric(t);
+
+		case EXPR_ARITH_COERCE:
+			return is_numeric(t) && is_numeric(e->Type());
+
+		default:
+			return IsRecord(t->Tag()) &&
+				((const HasFieldExpr*) e)->Field() >= 0;
+		}
+		}
+
+	if ( tag == EXPR_AND_AND || tag == EXPR_OR_OR )
+		{
+		const BinaryExpr* be = (const BinaryExpr*) e;
+		return be->Op1()->Type()->Tag() == TYPE_BOOL &&
+			be->Op2()->Type()->Tag() == TYPE_BOOL;
+		}
+
+	if ( arith_op(tag) < 0 && tag != EXPR_AND &&
+	     tag != EXPR_OR && tag != EXPR_XOR )
+		return false;
+
+	const BinaryExpr* be = (const BinaryExpr*) e;
+	const BroType* t1 = be->Op1()->Type();
+	const BroType* t2 = be->Op2()->Type();
+
+	if ( t1->Tag() == TYPE_VECTOR || t2->Tag() == TYPE_VECTOR )
+		return false;
+
+	InternalTypeTag it = t1->InternalType();
+
+	if ( it != t2->InternalType() )
+		return false;
+
+	if ( is_comparison(tag) )
+		{
+		if ( it == TYPE_INTERNAL_STRING )
+			// Equality with patterns isn't a string comparison.
+			return t1->Tag() != TYPE_PATTERN &&
+				t2->Tag() != TYPE_PATTERN;
+
+		return is_numeric(t1) || it == TYPE_INTERNAL_ADDR;
+		}
+
+	if ( ! is_numeric(t1) || e->Type()->InternalType() != it )
+		return false;
+
+	if ( tag == EXPR_MOD )
+		return it != TYPE_INTERNAL_DOUBLE;
+
+	if ( tag == EXPR_AND || tag == EXPR_OR || tag == EXPR_XOR )
+		return it == TYPE_INTERNAL_UNSIGNED;
+
+	return true;
+	}
+
+int BytecodeCompiler::CompileUnboxed(const Expr* e)
+	{
+	int n0 = ntop;
+	InternalTypeTag it = e->Type()->InternalType();
+
+	if ( e->IsError() )
+		; // Evaluated below.
+
+	else if ( e->Tag() == EXPR_CONST )
+		{
+		Val* v = ((const ConstExpr*) e)->Value();
+		int r = AllocN();
+		BytecodeInstr* in = Emit(BC_CONST_N, r);
+
+		if ( it == TYPE_INTERNAL_INT )
+			in->x.n.i = v->ForceAsInt();
+		else if ( it == TYPE_INTERNAL_UNSIGNED )
+			in->x.n.u = v->ForceAsUInt();
+		else
+			in->x.n.d = v->InternalDouble();
+
+		return r;
+		}
+
+	else if ( e->Tag() == EXPR_NAME && ! e->AsNameExpr()->Id()->AsType() )
+		{
+		ID* id = e->AsNameExpr()->Id();
+		int r = AllocN();
+
+		if ( id->IsGlobal() )
+			Emit(BC_GLOBAL_I + internal_offset(it), r, 0, 0, e)->x.id = id;
+		else
+			Emit(BC_LOCAL_I + internal_offset(it), r, id->Offset(), 0, e);
+
+		return r;
+		}
+
+	if ( IsNative(e) )
+		return CompileNative(e);
+
+	int v0 = vtop;
+	int v = CompileBoxed(e);
+	vtop = v0;
+	ntop = n0;
+	int r = AllocN();
+	Emit(BC_UNBOX_I + internal_offset(it), r, v);
+	return r;
+	}
+
+int BytecodeCompiler::CompileNative(const Expr* e)
+	{
+	int v0 = vtop, n0 = ntop;
+	BroExprTag tag = e->Tag();
+
+	switch ( tag ) {
+	case EXPR_NOT:
+		{
+		int n = CompileUnboxed(((const UnaryExpr*) e)->Op());
+		ntop = n0;
+		int r = AllocN();
+		Emit(BC_NOT, r, n);
+		return r;
+		}
+
+	case EXPR_NEGATE:
+		{
+		const Expr* op = ((const UnaryExpr*) e)->Op();
+		InternalTypeTag it = op->Type()->InternalType();
+		int n = CompileUnboxed(op);
+		ntop = n0;
+		int r = AllocN();
+
+		if ( it == TYPE_INTERNAL_DOUBLE )
+			Emit(BC_NEG_D, r, n);
+		else
+			{
+			if ( it == TYPE_INTERNAL_UNSIGNED )
+				Emit(BC_U2I, n, n);
+
+			Emit(BC_NEG_I, r, n);
+			}
+
+		return r;
+		}
+
+	case EXPR_ARITH_COERCE:
+		{
+		const Expr* op = ((const UnaryExpr*) e)->Op();
+		InternalTypeTag from = op->Type()->InternalType();
+		InternalTypeTag to = e->Type()->InternalType();
+		int n = CompileUnboxed(op);
+
+		if ( from == to )
+			return n;
+
+		ntop = n0;
+		int r = AllocN();
+		int cop;
+
+		if ( from == TYPE_INTERNAL_INT )
+			cop = to == TYPE_INTERNAL_UNSIGNED ? BC_I2U : BC_I2D;
+		else if ( from == TYPE_INTERNAL_UNSIGNED )
+			cop = to == TYPE_INTERNAL_INT ? BC_U2I : BC_U2D;
+		else
+			cop = to == TYPE_INTERNAL_INT ? BC_D2I : BC_D2U;
+
+		Emit(cop, r, n);
+		return r;
+		}
+
+	case EXPR_HAS_FIELD:
+		{
+		const HasFieldExpr* he = (const HasFieldExpr*) e;
+		int rec = CompileBoxed(he->Op());
+		vtop = v0;
+		int r = AllocN();
+		Emit(BC_HAS_FIELD, r, rec)->x.n.i = he->Field();
+		return r;
+		}
+
+	case EXPR_AND_AND:
+	case EXPR_OR_OR:
+		{
+		// The second operand only gets evaluated if the first
+		// doesn't decide the result already, and then its value
+		// becomes the result.
+		const BinaryExpr* be = (const BinaryExpr*) e;
+		int r = CompileUnboxed(be->Op1());
+
+		Emit(tag == EXPR_AND_AND ? BC_JMP_IF_FALSE : BC_JMP_IF_TRUE, r);
+		int jmp = Here() - 1;
+
+		ntop = n0;
+		int r2 = CompileUnboxed(be->Op2());
+
+		if ( r2 != r )
+			Emit(BC_MOVE_N, r, r2);
+
+		ntop = r + 1;
+		body->code[jmp].b = Here();
+		return r;
+		}
+
+	default:
+		break;
+	}
+
+	const BinaryExpr* be = (const BinaryExpr*) e;
+
+	if ( is_comparison(tag) && ! is_numeric(be->Op1()->Type()) )
+		return CompileComparison(be);
+
+	InternalTypeTag it = be->Op1()->Type()->InternalType();
+	int n1 = CompileUnboxed(be->Op1());
+	int n2 = CompileUnboxed(be->Op2());
+	ntop = n0;
+	int r = AllocN();
+	int op;
+
+	if ( tag == EXPR_AND )
+		op = BC_AND_U;
+	else if ( tag == EXPR_OR )
+		op = BC_OR_U;
+	else if ( tag == EXPR_XOR )
+		op = BC_XOR_U;
+	else
+		op = arith_op(tag) + internal_offset(it);
+
+	Emit(op, r, n1, n2, e);
+	return r;
+	}
+
+int BytecodeCompiler::CompileComparison(const BinaryExpr* e)
+	{
+	int v0 = vtop;
+	bool is_addr = e->Op1()->Type()->InternalType() == TYPE_INTERNAL_ADDR;
+
+	int r1 = CompileBoxed(e->Op1());
+	int r2 = CompileBoxed(e->Op2());
+	vtop = v0;
+	int r = AllocN();
+
+	Emit(is_addr ? BC_CMP_ADDR : BC_CMP_STR, r, r1, r2)->x.expr_tag = e->Tag();
+	return r;
+	}
+
+BytecodeBody* BytecodeBody::Compile(const Stmt* body)
+	{
+	BytecodeBody* b = new BytecodeBody();
+	BytecodeCompiler c(b);
+
+	c.CompileStmt(body);
+	c.Finish();
+
+	if ( c.Failed() || c.NumNative() == 0 )
+		{
+		delete b;
+		return 0;
+		}
+
+	return b;
+	}
+
+BytecodeBody::~BytecodeBody()
+	{
+	for ( auto v : constants )
+		Unref(v);
+	}
+
+void BytecodeBody::ClearRegs(Val** vregs) const
+	{
+	for ( int i = 0; i < num_vregs; ++i )
+		{
+		Unref(vregs[i]);
+		vregs[i] = 0;
+		}
+	}
+
+static inline Val* checked(Val* v, const Expr* e)
+	{
+	if ( ! v )
+		reporter->ExprRuntimeError(e, "%s", "value used but not set");
+
+	return v;
+	}
+
+static inline void check_divisor(bool zero, const Expr* e, const char* msg)
+	{
+	if ( zero )
+		reporter->ExprRuntimeError(e, "%s", msg);
+	}
+
+static bool compare_strings(BroExprTag tag, const BroString* s1,
+				const BroString* s2)
+	{
+	int cmp = Bstr_cmp(s1, s2);
+
+	switch ( tag ) {
+	case EXPR_LT:	return cmp < 0;
+	case EXPR_LE:	return cmp <= 0;
+	case EXPR_EQ:	return cmp == 0;
+	case EXPR_NE:	return cmp != 0;
+	case EXPR_GE:	return cmp >= 0;
+	default:	return cmp > 0;
+	}
+	}
+
+static bool compare_addrs(BroExprTag tag, const IPAddr& a1, const IPAddr& a2)
+	{
+	// Same as BinaryExpr::AddrFold().
+	switch ( tag ) {
+	case EXPR_LT:	return a1 < a2;
+	case EXPR_LE:	return a1 < a2 || a1 == a2;
+	case EXPR_EQ:	return a1 == a2;
+	case EXPR_NE:	return a1 != a2;
+	case EXPR_GE:	return ! (a1 < a2);
+	default:	return ! (a1 < a2) && a1 != a2;
+	}
+	}
+
+Val* BytecodeBody::Exec(Frame* f, stmt_flow_type& flow) const
+	{
+	Val* v[MAX_REGS];
+	BytecodeReg n[MAX_REGS];
+
+	for ( int i = 0; i < num_vregs; ++i )
+		v[i] = 0;
+
+	const BytecodeInstr* start = &code[0];
+	const BytecodeInstr* pc = start;
+
+	try
+		{
+		for ( ; ; )
+			{
+			const BytecodeInstr& in = *pc++;
+
+			switch ( in.op ) {
+			case BC_ACCESS:
+				in.x.s->RegisterAccess();
+				break;
+
+			case BC_JMP:
+				pc = start + in.a;
+				break;
+
+			case BC_JMP_IF_FALSE:
+				if ( ! n[in.a].i )
+					pc = start + in.b;
+				break;
+
+			case BC_JMP_IF_TRUE:
+				if ( n[in.a].i )
+					pc = start + in.b;
+				break;
+
+			case BC_EXEC:
+				{
+				stmt_flow_type sflow;
+				Val* result = in.x.s->Exec(f, sflow);
+
+				if ( sflow == FLOW_NEXT && ! result )
+					break;
+
+				if ( sflow == FLOW_BREAK && in.a >= 0 )
+					{
+					Unref(result);
+					pc = start + in.a;
+					break;
+					}
+
+				if ( sflow == FLOW_LOOP && in.b >= 0 )
+					{
+					Unref(result);
+					pc = start + in.b;
+					break;
+					}
+
+				flow = sflow;
+				return result;
+				}
+
+			case BC_FLOW:
+				flow = in.x.flow;
+				return 0;
+
+			case BC_RETURN:
+				flow = FLOW_RETURN;
+				return v[in.a];
+
+			case BC_EVAL:
+				if ( ! (v[in.a] = in.e->Eval(f)) )
+					{
+					ClearRegs(v);
+					pc = start + in.c;
+					}
+				break;
+
+			case BC_CONST:
+				v[in.a] = in.x.v->Ref();
+				break;
+
+			case BC_LOCAL:
+				v[in.a] = checked(f->NthElement(in.b), in.e)->Ref();
+				break;
+
+			case BC_GLOBAL:
+				v[in.a] = checked(in.x.id->ID_Val(), in.e)->Ref();
+				break;
+
+			case BC_STORE_LOCAL:
+				f->SetElement(in.a, v[in.b]);
+				v[in.b] = 0;
+				break;
+
+			case BC_STORE_GLOBAL:
+				in.x.id->SetVal(v[in.b]);
+				v[in.b] = 0;
+				break;
+
+			case BC_DISCARD:
+				Unref(v[in.a]);
+				v[in.a] = 0;
+				break;
+
+			case BC_FIELD:
+				{
+				Val* rec = v[in.b];
+				Val* result = rec->AsRecordVal()->Lookup(in.x.n.i);
+
+				if ( result )
+					result->Ref();
+				else
+					{
+					// Same as FieldExpr::Fold().
+					const TypeDecl* td = ((const FieldExpr*) in.e)->FieldDecl();
+					const Attr* def_attr = td ? td->FindAttr(ATTR_DEFAULT) : 0;
+
+					if ( ! def_attr )
+						reporter->ExprRuntimeError(in.e, "%s", "field value missing");
+
+					result = def_attr->AttrExpr()->Eval(0);
+					}
+
+				Unref(rec);
+				v[in.b] = 0;
+
+				if ( ! (v[in.a] = result) )
+					{
+					ClearRegs(v);
+					pc = start + in.c;
+					}
+				}
+				break;
+
+			case BC_HAS_FIELD:
+				n[in.a].i = v[in.b]->AsRecordVal()->Lookup(in.x.n.i) != 0;
+				Unref(v[in.b]);
+				v[in.b] = 0;
+				break;
+
+			case BC_ADD_STR:
+				{
+				std::vector<const BroString*> strings;
+				strings.push_back(v[in.b]->AsString());
+				strings.push_back(v[in.c]->AsString());
+
+				Val* result = new StringVal(concatenate(strings));
+				Unref(v[in.b]);
+				Unref(v[in.c]);
+				v[in.b] = v[in.c] = 0;
+				v[in.a] = result;
+				}
+				break;
+
+			case BC_CMP_STR:
+				{
+				bool result = compare_strings(BroExprTag(in.x.expr_tag),
+					v[in.b]->AsString(), v[in.c]->AsString());
+				Unref(v[in.b]);
+				Unref(v[in.c]);
+				v[in.b] = v[in.c] = 0;
+				n[in.a].i = result;
+				}
+				break;
+
+			case BC_CMP_ADDR:
+				{
+				bool result = compare_addrs(BroExprTag(in.x.expr_tag),
+					v[in.b]->AsAddr(), v[in.c]->AsAddr());
+				Unref(v[in.b]);
+				Unref(v[in.c]);
+				v[in.b] = v[in.c] = 0;
+				n[in.a].i = result;
+				}
+				break;
+
+#define UNBOX(op, field, get) \
+			case op: \
+				{ \
+				Val* val = v[in.b]; \
+				n[in.a].field = val->get(); \
+				Unref(val); \
+				v[in.b] = 0; \
+				} \
+				break;
+
+			UNBOX(BC_UNBOX_I, i, ForceAsInt)
+			UNBOX(BC_UNBOX_U, u, ForceAsUInt)
+			UNBOX(BC_UNBOX_D, d, InternalDouble)
+
+			case BC_BOX_INT:
+				v[in.a] = val_mgr->GetInt(n[in.b].i);
+				break;
+
+			case BC_BOX_COUNT:
+				v[in.a] = val_mgr->GetCount(n[in.b].u);
+				break;
+
+			case BC_BOX_BOOL:
+				v[in.a] = val_mgr->GetBool(n[in.b].i);
+				break;
+
+			case BC_BOX_DOUBLE:
+				v[in.a] = new Val(n[in.b].d, in.x.tag);
+				break;
+
+			case BC_BOX_INTERVAL:
+				v[in.a] = new IntervalVal(n[in.b].d, 1.0);
+				break;
+
+			case BC_CONST_N:
+				n[in.a] = in.x.n;
+				break;
+
+			case BC_MOVE_N:
+				n[in.a] = n[in.b];
+				break;
+
+			case BC_LOCAL_I:
+				n[in.a].i = checked(f->NthElement(in.b), in.e)->ForceAsInt();
+				break;
+
+			case BC_LOCAL_U:
+				n[in.a].u = checked(f->NthElement(in.b), in.e)->ForceAsUInt();
+				break;
+
+			case BC_LOCAL_D:
+				n[in.a].d = checked(f->NthElement(in.b), in.e)->InternalDouble();
+				break;
+
+			case BC_GLOBAL_I:
+				n[in.a].i = checked(in.x.id->ID_Val(), in.e)->ForceAsInt();
+				break;
+
+			case BC_GLOBAL_U:
+				n[in.a].u = checked(in.x.id->ID_Val(), in.e)->ForceAsUInt();
+				break;
+
+			case BC_GLOBAL_D:
+				n[in.a].d = checked(in.x.id->ID_Val(), in.e)->InternalDouble();
+				break;
+
+#define BINARY(op, field, result, oper) \
+			case op: \
+				n[in.a].result = n[in.b].field oper n[in.c].field; \
+				break;
+
+#define ARITH(name, oper) \
+			BINARY(BC_ ## name ## _I, i, i, oper) \
+			BINARY(BC_ ## name ## _U, u, u, oper) \
+			BINARY(BC_ ## name ## _D, d, d, oper)
+
+#define COMPARE(name, oper) \
+			BINARY(BC_ ## name ## _I, i, i, oper) \
+			BINARY(BC_ ## name ## _U, u, i, oper) \
+			BINARY(BC_ ## name ## _D, d, i, oper)
+
+			ARITH(ADD, +)
+			ARITH(SUB, -)
+			ARITH(MUL, *)
+			BINARY(BC_AND_U, u, u, &)
+			BINARY(BC_OR_U, u, u, |)
+			BINARY(BC_XOR_U, u, u, ^)
+			COMPARE(LT, <)
+			COMPARE(LE, <=)
+			COMPARE(EQ, ==)
+			COMPARE(NE, !=)
+			COMPARE(GE, >=)
+			COMPARE(GT, >)
+
+			case BC_DIV_I:
+				check_divisor(n[in.c].i == 0, in.e, "division by zero");
+				n[in.a].i = n[in.b].i / n[in.c].i;
+				break;
+
+			case BC_DIV_U:
+				check_divisor(n[in.c].u == 0, in.e, "division by zero");
+				n[in.a].u = n[in.b].u / n[in.c].u;
+				break;
+
+			case BC_DIV_D:
+				check_divisor(n[in.c].d == 0, in.e, "division by zero");
+				n[in.a].d = n[in.b].d / n[in.c].d;
+				break;
+
+			case BC_MOD_I:
+				check_divisor(n[in.c].i == 0, in.e, "modulo by zero");
+				n[in.a].i = n[in.b].i % n[in.c].i;
+				break;
+
+			case BC_MOD_U:
+				check_divisor(n[in.c].u == 0, in.e, "modulo by zero");
+				n[in.a].u = n[in.b].u % n[in.c].u;
+				break;
+
+			case BC_NEG_I:
+				n[in.a].i = - n[in.b].i;
+				break;
+
+			case BC_NEG_D:
+				n[in.a].d = - n[in.b].d;
+				break;
+
+			case BC_NOT:
+				n[in.a].i = ! n[in.b].i;
+				break;
+
+			case BC_I2U:
+				n[in.a].u = static_cast<bro_uint_t>(n[in.b].i);
+				break;
+
+			case BC_I2D:
+				n[in.a].d = static_cast<double>(n[in.b].i);
+				break;
+
+			case BC_U2I:
+				n[in.a].i = static_cast<bro_int_t>(n[in.b].u);
+				break;
+
+			case BC_U2D:
+				n[in.a].d = static_cast<double>(n[in.b].u);
+				break;
+
+			case BC_D2I:
+				n[in.a].i = static_cast<bro_int_t>(n[in.b].d);
+				break;
+
+			case BC_D2U:
+				n[in.a].u = static_cast<bro_uint_t>(n[in.b].d);
+				break;
+
+			default:
+				reporter->InternalError("bad opcode %d in BytecodeBody::Exec", in.op);
+			}
+			}
+		}
+
+	catch ( InterpreterException& )
+		{
+		ClearRegs(v);
+		throw;
+		}
+	}
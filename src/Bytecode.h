@@ -0,0 +1,112 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#ifndef bytecode_h
+#define bytecode_h
+
+#include <vector>
+
+#include "util.h"
+#include "Type.h"
+#include "StmtEnums.h"
+
+class Val;
+class Expr;
+class Stmt;
+class ID;
+class Frame;
+
+/**
+ * A register of the bytecode interpreter. Expressions of the numeric
+ * internal types (int, count, double, and everything stored as one of
+ * these, like bool or time) are kept unboxed here. All other values live
+ * in registers holding a Val*.
+ */
+union BytecodeReg {
+	bro_int_t i;
+	bro_uint_t u;
+	double d;
+};
+
+/**
+ * One bytecode instruction. The meaning of the operands depends on the
+ * opcode; see Bytecode.cc.
+ */
+struct BytecodeInstr {
+	int op;
+	int a, b, c;	// Registers, frame slots, jump targets.
+
+	union {
+		BytecodeReg n;	// Numeric constant.
+		Val* v;
+		ID* id;
+		const Stmt* s;
+		TypeTag tag;
+		int expr_tag;	// A BroExprTag.
+		stmt_flow_type flow;
+	} x;
+
+	const Expr* e;	// Expression to evaluate or to report errors for.
+};
+
+/**
+ * A function body lowered from its AST into bytecode for a small
+ * register-based interpreter.
+ *
+ * Statements and expressions on numbers, booleans, strings, addresses and
+ * record fields are translated into instructions that work on unboxed
+ * values where possible, so that evaluating them doesn't need to allocate
+ * intermediate Vals or go through the virtual Eval()/Exec() methods. All
+ * other statements and expressions stay in the AST: the bytecode simply
+ * calls Exec() or Eval() on them. Local variables always live in the
+ * Frame, which keeps both forms of execution interchangeable.
+ *
+ * Executing the bytecode has the same effect as executing the AST,
+ * including the errors it reports and the statement access statistics.
+ * It doesn't support the script debugger, and it must not be used for
+ * frames that run in the context of a trigger or that capture a closure.
+ */
+class BytecodeBody {
+public:
+	/**
+	 * Compiles a function body.
+	 *
+	 * @param body the body's statements.
+	 *
+	 * @return the compiled body, or null if the body doesn't lend itself
+	 * to compilation (for example, because it would merely hand over
+	 * all of its statements to the AST anyway).
+	 */
+	static BytecodeBody* Compile(const Stmt* body);
+
+	~BytecodeBody();
+
+	/**
+	 * Executes the body. The semantics are those of Stmt::Exec().
+	 */
+	Val* Exec(Frame* f, stmt_flow_type& flow) const;
+
+	/**
+	 * @return the number of instructions of the compiled body.
+	 */
+	int NumInstructions() const	{ return code.size(); }
+
+	/**
+	 * The maximum number of registers of each kind that a body may use.
+	 * Deeper expressions aren't compiled.
+	 */
+	static const int MAX_REGS = 32;
+
+private:
+	friend class BytecodeCompiler;
+
+	BytecodeBody()	{ num_vregs = 0; }
+
+	// Releases the values left in boxed registers.
+	void ClearRegs(Val** vregs) const;
+
+	std::vector<BytecodeInstr> code;
+	std::vector<Val*> constants;	// Refs held by the code.
+	int num_vregs;	// Number of boxed registers.
+};
+
+#endif
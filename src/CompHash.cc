@@ -15,6 +15,7 @@ CompositeHash::CompositeHash(TypeList* composite_type)
 	type = composite_type;
 	Ref(type);
 	singleton_tag = TYPE_INTERNAL_ERROR;
+	flat_fixed_size = 0;
 
 	// If the only element is a record, don't treat it as a
 	// singleton, since it needs to be evaluated specially.
@@ -52,6 +53,49 @@ CompositeHash::CompositeHash(TypeList* composite_type)
 		{
 		size = ComputeKeySize(0, 1, true);
 
+		if ( ! is_complex_type )
+			{
+			for ( const auto& t : *type->Types() )
+				{
+				InternalTypeTag it = t->InternalType();
+				int sz;
+
+				switch ( it ) {
+				case TYPE_INTERNAL_INT:
+				case TYPE_INTERNAL_UNSIGNED:
+				case TYPE_INTERNAL_DOUBLE:
+					sz = 8;
+					break;
+
+				case TYPE_INTERNAL_ADDR:
+					sz = 4 * sizeof(uint32);
+					break;
+
+				case TYPE_INTERNAL_SUBNET:
+					sz = 5 * sizeof(uint32);
+					break;
+
+				case TYPE_INTERNAL_STRING:
+					sz = sizeof(int);
+					break;
+
+				default:
+					sz = 0;
+					break;
+				}
+
+				if ( ! sz )
+					{
+					flat_fields.clear();
+					break;
+					}
+
+				// Leave room for alignment padding.
+				flat_fixed_size += sz + 7;
+				flat_fields.push_back({it, t});
+				}
+			}
+
 		if ( size > 0 )
 			// Fixed size.  Make sure what we get is fully aligned.
 			key = reinterpret_cast<char*>
@@ -336,6 +380,9 @@ HashKey* CompositeHash::ComputeHash(const Val* v, int type_check) const
 		return hk;
 		}
 
+	if ( ! flat_fields.empty() )
+		return ComputeFlatHash(v, type_check);
+
 	char* k = key;
 
 	if ( ! k )
@@ -668,8 +715,216 @@ int CompositeHash::SizeAlign(int offset, unsigned int size) const
 	return offset;
 	}
 
+// Rounds the offset into a flat key up to the next multiple of size,
+// which must be a power of 2.
+static inline int align_flat_offset(int offset, int size)
+	{
+	return (offset + size - 1) & ~(size - 1);
+	}
+
+// Same, but zero-pads the skipped bytes.
+static inline int pad_flat_key(char* key, int offset, int size)
+	{
+	while ( offset & (size - 1) )
+		key[offset++] = '\0';
+
+	return offset;
+	}
+
+HashKey* CompositeHash::ComputeFlatHash(const Val* v, int type_check) const
+	{
+	if ( type_check && v->Type()->Tag() != TYPE_LIST )
+		return 0;
+
+	const val_list* vl = v->AsListVal()->Vals();
+	int n = flat_fields.size();
+
+	if ( type_check && vl->length() != n )
+		return 0;
+
+	int max_size = flat_fixed_size;
+
+	for ( int i = 0; i < n; ++i )
+		{
+		const Val* vi = (*vl)[i];
+
+		if ( type_check &&
+		     vi->Type()->InternalType() != flat_fields[i].itag )
+			return 0;
+
+		if ( flat_fields[i].itag == TYPE_INTERNAL_STRING )
+			max_size += vi->AsString()->Len();
+		}
+
+	// The key goes straight to the HashKey, which takes ownership.
+	char* k = new char[max_size];
+	int off = 0;
+
+	for ( int i = 0; i < n; ++i )
+		{
+		const Val* vi = (*vl)[i];
+
+		switch ( flat_fields[i].itag ) {
+		case TYPE_INTERNAL_INT:
+			off = pad_flat_key(k, off, sizeof(bro_int_t));
+			*reinterpret_cast<bro_int_t*>(k + off) = vi->ForceAsInt();
+			off += sizeof(bro_int_t);
+			break;
+
+		case TYPE_INTERNAL_UNSIGNED:
+			off = pad_flat_key(k, off, sizeof(bro_uint_t));
+			*reinterpret_cast<bro_uint_t*>(k + off) = vi->ForceAsUInt();
+			off += sizeof(bro_uint_t);
+			break;
+
+		case TYPE_INTERNAL_DOUBLE:
+			off = pad_flat_key(k, off, sizeof(double));
+			*reinterpret_cast<double*>(k + off) = vi->InternalDouble();
+			off += sizeof(double);
+			break;
+
+		case TYPE_INTERNAL_ADDR:
+			{
+			off = pad_flat_key(k, off, sizeof(uint32));
+			uint32* kp = reinterpret_cast<uint32*>(k + off);
+			vi->AsAddr().CopyIPv6(kp);
+			off += 4 * sizeof(uint32);
+			}
+			break;
+
+		case TYPE_INTERNAL_SUBNET:
+			{
+			off = pad_flat_key(k, off, sizeof(uint32));
+			uint32* kp = reinterpret_cast<uint32*>(k + off);
+			vi->AsSubNet().Prefix().CopyIPv6(kp);
+			kp[4] = vi->AsSubNet().Length();
+			off += 5 * sizeof(uint32);
+			}
+			break;
+
+		case TYPE_INTERNAL_STRING:
+			{
+			const BroString* sval = vi->AsString();
+			off = pad_flat_key(k, off, sizeof(int));
+			*reinterpret_cast<int*>(k + off) = sval->Len();
+			off += sizeof(int);
+			memcpy(k + off, sval->Bytes(), sval->Len());
+			off += sval->Len();
+			}
+			break;
+
+		default:
+			reporter->InternalError("bad internal type in CompositeHash::ComputeFlatHash");
+		}
+		}
+
+	return new HashKey(0, k, off);
+	}
+
+ListVal* CompositeHash::RecoverFlatVals(const HashKey* k) const
+	{
+	ListVal* l = new ListVal(TYPE_ANY);
+	const char* key = (const char*) k->Key();
+	int off = 0;
+
+	for ( const auto& f : flat_fields )
+		{
+		TypeTag tag = f.type->Tag();
+		Val* v = 0;
+
+		switch ( f.itag ) {
+		case TYPE_INTERNAL_INT:
+			{
+			off = align_flat_offset(off, sizeof(bro_int_t));
+			bro_int_t i = *reinterpret_cast<const bro_int_t*>(key + off);
+			off += sizeof(bro_int_t);
+
+			if ( tag == TYPE_ENUM )
+				v = f.type->AsEnumType()->GetVal(i);
+			else if ( tag == TYPE_BOOL )
+				v = val_mgr->GetBool(i);
+			else if ( tag == TYPE_INT )
+				v = val_mgr->GetInt(i);
+			}
+			break;
+
+		case TYPE_INTERNAL_UNSIGNED:
+			{
+			off = align_flat_offset(off, sizeof(bro_uint_t));
+			bro_uint_t u = *reinterpret_cast<const bro_uint_t*>(key + off);
+			off += sizeof(bro_uint_t);
+
+			if ( tag == TYPE_COUNT || tag == TYPE_COUNTER )
+				v = val_mgr->GetCount(u);
+			else if ( tag == TYPE_PORT )
+				v = val_mgr->GetPort(u);
+			}
+			break;
+
+		case TYPE_INTERNAL_DOUBLE:
+			{
+			off = align_flat_offset(off, sizeof(double));
+			double d = *reinterpret_cast<const double*>(key + off);
+			off += sizeof(double);
+
+			if ( tag == TYPE_INTERVAL )
+				v = new IntervalVal(d, 1.0);
+			else
+				v = new Val(d, tag);
+			}
+			break;
+
+		case TYPE_INTERNAL_ADDR:
+			{
+			off = align_flat_offset(off, sizeof(uint32));
+			const uint32* kp = reinterpret_cast<const uint32*>(key + off);
+			off += 4 * sizeof(uint32);
+
+			if ( tag == TYPE_ADDR )
+				v = new AddrVal(IPAddr(IPv6, kp, IPAddr::Network));
+			}
+			break;
+
+		case TYPE_INTERNAL_SUBNET:
+			{
+			off = align_flat_offset(off, sizeof(uint32));
+			const uint32* kp = reinterpret_cast<const uint32*>(key + off);
+			off += 5 * sizeof(uint32);
+			v = new SubNetVal(kp, kp[4]);
+			}
+			break;
+
+		case TYPE_INTERNAL_STRING:
+			{
+			off = align_flat_offset(off, sizeof(int));
+			int n = *reinterpret_cast<const int*>(key + off);
+			off += sizeof(int);
+			v = new StringVal(new BroString((const byte_vec) key + off, n, 1));
+			off += n;
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		if ( ! v )
+			reporter->InternalError("bad internal type in CompositeHash::RecoverFlatVals()");
+
+		l->Append(v);
+		}
+
+	if ( off != k->Size() )
+		reporter->InternalError("under-ran key in CompositeHash::RecoverFlatVals %d", k->Size() - off);
+
+	return l;
+	}
+
 ListVal* CompositeHash::RecoverVals(const HashKey* k) const
 	{
+	if ( ! flat_fields.empty() )
+		return RecoverFlatVals(k);
+
 	ListVal* l = new ListVal(TYPE_ANY);
 	const type_list* tl = type->Types();
 	const char* kp = (const char*) k->Key();
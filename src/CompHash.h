@@ -3,6 +3,8 @@
 #ifndef comphash_h
 #define comphash_h
 
+#include <vector>
+
 #include "Hash.h"
 #include "Type.h"
 
@@ -25,6 +27,12 @@ public:
 protected:
 	HashKey* ComputeSingletonHash(const Val* v, int type_check) const;
 
+	// Counterparts of ComputeHash() and RecoverVals() for flat index
+	// types, see flat_fields. They produce the same keys as the generic
+	// code, but in a single pass over the index.
+	HashKey* ComputeFlatHash(const Val* v, int type_check) const;
+	ListVal* RecoverFlatVals(const HashKey* k) const;
+
 	// Computes the piece of the hash for Val*, returning the new kp.
 	// Used as a helper for ComputeHash in the non-singleton case.
 	char* SingleValHash(int type_check, char* kp, BroType* bt, Val* v,
@@ -88,6 +96,21 @@ protected:
 	int is_complex_type;
 
 	InternalTypeTag singleton_tag;
+
+	// Index types made up of more than one number, address, subnet or
+	// string, like [addr, port] or [string, count], have keys of a flat
+	// layout. For those we resolve the internal types of the index once
+	// up front. Empty for all other index types.
+	struct FlatField {
+		InternalTypeTag itag;
+		BroType* type;	// Not Ref'd, belongs to the TypeList.
+	};
+
+	std::vector<FlatField> flat_fields;
+
+	// Upper bound on the size of a flat key, not counting the bytes
+	// of strings.
+	int flat_fixed_size;
 };
 
 #endif
@@ -54,12 +54,13 @@ uint64 Connection::total_connections = 0;
 uint64 Connection::current_connections = 0;
 uint64 Connection::external_connections = 0;
 
-Connection::Connection(NetSessions* s, HashKey* k, double t, const ConnID* id,
+Connection::Connection(NetSessions* s, const ConnIDKey& k, double t, const ConnID* id,
                        uint32 flow, const Packet* pkt,
 		       const EncapsulationStack* arg_encap)
 	{
 	sessions = s;
 	key = k;
+	key_valid = true;
 	start_time = last_time = t;
 
 	orig_addr = id->src_addr;
@@ -144,7 +145,6 @@ Connection::~Connection()
 		Unref(conn_val);
 		}
 
-	delete key;
 	delete root_analyzer;
 	delete conn_timer_mgr;
 	delete encapsulation;
@@ -328,7 +328,10 @@ void Connection::EnableStatusUpdateTimer()
 
 void Connection::StatusUpdateTimer(double t)
 	{
-	ConnectionEventFast(connection_status_update, 0, { BuildConnVal() });
+	// The handler may have gone away since the timer was installed if
+	// it was only a remote one.
+	ConnectionEventLazy(connection_status_update, 0, [this]() -> val_list
+		{ return { BuildConnVal() }; });
 	ADD_TIMER(&Connection::StatusUpdateTimer,
 			network_time + connection_status_update_interval, 0,
 			TIMER_CONN_STATUS_UPDATE);
@@ -520,7 +523,7 @@ void Connection::AddTimer(timer_func timer, double t, int do_expire,
 	// If the key is cleared, the connection isn't stored in the connection
 	// table anymore and will soon be deleted. We're not installing new
 	// timers anymore then.
-	if ( ! key )
+	if ( ! key_valid )
 		return;
 
 	Timer* conn_timer = new ConnectionTimer(this, timer, t, do_expire, type);
@@ -600,7 +603,6 @@ void Connection::FlipRoles()
 unsigned int Connection::MemoryAllocation() const
 	{
 	return padded_sizeof(*this)
-		+ (key ? key->MemoryAllocation() : 0)
 		+ (timers.MemoryAllocation() - padded_sizeof(timers))
 		+ (conn_val ? conn_val->MemoryAllocation() : 0)
 		+ (root_analyzer ? root_analyzer->MemoryAllocation(): 0)
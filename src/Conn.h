@@ -57,7 +57,7 @@ namespace analyzer { class Analyzer; }
 
 class Connection : public BroObj {
 public:
-	Connection(NetSessions* s, HashKey* k, double t, const ConnID* id,
+	Connection(NetSessions* s, const ConnIDKey& k, double t, const ConnID* id,
 	           uint32 flow, const Packet* pkt, const EncapsulationStack* arg_encap);
 	~Connection() override;
 
@@ -90,8 +90,9 @@ public:
 			// arguments for reproducing packets
 			const Packet *pkt);
 
-	HashKey* Key() const			{ return key; }
-	void ClearKey()				{ key = 0; }
+	const ConnIDKey& Key() const		{ return key; }
+	void ClearKey()				{ key_valid = false; }
+	bool IsKeyValid() const			{ return key_valid; }
 
 	double StartTime() const		{ return start_time; }
 	void  SetStartTime(double t)		{ start_time = t; }
@@ -196,6 +197,19 @@ public:
 	void ConnectionEventFast(EventHandlerPtr f, analyzer::Analyzer* analyzer,
 				val_list vl);
 
+	// Queues an event whose arguments are built by calling 'build', which
+	// returns the event's val_list.  'build' only gets called if there's
+	// a handler (or remote consumer) for 'f', so this is the way to raise
+	// events whose arguments are expensive to construct without guarding
+	// against missing handlers separately.
+	template <typename ArgBuilder>
+	void ConnectionEventLazy(EventHandlerPtr f, analyzer::Analyzer* analyzer,
+				const ArgBuilder& build)
+		{
+		if ( f )
+			ConnectionEventFast(f, analyzer, build());
+		}
+
 	void Weird(const char* name, const char* addl = "");
 	bool DidWeird() const	{ return weird != 0; }
 
@@ -306,7 +320,8 @@ protected:
 	void RemoveConnectionTimer(double t);
 
 	NetSessions* sessions;
-	HashKey* key;
+	ConnIDKey key;
+	bool key_valid;
 
 	// Timer manager to use for this conn (or nil).
 	TimerMgr::Tag* conn_timer_mgr;
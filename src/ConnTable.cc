@@ -0,0 +1,192 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek-config.h"
+
+#include "ConnTable.h"
+#include "Conn.h"
+#include "siphash24.h"
+
+// Grow once the table is filled beyond this fraction.
+#define MAX_LOAD_NUMERATOR 7
+#define MAX_LOAD_DENOMINATOR 8
+
+#define MIN_LOG2_BUCKETS 6
+#define OVERFLOW_SLOTS 8
+
+ConnTable::ConnTable()
+	{
+	slots = 0;
+	log2_buckets = capacity = thresh_entries = 0;
+	num_entries = max_num_entries = 0;
+	cumulative_entries = 0;
+	}
+
+ConnTable::~ConnTable()
+	{
+	for ( int i = 0; i < capacity; ++i )
+		Unref(slots[i].conn);
+
+	delete [] slots;
+	}
+
+hash_t ConnTable::Hash(const ConnIDKey& key)
+	{
+	// We hash with the same keyed function that HashKey uses for short
+	// keys, so that remote parties can't steer connections into
+	// colliding slots.
+	hash_t h;
+	siphash(&h, (const uint8_t*) &key, ConnIDKey::DATA_SIZE,
+		shared_siphash_key);
+	return h;
+	}
+
+void ConnTable::Init(int arg_log2_buckets)
+	{
+	log2_buckets = arg_log2_buckets;
+
+	int num_buckets = 1 << log2_buckets;
+	capacity = num_buckets + log2_buckets + OVERFLOW_SLOTS;
+	thresh_entries = num_buckets / MAX_LOAD_DENOMINATOR * MAX_LOAD_NUMERATOR;
+
+	slots = new Slot[capacity];
+
+	for ( int i = 0; i < capacity; ++i )
+		slots[i].conn = 0;
+	}
+
+int ConnTable::Find(const ConnIDKey& key, hash_t hash) const
+	{
+	if ( ! slots )
+		return -1;
+
+	int home = Bucket(hash);
+
+	for ( int i = home; i < capacity; ++i )
+		{
+		const Slot& s = slots[i];
+
+		// An entry that's closer to its home than we'd be means
+		// we're past where the key could be.
+		if ( ! s.conn || Bucket(s.hash) > home )
+			return -1;
+
+		if ( s.hash == hash && s.conn->Key() == key )
+			return i;
+		}
+
+	return -1;
+	}
+
+Connection* ConnTable::Lookup(const ConnIDKey& key) const
+	{
+	int idx = Find(key, Hash(key));
+	return idx >= 0 ? slots[idx].conn : 0;
+	}
+
+bool ConnTable::Place(const Slot& slot)
+	{
+	int home = Bucket(slot.hash);
+	int i = home;
+
+	for ( ; i < capacity; ++i )
+		if ( ! slots[i].conn || Bucket(slots[i].hash) > home )
+			break;
+
+	int end = i;
+	while ( end < capacity && slots[end].conn )
+		++end;
+
+	if ( end >= capacity )
+		return false;
+
+	if ( end > i )
+		memmove(&slots[i + 1], &slots[i], (end - i) * sizeof(Slot));
+
+	slots[i] = slot;
+	return true;
+	}
+
+Connection* ConnTable::Insert(Connection* c)
+	{
+	if ( ! slots )
+		Init(MIN_LOG2_BUCKETS);
+
+	Slot slot;
+	slot.hash = Hash(c->Key());
+	slot.conn = c;
+
+	int idx = Find(c->Key(), slot.hash);
+
+	if ( idx >= 0 )
+		{
+		Connection* old = slots[idx].conn;
+		slots[idx].conn = c;
+		return old;
+		}
+
+	if ( num_entries >= thresh_entries )
+		SizeUp();
+
+	while ( ! Place(slot) )
+		SizeUp();
+
+	++cumulative_entries;
+	if ( max_num_entries < ++num_entries )
+		max_num_entries = num_entries;
+
+	return 0;
+	}
+
+Connection* ConnTable::Remove(const ConnIDKey& key)
+	{
+	int idx = Find(key, Hash(key));
+
+	if ( idx < 0 )
+		return 0;
+
+	Connection* c = slots[idx].conn;
+
+	// Pull the rest of the cluster one slot closer to home.
+	int last = idx;
+	while ( last + 1 < capacity && slots[last + 1].conn &&
+		Bucket(slots[last + 1].hash) <= last )
+		++last;
+
+	if ( last > idx )
+		memmove(&slots[idx], &slots[idx + 1], (last - idx) * sizeof(Slot));
+
+	slots[last].conn = 0;
+	--num_entries;
+
+	return c;
+	}
+
+void ConnTable::SizeUp()
+	{
+	Slot* old_slots = slots;
+	int old_capacity = capacity;
+	int n = log2_buckets + 1;
+
+	while ( true )
+		{
+		Init(n);
+
+		int i;
+		for ( i = 0; i < old_capacity; ++i )
+			if ( old_slots[i].conn && ! Place(old_slots[i]) )
+				break;
+
+		if ( i == old_capacity )
+			break;
+
+		delete [] slots;
+		++n;
+		}
+
+	delete [] old_slots;
+	}
+
+unsigned int ConnTable::MemoryAllocation() const
+	{
+	return padded_sizeof(*this) + pad_size(capacity * sizeof(Slot));
+	}
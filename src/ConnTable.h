@@ -0,0 +1,134 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#ifndef conntable_h
+#define conntable_h
+
+#include "IPAddr.h"
+
+class Connection;
+
+/**
+ * The table of active connections for one transport protocol, keyed by
+ * their ConnIDKey.
+ *
+ * This is on the per-packet path, so unlike a general Dictionary it
+ * needs no HashKey: the key is hashed where it sits on the caller's
+ * stack, and the table itself is a flat array of (hash, Connection*)
+ * slots using Robin Hood linear probing.  Keys are compared against the
+ * ConnIDKey each Connection carries, which is only consulted once the
+ * full hash matches.
+ *
+ * The table holds a reference to each connection it stores.
+ */
+class ConnTable {
+public:
+	ConnTable();
+	~ConnTable();
+
+	/**
+	 * Returns the connection stored under the given key, or nil.
+	 */
+	Connection* Lookup(const ConnIDKey& key) const;
+
+	/**
+	 * Stores a connection under its own key, taking over the caller's
+	 * reference.  Returns the connection previously stored under that
+	 * key, or nil; the caller then owns the table's reference to it.
+	 */
+	Connection* Insert(Connection* c);
+
+	/**
+	 * Removes the connection stored under the given key and returns it
+	 * (or nil if there's none).  The caller then owns the table's
+	 * reference to it.
+	 */
+	Connection* Remove(const ConnIDKey& key);
+
+	/**
+	 * Number of entries.
+	 */
+	int Length() const		{ return num_entries; }
+
+	/**
+	 * Largest it's ever been.
+	 */
+	int MaxLength() const		{ return max_num_entries; }
+
+	/**
+	 * Total number of entries ever.
+	 */
+	uint64 NumCumulativeInserts() const	{ return cumulative_entries; }
+
+	unsigned int MemoryAllocation() const;
+
+	/**
+	 * Hashes a key the way the table does.
+	 */
+	static hash_t Hash(const ConnIDKey& key);
+
+	/**
+	 * Iterates over the stored connections.  The table must not be
+	 * modified while an iteration is in progress.
+	 */
+	class iterator {
+	public:
+		Connection* operator*() const	{ return t->slots[i].conn; }
+
+		iterator& operator++()
+			{
+			++i;
+			Skip();
+			return *this;
+			}
+
+		bool operator==(const iterator& other) const
+			{ return i == other.i; }
+		bool operator!=(const iterator& other) const
+			{ return i != other.i; }
+
+	private:
+		friend class ConnTable;
+
+		iterator(const ConnTable* arg_t, int arg_i) : t(arg_t), i(arg_i)
+			{ Skip(); }
+
+		void Skip()
+			{
+			while ( i < t->capacity && ! t->slots[i].conn )
+				++i;
+			}
+
+		const ConnTable* t;
+		int i;
+	};
+
+	iterator begin() const	{ return iterator(this, 0); }
+	iterator end() const	{ return iterator(this, capacity); }
+
+private:
+	struct Slot {
+		hash_t hash;
+		Connection* conn;	// nil if the slot is empty
+	};
+
+	int Bucket(hash_t hash) const
+		{ return int((hash * 0x9E3779B97F4A7C15ULL) >> (64 - log2_buckets)); }
+
+	int Find(const ConnIDKey& key, hash_t hash) const;
+	bool Place(const Slot& slot);
+	void Init(int arg_log2_buckets);
+	void SizeUp();
+
+	// As in Dictionary, probes don't wrap around but may spill into a
+	// few extra slots at the end.
+	Slot* slots;
+	int log2_buckets;
+	int capacity;
+	int thresh_entries;
+
+	int num_entries;
+	int max_num_entries;
+	uint64 cumulative_entries;
+};
+
+#endif
@@ -2,8 +2,18 @@
 
 #include "zeek-config.h"
 
+#include <string.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "EquivClass.h"
 #include "DFA.h"
+#include "NetVar.h"
 #include "digest.h"
 
 unsigned int DFA_State::transition_counter = 0;
@@ -18,6 +28,10 @@ DFA_State::DFA_State(int arg_state_num, const EquivClass* ec,
 	accept = arg_accept;
 	mark = 0;
 	centry = 0;
+	accel = 0;
+	accel_computed = false;
+	used = true;
+	evicting = false;
 
 	SymPartition(ec);
 
@@ -33,6 +47,7 @@ DFA_State::~DFA_State()
 	delete nfa_states;
 	delete accept;
 	delete meta_ec;
+	delete accel;
 	}
 
 void DFA_State::AddXtion(int sym, DFA_State* next_state)
@@ -103,9 +118,115 @@ DFA_State* DFA_State::ComputeXtion(int sym, DFA_Machine* machine)
 	if ( sym != equiv_sym )
 		AddXtion(sym, next_d);
 
+	DFA_State_Cache* cache = machine->Cache();
+
+	if ( cache->OverBudget() )
+		cache->Evict(this, next_d);
+
 	return xtions[sym];
 	}
 
+void DFA_State::ForgetEvictedXtions()
+	{
+	for ( int i = 0; i < num_sym; ++i )
+		{
+		DFA_State* s = xtions[i];
+
+		if ( s && s != DFA_UNCOMPUTED_STATE_PTR && s->evicting )
+			xtions[i] = DFA_UNCOMPUTED_STATE_PTR;
+		}
+	}
+
+void DFA_State::ComputeAccel(DFA_Machine* machine)
+	{
+	accel_computed = true;
+
+	if ( accept )
+		// We need to record a match for each byte.
+		return;
+
+	// There's no point in skipping ahead if most bytes stop us anyway.
+	const int max_stops = 128;
+
+	const int* ecs = machine->EC()->EquivClasses();
+	Accel* a = new Accel;
+	a->num_stops = 0;
+
+	for ( int c = 0; c < 256; ++c )
+		{
+		a->is_stop[c] = (Xtion(ecs[c], machine) != this);
+
+		if ( ! a->is_stop[c] )
+			continue;
+
+		if ( a->num_stops < 4 )
+			a->stops[a->num_stops] = c;
+
+		if ( ++a->num_stops > max_stops )
+			{
+			delete a;
+			return;
+			}
+		}
+
+	accel = a;
+	}
+
+const u_char* DFA_State::FindStop(const Accel* a,
+				const u_char* data, const u_char* end)
+	{
+	if ( a->num_stops == 0 )
+		return end;
+
+	if ( a->num_stops == 1 )
+		{
+		const void* p = memchr(data, a->stops[0], end - data);
+		return p ? (const u_char*) p : end;
+		}
+
+#if defined(__SSE2__)
+	if ( a->num_stops <= 4 )
+		{
+		// Unused slots repeat the first stop byte.
+		__m128i s[4];
+
+		for ( int i = 0; i < 4; ++i )
+			s[i] = _mm_set1_epi8(a->stops[i < a->num_stops ? i : 0]);
+
+		for ( ; end - data >= 16; data += 16 )
+			{
+			__m128i v = _mm_loadu_si128((const __m128i*) data);
+			__m128i m = _mm_or_si128(
+				_mm_or_si128(_mm_cmpeq_epi8(v, s[0]), _mm_cmpeq_epi8(v, s[1])),
+				_mm_or_si128(_mm_cmpeq_epi8(v, s[2]), _mm_cmpeq_epi8(v, s[3])));
+			int mask = _mm_movemask_epi8(m);
+
+			if ( mask )
+				return data + __builtin_ctz(mask);
+			}
+		}
+#endif
+
+	const bool* is_stop = a->is_stop;
+
+	for ( ; end - data >= 4; data += 4 )
+		{
+		if ( is_stop[data[0]] )
+			return data;
+		if ( is_stop[data[1]] )
+			return data + 1;
+		if ( is_stop[data[2]] )
+			return data + 2;
+		if ( is_stop[data[3]] )
+			return data + 3;
+		}
+
+	while ( data < end && ! is_stop[*data] )
+		++data;
+
+	return data;
+	}
+
 void DFA_State::AppendIfNew(int sym, int_list* sym_list)
 	{
 	for ( auto value : *sym_list )
@@ -286,12 +407,15 @@ unsigned int DFA_State::Size()
 		+ (accept ? pad_size(sizeof(int) * accept->size()) : 0)
 		+ (nfa_states ? pad_size(sizeof(NFA_State*) * nfa_states->length()) : 0)
 		+ (meta_ec ? meta_ec->Size() : 0)
-		+ (centry ? padded_sizeof(CacheEntry) : 0);
+		+ (centry ? padded_sizeof(CacheEntry) : 0)
+		+ (accel ? padded_sizeof(Accel) : 0);
 	}
 
 DFA_State_Cache::DFA_State_Cache()
 	{
-	hits = misses = 0;
+	hits = misses = evictions = 0;
+	hand = 0;
+	mem = 0;
 	}
 
 DFA_State_Cache::~DFA_State_Cache()
@@ -362,12 +486,96 @@ DFA_State* DFA_State_Cache::Insert(DFA_State* state, HashKey* hash)
 	e->state = state;
 	e->state->centry = e;
 	e->hash = hash;
+	e->size = pad_size(state->Size()) + padded_sizeof(*state);
 
 	states.Insert(hash, e);
+	entries.push_back(e);
+	mem += e->size;
 
 	return e->state;
 	}
 
+std::vector<DFA_State*> DFA_State_Cache::States() const
+	{
+	std::vector<DFA_State*> rval;
+	rval.reserve(entries.size());
+
+	for ( const auto& e : entries )
+		rval.push_back(e->state);
+
+	return rval;
+	}
+
+bool DFA_State_Cache::OverBudget() const
+	{
+	return max_dfa_state_mem && mem > max_dfa_state_mem;
+	}
+
+void DFA_State_Cache::Evict(DFA_State* keep1, DFA_State* keep2)
+	{
+	uint64 target = max_dfa_state_mem / 4 * 3;
+	int num_victims = 0;
+
+	// This is a CLOCK scheme: the hand gives states that have been
+	// used since it last came by another round.  Going around twice
+	// is enough to find all candidates.
+	for ( size_t n = 0; n < 2 * entries.size() && mem > target; ++n )
+		{
+		if ( hand >= entries.size() )
+			hand = 0;
+
+		CacheEntry* e = entries[hand++];
+		DFA_State* s = e->state;
+
+		if ( s->evicting || s == keep1 || s == keep2 ||
+		     s->RefCnt() > 1 )
+			continue;
+
+		if ( s->used )
+			{
+			s->used = false;
+			continue;
+			}
+
+		s->evicting = true;
+		mem -= e->size;
+		++num_victims;
+		}
+
+	if ( ! num_victims )
+		return;
+
+	for ( const auto& e : entries )
+		if ( ! e->state->evicting )
+			e->state->ForgetEvictedXtions();
+
+	size_t num_kept = 0;
+	size_t new_hand = 0;
+
+	for ( size_t i = 0; i < entries.size(); ++i )
+		{
+		CacheEntry* e = entries[i];
+
+		if ( ! e->state->evicting )
+			{
+			if ( i < hand )
+				++new_hand;
+
+			entries[num_kept++] = e;
+			continue;
+			}
+
+		states.RemoveEntry(e->hash);
+		delete e->hash;
+		Unref(e->state);
+		delete e;
+		}
+
+	entries.resize(num_kept);
+	hand = new_hand;
+	evictions += num_victims;
+	}
+
 void DFA_State_Cache::GetStats(Stats* s)
 	{
 	s->dfa_states = 0;
@@ -377,6 +585,7 @@ void DFA_State_Cache::GetStats(Stats* s)
 	s->mem = 0;
 	s->hits = hits;
 	s->misses = misses;
+	s->evictions = evictions;
 
 	CacheEntry* e;
 
@@ -408,6 +617,9 @@ DFA_Machine::DFA_Machine(NFA_Machine* n, EquivClass* arg_ec)
 		{
 		NFA_state_list* state_set = epsilon_closure(ns);
 		(void) StateSetToDFA_State(state_set, start_state, ec);
+
+		// Keep the start state from being evicted.
+		Ref(start_state);
 		}
 	else
 		{
@@ -418,6 +630,7 @@ DFA_Machine::DFA_Machine(NFA_Machine* n, EquivClass* arg_ec)
 
 DFA_Machine::~DFA_Machine()
 	{
+	Unref(start_state);
 	delete dfa_state_cache;
 	Unref(nfa);
 	}
@@ -445,6 +658,202 @@ unsigned int DFA_Machine::MemoryAllocation() const
 		+ nfa->MemoryAllocation();
 	}
 
+std::vector<NFA_State*> DFA_Machine::NFA_States() const
+	{
+	std::vector<NFA_State*> states;
+	std::unordered_map<NFA_State*, int> seen;
+
+	states.push_back(nfa->FirstState());
+	seen[nfa->FirstState()] = 0;
+
+	// Breadth-first, following the transitions in order.
+	for ( size_t i = 0; i < states.size(); ++i )
+		{
+		for ( const auto& n : *states[i]->Transitions() )
+			{
+			if ( seen.count(n) )
+				continue;
+
+			seen[n] = states.size();
+			states.push_back(n);
+			}
+		}
+
+	return states;
+	}
+
+// Save() writes a header to check the data against the machine it's
+// loaded into: the number of NFA states, the number of equivalence
+// classes, and the class of each symbol.  Then follows the number of
+// DFA states, and for each of them its NFA states (as indices into
+// NFA_States()) and its transitions (as indices of DFA states, -1 for
+// jam and -2 for not computed yet).  All values are 32-bit integers
+// in host byte order.
+
+static void append_int(std::string* buf, int32_t v)
+	{
+	buf->append((const char*) &v, sizeof(v));
+	}
+
+void DFA_Machine::Save(std::string* buf) const
+	{
+	std::vector<NFA_State*> nfa_states = NFA_States();
+	std::unordered_map<NFA_State*, int> nfa_index;
+
+	for ( size_t i = 0; i < nfa_states.size(); ++i )
+		nfa_index[nfa_states[i]] = i;
+
+	std::vector<DFA_State*> states = dfa_state_cache->States();
+	std::unordered_map<DFA_State*, int> index;
+
+	for ( size_t i = 0; i < states.size(); ++i )
+		index[states[i]] = i;
+
+	append_int(buf, nfa_states.size());
+	append_int(buf, ec->NumClasses());
+
+	for ( int i = 0; i < NUM_SYM; ++i )
+		append_int(buf, ec->SymEquivClass(i));
+
+	append_int(buf, states.size());
+
+	for ( const auto& d : states )
+		{
+		append_int(buf, d->nfa_states->length());
+
+		for ( const auto& n : *d->nfa_states )
+			append_int(buf, nfa_index[n]);
+
+		for ( int i = 0; i < d->num_sym; ++i )
+			{
+			DFA_State* x = d->xtions[i];
+
+			if ( x == DFA_UNCOMPUTED_STATE_PTR )
+				append_int(buf, DFA_UNCOMPUTED_STATE);
+			else if ( ! x )
+				append_int(buf, -1);
+			else
+				append_int(buf, index[x]);
+			}
+		}
+	}
+
+bool DFA_Machine::Load(const u_char* data, size_t len)
+	{
+	const u_char* end = data + len;
+
+	auto next_int = [&](int32_t* v) -> bool
+		{
+		if ( end - data < (ptrdiff_t) sizeof(*v) )
+			return false;
+
+		memcpy(v, data, sizeof(*v));
+		data += sizeof(*v);
+		return true;
+		};
+
+	std::vector<NFA_State*> nfa_states = NFA_States();
+	int num_ecs = ec->NumClasses();
+	int32_t v;
+
+	if ( ! next_int(&v) || v != (int32_t) nfa_states.size() )
+		return false;
+
+	if ( ! next_int(&v) || v != num_ecs )
+		return false;
+
+	for ( int i = 0; i < NUM_SYM; ++i )
+		if ( ! next_int(&v) || v != ec->SymEquivClass(i) )
+			return false;
+
+	int32_t num_states;
+
+	if ( ! next_int(&num_states) || num_states < 0 )
+		return false;
+
+	// Each state needs at least its set size, one member and its
+	// transitions, so a count the remaining data can't hold is bogus;
+	// reject it before sizing anything by it.
+	if ( (size_t) num_states >
+	     (size_t) (end - data) / (sizeof(int32_t) * (2 + num_ecs)) )
+		return false;
+
+	// First create the states, then link them up.  States beyond
+	// the cache's budget are left out.
+	std::vector<DFA_State*> states(num_states);
+	std::vector<const u_char*> xtion_data(num_states);
+
+	for ( int i = 0; i < num_states; ++i )
+		{
+		int32_t n;
+
+		if ( ! next_int(&n) || n <= 0 || n > (int32_t) nfa_states.size() )
+			return false;
+
+		NFA_state_list* state_set = new NFA_state_list;
+
+		for ( int j = 0; j < n; ++j )
+			{
+			if ( ! next_int(&v) || v < 0 ||
+			     v >= (int32_t) nfa_states.size() )
+				{
+				delete state_set;
+				return false;
+				}
+
+			state_set->push_back(nfa_states[v]);
+			}
+
+		// Lookups rely on the same order as epsilon_closure()
+		// produces.
+		std::sort(state_set->begin(), state_set->end(),
+		          NFA_state_cmp_neg);
+
+		if ( dfa_state_cache->OverBudget() )
+			{
+			delete state_set;
+			states[i] = 0;
+			}
+
+		else if ( ! StateSetToDFA_State(state_set, states[i], ec) )
+			delete state_set;
+
+		xtion_data[i] = data;
+
+		if ( (size_t) (end - data) < num_ecs * sizeof(v) )
+			return false;
+
+		data += num_ecs * sizeof(v);
+		}
+
+	for ( int i = 0; i < num_states; ++i )
+		{
+		DFA_State* d = states[i];
+
+		if ( ! d )
+			continue;
+
+		data = xtion_data[i];
+
+		for ( int sym = 0; sym < num_ecs; ++sym )
+			{
+			next_int(&v);
+
+			if ( d->xtions[sym] != DFA_UNCOMPUTED_STATE_PTR ||
+			     v < -1 || v >= num_states )
+				continue;
+
+			if ( v == -1 )
+				d->AddXtion(sym, 0);
+
+			else if ( states[v] )
+				d->AddXtion(sym, states[v]);
+			}
+		}
+
+	return true;
+	}
+
 int DFA_Machine::StateSetToDFA_State(NFA_state_list* state_set,
 				DFA_State*& d, const EquivClass* ec)
 	{
@@ -6,6 +6,9 @@
 
 #include <assert.h>
 
+#include <string>
+#include <vector>
+
 class DFA_State;
 
 // Transitions to the uncomputed state indicate that we haven't yet
@@ -34,6 +37,21 @@ public:
 	const AcceptingSet* Accept() const	{ return accept; }
 	void SymPartition(const EquivClass* ec);
 
+	// Returns the number of bytes at the start of [data, end) on
+	// which the state transitions back to itself, if it has been
+	// set up for skipping over them (see ComputeAccel()), and 0
+	// otherwise.
+	inline int LoopingBytes(const u_char* data, const u_char* end) const;
+
+	// Returns true if ComputeAccel() has already been called.
+	bool AccelComputed() const	{ return accel_computed; }
+
+	// Computes all of the state's transitions to find the bytes
+	// that lead out of it.  If it's not an accepting state and
+	// there aren't too many of them, sets up LoopingBytes() to skip
+	// to the next one.
+	void ComputeAccel(DFA_Machine* machine);
+
 	// ec_sym is an equivalence class, not a character.
 	NFA_state_list* SymFollowSet(int ec_sym, const EquivClass* ec);
 
@@ -51,10 +69,15 @@ public:
 
 protected:
 	friend class DFA_State_Cache;
+	friend class DFA_Machine;	// for Save() and Load()
 
 	DFA_State* ComputeXtion(int sym, DFA_Machine* machine);
 	void AppendIfNew(int sym, int_list* sym_list);
 
+	// Resets transitions into states the cache is evicting, so that
+	// they get computed again.
+	void ForgetEvictedXtions();
+
 	int state_num;
 	int num_sym;
 
@@ -66,12 +89,31 @@ protected:
 	DFA_State* mark;
 	CacheEntry* centry;
 
+	// The bytes leading out of the state, for states set up by
+	// ComputeAccel().
+	struct Accel {
+		int num_stops;
+		u_char stops[4];	// if num_stops <= 4
+		bool is_stop[256];
+	};
+
+	static const u_char* FindStop(const Accel* a,
+				const u_char* data, const u_char* end);
+
+	Accel* accel;
+	bool accel_computed;
+
+	// For the cache's eviction.
+	bool used;	// since the eviction hand last passed
+	bool evicting;
+
 	static unsigned int transition_counter;	// see Xtion()
 };
 
 struct CacheEntry {
 	DFA_State* state;
 	HashKey* hash;
+	unsigned int size;	// memory accounted for the state
 };
 
 class DFA_State_Cache {
@@ -88,6 +130,19 @@ public:
 
 	int NumEntries() const	{ return states.Length(); }
 
+	// Returns all states in the cache.
+	std::vector<DFA_State*> States() const;
+
+	// Returns true if the states use more memory than
+	// max_dfa_state_mem allows.
+	bool OverBudget() const;
+
+	// Evicts states that haven't been used recently until memory
+	// use is down to three quarters of the budget.  States that
+	// are referenced from elsewhere (like a matcher's current state)
+	// aren't evicted, nor are the two given ones.
+	void Evict(DFA_State* keep1, DFA_State* keep2);
+
 	struct Stats {
 		// Sum of all NFA states
 		unsigned int nfa_states;
@@ -97,6 +152,7 @@ public:
 		unsigned int mem;
 		unsigned int hits;
 		unsigned int misses;
+		unsigned int evictions;
 	};
 
 	void GetStats(Stats* s);
@@ -104,9 +160,16 @@ public:
 private:
 	int hits;	// Statistics
 	int misses;
+	int evictions;
 
 	// Hash indexed by NFA states (MD5s of them, actually).
 	PDict<CacheEntry> states;
+
+	// The same entries, in the order the eviction hand visits them.
+	std::vector<CacheEntry*> entries;
+	size_t hand;
+
+	uint64 mem;	// sum of the entries' sizes
 };
 
 class DFA_Machine : public BroObj {
@@ -127,6 +190,15 @@ public:
 
 	unsigned int MemoryAllocation() const;
 
+	// Appends the states computed so far, along with their
+	// transitions, to buf.  Load() restores them into a machine built
+	// from the same patterns, e.g. in a later run.
+	void Save(std::string* buf) const;
+
+	// Restores states written by Save(), as far as the cache's budget
+	// allows.  Returns false if the data doesn't fit this machine.
+	bool Load(const u_char* data, size_t len);
+
 protected:
 	friend class DFA_State;	// for DFA_State::ComputeXtion
 	friend class DFA_State_Cache;
@@ -138,6 +210,10 @@ protected:
 				const EquivClass* ec);
 	const EquivClass* EC() const	{ return ec; }
 
+	// Returns the NFA's states in a fixed order, which is the same
+	// for NFAs built from the same patterns.
+	std::vector<NFA_State*> NFA_States() const;
+
 	EquivClass* ec;	// equivalence classes corresponding to NFAs
 	DFA_State* start_state;
 	DFA_State_Cache* dfa_state_cache;
@@ -145,8 +221,18 @@ protected:
 	NFA_Machine* nfa;
 };
 
+inline int DFA_State::LoopingBytes(const u_char* data, const u_char* end) const
+	{
+	if ( ! accel || data == end || accel->is_stop[*data] )
+		return 0;
+
+	return FindStop(accel, data, end) - data;
+	}
+
 inline DFA_State* DFA_State::Xtion(int sym, DFA_Machine* machine)
 	{
+	used = true;
+
 	if ( xtions[sym] == DFA_UNCOMPUTED_STATE_PTR )
 		return ComputeXtion(sym, machine);
 	else
@@ -7,72 +7,74 @@
 #endif
 
 #include "Dict.h"
-#include "Reporter.h"
 
-// If the mean bucket length exceeds the following then Insert() will
-// increase the size of the hash table.
-#define DEFAULT_DENSITY_THRESH 3.0
-
-// Threshold above which we do not try to ensure that the hash size
-// is prime.
-#define PRIME_THRESH 1000
+// The table is grown once it's filled beyond this fraction.  Robin Hood
+// probing keeps lookups short up to fairly high loads, but misses get
+// expensive beyond this.
+#define MAX_LOAD_NUMERATOR 3
+#define MAX_LOAD_DENOMINATOR 4
 
 // Default number of hash buckets in dictionary.  The dictionary will
 // increase the size of the hash table as needed.
-#define DEFAULT_DICT_SIZE 16
+#define DEFAULT_DICT_SIZE 8
+
+// The smallest table we'll create, as a power of two.
+#define MIN_LOG2_BUCKETS 3
+
+// Probe sequences don't wrap around; instead, each table has this many
+// slots beyond the last bucket (plus one per bit of buckets) into which
+// the final clusters can spill.
+#define OVERFLOW_SLOTS 4
 
+// A table slot.  Entries are stored by value so that a probe walks
+// through contiguous memory; the key itself is kept out of line, but
+// we only touch it once the full hash matches.
 class DictEntry {
 public:
-	DictEntry(void* k, int l, hash_t h, void* val)
-		{ key = k; len = l; hash = h; value = val; }
+	bool Empty() const	{ return distance < 0; }
 
-	~DictEntry()
-		{
-		delete [] (char*) key;
-		}
+	bool Matches(const void* k, int l, hash_t h) const
+		{ return hash == h && len == l && ! memcmp(key, k, l); }
 
 	void* key;
-	int len;
-	hash_t hash;
 	void* value;
+	hash_t hash;
+	int len;
+
+	// How far this entry sits from its home bucket; -1 if the slot
+	// is empty.
+	int distance;
 };
 
-// The value of an iteration cookie is the bucket and offset within the
-// bucket at which to start looking for the next value to return.
+// An iteration cookie holds the next slot to look at.  For robust
+// cookies, the dictionary keeps "next" consistent while entries get
+// shifted around, and collects entries that show up behind it.
 class IterCookie {
 public:
-	IterCookie(int b, int o)
+	IterCookie()
 		{
-		bucket = b;
-		offset = o;
-		ttbl = 0;
-		num_buckets_p = 0;
+		next = 0;
 		}
 
-	int bucket, offset;
-	PList<DictEntry>** ttbl;
-	const int* num_buckets_p;
-	PList<DictEntry> inserted;	// inserted while iterating
+	int next;
+	std::vector<DictEntry> inserted;	// inserted while iterating
 };
 
 Dictionary::Dictionary(dict_order ordering, int initial_size)
 	{
-	tbl = 0;
-	tbl2 = 0;
+	table = 0;
+	log2_buckets = 0;
+	num_buckets = capacity = thresh_entries = 0;
 
 	if ( ordering == ORDERED )
-		order = new PList<DictEntry>;
+		order = new std::vector<DictEntry>;
 	else
 		order = 0;
 
 	delete_func = 0;
-	tbl_next_ind = 0;
 
 	cumulative_entries = 0;
-	num_buckets = num_entries = max_num_entries = thresh_entries = 0;
-	den_thresh = 0;
-	num_buckets2 = num_entries2 = max_num_entries2 = thresh_entries2 = 0;
-	den_thresh2 = 0;
+	num_entries = max_num_entries = 0;
 
 	if ( initial_size > 0 )
 		Init(initial_size);
@@ -87,191 +89,262 @@ Dictionary::~Dictionary()
 void Dictionary::Clear()
 	{
 	DeInit();
-	tbl = 0;
-	tbl2 = 0;
+	table = 0;
 	num_entries = 0;
-	num_entries2 = 0;
+
+	if ( order )
+		order->clear();
+
+	for ( const auto& c : cookies )
+		{
+		c->inserted.clear();
+		c->next = 0;
+		}
 	}
 
 void Dictionary::DeInit()
 	{
-	if ( ! tbl )
+	if ( ! table )
 		return;
 
-	for ( int i = 0; i < num_buckets; ++i )
-		if ( tbl[i] )
-			{
-			PList<DictEntry>* chain = tbl[i];
-			for ( const auto& e : *chain )
-				{
-				if ( delete_func )
-					delete_func(e->value);
-				delete e;
-				}
+	for ( int i = 0; i < capacity; ++i )
+		{
+		DictEntry& e = table[i];
 
-			delete chain;
-			}
+		if ( e.Empty() )
+			continue;
 
-	delete [] tbl;
+		if ( delete_func )
+			delete_func(e.value);
 
-	if ( tbl2 == 0 )
-		return;
-
-	for ( int i = 0; i < num_buckets2; ++i )
-		if ( tbl2[i] )
-			{
-			PList<DictEntry>* chain = tbl2[i];
-			for ( const auto& e : *chain )
-				{
-				if ( delete_func )
-					delete_func(e->value);
-				delete e;
-				}
-
-			delete chain;
-			}
+		delete [] (char*) e.key;
+		}
 
-	delete [] tbl2;
-	tbl2 = 0;
+	delete [] table;
+	table = 0;
 	}
 
-void* Dictionary::Lookup(const void* key, int key_size, hash_t hash) const
+int Dictionary::LookupIndex(const void* key, int key_size, hash_t hash) const
 	{
-	if ( ! tbl && ! tbl2 )
-		return 0;
+	if ( ! table )
+		return -1;
 
-	hash_t h;
-	PList<DictEntry>* chain;
+	int d = 0;
 
-	// Figure out which hash table to look in.
-	h = hash % num_buckets;
-	if ( ! tbl2 || h >= tbl_next_ind )
-		chain = tbl[h];
-	else
-		chain = tbl2[hash % num_buckets2];
-
-	if ( chain )
+	for ( int i = Bucket(hash); i < capacity; ++i, ++d )
 		{
-		for ( int i = 0; i < chain->length(); ++i )
-			{
-			DictEntry* entry = (*chain)[i];
-
-			if ( entry->hash == hash && entry->len == key_size &&
-			     ! memcmp(key, entry->key, key_size) )
-				return entry->value;
-			}
+		const DictEntry& e = table[i];
+
+		// Entries within a cluster are sorted by home bucket, so
+		// once we see one closer to home than we'd be, the key
+		// can't be further on.
+		if ( e.Empty() || e.distance < d )
+			return -1;
+
+		if ( e.Matches(key, key_size, hash) )
+			return i;
 		}
 
-	return 0;
+	return -1;
+	}
+
+void* Dictionary::Lookup(const void* key, int key_size, hash_t hash) const
+	{
+	int idx = LookupIndex(key, key_size, hash);
+	return idx >= 0 ? table[idx].value : 0;
 	}
 
 void* Dictionary::Insert(void* key, int key_size, hash_t hash, void* val,
 				int copy_key)
 	{
-	if ( ! tbl )
+	if ( ! table )
 		Init(DEFAULT_DICT_SIZE);
 
-	DictEntry* new_entry = new DictEntry(key, key_size, hash, val);
-	void* old_val = Insert(new_entry, copy_key);
+	int idx = LookupIndex(key, key_size, hash);
+
+	if ( idx >= 0 )
+		{
+		// The key was already present.  We don't need the new key,
+		// only the new value.
+		DictEntry& e = table[idx];
+		void* old_value = e.value;
+		e.value = val;
+
+		for ( const auto& c : cookies )
+			for ( auto& ie : c->inserted )
+				if ( ie.key == e.key )
+					ie.value = val;
 
-	if ( old_val )
+		if ( ! copy_key )
+			delete [] (char*) key;
+
+		return old_value;
+		}
+
+	DictEntry new_entry;
+	new_entry.key = key;
+	new_entry.len = key_size;
+	new_entry.hash = hash;
+	new_entry.value = val;
+
+	// If we got this far, then we couldn't use an existing copy
+	// of the key, so make a new one if necessary.
+	if ( copy_key )
 		{
-		// We didn't need the new DictEntry, the key was already
-		// present.
-		delete new_entry;
+		new_entry.key = (void*) new char[key_size];
+		memcpy(new_entry.key, key, key_size);
 		}
-	else if ( order )
-		order->push_back(new_entry);
 
-	// Resize logic.
-	if ( tbl2 )
-		MoveChains();
-	else if ( num_entries >= thresh_entries )
-		StartChangeSize(num_buckets * 2 + 1);
+	if ( num_entries >= thresh_entries )
+		SizeUp();
+
+	int last;
+	while ( (idx = Place(new_entry, &last)) < 0 )
+		SizeUp();
+
+	++cumulative_entries;
+	if ( max_num_entries < ++num_entries )
+		max_num_entries = num_entries;
+
+	if ( order )
+		order->push_back(table[idx]);
+
+	if ( cookies.length() > 0 )
+		AdjustCookiesOnInsert(table[idx], idx, last);
 
-	return old_val;
+	return 0;
 	}
 
 void* Dictionary::Remove(const void* key, int key_size, hash_t hash,
 				bool dont_delete)
 	{
-	if ( ! tbl && ! tbl2 )
+	int idx = LookupIndex(key, key_size, hash);
+
+	if ( idx < 0 )
 		return 0;
 
-	hash_t h;
-	PList<DictEntry>* chain;
-	int* num_entries_ptr;
+	DictEntry entry = table[idx];
 
-	// Figure out which hash table to look in
-	h = hash % num_buckets;
-	if ( ! tbl2 || h >= tbl_next_ind )
+	if ( order )
 		{
-		chain = tbl[h];
-		num_entries_ptr = &num_entries;
+		for ( auto it = order->begin(); it != order->end(); ++it )
+			if ( it->key == entry.key )
+				{
+				order->erase(it);
+				break;
+				}
 		}
-	else
+
+	RemoveIndex(idx);
+
+	if ( ! dont_delete )
+		delete [] (char*) entry.key;
+
+	return entry.value;
+	}
+
+int Dictionary::Place(const DictEntry& entry, int* last_shifted)
+	{
+	int d = 0;
+	int i = Bucket(entry.hash);
+
+	// Find our spot: the first slot that's either free or held by an
+	// entry that's closer to its home than we'd be.
+	for ( ; i < capacity; ++i, ++d )
+		if ( table[i].Empty() || table[i].distance < d )
+			break;
+
+	int end = i;
+	while ( end < capacity && ! table[end].Empty() )
+		++end;
+
+	if ( end >= capacity )
+		return -1;
+
+	// Everybody from our spot up to the next free slot moves one
+	// further away from home.
+	if ( end > i )
 		{
-		chain = tbl2[hash % num_buckets2];
-		num_entries_ptr = &num_entries2;
+		memmove(&table[i + 1], &table[i], (end - i) * sizeof(DictEntry));
+
+		for ( int j = i + 1; j <= end; ++j )
+			++table[j].distance;
 		}
 
-	if ( ! chain )
-		return 0;
+	table[i] = entry;
+	table[i].distance = d;
 
-	for ( int i = 0; i < chain->length(); ++i )
-		{
-		DictEntry* entry = (*chain)[i];
+	if ( last_shifted )
+		*last_shifted = end;
 
-		if ( entry->hash == hash && entry->len == key_size &&
-		     ! memcmp(key, entry->key, key_size) )
-			{
-			void* entry_value = DoRemove(entry, h, chain, i);
+	return i;
+	}
 
-			if ( dont_delete )
-				entry->key = 0;
+void Dictionary::RemoveIndex(int idx)
+	{
+	DictEntry entry = table[idx];
+
+	// Backward-shift deletion: pull the rest of the cluster one slot
+	// closer to home, up to the first entry that's already there.
+	int last = idx;
+	while ( last + 1 < capacity && ! table[last + 1].Empty() &&
+		table[last + 1].distance > 0 )
+		++last;
 
-			delete entry;
-			--*num_entries_ptr;
-			return entry_value;
-			}
+	if ( last > idx )
+		{
+		memmove(&table[idx], &table[idx + 1],
+			(last - idx) * sizeof(DictEntry));
+
+		for ( int j = idx; j < last; ++j )
+			--table[j].distance;
 		}
 
-	return 0;
+	table[last].distance = -1;
+	--num_entries;
+
+	if ( cookies.length() > 0 )
+		AdjustCookiesOnRemove(entry, idx, last);
 	}
 
-void* Dictionary::DoRemove(DictEntry* entry, hash_t h,
-				PList<DictEntry>* chain, int chain_offset)
+void Dictionary::AdjustCookiesOnInsert(const DictEntry& entry, int idx,
+					int last)
 	{
-	void* entry_value = entry->value;
+	for ( const auto& c : cookies )
+		{
+		if ( idx >= c->next )
+			// We'll get to it.
+			continue;
 
-	chain->remove_nth(chain_offset);
-	if ( order )
-		order->remove(entry);
+		// It landed in the part that has already been visited.
+		c->inserted.push_back(entry);
 
-	// Adjust existing cookies.
+		// If the shift pushed a visited entry into the unvisited
+		// part, step over it.
+		if ( last >= c->next )
+			++c->next;
+		}
+	}
+
+void Dictionary::AdjustCookiesOnRemove(const DictEntry& entry, int idx,
+					int last)
+	{
 	for ( const auto& c : cookies )
 		{
-		// Is the affected bucket the current one?
-		if ( (unsigned int) c->bucket == h )
-			{
-			if ( c->offset > chain_offset )
-				--c->offset;
-
-			// The only other important case here occurs when we
-			// are deleting the current entry which
-			// simultaniously happens to be the last one in this
-			// bucket. This means that we would have to move on
-			// to the next non-empty bucket. Fortunately,
-			// NextEntry() will do exactly the right thing in
-			// this case. :-)
-			}
+		// If the shift pulled an unvisited entry back into the
+		// visited part, step back to it.
+		if ( idx < c->next && last >= c->next )
+			--c->next;
 
 		// This item may have been inserted during this iteration.
-		if ( (unsigned int) c->bucket > h )
-			c->inserted.remove(entry);
+		auto& ins = c->inserted;
+		for ( auto it = ins.begin(); it != ins.end(); ++it )
+			if ( it->key == entry.key )
+				{
+				ins.erase(it);
+				break;
+				}
 		}
-
-	return entry_value;
 	}
 
 void* Dictionary::NthEntry(int n, const void*& key, int& key_len) const
@@ -279,89 +352,49 @@ void* Dictionary::NthEntry(int n, const void*& key, int& key_len) const
 	if ( ! order || n < 0 || n >= Length() )
 		return 0;
 
-	DictEntry* entry = (*order)[n];
-	key = entry->key;
-	key_len = entry->len;
-	return entry->value;
+	const DictEntry& entry = (*order)[n];
+	key = entry.key;
+	key_len = entry.len;
+	return Lookup(entry.key, entry.len, entry.hash);
 	}
 
 IterCookie* Dictionary::InitForIteration() const
 	{
-	return new IterCookie(0, 0);
+	return new IterCookie();
 	}
 
 void Dictionary::StopIteration(IterCookie* cookie) const
 	{
+	const_cast<PList<IterCookie>*>(&cookies)->remove(cookie);
 	delete cookie;
 	}
 
 void* Dictionary::NextEntry(HashKey*& h, IterCookie*& cookie, int return_hash) const
 	{
-	if ( ! tbl && ! tbl2 )
-		{
-		const_cast<PList<IterCookie>*>(&cookies)->remove(cookie);
-		delete cookie;
-		cookie = 0;
-		return 0;
-		}
-
 	// If there are any inserted entries, return them first.
 	// That keeps the list small and helps avoiding searching
 	// a large list when deleting an entry.
-
-	DictEntry* entry;
-
-	if ( cookie->inserted.length() )
+	if ( table && cookie->inserted.size() )
 		{
 		// Return the last one. Order doesn't matter,
 		// and removing from the tail is cheaper.
-		entry = cookie->inserted.remove_nth(cookie->inserted.length()-1);
-		if ( return_hash )
-			h = new HashKey(entry->key, entry->len, entry->hash);
+		DictEntry entry = cookie->inserted.back();
+		cookie->inserted.pop_back();
 
-		return entry->value;
-		}
-
-	int b = cookie->bucket;
-	int o = cookie->offset;
-	PList<DictEntry>** ttbl;
-	const int* num_buckets_p;
+		if ( return_hash )
+			h = new HashKey(entry.key, entry.len, entry.hash);
 
-	if ( ! cookie->ttbl )
-		{
-		// XXX maybe we could update cookie->b from tbl_next_ind here?
-		cookie->ttbl = tbl;
-		cookie->num_buckets_p = &num_buckets;
+		return entry.value;
 		}
 
-	ttbl = cookie->ttbl;
-	num_buckets_p = cookie->num_buckets_p;
+	int i = cookie->next;
 
-	if ( ttbl[b] && ttbl[b]->length() > o )
-		{
-		entry = (*ttbl[b])[o];
-		++cookie->offset;
-		if ( return_hash )
-			h = new HashKey(entry->key, entry->len, entry->hash);
-		return entry->value;
-		}
-
-	++b;	// Move on to next non-empty bucket.
-	while ( b < *num_buckets_p && (! ttbl[b] || ttbl[b]->length() == 0) )
-		++b;
+	if ( table )
+		while ( i < capacity && table[i].Empty() )
+			++i;
 
-	if ( b >= *num_buckets_p )
+	if ( ! table || i >= capacity )
 		{
-		// If we're resizing, we need to search the 2nd table too.
-		if ( ttbl == tbl && tbl2 )
-			{
-			cookie->ttbl = tbl2;
-			cookie->num_buckets_p = &num_buckets2;
-			cookie->bucket = 0;
-			cookie->offset = 0;
-			return Dictionary::NextEntry(h, cookie, return_hash);
-			}
-
 		// All done.
 
 		// FIXME: I don't like removing the const here. But is there
@@ -372,260 +405,97 @@ void* Dictionary::NextEntry(HashKey*& h, IterCookie*& cookie, int return_hash) c
 		return 0;
 		}
 
-	entry = (*ttbl[b])[0];
-	if ( return_hash )
-		h = new HashKey(entry->key, entry->len, entry->hash);
+	const DictEntry& entry = table[i];
+	cookie->next = i + 1;
 
-	cookie->bucket = b;
-	cookie->offset = 1;
+	if ( return_hash )
+		h = new HashKey(entry.key, entry.len, entry.hash);
 
-	return entry->value;
+	return entry.value;
 	}
 
 void Dictionary::Init(int size)
 	{
-	num_buckets = NextPrime(size);
-	tbl = new PList<DictEntry>*[num_buckets];
+	// Size the table so that "size" entries fit without growing.
+	int want = size * MAX_LOAD_DENOMINATOR / MAX_LOAD_NUMERATOR + 1;
+	int n = MIN_LOG2_BUCKETS;
 
-	for ( int i = 0; i < num_buckets; ++i )
-		tbl[i] = 0;
+	while ( (1 << n) < want )
+		++n;
 
+	InitTable(n);
 	max_num_entries = num_entries = 0;
-	SetDensityThresh(DEFAULT_DENSITY_THRESH);
 	}
 
-void Dictionary::Init2(int size)
+void Dictionary::InitTable(int arg_log2_buckets)
 	{
-	num_buckets2 = NextPrime(size);
-	tbl2 = new PList<DictEntry>*[num_buckets2];
+	log2_buckets = arg_log2_buckets;
+	num_buckets = 1 << log2_buckets;
+	capacity = num_buckets + log2_buckets + OVERFLOW_SLOTS;
+	thresh_entries = num_buckets / MAX_LOAD_DENOMINATOR * MAX_LOAD_NUMERATOR;
 
-	for ( int i = 0; i < num_buckets2; ++i )
-		tbl2[i] = 0;
+	table = new DictEntry[capacity];
 
-	max_num_entries2 = num_entries2 = 0;
+	for ( int i = 0; i < capacity; ++i )
+		table[i].distance = -1;
 	}
 
-// private
-void* Dictionary::Insert(DictEntry* new_entry, int copy_key)
+void Dictionary::SizeUp()
 	{
-	if ( ! tbl )
-		Init(DEFAULT_DICT_SIZE);
-
-	PList<DictEntry>** ttbl;
-	int* num_entries_ptr;
-	int* max_num_entries_ptr;
-	hash_t h = new_entry->hash % num_buckets;
-
-	// We must be careful when we are in the middle of resizing.
-	// If the new entry hashes to a bucket in the old table we
-	// haven't moved yet, we need to put it in the old table. If
-	// we didn't do it this way, we would sometimes have to
-	// search both tables which is probably more expensive.
-
-	if ( ! tbl2 || h >= tbl_next_ind )
-		{
-		ttbl = tbl;
-		num_entries_ptr = &num_entries;
-		max_num_entries_ptr = &max_num_entries;
-		}
-	else
-		{
-		ttbl = tbl2;
-		h = new_entry->hash % num_buckets2;
-		num_entries_ptr = &num_entries2;
-		max_num_entries_ptr = &max_num_entries2;
-		}
-
-	PList<DictEntry>* chain = ttbl[h];
-
-	int n = new_entry->len;
-
-	if ( chain )
-		{
-		for ( int i = 0; i < chain->length(); ++i )
-			{
-			DictEntry* entry = (*chain)[i];
-
-			if ( entry->hash == new_entry->hash &&
-			     entry->len == n &&
-			     ! memcmp(entry->key, new_entry->key, n) )
-				{
-				void* old_value = entry->value;
-				entry->value = new_entry->value;
-				return old_value;
-				}
-			}
-		}
-	else
-		// Create new chain.
-		chain = ttbl[h] = new PList<DictEntry>;
-
-	// If we got this far, then we couldn't use an existing copy
-	// of the key, so make a new one if necessary.
-	if ( copy_key )
-		{
-		void* old_key = new_entry->key;
-		new_entry->key = (void*) new char[n];
-		memcpy(new_entry->key, old_key, n);
-		delete (char*) old_key;
-		}
-
-	// We happen to know (:-() that appending is more efficient
-	// on lists than prepending.
-	chain->push_back(new_entry);
-
-	++cumulative_entries;
-	if ( *max_num_entries_ptr < ++*num_entries_ptr )
-		*max_num_entries_ptr = *num_entries_ptr;
+	DictEntry* old_table = table;
+	int old_capacity = capacity;
 
-	// For ongoing iterations: If we already passed the bucket where this
-	// entry was put, add it to the cookie's list of inserted entries.
+	// Entries that robust cookies have yet to visit get handed to them
+	// directly, since their slots are about to change.  The cookies
+	// then treat the whole new table as visited.
 	for ( const auto& c : cookies )
 		{
-		if ( h < (unsigned int) c->bucket )
-			c->inserted.push_back(new_entry);
+		for ( int i = c->next; i < old_capacity; ++i )
+			if ( ! old_table[i].Empty() )
+				c->inserted.push_back(old_table[i]);
 		}
 
-	return 0;
-	}
-
-int Dictionary::NextPrime(int n) const
-	{
-	if ( (n & 0x1) == 0 )
-		// Even.
-		++n;
-
-	if ( n > PRIME_THRESH )
-		// Too expensive to test for primality, just stick with it.
-		return n;
-
-	while ( ! IsPrime(n) )
-		n += 2;
-
-	return n;
-	}
-
-int Dictionary::IsPrime(int n) const
-	{
-	for ( int j = 3; j * j <= n; ++j )
-		if ( n % j == 0 )
-			return 0;
-
-	return 1;
-	}
-
-void Dictionary::StartChangeSize(int new_size)
-	{
-	// Only start resizing if there isn't any iteration in progress.
-	if ( cookies.length() > 0 )
-		return;
+	int n = log2_buckets + 1;
 
-	if ( tbl2 )
-		reporter->InternalError("Dictionary::StartChangeSize() tbl2 not NULL");
-
-	Init2(new_size);
-
-	tbl_next_ind = 0;
-
-	// Preserve threshold density
-	SetDensityThresh2(DensityThresh());
-	}
-
-void Dictionary::MoveChains()
-	{
-	// Do not change current distribution if there an ongoing iteration.
-	if ( cookies.length() > 0 )
-		return;
-
-	// Attempt to move this many entries (must do at least 2)
-	int num = 8;
-
-	do
+	while ( true )
 		{
-		PList<DictEntry>* chain = tbl[tbl_next_ind++];
-
-		if ( ! chain )
-			continue;
+		InitTable(n);
 
-		tbl[tbl_next_ind - 1] = 0;
+		int i;
+		for ( i = 0; i < old_capacity; ++i )
+			if ( ! old_table[i].Empty() && Place(old_table[i]) < 0 )
+				break;
 
-		for ( int j = 0; j < chain->length(); ++j )
-			{
-			Insert((*chain)[j], 0);
-			--num_entries;
-			--num;
-			}
+		if ( i == old_capacity )
+			break;
 
-		delete chain;
+		// A cluster ran off the end of the new table; very unlikely,
+		// but try again with more room.
+		delete [] table;
+		++n;
 		}
-	while ( num > 0 && int(tbl_next_ind) < num_buckets );
 
-	if ( int(tbl_next_ind) >= num_buckets )
-		FinishChangeSize();
-	}
+	delete [] old_table;
 
-void Dictionary::FinishChangeSize()
-	{
-	// Cheap safety check.
-	if ( num_entries != 0 )
-		reporter->InternalError(
-		    "Dictionary::FinishChangeSize: num_entries is %d\n",
-		    num_entries);
-
-	for ( int i = 0; i < num_buckets; ++i )
-		delete tbl[i];
-	delete [] tbl;
-
-	tbl = tbl2;
-	tbl2 = 0;
-
-	num_buckets = num_buckets2;
-	num_entries = num_entries2;
-	max_num_entries = max_num_entries2;
-	den_thresh = den_thresh2;
-	thresh_entries = thresh_entries2;
-
-	num_buckets2 = 0;
-	num_entries2 = 0;
-	max_num_entries2 = 0;
-	den_thresh2 = 0;
-	thresh_entries2 = 0;
+	for ( const auto& c : cookies )
+		c->next = capacity;
 	}
 
 unsigned int Dictionary::MemoryAllocation() const
 	{
 	int size = padded_sizeof(*this);
 
-	if ( ! tbl )
+	if ( ! table )
 		return size;
 
-	for ( int i = 0; i < num_buckets; ++i )
-		if ( tbl[i] )
-			{
-			PList<DictEntry>* chain = tbl[i];
-			for ( const auto& c : *chain )
-				size += padded_sizeof(DictEntry) + pad_size(c->len);
-			size += chain->MemoryAllocation();
-			}
+	size += pad_size(capacity * sizeof(DictEntry));
 
-	size += pad_size(num_buckets * sizeof(PList<DictEntry>*));
+	for ( int i = 0; i < capacity; ++i )
+		if ( ! table[i].Empty() )
+			size += pad_size(table[i].len);
 
 	if ( order )
-		size += order->MemoryAllocation();
-
-	if ( tbl2 )
-		{
-		for ( int i = 0; i < num_buckets2; ++i )
-			if ( tbl2[i] )
-				{
-				PList<DictEntry>* chain = tbl2[i];
-				for ( const auto& c : *chain )
-					size += padded_sizeof(DictEntry) + pad_size(c->len);
-				size += chain->MemoryAllocation();
-				}
-
-		size += pad_size(num_buckets2 * sizeof(PList<DictEntry>*));
-		}
+		size += pad_size(order->capacity() * sizeof(DictEntry));
 
 	return size;
 	}
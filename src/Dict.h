@@ -3,6 +3,8 @@
 #ifndef dict_h
 #define dict_h
 
+#include <vector>
+
 #include "List.h"
 #include "Hash.h"
 
@@ -55,14 +57,11 @@ public:
 
 	// Number of entries.
 	int Length() const
-		{ return tbl2 ? num_entries + num_entries2 : num_entries; }
+		{ return num_entries; }
 
 	// Largest it's ever been.
 	int MaxLength() const
-		{
-		return tbl2 ?
-			max_num_entries + max_num_entries2 : max_num_entries;
-		}
+		{ return max_num_entries; }
 
 	// Total number of entries ever.
 	uint64 NumCumulativeInserts() const
@@ -122,62 +121,54 @@ public:
 
 private:
 	void Init(int size);
-	void Init2(int size);	// initialize second table for resizing
+	void InitTable(int arg_log2_buckets);
 	void DeInit();
 
-	// Internal version of Insert().
-	void* Insert(DictEntry* entry, int copy_key);
-
-	void* DoRemove(DictEntry* entry, hash_t h,
-			PList<DictEntry>* chain, int chain_offset);
-
-	int NextPrime(int n) const;
-	int IsPrime(int n) const;
-	void StartChangeSize(int new_size);
-	void FinishChangeSize();
-	void MoveChains();
-
-	// The following get and set the "density" threshold - if the
-	// average hash chain length exceeds this threshold, the
-	// table will be resized.  The default value is 3.0.
-	double DensityThresh() const	{ return den_thresh; }
-
-	void SetDensityThresh(double thresh)
-		{
-		den_thresh = thresh;
-		thresh_entries = int(thresh * double(num_buckets));
-		}
-
-	// Same for the second table, when resizing.
-	void SetDensityThresh2(double thresh)
-		{
-		den_thresh2 = thresh;
-		thresh_entries2 = int(thresh * double(num_buckets2));
-		}
-
-	// Normally we only have tbl.
-	// When we're resizing, we'll have tbl (old) and tbl2 (new)
-	// tbl_next_ind keeps track of how much we've moved to tbl2
-	// (it's the next index we're going to move).
-	PList<DictEntry>** tbl;
+	// Returns the slot where the given key lives, or -1 if it's not
+	// in the table.
+	int LookupIndex(const void* key, int key_size, hash_t hash) const;
+
+	// Places an entry into the table without looking for an existing
+	// copy of its key.  Returns the slot the entry ended up in, or -1
+	// if the probe ran off the end of the table (in which case the
+	// table is unchanged and needs to grow).  If last_shifted is
+	// non-nil, it's set to the last slot touched by the shift that
+	// made room for the entry.
+	int Place(const DictEntry& entry, int* last_shifted = 0);
+
+	// Removes the entry in the given slot, shifting its successors
+	// back into place.
+	void RemoveIndex(int idx);
+
+	// Doubles the number of buckets and rehashes all entries.
+	void SizeUp();
+
+	// Maps a hash onto its home bucket.
+	int Bucket(hash_t hash) const
+		{ return int((hash * 0x9E3779B97F4A7C15ULL) >> (64 - log2_buckets)); }
+
+	// Bring robust cookies up to date after an entry has been placed
+	// into slot idx, or removed from it, with all of the entries up to
+	// and including slot last shifted by one.
+	void AdjustCookiesOnInsert(const DictEntry& entry, int idx, int last);
+	void AdjustCookiesOnRemove(const DictEntry& entry, int idx, int last);
+
+	// Slots are kept in one contiguous array.  An entry's home bucket is
+	// in [0, num_buckets); collisions are resolved with Robin Hood
+	// linear probing into the following slots, which may spill into an
+	// overflow area at the end of the array.  We never wrap around, so
+	// that slot order is iteration order.
+	DictEntry* table;
+	int log2_buckets;
 	int num_buckets;
+	int capacity;	// num_buckets plus overflow slots
+	int thresh_entries;
+
 	int num_entries;
 	int max_num_entries;
 	uint64 cumulative_entries;
-	double den_thresh;
-	int thresh_entries;
-
-	// Resizing table (replicates tbl above).
-	PList<DictEntry>** tbl2;
-	int num_buckets2;
-	int num_entries2;
-	int max_num_entries2;
-	double den_thresh2;
-	int thresh_entries2;
-
-	hash_t tbl_next_ind;
 
-	PList<DictEntry>* order;
+	std::vector<DictEntry>* order;
 	dict_delete_func delete_func;
 
 	PList<IterCookie> cookies;
@@ -10,6 +10,8 @@
 
 EventMgr mgr;
 
+DEFINE_POOL_ALLOCATOR(Event)
+
 uint64 num_events_queued = 0;
 uint64 num_events_dispatched = 0;
 
@@ -21,8 +23,7 @@ Event::Event(EventHandlerPtr arg_handler, val_list arg_args,
 	  src(arg_src),
 	  aid(arg_aid),
 	  mgr(arg_mgr ? arg_mgr : timer_mgr),
-	  obj(arg_obj),
-	  next_event(nullptr)
+	  obj(arg_obj)
 	{
 	if ( obj )
 		Ref(obj);
@@ -81,7 +82,10 @@ void Event::Dispatch(bool no_remote)
 
 EventMgr::EventMgr()
 	{
-	head = tail = 0;
+	queue.resize(1024);
+	queue_head = 0;
+	num_queued = 0;
+	max_queued = 0;
 	current_src = SOURCE_LOCAL;
 	current_mgr = timer_mgr;
 	current_aid = 0;
@@ -91,12 +95,8 @@ EventMgr::EventMgr()
 
 EventMgr::~EventMgr()
 	{
-	while ( head )
-		{
-		Event* n = head->NextEvent();
-		Unref(head);
-		head = n;
-		}
+	while ( num_queued )
+		Unref(PopEvent());
 
 	Unref(src_val);
 	}
@@ -108,17 +108,28 @@ void EventMgr::QueueEvent(Event* event)
 	if ( done )
 		return;
 
-	if ( ! head )
-		head = tail = event;
-	else
-		{
-		tail->SetNext(event);
-		tail = event;
-		}
+	if ( num_queued == queue.size() )
+		GrowQueue();
+
+	queue[(queue_head + num_queued) & (queue.size() - 1)] = event;
+
+	if ( ++num_queued > max_queued )
+		max_queued = num_queued;
 
 	++num_events_queued;
 	}
 
+void EventMgr::GrowQueue()
+	{
+	std::vector<Event*> q(2 * queue.size());
+
+	for ( size_t i = 0; i < num_queued; ++i )
+		q[i] = queue[(queue_head + i) & (queue.size() - 1)];
+
+	queue.swap(q);
+	queue_head = 0;
+	}
+
 void EventMgr::Drain()
 	{
 	if ( event_queue_flush_point )
@@ -137,15 +148,12 @@ void EventMgr::Drain()
 	// just one round to make it less likley to break existing scripts
 	// that expect the old behavior to trigger something quickly.
 
-	for ( int round = 0; head && round < 2; round++ )
+	for ( int round = 0; num_queued && round < 2; round++ )
 		{
-		Event* current = head;
-		head = 0;
-		tail = 0;
-
-		while ( current )
+		// Events queued by the handlers go into the next round.
+		for ( size_t n = num_queued; n && num_queued; --n )
 			{
-			Event* next = current->NextEvent();
+			Event* current = PopEvent();
 
 			current_src = current->Source();
 			current_mgr = current->Mgr();
@@ -154,7 +162,6 @@ void EventMgr::Drain()
 			Unref(current);
 
 			++num_events_dispatched;
-			current = next;
 			}
 		}
 
@@ -170,16 +177,11 @@ void EventMgr::Drain()
 
 void EventMgr::Describe(ODesc* d) const
 	{
-	int n = 0;
-	Event* e;
-	for ( e = head; e; e = e->NextEvent() )
-		++n;
-
-	d->AddCount(n);
+	d->AddCount(num_queued);
 
-	for ( e = head; e; e = e->NextEvent() )
+	for ( size_t i = 0; i < num_queued; ++i )
 		{
-		e->Describe(d);
+		queue[(queue_head + i) & (queue.size() - 1)]->Describe(d);
 		d->NL();
 		}
 	}
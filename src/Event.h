@@ -3,7 +3,10 @@
 #ifndef event_h
 #define event_h
 
+#include <vector>
+
 #include "EventRegistry.h"
+#include "PoolAllocator.h"
 
 #include "analyzer/Tag.h"
 #include "analyzer/Analyzer.h"
@@ -14,6 +17,8 @@ class EventMgr;
 // in a dtor because Func::Call already does that.
 class Event : public BroObj {
 public:
+	DECLARE_POOL_ALLOCATOR(Event)
+
 	Event(EventHandlerPtr handler, val_list args,
 		SourceID src = SOURCE_LOCAL, analyzer::ID aid = 0,
 		TimerMgr* mgr = 0, BroObj* obj = 0);
@@ -22,9 +27,6 @@ public:
 		SourceID src = SOURCE_LOCAL, analyzer::ID aid = 0,
 		TimerMgr* mgr = 0, BroObj* obj = 0);
 
-	void SetNext(Event* n)		{ next_event = n; }
-	Event* NextEvent() const	{ return next_event; }
-
 	SourceID Source() const		{ return src; }
 	analyzer::ID Analyzer() const	{ return aid; }
 	TimerMgr* Mgr() const		{ return mgr; }
@@ -46,7 +48,6 @@ protected:
 	analyzer::ID aid;
 	TimerMgr* mgr;
 	BroObj* obj;
-	Event* next_event;
 };
 
 extern uint64 num_events_queued;
@@ -103,6 +104,21 @@ public:
 		delete vl;
 		}
 
+	// Queues an event whose arguments are only built if there's an event
+	// handler (or remote consumer) for it.  'build' is a callable taking
+	// no arguments and returning the event's val_list; it doesn't get
+	// called at all if nothing would consume the event.  The arguments
+	// are built right away, not when the event is dispatched, so 'build'
+	// may refer to state that's only valid during the call.
+	template <typename ArgBuilder>
+	void QueueEventLazy(const EventHandlerPtr &h, const ArgBuilder& build,
+			SourceID src = SOURCE_LOCAL, analyzer::ID aid = 0,
+			TimerMgr* mgr = 0, BroObj* obj = 0)
+		{
+		if ( h )
+			QueueEventFast(h, build(), src, aid, mgr, obj);
+		}
+
 	void Dispatch(Event* event, bool no_remote = false)
 		{
 		current_src = event->Source();
@@ -113,7 +129,7 @@ public:
 	void Drain();
 	bool IsDraining() const	{ return draining; }
 
-	int HasEvents() const	{ return head != 0; }
+	int HasEvents() const	{ return num_queued != 0; }
 
 	// Returns the source ID of last raised event.
 	SourceID CurrentSource() const	{ return current_src; }
@@ -128,13 +144,35 @@ public:
 	int Size() const
 		{ return num_events_queued - num_events_dispatched; }
 
+	// Returns the largest number of events that have been waiting in the
+	// queue at the same time.
+	uint64 MaxSize() const	{ return max_queued; }
+
 	void Describe(ODesc* d) const override;
 
 protected:
 	void QueueEvent(Event* event);
 
-	Event* head;
-	Event* tail;
+	// Removes the event at the front of the queue.
+	Event* PopEvent()
+		{
+		Event* e = queue[queue_head];
+		queue_head = (queue_head + 1) & (queue.size() - 1);
+		--num_queued;
+		return e;
+		}
+
+	// Doubles the size of the queue, keeping its order.
+	void GrowQueue();
+
+	// The queue is a ring buffer whose size is a power of 2. It only
+	// ever grows, so that queueing events doesn't allocate once it has
+	// reached its working size.
+	std::vector<Event*> queue;
+	size_t queue_head;	// Index of the first queued event.
+	size_t num_queued;
+	uint64 max_queued;
+
 	SourceID current_src;
 	analyzer::ID current_aid;
 	TimerMgr* current_mgr;
@@ -16,6 +16,7 @@ EventHandler::EventHandler(const char* arg_name)
 	error_handler = false;
 	enabled = true;
 	generate_always = false;
+	call_count = 0;
 	}
 
 EventHandler::~EventHandler()
@@ -66,6 +67,8 @@ void EventHandler::Call(val_list* vl, bool no_remote)
 	DEBUG_MSG("Event: %s\n", Name());
 #endif
 
+	++call_count;
+
 	if ( new_event )
 		NewEvent(vl);
 
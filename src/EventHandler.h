@@ -35,6 +35,9 @@ public:
 
 	void Call(val_list* vl, bool no_remote = false);
 
+	// Returns the number of times the event has been dispatched.
+	uint64 CallCount() const	{ return call_count; }
+
 	// Returns true if there is at least one local or remote handler.
 	explicit operator  bool() const;
 
@@ -63,6 +66,7 @@ private:
 	bool enabled;
 	bool error_handler;	// this handler reports error messages.
 	bool generate_always;
+	uint64 call_count;
 
 	std::unordered_set<std::string> auto_publish;
 };
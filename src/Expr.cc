@@ -4236,6 +4236,9 @@ int CallExpr::IsPure() const
 	return pure;
 	}
 
+// Argument lists of calls that aren't in use, see CallExpr::Eval().
+static vector<val_list*> free_call_args;
+
 Val* CallExpr::Eval(Frame* f) const
 	{
 	if ( IsError() )
@@ -4263,9 +4266,22 @@ Val* CallExpr::Eval(Frame* f) const
 
 	Val* ret = 0;
 	Val* func_val = func->Eval(f);
-	val_list* v = eval_list(f, args);
 
-	if ( func_val && v )
+	// Argument lists are recycled across calls, so that a call doesn't
+	// need to allocate one. Func::Call() doesn't hold on to them.
+	val_list* v;
+
+	if ( free_call_args.empty() )
+		v = new val_list(args->Exprs().length());
+	else
+		{
+		v = free_call_args.back();
+		free_call_args.pop_back();
+		}
+
+	bool have_args = eval_list(f, args, v);
+
+	if ( func_val && have_args )
 		{
 		const ::Func* func = func_val->AsFunc();
 		const CallExpr* current_call = f ? f->GetCall() : 0;
@@ -4279,11 +4295,17 @@ Val* CallExpr::Eval(Frame* f) const
 			f->SetCall(current_call);
 
 		// Don't Unref() the arguments, as Func::Call already did that.
-		delete v;
 		}
 	else
-		delete_vals(v);
+		{
+		for ( const auto& val : *v )
+			Unref(val);
+		}
 
+	while ( v->length() )
+		v->pop_back();
+
+	free_call_args.push_back(v);
 	Unref(func_val);
 
 	return ret;
@@ -5225,31 +5247,37 @@ int check_and_promote_exprs_to_type(ListExpr*& elements, BroType* type)
 
 val_list* eval_list(Frame* f, const ListExpr* l)
 	{
-	const expr_list& e = l->Exprs();
-	val_list* v = new val_list(e.length());
+	val_list* v = new val_list(l->Exprs().length());
+
+	if ( ! eval_list(f, l, v) )
+		{ // Failure.
+		delete v;
+		return 0;
+		}
 
-	bool success = true;
-	for ( const auto& expr : e )
+	return v;
+	}
+
+bool eval_list(Frame* f, const ListExpr* l, val_list* v)
+	{
+	for ( const auto& expr : l->Exprs() )
 		{
 		Val* ev = expr->Eval(f);
 		if ( ! ev )
 			{
-			success = false;
-			break;
+			while ( v->length() )
+				{
+				Unref(v->back());
+				v->pop_back();
+				}
+
+			return false;
 			}
-		v->push_back(ev);
-		}
 
-	if ( ! success )
-		{ // Failure.
-		for ( const auto& val : *v )
-			Unref(val);
-		delete v;
-		return 0;
+		v->push_back(ev);
 		}
 
-	else
-		return v;
+	return true;
 	}
 
 int expr_greater(const Expr* e1, const Expr* e2)
@@ -606,6 +606,9 @@ public:
 	AssignExpr(Expr* op1, Expr* op2, int is_init, Val* val = 0, attr_list* attrs = 0);
 	~AssignExpr() override { Unref(val); }
 
+	int IsInit() const	{ return is_init; }
+	Val* ResultVal() const	{ return val; }
+
 	Val* Eval(Frame* f) const override;
 	void EvalIntoAggregate(const BroType* t, Val* aggr, Frame* f) const override;
 	BroType* InitType() const override;
@@ -673,6 +676,7 @@ public:
 
 	int Field() const	{ return field; }
 	const char* FieldName() const	{ return field_name; }
+	const TypeDecl* FieldDecl() const	{ return td; }
 
 	int CanDel() const override;
 
@@ -701,6 +705,7 @@ public:
 	HasFieldExpr(Expr* op, const char* field_name);
 	~HasFieldExpr() override;
 
+	int Field() const	{ return field; }
 	const char* FieldName() const	{ return field_name; }
 
 protected:
@@ -1101,6 +1106,10 @@ extern int check_and_promote_exprs_to_type(ListExpr*& elements, BroType* type);
 // pointer if they couldn't all be reduced.
 val_list* eval_list(Frame* f, const ListExpr* l);
 
+// Same, but appends the values to the empty list *v*. Returns false, with
+// *v* empty again, if they couldn't all be reduced.
+bool eval_list(Frame* f, const ListExpr* l, val_list* v);
+
 // Returns true if e1 is "greater" than e2 - here "greater" is just
 // a heuristic, used with commutative operators to put them into
 // a canonical form.
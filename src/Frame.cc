@@ -8,10 +8,73 @@
 
 vector<Frame*> g_frame_stack;
 
+// The slots of frames created by PushCallFrame() are carved out of large
+// chunks in LIFO order, following the nesting of calls. A call that doesn't
+// fit into the current chunk moves on to the next one, which we go back from
+// once it has become empty again.
+struct FrameSlotChunk {
+	Val** slots;
+	int size;
+	int used;
+};
+
+static const int FRAME_SLOT_CHUNK_SIZE = 4096;
+static vector<FrameSlotChunk> slot_chunks;
+static size_t cur_slot_chunk = 0;
+
+// Memory of deleted frames, kept for reuse by Frame::operator new.
+static const size_t MAX_FREE_FRAMES = 256;
+static vector<void*> free_frames;
+
+static FrameSlotChunk new_slot_chunk(int min_size)
+	{
+	FrameSlotChunk c;
+	c.size = max(min_size, FRAME_SLOT_CHUNK_SIZE);
+	c.slots = new Val*[c.size];
+	c.used = 0;
+	return c;
+	}
+
+static Val** push_slots(int n)
+	{
+	if ( slot_chunks.empty() )
+		slot_chunks.push_back(new_slot_chunk(n));
+
+	while ( slot_chunks[cur_slot_chunk].used + n >
+		slot_chunks[cur_slot_chunk].size )
+		{
+		if ( ++cur_slot_chunk == slot_chunks.size() )
+			slot_chunks.push_back(new_slot_chunk(n));
+
+		else if ( slot_chunks[cur_slot_chunk].size < n )
+			{
+			// Chunks past the current one are always empty.
+			delete [] slot_chunks[cur_slot_chunk].slots;
+			slot_chunks[cur_slot_chunk] = new_slot_chunk(n);
+			}
+		}
+
+	FrameSlotChunk& c = slot_chunks[cur_slot_chunk];
+	Val** slots = c.slots + c.used;
+	c.used += n;
+
+	return slots;
+	}
+
+static void pop_slots(Val** slots, int n)
+	{
+	FrameSlotChunk& c = slot_chunks[cur_slot_chunk];
+	assert(slots == c.slots + c.used - n);
+	c.used -= n;
+
+	if ( c.used == 0 && cur_slot_chunk > 0 )
+		--cur_slot_chunk;
+	}
+
 Frame::Frame(int arg_size, const BroFunc* func, const val_list* fn_args)
 	{
 	size = arg_size;
-	frame = new Val*[size];
+	frame = size > 0 ? new Val*[size] : nullptr;
 	function = func;
 	func_args = fn_args;
 
@@ -51,6 +114,66 @@ Frame::~Frame()
 	delete [] weak_refs;
 	}
 
+Frame* Frame::PushCallFrame(int size, const BroFunc* func,
+				const val_list* fn_args)
+	{
+	// Pass a size of zero so that the constructor doesn't allocate.
+	Frame* f = new Frame(0, func, fn_args);
+
+	if ( size > 0 )
+		{
+		f->size = size;
+		f->frame = push_slots(size);
+		f->stack_slots = true;
+
+		for ( int i = 0; i < size; ++i )
+			f->frame[i] = nullptr;
+		}
+
+	return f;
+	}
+
+void Frame::PopCallFrame(Frame* f)
+	{
+	if ( f->stack_slots && f->RefCnt() > 1 )
+		f->DetachSlots();
+
+	Unref(f);
+	}
+
+void Frame::DetachSlots()
+	{
+	Val** heap_frame = new Val*[size];
+
+	for ( int i = 0; i < size; ++i )
+		heap_frame[i] = frame[i];
+
+	pop_slots(frame, size);
+	frame = heap_frame;
+	stack_slots = false;
+	}
+
+void* Frame::operator new(size_t size)
+	{
+	if ( size != sizeof(Frame) || free_frames.empty() )
+		return ::operator new(size);
+
+	void* p = free_frames.back();
+	free_frames.pop_back();
+	return p;
+	}
+
+void Frame::operator delete(void* p, size_t size)
+	{
+	if ( size != sizeof(Frame) || free_frames.size() >= MAX_FREE_FRAMES )
+		{
+		::operator delete(p);
+		return;
+		}
+
+	free_frames.push_back(p);
+	}
+
 void Frame::AddFunctionWithClosureRef(BroFunc* func)
 	{
 	::Ref(func);
@@ -143,7 +266,13 @@ void Frame::Release()
 	for ( int i = 0; i < size; ++i )
 		UnrefElement(i);
 
-	delete [] frame;
+	if ( stack_slots )
+		pop_slots(frame, size);
+	else
+		delete [] frame;
+
+	frame = nullptr;
+	stack_slots = false;
 	}
 
 void Frame::Describe(ODesc* d) const
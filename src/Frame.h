@@ -33,6 +33,33 @@ public:
 	 */
 	virtual ~Frame() override;
 
+	/**
+	 * Returns a new frame for a call of *func*. Unlike the constructor,
+	 * this takes the frame's slots from a stack shared by all calls, so
+	 * that setting up a call doesn't need to allocate. Such frames must
+	 * be released through PopCallFrame(), in reverse order of creation.
+	 *
+	 * @param the size of the frame
+	 * @param func the function that is creating this frame
+	 * @param fn_args the arguments being passed to that function.
+	 */
+	static Frame* PushCallFrame(int size, const BroFunc* func,
+					const val_list* fn_args);
+
+	/**
+	 * Releases the caller's reference to a frame returned by
+	 * PushCallFrame(). If the frame is still referenced elsewhere, its
+	 * slots move to the heap first so that it can outlive the call.
+	 *
+	 * @param f the frame to release.
+	 */
+	static void PopCallFrame(Frame* f);
+
+	// Frames are allocated and deleted once per function call, so we
+	// keep a pool of them.
+	static void* operator new(size_t size);
+	static void operator delete(void* p, size_t size);
+
 	/**
 	 * @param n the index to get.
 	 * @return the value at index *n* of the underlying array.
@@ -241,6 +268,9 @@ private:
 		Unref(frame[n]);
 		}
 
+	/** Moves the frame's slots from the call stack to the heap. */
+	void DetachSlots();
+
 	/** Have we captured this id? */
 	bool IsOuterID(const ID* in) const;
 
@@ -266,6 +296,9 @@ private:
 	/** Associates ID's offsets with values. */
 	Val** frame;
 
+	/** True if *frame* lives on the call stack of PushCallFrame(). */
+	bool stack_slots = false;
+
 	/** Values that are weakly referenced by the frame.  Used to
 	 * prevent circular reference memory leaks in lambda/closures */
 	bool* weak_refs = nullptr;
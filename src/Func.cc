@@ -38,6 +38,7 @@
 #include "NetVar.h"
 #include "File.h"
 #include "Func.h"
+#include "Bytecode.h"
 #include "Frame.h"
 #include "Var.h"
 #include "analyzer/protocol/login/Login.h"
@@ -288,6 +289,8 @@ BroFunc::~BroFunc()
 	std::for_each(bodies.begin(), bodies.end(),
 		[](Body& b) { Unref(b.stmts); });
 
+	ClearCompiledBodies();
+
 	if ( ! weak_closure_ref )
 		Unref(closure);
 	}
@@ -328,7 +331,7 @@ Val* BroFunc::Call(val_list* args, Frame* parent) const
 		return Flavor() == FUNC_FLAVOR_HOOK ? val_mgr->GetTrue() : 0;
 		}
 
-	Frame* f = new Frame(frame_size, this, args);
+	Frame* f = Frame::PushCallFrame(frame_size, this, args);
 
 	if ( closure )
 		f->CaptureClosure(closure, outer_ids);
@@ -340,6 +343,14 @@ Val* BroFunc::Call(val_list* args, Frame* parent) const
 		f->SetCall(parent->GetCall());
 		}
 
+	// The debugger needs to see the statements getting executed, and
+	// suspending calls inside triggers relies on the AST.
+	bool use_bytecode = compile_script_functions && ! closure &&
+			    ! f->GetTrigger() && ! g_policy_debug;
+
+	if ( use_bytecode && ! bodies_compiled )
+		CompileBodies();
+
 	g_frame_stack.push_back(f);	// used for backtracing
 	const CallExpr* call_expr = parent ? parent->GetCall() : nullptr;
 	call_stack.emplace_back(CallInfo{call_expr, this, args});
@@ -356,8 +367,11 @@ Val* BroFunc::Call(val_list* args, Frame* parent) const
 	stmt_flow_type flow = FLOW_NEXT;
 	Val* result = 0;
 
-	for ( const auto& body : bodies )
+	for ( size_t i = 0; i < bodies.size(); ++i )
 		{
+		const Body& body = bodies[i];
+		const BytecodeBody* code = use_bytecode ? compiled_bodies[i] : 0;
+
 		if ( sample_logger )
 			sample_logger->LocationSeen(
 				body.stmts->GetLocationInfo());
@@ -381,7 +395,10 @@ Val* BroFunc::Call(val_list* args, Frame* parent) const
 
 		try
 			{
-			result = body.stmts->Exec(f, flow);
+			if ( code )
+				result = code->Exec(f, flow);
+			else
+				result = body.stmts->Exec(f, flow);
 			}
 
 		catch ( InterpreterException& e )
@@ -391,7 +408,7 @@ Val* BroFunc::Call(val_list* args, Frame* parent) const
 				{
 				g_frame_stack.pop_back();
 				call_stack.pop_back();
-				Unref(f);
+				Frame::PopCallFrame(f);
 				// Result not set b/c exception was thrown
 				throw;
 				}
@@ -456,7 +473,7 @@ Val* BroFunc::Call(val_list* args, Frame* parent) const
 
 	g_frame_stack.pop_back();
 
-	Unref(f);
+	Frame::PopCallFrame(f);
 
 	return result;
 	}
@@ -484,6 +501,25 @@ void BroFunc::AddBody(Stmt* new_body, id_list* new_inits,
 
 	bodies.push_back(b);
 	sort(bodies.begin(), bodies.end());
+
+	ClearCompiledBodies();
+	}
+
+void BroFunc::CompileBodies() const
+	{
+	for ( const auto& body : bodies )
+		compiled_bodies.push_back(BytecodeBody::Compile(body.stmts));
+
+	bodies_compiled = true;
+	}
+
+void BroFunc::ClearCompiledBodies()
+	{
+	for ( auto code : compiled_bodies )
+		delete code;
+
+	compiled_bodies.clear();
+	bodies_compiled = false;
 	}
 
 void BroFunc::AddClosure(id_list ids, Frame* f)
@@ -770,6 +806,8 @@ void init_builtin_funcs()
 	ThreadStats = internal_type("ThreadStats")->AsRecordType();
 	BrokerStats = internal_type("BrokerStats")->AsRecordType();
 	ReporterStats = internal_type("ReporterStats")->AsRecordType();
+	AllocStats = internal_type("AllocStats")->AsRecordType();
+	PoolAllocStats = internal_type("PoolAllocStats")->AsRecordType();
 
 	var_sizes = internal_type("var_sizes")->AsTableType();
 
@@ -21,6 +21,7 @@ class Stmt;
 class Frame;
 class ID;
 class CallExpr;
+class BytecodeBody;
 
 class Func : public BroObj {
 public:
@@ -154,9 +155,19 @@ protected:
 	 */
 	void SetClosureFrame(Frame* f);
 
+	// Compiles all bodies into bytecode, or discards the compiled
+	// versions.  See Bytecode.h.
+	void CompileBodies() const;
+	void ClearCompiledBodies();
+
 private:
 	size_t frame_size;
 
+	// Bytecode for the bodies, in the same order; null for those that
+	// run from the AST.  Compiled on first use.
+	mutable std::vector<BytecodeBody*> compiled_bodies;
+	mutable bool bodies_compiled = false;
+
 	// List of the outer IDs used in the function.
 	id_list outer_ids;
 	// The frame the BroFunc was initialized in.
@@ -10,6 +10,7 @@
 #include "BroString.h"
 #include "Hash.h"
 #include "util.h"
+#include "net_util.h"
 #include "Type.h"
 #include "threading/SerialTypes.h"
 
@@ -363,6 +364,8 @@ public:
 	void ConvertToThreadingValue(threading::Value::addr_t* v) const;
 
 	friend HashKey* BuildConnIDHashKey(const ConnID& id);
+	friend struct ConnIDKey BuildConnIDKey(const ConnID& id,
+	                                       TransportProto proto);
 
 	unsigned int MemoryAllocation() const { return padded_sizeof(*this); }
 
@@ -484,6 +487,37 @@ inline void IPAddr::ConvertToThreadingValue(threading::Value::addr_t* v) const
 	}
 	}
 
+/**
+ * A connection's canonical 5-tuple in flat, fixed-size form: the smaller
+ * of <src addr, src port> and <dst addr, dst port> followed by the other,
+ * plus the transport protocol.  Being plain bytes, it can be hashed and
+ * compared with memcmp() without any allocation.
+ */
+struct ConnIDKey {
+	in6_addr ip1;
+	in6_addr ip2;
+	uint16 port1;
+	uint16 port2;
+	uint8 transport;
+	uint8 pad[3];	// always zero, so that the whole struct compares
+
+	/**
+	 * Number of bytes that carry information.
+	 */
+	static const int DATA_SIZE = 37;
+
+	bool operator==(const ConnIDKey& other) const
+		{ return memcmp(this, &other, sizeof(*this)) == 0; }
+
+	bool operator!=(const ConnIDKey& other) const
+		{ return ! (*this == other); }
+};
+
+/**
+ * Returns the flat key for a given ConnID.
+ */
+ConnIDKey BuildConnIDKey(const ConnID& id, TransportProto proto);
+
 /**
   * Returns a hash key for a given ConnID. Passes ownership to caller.
   */
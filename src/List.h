@@ -37,7 +37,7 @@ public:
 	const int DEFAULT_LIST_SIZE = 10;
 	const int LIST_GROWTH_FACTOR = 2;
 
-	~List()		{ free(entries); }
+	~List()		{ FreeEntries(entries, max_entries); }
 	explicit List(int size = 0)
 		{
 		num_entries = 0;
@@ -51,7 +51,7 @@ public:
 
 		max_entries = size;
 
-		entries = (T*) safe_malloc(max_entries * sizeof(T));
+		entries = AllocEntries(max_entries);
 		}
 
 	List(const List& b)
@@ -60,7 +60,7 @@ public:
 		num_entries = b.num_entries;
 
 		if ( max_entries )
-			entries = (T*) safe_malloc(max_entries * sizeof(T));
+			entries = AllocEntries(max_entries);
 		else
 			entries = nullptr;
 
@@ -81,7 +81,7 @@ public:
 	List(const T* arr, int n)
 		{
 		num_entries = max_entries = n;
-		entries = (T*) safe_malloc(max_entries * sizeof(T));
+		entries = AllocEntries(max_entries);
 		memcpy(entries, arr, n * sizeof(T));
 		}
 
@@ -92,13 +92,13 @@ public:
 		if ( this == &b )
 			return *this;
 
-		free(entries);
+		FreeEntries(entries, max_entries);
 
 		max_entries = b.max_entries;
 		num_entries = b.num_entries;
 
 		if ( max_entries )
-			entries = (T *) safe_malloc(max_entries * sizeof(T));
+			entries = AllocEntries(max_entries);
 		else
 			entries = nullptr;
 
@@ -113,7 +113,7 @@ public:
 		if ( this == &b )
 			return *this;
 
-		free(entries);
+		FreeEntries(entries, max_entries);
 		entries = b.entries;
 		num_entries = b.num_entries;
 		max_entries = b.max_entries;
@@ -131,7 +131,7 @@ public:
 
 	void clear()		// remove all entries
 		{
-		free(entries);
+		FreeEntries(entries, max_entries);
 		entries = nullptr;
 		num_entries = max_entries = 0;
 		}
@@ -145,7 +145,7 @@ public:
 
 		if ( new_size != max_entries )
 			{
-			entries = (T*) safe_realloc((void*) entries, sizeof(T) * new_size);
+			entries = ReallocEntries(entries, max_entries, new_size);
 			if ( entries )
 				max_entries = new_size;
 			else
@@ -331,6 +331,16 @@ protected:
 	//    advantage of realloc's ability to contract in-place, it would
 	//    allocate-and-copy.
 
+	// Where the entries array comes from.  Lists of particular types
+	// can specialize these to manage their memory themselves (see
+	// val_list).
+	static T* AllocEntries(int n)
+		{ return (T*) safe_malloc(n * sizeof(T)); }
+	static T* ReallocEntries(T* e, int old_n, int new_n)
+		{ return (T*) safe_realloc((void*) e, new_n * sizeof(T)); }
+	static void FreeEntries(T* e, int n)
+		{ free(e); }
+
 	T* entries;
 	int max_entries;
 	int num_entries;
@@ -340,10 +340,10 @@ void net_run()
 			// us a lot of idle time, but doesn't delay near-term
 			// timers too much.  (Delaying them somewhat is okay,
 			// since Bro timers are not high-precision anyway.)
+			// With communication, the IOSource manager already
+			// waits for Broker's fds to become ready.
 			if ( ! communication_enabled )
 				usleep(100000);
-			else
-				usleep(1000);
 
 			// Flawfinder says about usleep:
 			//
@@ -412,7 +412,12 @@ void net_get_final_stats()
 		if ( ps->IsLive() )
 			{
 			iosource::PktSrc::Stats s;
-			ps->Statistics(&s);
+
+				{
+				std::lock_guard<std::mutex> lock(ps->SourceMutex());
+				ps->Statistics(&s);
+				}
+
 			reporter->Info("%" PRIu64 " packets received on interface %s, %" PRIu64 " dropped",
 					s.received, ps->Path().c_str(), s.dropped);
 			}
@@ -157,6 +157,7 @@ double gap_report_freq;
 int packet_filter_default;
 
 int sig_max_group_size;
+bro_uint_t max_dfa_state_mem;
 
 TableType* irc_join_list;
 RecordType* irc_join_info;
@@ -170,6 +171,8 @@ TableVal* likely_server_ports;
 
 int check_for_unused_event_handlers;
 
+int compile_script_functions;
+
 int suppress_local_output;
 
 double timer_mgr_inactivity_timeout;
@@ -216,10 +219,13 @@ void init_general_global_var()
 	packet_filter_default = opt_internal_int("packet_filter_default");
 
 	sig_max_group_size = opt_internal_int("sig_max_group_size");
+	max_dfa_state_mem = opt_internal_unsigned("max_dfa_state_mem");
 
 	check_for_unused_event_handlers =
 		opt_internal_int("check_for_unused_event_handlers");
 
+	compile_script_functions = opt_internal_int("compile_script_functions");
+
 	suppress_local_output = opt_internal_int("suppress_local_output");
 
 	trace_output_file = internal_val("trace_output_file")->AsStringVal();
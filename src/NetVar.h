@@ -159,6 +159,7 @@ extern int load_sample_freq;
 extern int packet_filter_default;
 
 extern int sig_max_group_size;
+extern bro_uint_t max_dfa_state_mem;
 
 extern TableType* irc_join_list;
 extern RecordType* irc_join_info;
@@ -172,6 +173,8 @@ extern TableVal* likely_server_ports;
 
 extern int check_for_unused_event_handlers;
 
+extern int compile_script_functions;
+
 extern int suppress_local_output;
 
 extern double timer_mgr_inactivity_timeout;
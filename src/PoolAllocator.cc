@@ -0,0 +1,40 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "PoolAllocator.h"
+
+PoolAllocator* PoolAllocator::pools = nullptr;
+
+void PoolAllocator::NewSlab()
+	{
+	if ( ! registered )
+		{
+		next = pools;
+		pools = this;
+		registered = true;
+		}
+
+	size_t n = SlotsPerSlab();
+
+	slab = static_cast<char*>(::operator new(n * slot_size));
+	slab_left = n;
+	++num_slabs;
+	}
+
+size_t PoolAllocator::SlotsPerSlab() const
+	{
+	// Classes too large for a slab of the default size still get a few
+	// objects per slab.
+	size_t n = SLAB_SIZE / slot_size;
+	return n < 16 ? 16 : n;
+	}
+
+void PoolAllocator::GetStats(Stats* s) const
+	{
+	s->name = name;
+	s->size = obj_size;
+	s->allocs = allocs;
+	s->in_use = allocs - frees;
+	s->free = num_free;
+	s->bytes = num_slabs * SlotsPerSlab() * slot_size;
+	s->heap_allocs = heap_allocs;
+	}
@@ -0,0 +1,171 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#ifndef pool_allocator_h
+#define pool_allocator_h
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+/**
+ * Allocates objects of a single class from slabs, keeping the memory of
+ * deleted objects on a free list for reuse. This avoids the overhead of
+ * going through malloc() for classes whose instances come and go at a high
+ * rate, and keeps them from fragmenting the heap.
+ *
+ * Memory given to a pool is never returned to the system, so its footprint
+ * is that of the largest number of objects alive at any one time. Pools
+ * aren't thread-safe; they are meant for objects that only the main thread
+ * creates, like values.
+ *
+ * Classes use a pool through DECLARE_POOL_ALLOCATOR and
+ * DEFINE_POOL_ALLOCATOR.
+ */
+class PoolAllocator {
+public:
+	/**
+	 * Constructs a pool. Pools are meant to be static objects; the
+	 * constructor is constexpr so that they're ready before any code runs.
+	 *
+	 * @param arg_name the name of the pool's class, for statistics.
+	 *
+	 * @param arg_size the size of the pool's class.
+	 */
+	constexpr PoolAllocator(const char* arg_name, size_t arg_size)
+		: name(arg_name), obj_size(arg_size),
+		  slot_size(round_up(arg_size)), free_list(nullptr),
+		  slab(nullptr), slab_left(0), num_slabs(0), num_free(0),
+		  allocs(0), frees(0), heap_allocs(0), next(nullptr),
+		  registered(false)
+		{ }
+
+	/**
+	 * Allocates memory for an object. Requests for anything other than
+	 * the pool's class, such as subclasses without a pool of their own,
+	 * go to the heap.
+	 */
+	void* Alloc(size_t size)
+		{
+		if ( size != obj_size )
+			{
+			++heap_allocs;
+			return ::operator new(size);
+			}
+
+		++allocs;
+
+		if ( free_list )
+			{
+			FreeSlot* s = free_list;
+			free_list = s->next;
+			--num_free;
+			return s;
+			}
+
+		if ( ! slab_left )
+			NewSlab();
+
+		void* p = slab;
+		slab += slot_size;
+		--slab_left;
+		return p;
+		}
+
+	/**
+	 * Releases memory obtained from Alloc().
+	 */
+	void Free(void* p, size_t size)
+		{
+		if ( size != obj_size )
+			{
+			::operator delete(p);
+			return;
+			}
+
+		++frees;
+
+		FreeSlot* s = static_cast<FreeSlot*>(p);
+		s->next = free_list;
+		free_list = s;
+		++num_free;
+		}
+
+	struct Stats {
+		const char* name;	// Name of the pool's class.
+		size_t size;	// Size of an object.
+		uint64_t allocs;	// Objects allocated from the pool so far.
+		uint64_t in_use;	// Objects currently allocated.
+		uint64_t free;	// Objects on the free list.
+		uint64_t bytes;	// Memory held by the pool.
+		uint64_t heap_allocs;	// Requests passed on to the heap.
+	};
+
+	void GetStats(Stats* s) const;
+
+	/**
+	 * @return the first of all pools that have allocated an object so
+	 * far. Use NextPool() to iterate over the rest.
+	 */
+	static const PoolAllocator* FirstPool()	{ return pools; }
+	const PoolAllocator* NextPool() const	{ return next; }
+
+private:
+	struct FreeSlot {
+		FreeSlot* next;
+	};
+
+	static constexpr size_t round_up(size_t size)
+		{
+		return size < sizeof(FreeSlot) ? sizeof(FreeSlot) :
+			(size + alignof(std::max_align_t) - 1) /
+			alignof(std::max_align_t) * alignof(std::max_align_t);
+		}
+
+	// Allocates a new slab, and registers the pool the first time.
+	void NewSlab();
+
+	size_t SlotsPerSlab() const;
+
+	static const size_t SLAB_SIZE = 64 * 1024;
+
+	const char* name;
+	size_t obj_size;
+	size_t slot_size;
+
+	FreeSlot* free_list;
+	char* slab;	// Next unused slot of the current slab.
+	size_t slab_left;	// Number of unused slots in the current slab.
+	size_t num_slabs;
+	size_t num_free;
+
+	uint64_t allocs;
+	uint64_t frees;
+	uint64_t heap_allocs;
+
+	PoolAllocator* next;
+	bool registered;
+
+	static PoolAllocator* pools;
+};
+
+/**
+ * Declares class-specific operators new and delete that allocate instances
+ * from a PoolAllocator of the class's own. Subclasses that don't declare
+ * a pool themselves inherit these, but since their instances are larger,
+ * those end up on the heap.
+ */
+#define DECLARE_POOL_ALLOCATOR(cls) \
+	static void* operator new(size_t size) \
+		{ return pool_allocator.Alloc(size); } \
+	static void operator delete(void* p, size_t size) \
+		{ pool_allocator.Free(p, size); } \
+	static PoolAllocator pool_allocator;
+
+/**
+ * Defines the pool declared by DECLARE_POOL_ALLOCATOR. Goes into the
+ * class's implementation file.
+ */
+#define DEFINE_POOL_ALLOCATOR(cls) \
+	PoolAllocator cls::pool_allocator(#cls, sizeof(cls));
+
+#endif
@@ -294,6 +294,11 @@ void Specific_RE_Matcher::Dump(FILE* f)
 	dfa->Dump(f);
 	}
 
+RE_Match_State::~RE_Match_State()
+	{
+	Unref(held_state);
+	}
+
 inline void RE_Match_State::AddMatches(const AcceptingSet& as,
                                        MatchPos position)
 	{
@@ -332,9 +337,14 @@ bool RE_Match_State::Match(const u_char* bv, int n,
 
 	size_t old_matches = accepted_matches.size();
 
+	// After this many transitions of a state back to itself, we check
+	// whether it's worth skipping ahead in it.
+	const int accel_min_loops = 16;
+
 	int ec;
 	int m = bol ? n + 1 : n;
 	int e = eol ? -1 : 0;
+	int loops = 0;
 
 	while ( --m >= e )
 		{
@@ -343,7 +353,21 @@ bool RE_Match_State::Match(const u_char* bv, int n,
 		else if ( m == -1 )
 			ec = ecs[SYM_EOL];
 		else
+			{
+			// Bytes that keep us in a non-accepting state don't
+			// need to go through the DFA individually.
+			int skip = current_state->LoopingBytes(bv, bv + m + 1);
+
+			if ( skip > 0 )
+				{
+				bv += skip;
+				current_pos += skip;
+				m -= skip - 1;
+				continue;
+				}
+
 			ec = ecs[*(bv++)];
+			}
 
 		DFA_State* next_state = current_state->Xtion(ec,dfa);
 
@@ -360,9 +384,25 @@ bool RE_Match_State::Match(const u_char* bv, int n,
 
 		++current_pos;
 
+		if ( next_state != current_state )
+			loops = 0;
+
+		else if ( ++loops == accel_min_loops &&
+			  ! current_state->AccelComputed() )
+			current_state->ComputeAccel(dfa);
+
 		current_state = next_state;
 		}
 
+	if ( current_state != held_state )
+		{
+		if ( current_state )
+			Ref(current_state);
+
+		Unref(held_state);
+		held_state = current_state;
+		}
+
 	return accepted_matches.size() != old_matches;
 	}
 
@@ -137,8 +137,11 @@ public:
 		ecs = matcher->EC()->EquivClasses();
 		current_pos = -1;
 		current_state = 0;
+		held_state = 0;
 		}
 
+	~RE_Match_State();
+
 	const AcceptingMatchSet& AcceptedMatches() const
 		{ return accepted_matches; }
 
@@ -165,6 +168,10 @@ protected:
 	AcceptingMatchSet accepted_matches;
 	DFA_State* current_state;
 	int current_pos;
+
+	// The state we keep a reference to between calls to Match(), so
+	// that the DFA's cache doesn't evict it.
+	DFA_State* held_state;
 };
 
 class RE_Matcher {
@@ -1,6 +1,7 @@
 // See the file "COPYING" in the main distribution directory for copyright.
 
 #include <algorithm>
+#include <cstddef>
 #include <vector>
 
 #include "zeek-config.h"
@@ -9,13 +10,127 @@
 
 static const bool DEBUG_reassem = false;
 
+namespace {
+
+// Blocks are allocated in power-of-two sized chunks, from MIN_CHUNK_SIZE
+// up to MIN_CHUNK_SIZE << (NUM_CHUNK_CLASSES - 1), which covers a
+// full-sized Ethernet segment. Freed chunks go onto per-thread free lists
+// for reuse, up to MAX_CACHED_BYTES per size class. Larger blocks come
+// straight from malloc().
+const size_t MIN_CHUNK_SIZE = 128;
+const int NUM_CHUNK_CLASSES = 6;
+const size_t MAX_CACHED_BYTES = 1024 * 1024;
+
+// Precedes each chunk.
+union ChunkHeader {
+	int chunk_class;	// NUM_CHUNK_CLASSES if not cached
+	std::max_align_t align;
+};
+
+struct FreeChunk {
+	FreeChunk* next;
+};
+
+class ChunkCache {
+public:
+	ChunkCache()
+		{
+		for ( int i = 0; i < NUM_CHUNK_CLASSES; ++i )
+			{
+			free_chunks[i] = 0;
+			num_free[i] = 0;
+			}
+		}
+
+	~ChunkCache()
+		{
+		for ( int i = 0; i < NUM_CHUNK_CLASSES; ++i )
+			{
+			while ( free_chunks[i] )
+				{
+				FreeChunk* c = free_chunks[i];
+				free_chunks[i] = c->next;
+				free(c);
+				}
+			}
+		}
+
+	void* Get(size_t size)
+		{
+		size += sizeof(ChunkHeader);
+
+		int cls = 0;
+		while ( cls < NUM_CHUNK_CLASSES && (MIN_CHUNK_SIZE << cls) < size )
+			++cls;
+
+		ChunkHeader* h;
+
+		if ( cls < NUM_CHUNK_CLASSES && free_chunks[cls] )
+			{
+			FreeChunk* c = free_chunks[cls];
+			free_chunks[cls] = c->next;
+			--num_free[cls];
+			h = reinterpret_cast<ChunkHeader*>(c);
+			}
+
+		else if ( cls < NUM_CHUNK_CLASSES )
+			h = (ChunkHeader*) safe_malloc(MIN_CHUNK_SIZE << cls);
+		else
+			h = (ChunkHeader*) safe_malloc(size);
+
+		h->chunk_class = cls;
+		return h + 1;
+		}
+
+	void Put(void* p)
+		{
+		ChunkHeader* h = static_cast<ChunkHeader*>(p) - 1;
+		int cls = h->chunk_class;
+
+		if ( cls == NUM_CHUNK_CLASSES ||
+		     num_free[cls] * (MIN_CHUNK_SIZE << cls) >= MAX_CACHED_BYTES )
+			{
+			free(h);
+			return;
+			}
+
+		FreeChunk* c = reinterpret_cast<FreeChunk*>(h);
+		c->next = free_chunks[cls];
+		free_chunks[cls] = c;
+		++num_free[cls];
+		}
+
+private:
+	FreeChunk* free_chunks[NUM_CHUNK_CLASSES];
+	size_t num_free[NUM_CHUNK_CLASSES];
+};
+
+thread_local ChunkCache chunk_cache;
+
+}
+
+void* DataBlock::operator new(size_t n, uint64 payload_size)
+	{
+	return chunk_cache.Get(n + payload_size);
+	}
+
+void DataBlock::operator delete(void* p, uint64 payload_size)
+	{
+	chunk_cache.Put(p);
+	}
+
+void DataBlock::operator delete(void* p)
+	{
+	chunk_cache.Put(p);
+	}
+
 DataBlock::DataBlock(Reassembler* reass, const u_char* data,
                      uint64 size, uint64 arg_seq, DataBlock* arg_prev,
                      DataBlock* arg_next, ReassemblerType reassem_type)
 	{
 	seq = arg_seq;
 	upper = seq + size;
-	block = new u_char[size];
+	block = reinterpret_cast<u_char*>(this + 1);
 
 	memcpy((void*) block, (const void*) data, size);
 
@@ -71,7 +186,9 @@ void Reassembler::CheckOverlap(DataBlock *head, DataBlock *tail,
 		const u_char* ndata = data;
 
 		if ( nupper <= b->seq )
-			continue;
+			// Blocks are sorted, none of the remaining ones
+			// can overlap either.
+			break;
 
 		if ( nseq >= b->upper )
 			continue;
@@ -106,7 +223,9 @@ void Reassembler::NewBlock(double t, uint64 seq, uint64 len, const u_char* data)
 		// Old data, don't do any work for it.
 		return;
 
-	CheckOverlap(blocks, last_block, seq, len, data);
+	if ( blocks && seq != last_block->upper )
+		// Only blocks ending beyond seq can overlap.
+		CheckOverlap(FindBlock(seq), last_block, seq, len, data);
 
 	if ( seq < trim_seq )
 		{ // Partially old data, just keep the good stuff.
@@ -121,7 +240,7 @@ void Reassembler::NewBlock(double t, uint64 seq, uint64 len, const u_char* data)
 
 	if ( ! blocks )
 		blocks = last_block = start_block =
-			new DataBlock(this, data, len, seq, 0, 0, rtype);
+			InsertBlock(data, len, seq, 0, 0);
 	else
 		start_block = AddAndCheck(blocks, seq, upper_seq, data);
 
@@ -156,8 +275,12 @@ uint64 Reassembler::TrimToSeq(uint64 seq)
 		Undelivered(seq);
 		}
 
+	size_t num_trimmed = 0;
+
 	while ( blocks && blocks->upper <= seq )
 		{
+		++num_trimmed;
+
 		DataBlock* b = blocks->next;
 
 		if ( b && b->seq <= seq )
@@ -208,6 +331,8 @@ uint64 Reassembler::TrimToSeq(uint64 seq)
 		blocks = b;
 		}
 
+	block_index.erase(block_index.begin(), block_index.begin() + num_trimmed);
+
 	if ( blocks )
 		{
 		blocks->prev = 0;
@@ -238,6 +363,7 @@ void Reassembler::ClearBlocks()
 		}
 
 	last_block = 0;
+	block_index.clear();
 	}
 
 void Reassembler::ClearOldBlocks()
@@ -280,22 +406,20 @@ DataBlock* Reassembler::AddAndCheck(DataBlock* b, uint64 seq, uint64 upper,
 	// Special check for the common case of appending to the end.
 	if ( last_block && seq == last_block->upper )
 		{
-		last_block = new DataBlock(this, data, upper - seq,
-		                           seq, last_block, 0, rtype);
+		last_block = InsertBlock(data, upper - seq, seq, last_block, 0);
 		return last_block;
 		}
 
 	// Find the first block that doesn't come completely before the
 	// new data.
-	while ( b->next && b->upper <= seq )
-		b = b->next;
+	if ( b->upper <= seq )
+		b = FindBlock(seq);
 
 	if ( b->upper <= seq )
 		{
 		// b is the last block, and it comes completely before
 		// the new block.
-		last_block = new DataBlock(this, data, upper - seq,
-		                           seq, b, 0, rtype);
+		last_block = InsertBlock(data, upper - seq, seq, b, 0);
 		return last_block;
 		}
 
@@ -304,8 +428,7 @@ DataBlock* Reassembler::AddAndCheck(DataBlock* b, uint64 seq, uint64 upper,
 	if ( upper <= b->seq )
 		{
 		// The new block comes completely before b.
-		new_b = new DataBlock(this, data, upper - seq, seq,
-		                      b->prev, b, rtype);
+		new_b = InsertBlock(data, upper - seq, seq, b->prev, b);
 		if ( b == blocks )
 			blocks = new_b;
 		return new_b;
@@ -316,8 +439,7 @@ DataBlock* Reassembler::AddAndCheck(DataBlock* b, uint64 seq, uint64 upper,
 		{
 		// The new block has a prefix that comes before b.
 		uint64 prefix_len = b->seq - seq;
-		new_b = new DataBlock(this, data, prefix_len, seq,
-		                      b->prev, b, rtype);
+		new_b = InsertBlock(data, prefix_len, seq, b->prev, b);
 		if ( b == blocks )
 			blocks = new_b;
 
@@ -351,6 +473,34 @@ DataBlock* Reassembler::AddAndCheck(DataBlock* b, uint64 seq, uint64 upper,
 	return new_b;
 	}
 
+DataBlock* Reassembler::FindBlock(uint64 seq) const
+	{
+	auto it = std::upper_bound(block_index.begin(), block_index.end(), seq,
+	                           [](uint64 s, const DataBlock* b)
+	                           { return s < b->upper; });
+
+	return it != block_index.end() ? *it : last_block;
+	}
+
+DataBlock* Reassembler::InsertBlock(const u_char* data, uint64 size,
+                                    uint64 seq, DataBlock* prev,
+                                    DataBlock* next)
+	{
+	DataBlock* b = new (size) DataBlock(this, data, size, seq, prev, next, rtype);
+
+	if ( ! next )
+		block_index.push_back(b);
+	else
+		{
+		auto it = std::lower_bound(block_index.begin(), block_index.end(), seq,
+		                           [](const DataBlock* b, uint64 s)
+		                           { return b->seq < s; });
+		block_index.insert(it, b);
+		}
+
+	return b;
+	}
+
 uint64 Reassembler::MemoryAllocation(ReassemblerType rtype)
 	{
 	return Reassembler::sizes[rtype];
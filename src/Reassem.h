@@ -3,6 +3,8 @@
 #ifndef reassem_h
 #define reassem_h
 
+#include <vector>
+
 #include "Obj.h"
 #include "IPAddr.h"
 
@@ -20,6 +22,9 @@ enum ReassemblerType {
 
 class Reassembler;
 
+// A DataBlock and its payload share a single allocation, which comes from
+// per-thread caches of fixed-size chunks. Create them with
+// "new (size) DataBlock(...)", passing the payload size twice.
 class DataBlock {
 public:
 	DataBlock(Reassembler* reass, const u_char* data,
@@ -29,6 +34,10 @@ public:
 
 	~DataBlock();
 
+	static void* operator new(size_t n, uint64 payload_size);
+	static void operator delete(void* p, uint64 payload_size);
+	static void operator delete(void* p);
+
 	uint64 Size() const	{ return upper - seq; }
 
 	DataBlock* next;	// next block with higher seq #
@@ -86,9 +95,21 @@ protected:
 	void CheckOverlap(DataBlock *head, DataBlock *tail,
 				uint64 seq, uint64 len, const u_char* data);
 
+	// Returns the first block in the list that ends beyond seq, or the
+	// last block if there's none.
+	DataBlock* FindBlock(uint64 seq) const;
+
+	// Creates a block and adds it to both the list and the index.
+	DataBlock* InsertBlock(const u_char* data, uint64 size, uint64 seq,
+				DataBlock* prev, DataBlock* next);
+
 	DataBlock* blocks;
 	DataBlock* last_block;
 
+	// The blocks of the list above, sorted by sequence number for
+	// binary searching.
+	std::vector<DataBlock*> block_index;
+
 	DataBlock* old_blocks;
 	DataBlock* last_old_block;
 
@@ -109,7 +130,6 @@ inline DataBlock::~DataBlock()
 	reassembler->size_of_all_blocks -= Size();
 	Reassembler::total_size -= pad_size(upper - seq) + padded_sizeof(DataBlock);
 	Reassembler::sizes[rtype] -= pad_size(upper - seq) + padded_sizeof(DataBlock);
-	delete [] block;
 	}
 
 #endif
@@ -1,6 +1,10 @@
 #include <algorithm>
 #include <functional>
 
+#include <errno.h>
+#include <stdio.h>
+#include <unistd.h>
+
 #include "zeek-config.h"
 
 #include "analyzer/Analyzer.h"
@@ -10,6 +14,7 @@
 #include "Scope.h"
 #include "File.h"
 #include "Reporter.h"
+#include "digest.h"
 
 // FIXME: Things that are not fully implemented/working yet:
 //
@@ -427,6 +432,169 @@ void RuleMatcher::BuildPatternSets(RuleHdrTest::pattern_set_list* dst,
 		}
 	}
 
+void RuleMatcher::CollectMatchers(RuleHdrTest* hdr_test,
+				keyed_matcher_list* matchers)
+	{
+	for ( int i = 0; i < Rule::TYPES; ++i )
+		{
+		for ( const auto& set : hdr_test->psets[i] )
+			{
+			if ( ! set->re->DFA() )
+				continue;
+
+			string text = fmt("%d", i);
+
+			loop_over_list(set->patterns, j)
+				{
+				text += '\0';
+				text += set->patterns[j];
+				text += '\0';
+				text += std::to_string(set->ids[j]);
+				}
+
+			u_char digest[16];
+			internal_md5((const u_char*) text.data(), text.size(), digest);
+
+			matchers->push_back(std::make_pair(
+				string((const char*) digest, sizeof(digest)), set->re));
+			}
+		}
+
+	for ( RuleHdrTest* h = hdr_test->child; h; h = h->sibling )
+		CollectMatchers(h, matchers);
+	}
+
+// The DFA cache file starts with the magic string, followed by a record
+// for each pattern group: the key CollectMatchers() computed for it, the
+// length of the data, and the data written by DFA_Machine::Save().
+static const char dfa_cache_magic[] = "ZEEKDFA1";
+static const size_t dfa_cache_key_len = 16;
+
+void RuleMatcher::LoadDFAs(const char* file)
+	{
+	dfa_cache_file = file;
+
+	FILE* f = fopen(file, "r");
+
+	if ( ! f )
+		{
+		if ( errno != ENOENT )
+			reporter->Warning("can't open DFA cache %s: %s", file,
+			                  strerror(errno));
+		return;
+		}
+
+	string buf;
+	char chunk[65536];
+	size_t n;
+
+	while ( (n = fread(chunk, 1, sizeof(chunk), f)) > 0 )
+		buf.append(chunk, n);
+
+	fclose(f);
+
+	size_t magic_len = strlen(dfa_cache_magic);
+
+	if ( buf.compare(0, magic_len, dfa_cache_magic) != 0 )
+		{
+		reporter->Warning("ignoring DFA cache %s: unknown format", file);
+		return;
+		}
+
+	map<string, pair<size_t, uint32> > records;
+	size_t pos = magic_len;
+
+	while ( buf.size() - pos >= dfa_cache_key_len + sizeof(uint32) )
+		{
+		string key = buf.substr(pos, dfa_cache_key_len);
+		pos += dfa_cache_key_len;
+
+		uint32 len;
+		memcpy(&len, buf.data() + pos, sizeof(len));
+		pos += sizeof(len);
+
+		if ( len > buf.size() - pos )
+			break;
+
+		records[key] = std::make_pair(pos, len);
+		pos += len;
+		}
+
+	keyed_matcher_list matchers;
+	CollectMatchers(root, &matchers);
+
+	int loaded = 0;
+
+	for ( const auto& m : matchers )
+		{
+		auto r = records.find(m.first);
+
+		if ( r == records.end() )
+			continue;
+
+		const u_char* data = (const u_char*) buf.data() + r->second.first;
+
+		if ( m.second->DFA()->Load(data, r->second.second) )
+			++loaded;
+		}
+
+	DBG_LOG(DBG_RULES, "loaded DFA states for %d of %d pattern groups from %s",
+		loaded, int(matchers.size()), file);
+	}
+
+void RuleMatcher::SaveDFAs()
+	{
+	if ( dfa_cache_file.empty() )
+		return;
+
+	keyed_matcher_list matchers;
+	CollectMatchers(root, &matchers);
+
+	string buf = dfa_cache_magic;
+	set<string> saved;
+
+	for ( const auto& m : matchers )
+		{
+		// Identical groups on different nodes build identical DFAs;
+		// one of them will do.
+		if ( ! saved.insert(m.first).second )
+			continue;
+
+		string data;
+		m.second->DFA()->Save(&data);
+
+		uint32 len = data.size();
+		buf += m.first;
+		buf.append((const char*) &len, sizeof(len));
+		buf += data;
+		}
+
+	// Write to a temporary file first, so that concurrent readers
+	// (and writers) always see a complete file.
+	string tmp = fmt("%s.%d.tmp", dfa_cache_file.c_str(), getpid());
+
+	FILE* f = fopen(tmp.c_str(), "w");
+
+	if ( ! f )
+		{
+		reporter->Warning("can't write DFA cache %s: %s", tmp.c_str(),
+		                  strerror(errno));
+		return;
+		}
+
+	bool ok = fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+
+	if ( fclose(f) != 0 )
+		ok = false;
+
+	if ( ! ok || rename(tmp.c_str(), dfa_cache_file.c_str()) < 0 )
+		{
+		reporter->Warning("can't write DFA cache %s: %s",
+		                  dfa_cache_file.c_str(), strerror(errno));
+		unlink(tmp.c_str());
+		}
+	}
+
 // Get a 8/16/32-bit value from the given position in the packet header
 static inline uint32 getval(const u_char* data, int size)
 	{
@@ -1160,6 +1328,7 @@ void RuleMatcher::GetStats(Stats* stats, RuleHdrTest* hdr_test)
 		stats->mem = 0;
 		stats->hits = 0;
 		stats->misses = 0;
+		stats->evictions = 0;
 		stats->nfa_states = 0;
 		hdr_test = root;
 		}
@@ -1180,6 +1349,7 @@ void RuleMatcher::GetStats(Stats* stats, RuleHdrTest* hdr_test)
 			stats->mem += cstats.mem;
 			stats->hits += cstats.hits;
 			stats->misses += cstats.misses;
+			stats->evictions += cstats.evictions;
 			stats->nfa_states += cstats.nfa_states;
 			}
 		}
@@ -1197,8 +1367,8 @@ void RuleMatcher::DumpStats(BroFile* f)
 			"computed trans. = %d; matchers = %d; mem = %d\n",
 			network_time, stats.dfa_states, stats.computed,
 			stats.matchers, stats.mem));
-	f->Write(fmt("%.6f DFA cache hits = %d; misses = %d\n", network_time,
-			stats.hits, stats.misses));
+	f->Write(fmt("%.6f DFA cache hits = %d; misses = %d; evictions = %d\n",
+			network_time, stats.hits, stats.misses, stats.evictions));
 
 	DumpStateStats(f, root);
 	}
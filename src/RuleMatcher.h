@@ -224,6 +224,15 @@ public:
 	// Parse the given files and built up data structures.
 	bool ReadFiles(const name_list& files);
 
+	// Restores the DFA states that SaveDFAs() wrote to the given file,
+	// for all pattern groups that are still the same.  The file is
+	// remembered for SaveDFAs().
+	void LoadDFAs(const char* file);
+
+	// Writes the DFA states computed so far to the file given to
+	// LoadDFAs(), if any, replacing its contents.
+	void SaveDFAs();
+
 	/**
 	 * Inititialize a state object for matching file magic signatures.
 	 * @return A state object that can be used for file magic mime type
@@ -301,6 +310,7 @@ public:
 		// # cache hits (sampled, multiply by MOVE_TO_FRONT_SAMPLE_SIZE)
 		unsigned int hits;
 		unsigned int misses;	// # cache misses
+		unsigned int evictions;	// # DFA states evicted from caches
 	};
 
 	Val* BuildRuleStateValue(const Rule* rule,
@@ -327,6 +337,11 @@ private:
 	void BuildPatternSets(RuleHdrTest::pattern_set_list* dst,
 				const string_list& exprs, const int_list& ids);
 
+	// Collects the matchers of all pattern groups, along with a key
+	// identifying each group's patterns.
+	typedef std::vector<std::pair<string, Specific_RE_Matcher*> > keyed_matcher_list;
+	void CollectMatchers(RuleHdrTest* hdr_test, keyed_matcher_list* matchers);
+
 	// Check an arbitrary rule if it's satisfied right now.
 	// eos signals end of stream
 	void ExecRule(Rule* rule, RuleEndpointState* state, bool eos);
@@ -360,6 +375,7 @@ private:
 	RuleHdrTest* root;
 	rule_list rules;
 	rule_dict rules_by_id;
+	string dfa_cache_file;
 };
 
 // Keeps bi-directional matching-state.
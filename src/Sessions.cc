@@ -9,6 +9,10 @@
 #include <stdlib.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <vector>
+
+
 #include "Net.h"
 #include "Event.h"
 #include "Timer.h"
@@ -97,9 +101,6 @@ NetSessions::NetSessions()
 
 	Unref(t);
 
-	tcp_conns.SetDeleteFunc(bro_obj_delete_func);
-	udp_conns.SetDeleteFunc(bro_obj_delete_func);
-	icmp_conns.SetDeleteFunc(bro_obj_delete_func);
 	fragments.SetDeleteFunc(bro_obj_delete_func);
 
 	if ( stp_correlate_pair )
@@ -427,7 +428,7 @@ void NetSessions::DoNextPacket(double t, const Packet* pkt, const IP_Hdr* ip_hdr
 			}
 
 		if ( mobile_ipv6_message )
-			mgr.QueueEvent(mobile_ipv6_message, {ip_hdr->BuildPktHdrVal()});
+			mgr.QueueEventFast(mobile_ipv6_message, {ip_hdr->BuildPktHdrVal()});
 
 		if ( ip_hdr->NextProto() != IPPROTO_NONE )
 			Weird("mobility_piggyback", pkt, encapsulation);
@@ -445,7 +446,8 @@ void NetSessions::DoNextPacket(double t, const Packet* pkt, const IP_Hdr* ip_hdr
 	ConnID id;
 	id.src_addr = ip_hdr->SrcAddr();
 	id.dst_addr = ip_hdr->DstAddr();
-	Dictionary* d = 0;
+	ConnTable* d = 0;
+	TransportProto tproto = TRANSPORT_UNKNOWN;
 	BifEnum::Tunnel::Type tunnel_type = BifEnum::Tunnel::IP;
 
 	switch ( proto ) {
@@ -456,6 +458,7 @@ void NetSessions::DoNextPacket(double t, const Packet* pkt, const IP_Hdr* ip_hdr
 		id.dst_port = tp->th_dport;
 		id.is_one_way = 0;
 		d = &tcp_conns;
+		tproto = TRANSPORT_TCP;
 		break;
 		}
 
@@ -466,6 +469,7 @@ void NetSessions::DoNextPacket(double t, const Packet* pkt, const IP_Hdr* ip_hdr
 		id.dst_port = up->uh_dport;
 		id.is_one_way = 0;
 		d = &udp_conns;
+		tproto = TRANSPORT_UDP;
 		break;
 		}
 
@@ -482,6 +486,7 @@ void NetSessions::DoNextPacket(double t, const Packet* pkt, const IP_Hdr* ip_hdr
 		id.dst_port = htons(id.dst_port);
 
 		d = &icmp_conns;
+		tproto = TRANSPORT_ICMP;
 		break;
 		}
 
@@ -498,6 +503,7 @@ void NetSessions::DoNextPacket(double t, const Packet* pkt, const IP_Hdr* ip_hdr
 		id.dst_port = htons(id.dst_port);
 
 		d = &icmp_conns;
+		tproto = TRANSPORT_ICMP;
 		break;
 		}
 
@@ -736,30 +742,24 @@ void NetSessions::DoNextPacket(double t, const Packet* pkt, const IP_Hdr* ip_hdr
 		return;
 	}
 
-	HashKey* h = BuildConnIDHashKey(id);
-	if ( ! h )
-		reporter->InternalError("hash computation failed");
-
+	ConnIDKey key = BuildConnIDKey(id, tproto);
 	Connection* conn = 0;
 
 	// FIXME: The following is getting pretty complex. Need to split up
 	// into separate functions.
-	conn = (Connection*) d->Lookup(h);
+	conn = d->Lookup(key);
 	if ( ! conn )
 		{
-		conn = NewConn(h, t, &id, data, proto, ip_hdr->FlowLabel(), pkt, encapsulation);
+		conn = NewConn(key, t, &id, data, proto, ip_hdr->FlowLabel(), pkt, encapsulation);
 		if ( conn )
-			d->Insert(h, conn);
+			d->Insert(conn);
 		}
 	else
 		{
 		// We already know that connection.
 		int consistent = CheckConnectionTag(conn);
 		if ( consistent < 0 )
-			{
-			delete h;
 			return;
-			}
 
 		if ( ! consistent || conn->IsReuse(t, data) )
 			{
@@ -767,22 +767,16 @@ void NetSessions::DoNextPacket(double t, const Packet* pkt, const IP_Hdr* ip_hdr
 				conn->Event(connection_reused, 0);
 
 			Remove(conn);
-			conn = NewConn(h, t, &id, data, proto, ip_hdr->FlowLabel(), pkt, encapsulation);
+			conn = NewConn(key, t, &id, data, proto, ip_hdr->FlowLabel(), pkt, encapsulation);
 			if ( conn )
-				d->Insert(h, conn);
+				d->Insert(conn);
 			}
 		else
-			{
-			delete h;
 			conn->CheckEncapsulation(encapsulation);
-			}
 		}
 
 	if ( ! conn )
-		{
-		delete h;
 		return;
-		}
 
 	int record_packet = 1;	// whether to record the packet at all
 	int record_content = 1;	// whether to record its data
@@ -1037,38 +1031,43 @@ Connection* NetSessions::FindConnection(Val* v)
 
 	id.is_one_way = 0;	// ### incorrect for ICMP connections
 
-	HashKey* h = BuildConnIDHashKey(id);
-	if ( ! h )
-		reporter->InternalError("hash computation failed");
-
-	Dictionary* d;
+	TransportProto proto;
 
 	if ( orig_portv->IsTCP() )
-		d = &tcp_conns;
+		proto = TRANSPORT_TCP;
 	else if ( orig_portv->IsUDP() )
-		d = &udp_conns;
+		proto = TRANSPORT_UDP;
 	else if ( orig_portv->IsICMP() )
-		d = &icmp_conns;
+		proto = TRANSPORT_ICMP;
 	else
-		{
 		// This can happen due to pseudo-connections we
 		// construct, for example for packet headers embedded
 		// in ICMPs.
-		delete h;
 		return 0;
-		}
 
-	Connection* conn = (Connection*) d->Lookup(h);
+	return TableFor(proto)->Lookup(BuildConnIDKey(id, proto));
+	}
 
-	delete h;
+ConnTable* NetSessions::TableFor(TransportProto proto)
+	{
+	switch ( proto ) {
+	case TRANSPORT_TCP:
+		return &tcp_conns;
 
-	return conn;
+	case TRANSPORT_UDP:
+		return &udp_conns;
+
+	case TRANSPORT_ICMP:
+		return &icmp_conns;
+
+	default:
+		return 0;
+	}
 	}
 
 void NetSessions::Remove(Connection* c)
 	{
-	HashKey* k = c->Key();
-	if ( k )
+	if ( c->IsKeyValid() )
 		{
 		c->CancelTimers();
 
@@ -1087,34 +1086,19 @@ void NetSessions::Remove(Connection* c)
 		if ( connection_state_remove )
 			c->Event(connection_state_remove, 0);
 
-		// Zero out c's copy of the key, so that if c has been Ref()'d
+		// Mark c's key as invalid, so that if c has been Ref()'d
 		// up, we know on a future call to Remove() that it's no
-		// longer in the dictionary.
+		// longer in the table.
 		c->ClearKey();
 
-		switch ( c->ConnTransport() ) {
-		case TRANSPORT_TCP:
-			if ( ! tcp_conns.RemoveEntry(k) )
-				reporter->InternalWarning("connection missing");
-			break;
-
-		case TRANSPORT_UDP:
-			if ( ! udp_conns.RemoveEntry(k) )
-				reporter->InternalWarning("connection missing");
-			break;
-
-		case TRANSPORT_ICMP:
-			if ( ! icmp_conns.RemoveEntry(k) )
-				reporter->InternalWarning("connection missing");
-			break;
+		ConnTable* t = TableFor(c->ConnTransport());
 
-		case TRANSPORT_UNKNOWN:
+		if ( ! t )
 			reporter->InternalWarning("unknown transport when removing connection");
-			break;
-		}
+		else if ( ! t->Remove(c->Key()) )
+			reporter->InternalWarning("connection missing");
 
 		Unref(c);
-		delete k;
 		}
 	}
 
@@ -1138,70 +1122,67 @@ void NetSessions::Remove(FragReassembler* f)
 
 void NetSessions::Insert(Connection* c)
 	{
-	assert(c->Key());
-
-	Connection* old = 0;
+	assert(c->IsKeyValid());
 
-	switch ( c->ConnTransport() ) {
-	// Remove first. Otherwise the dictioanry would still
-	// reference the old key for already existing connections.
+	ConnTable* t = TableFor(c->ConnTransport());
 
-	case TRANSPORT_TCP:
-		old = (Connection*) tcp_conns.Remove(c->Key());
-		tcp_conns.Insert(c->Key(), c);
-		break;
-
-	case TRANSPORT_UDP:
-		old = (Connection*) udp_conns.Remove(c->Key());
-		udp_conns.Insert(c->Key(), c);
-		break;
-
-	case TRANSPORT_ICMP:
-		old = (Connection*) icmp_conns.Remove(c->Key());
-		icmp_conns.Insert(c->Key(), c);
-		break;
-
-	default:
+	if ( ! t )
+		{
 		reporter->InternalWarning("unknown connection type");
 		Unref(c);
 		return;
-	}
+		}
+
+	Connection* old = t->Insert(c);
 
 	if ( old && old != c )
 		{
 		// Some clean-ups similar to those in Remove() (but invisible
 		// to the script layer).
 		old->CancelTimers();
-		delete old->Key();
 		old->ClearKey();
 		Unref(old);
 		}
 	}
 
-void NetSessions::Drain()
+// Returns a table's connections ordered by their start times, so that
+// what's flushed at termination doesn't depend on the table's hashing.
+// Connections starting at the same time are ordered by their keys.
+static std::vector<Connection*> by_start_time(const ConnTable& t)
 	{
-	IterCookie* cookie = tcp_conns.InitForIteration();
-	Connection* tc;
+	std::vector<Connection*> conns;
+	conns.reserve(t.Length());
+
+	for ( auto c : t )
+		conns.push_back(c);
 
-	while ( (tc = tcp_conns.NextEntry(cookie)) )
+	std::sort(conns.begin(), conns.end(),
+		[](const Connection* a, const Connection* b)
+			{
+			if ( a->StartTime() != b->StartTime() )
+				return a->StartTime() < b->StartTime();
+
+			return memcmp(&a->Key(), &b->Key(), sizeof(ConnIDKey)) < 0;
+			});
+
+	return conns;
+	}
+
+void NetSessions::Drain()
+	{
+	for ( auto tc : by_start_time(tcp_conns) )
 		{
 		tc->Done();
 		tc->Event(connection_state_remove, 0);
 		}
 
-	cookie = udp_conns.InitForIteration();
-	Connection* uc;
-
-	while ( (uc = udp_conns.NextEntry(cookie)) )
+	for ( auto uc : by_start_time(udp_conns) )
 		{
 		uc->Done();
 		uc->Event(connection_state_remove, 0);
 		}
 
-	cookie = icmp_conns.InitForIteration();
-	Connection* ic;
-
-	while ( (ic = icmp_conns.NextEntry(cookie)) )
+	for ( auto ic : by_start_time(icmp_conns) )
 		{
 		ic->Done();
 		ic->Event(connection_state_remove, 0);
@@ -1227,7 +1208,7 @@ void NetSessions::GetStats(SessionStats& s) const
 	s.max_fragments = fragments.MaxLength();
 	}
 
-Connection* NetSessions::NewConn(HashKey* k, double t, const ConnID* id,
+Connection* NetSessions::NewConn(const ConnIDKey& k, double t, const ConnID* id,
 					const u_char* data, int proto, uint32 flow_label,
 					const Packet* pkt, const EncapsulationStack* encapsulation)
 	{
@@ -1462,22 +1443,13 @@ unsigned int NetSessions::ConnectionMemoryUsage()
 		// Connections have been flushed already.
 		return 0;
 
-	IterCookie* cookie = tcp_conns.InitForIteration();
-	Connection* tc;
-
-	while ( (tc = tcp_conns.NextEntry(cookie)) )
+	for ( auto tc : tcp_conns )
 		mem += tc->MemoryAllocation();
 
-	cookie = udp_conns.InitForIteration();
-	Connection* uc;
-
-	while ( (uc = udp_conns.NextEntry(cookie)) )
+	for ( auto uc : udp_conns )
 		mem += uc->MemoryAllocation();
 
-	cookie = icmp_conns.InitForIteration();
-	Connection* ic;
-
-	while ( (ic = icmp_conns.NextEntry(cookie)) )
+	for ( auto ic : icmp_conns )
 		mem += ic->MemoryAllocation();
 
 	return mem;
@@ -1491,22 +1463,13 @@ unsigned int NetSessions::ConnectionMemoryUsageConnVals()
 		// Connections have been flushed already.
 		return 0;
 
-	IterCookie* cookie = tcp_conns.InitForIteration();
-	Connection* tc;
-
-	while ( (tc = tcp_conns.NextEntry(cookie)) )
+	for ( auto tc : tcp_conns )
 		mem += tc->MemoryAllocationConnVal();
 
-	cookie = udp_conns.InitForIteration();
-	Connection* uc;
-
-	while ( (uc = udp_conns.NextEntry(cookie)) )
+	for ( auto uc : udp_conns )
 		mem += uc->MemoryAllocationConnVal();
 
-	cookie = icmp_conns.InitForIteration();
-	Connection* ic;
-
-	while ( (ic = icmp_conns.NextEntry(cookie)) )
+	for ( auto ic : icmp_conns )
 		mem += ic->MemoryAllocationConnVal();
 
 	return mem;
@@ -1521,15 +1484,9 @@ unsigned int NetSessions::MemoryAllocation()
 	return ConnectionMemoryUsage()
 		+ padded_sizeof(*this)
 		+ ch->MemoryAllocation()
-		// must take care we don't count the HaskKeys twice.
-		+ tcp_conns.MemoryAllocation() - padded_sizeof(tcp_conns) -
-		// 12 is sizeof(Key) from ConnID::BuildConnKey();
-		// it can't be (easily) accessed here. :-(
-			(tcp_conns.Length() * pad_size(12))
-		+ udp_conns.MemoryAllocation() - padded_sizeof(udp_conns) -
-			(udp_conns.Length() * pad_size(12))
-		+ icmp_conns.MemoryAllocation() - padded_sizeof(icmp_conns) -
-			(icmp_conns.Length() * pad_size(12))
+		+ tcp_conns.MemoryAllocation() - padded_sizeof(tcp_conns)
+		+ udp_conns.MemoryAllocation() - padded_sizeof(udp_conns)
+		+ icmp_conns.MemoryAllocation() - padded_sizeof(icmp_conns)
 		+ fragments.MemoryAllocation() - padded_sizeof(fragments)
 		// FIXME: MemoryAllocation() not implemented for rest.
 		;
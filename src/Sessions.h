@@ -4,6 +4,7 @@
 #define sessions_h
 
 #include "Dict.h"
+#include "ConnTable.h"
 #include "CompHash.h"
 #include "IP.h"
 #include "Frag.h"
@@ -172,7 +173,7 @@ protected:
 	friend class TimerMgrExpireTimer;
 	friend class IPTunnelTimer;
 
-	Connection* NewConn(HashKey* k, double t, const ConnID* id,
+	Connection* NewConn(const ConnIDKey& k, double t, const ConnID* id,
 			const u_char* data, int proto, uint32 flow_label,
 			const Packet* pkt, const EncapsulationStack* encapsulation);
 
@@ -213,9 +214,12 @@ protected:
 			      const Packet *pkt, const EncapsulationStack* encap);
 
 	CompositeHash* ch;
-	PDict<Connection> tcp_conns;
-	PDict<Connection> udp_conns;
-	PDict<Connection> icmp_conns;
+	// Returns the table for connections of the given transport, or nil.
+	ConnTable* TableFor(TransportProto proto);
+
+	ConnTable tcp_conns;
+	ConnTable udp_conns;
+	ConnTable icmp_conns;
 	PDict<FragReassembler> fragments;
 
 	typedef pair<IPAddr, IPAddr> IPPair;
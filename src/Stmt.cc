@@ -942,7 +942,7 @@ TraversalCode EventStmt::Traverse(TraversalCallback* cb) const
 	}
 
 WhileStmt::WhileStmt(Expr* arg_loop_condition, Stmt* arg_body)
-	: loop_condition(arg_loop_condition), body(arg_body)
+	: Stmt(STMT_WHILE), loop_condition(arg_loop_condition), body(arg_body)
 	{
 	if ( ! loop_condition->IsError() &&
 	     ! IsBool(loop_condition->Type()->Tag()) )
@@ -288,6 +288,9 @@ public:
 	WhileStmt(Expr* loop_condition, Stmt* body);
 	~WhileStmt() override;
 
+	const Expr* Condition() const	{ return loop_condition; }
+	const Stmt* Body() const	{ return body; }
+
 	int IsPure() const override;
 
 	void Describe(ODesc* d) const override;
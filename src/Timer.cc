@@ -227,3 +227,313 @@ void CQ_TimerMgr::Remove(Timer* timer)
 		delete timer;
 		}
 	}
+
+TW_TimerMgr::TW_TimerMgr(const Tag& tag) : TimerMgr(tag)
+	{
+	for ( int i = 0; i <= OVERFLOW_SLOT; ++i )
+		slots[i] = 0;
+
+	memset(occupied, 0, sizeof(occupied));
+
+	ready = new PriorityQueue;
+	cur_tick = 0;
+
+	num_timers = peak_num_timers = 0;
+	cumulative_num = 0;
+	}
+
+TW_TimerMgr::~TW_TimerMgr()
+	{
+	delete ready;
+	}
+
+uint64 TW_TimerMgr::TickOf(double t) const
+	{
+	if ( t <= 0.0 )
+		return 0;
+
+	double ticks = t * TICKS_PER_SEC;
+
+	// Anything this far out only leaves the overflow list via Expire().
+	if ( ticks >= double(uint64(1) << 62) )
+		return uint64(1) << 62;
+
+	return uint64(ticks);
+	}
+
+void TW_TimerMgr::Add(Timer* timer)
+	{
+	DBG_LOG(DBG_TM, "Adding timer %s to TimeMgr %p",
+			timer_type_to_string(timer->Type()), this);
+
+	// As with PQ_TimerMgr, timers that are already due still get
+	// queued, so that they execute in sorted order.
+	Place(timer);
+
+	++current_timers[timer->Type()];
+	++cumulative_num;
+
+	if ( ++num_timers > peak_num_timers )
+		peak_num_timers = num_timers;
+	}
+
+void TW_TimerMgr::Place(Timer* timer)
+	{
+	uint64 tick = TickOf(timer->Time());
+
+	if ( tick <= cur_tick )
+		{
+		if ( ! ready->Add(timer) )
+			reporter->InternalError("out of memory");
+		return;
+		}
+
+	// Use the finest wheel whose current revolution covers the tick.
+	for ( int level = 0; level < LEVELS; ++level )
+		{
+		int shift = SLOT_BITS * (level + 1);
+
+		if ( (tick >> shift) == (cur_tick >> shift) )
+			{
+			int idx = (tick >> (SLOT_BITS * level)) & (SLOTS - 1);
+			Link(timer, level * SLOTS + idx);
+			return;
+			}
+		}
+
+	Link(timer, OVERFLOW_SLOT);
+	}
+
+void TW_TimerMgr::Link(Timer* timer, int slot)
+	{
+	Timer* head = slots[slot];
+
+	timer->wheel_next = head;
+	timer->wheel_link = &slots[slot];
+	timer->wheel_slot = slot;
+
+	if ( head )
+		head->wheel_link = &timer->wheel_next;
+
+	slots[slot] = timer;
+
+	if ( slot < OVERFLOW_SLOT )
+		{
+		int idx = slot % SLOTS;
+		occupied[slot / SLOTS][idx / 64] |= uint64(1) << (idx % 64);
+		}
+	}
+
+void TW_TimerMgr::Unlink(Timer* timer)
+	{
+	int slot = timer->wheel_slot;
+
+	*timer->wheel_link = timer->wheel_next;
+
+	if ( timer->wheel_next )
+		timer->wheel_next->wheel_link = timer->wheel_link;
+
+	timer->wheel_next = 0;
+	timer->wheel_link = 0;
+	timer->wheel_slot = -1;
+
+	if ( slot < OVERFLOW_SLOT && ! slots[slot] )
+		{
+		int idx = slot % SLOTS;
+		occupied[slot / SLOTS][idx / 64] &= ~(uint64(1) << (idx % 64));
+		}
+	}
+
+void TW_TimerMgr::Cascade(int slot)
+	{
+	Timer* timer = slots[slot];
+	slots[slot] = 0;
+
+	if ( slot < OVERFLOW_SLOT )
+		{
+		int idx = slot % SLOTS;
+		occupied[slot / SLOTS][idx / 64] &= ~(uint64(1) << (idx % 64));
+		}
+
+	while ( timer )
+		{
+		Timer* next = timer->wheel_next;
+
+		timer->wheel_next = 0;
+		timer->wheel_link = 0;
+		timer->wheel_slot = -1;
+
+		Place(timer);
+		timer = next;
+		}
+	}
+
+int TW_TimerMgr::NextOccupied(int level, int from) const
+	{
+	for ( int w = from / 64; w < BITMAP_WORDS; ++w )
+		{
+		uint64 bits = occupied[level][w];
+
+		if ( w == from / 64 )
+			bits &= ~uint64(0) << (from % 64);
+
+		if ( bits )
+			return w * 64 + __builtin_ctzll(bits);
+		}
+
+	return -1;
+	}
+
+uint64 TW_TimerMgr::NextEventTick(uint64 target) const
+	{
+	uint64 next = target;
+
+	for ( int level = 0; level < LEVELS; ++level )
+		{
+		int shift = SLOT_BITS * level;
+		int cur = (cur_tick >> shift) & (SLOTS - 1);
+		int idx = NextOccupied(level, cur + 1);
+
+		if ( idx < 0 )
+			continue;
+
+		uint64 base = (cur_tick >> (shift + SLOT_BITS)) << (shift + SLOT_BITS);
+		uint64 tick = base + (uint64(idx) << shift);
+
+		if ( tick < next )
+			next = tick;
+		}
+
+	if ( slots[OVERFLOW_SLOT] )
+		{
+		int shift = SLOT_BITS * LEVELS;
+		uint64 tick = ((cur_tick >> shift) + 1) << shift;
+
+		// Skip straight to the revolution of the earliest timer
+		// rather than stepping through the empty ones in between.
+		uint64 earliest = TickOf(slots[OVERFLOW_SLOT]->Time());
+		for ( Timer* t = slots[OVERFLOW_SLOT]; t; t = t->wheel_next )
+			if ( TickOf(t->Time()) < earliest )
+				earliest = TickOf(t->Time());
+
+		earliest = (earliest >> shift) << shift;
+
+		if ( earliest > tick )
+			tick = earliest;
+
+		if ( tick < next )
+			next = tick;
+		}
+
+	return next;
+	}
+
+void TW_TimerMgr::AdvanceTo(uint64 target)
+	{
+	while ( cur_tick < target )
+		{
+		// Nothing's filed in between, so we can jump ahead.
+		cur_tick = NextEventTick(target);
+
+		// Cascade the slots that start at the new tick, coarsest
+		// first so that their timers trickle down all the way.
+		uint64 mask = (uint64(1) << (SLOT_BITS * LEVELS)) - 1;
+		if ( (cur_tick & mask) == 0 && slots[OVERFLOW_SLOT] )
+			Cascade(OVERFLOW_SLOT);
+
+		for ( int level = LEVELS - 1; level >= 0; --level )
+			{
+			int shift = SLOT_BITS * level;
+			mask = (uint64(1) << shift) - 1;
+
+			if ( cur_tick & mask )
+				continue;
+
+			int slot = level * SLOTS + ((cur_tick >> shift) & (SLOTS - 1));
+
+			if ( slots[slot] )
+				Cascade(slot);
+			}
+		}
+	}
+
+void TW_TimerMgr::Flush()
+	{
+	for ( int slot = 0; slot <= OVERFLOW_SLOT; ++slot )
+		{
+		while ( Timer* timer = slots[slot] )
+			{
+			Unlink(timer);
+
+			if ( ! ready->Add(timer) )
+				reporter->InternalError("out of memory");
+			}
+		}
+	}
+
+void TW_TimerMgr::Expire()
+	{
+	while ( true )
+		{
+		// Dispatching may add further timers.
+		if ( num_timers > ready->Size() )
+			Flush();
+
+		Timer* timer = (Timer*) ready->Remove();
+
+		if ( ! timer )
+			break;
+
+		--num_timers;
+
+		DBG_LOG(DBG_TM, "Dispatching timer %s in TimeMgr %p",
+				timer_type_to_string(timer->Type()), this);
+		timer->Dispatch(t, 1);
+		--current_timers[timer->Type()];
+		delete timer;
+		}
+	}
+
+int TW_TimerMgr::DoAdvance(double new_t, int max_expire)
+	{
+	uint64 target = TickOf(new_t);
+
+	if ( target > cur_tick )
+		AdvanceTo(target);
+
+	Timer* timer = (Timer*) ready->Top();
+	for ( num_expired = 0; (num_expired < max_expire || max_expire == 0) &&
+		     timer && timer->Time() <= new_t; ++num_expired )
+		{
+		last_timestamp = timer->Time();
+		--current_timers[timer->Type()];
+		--num_timers;
+
+		// Remove it before dispatching, since the dispatch
+		// can otherwise delete it, and then we won't know
+		// whether we should delete it too.
+		(void) ready->Remove();
+
+		DBG_LOG(DBG_TM, "Dispatching timer %s in TimeMgr %p",
+				timer_type_to_string(timer->Type()), this);
+		timer->Dispatch(new_t, 0);
+		delete timer;
+
+		timer = (Timer*) ready->Top();
+		}
+
+	return num_expired;
+	}
+
+void TW_TimerMgr::Remove(Timer* timer)
+	{
+	if ( timer->wheel_link )
+		Unlink(timer);
+
+	else if ( ! ready->Remove(timer) )
+		reporter->InternalError("asked to remove a missing timer");
+
+	--num_timers;
+	--current_timers[timer->Type()];
+	delete timer;
+	}
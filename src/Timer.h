@@ -53,7 +53,12 @@ class ODesc;
 class Timer : public PQ_Element {
 public:
 	Timer(double t, TimerType arg_type) : PQ_Element(t)
-		{ type = (char) arg_type; }
+		{
+		type = (char) arg_type;
+		wheel_next = 0;
+		wheel_link = 0;
+		wheel_slot = -1;
+		}
 	~Timer() override { }
 
 	TimerType Type() const	{ return (TimerType) type; }
@@ -66,9 +71,17 @@ public:
 	void Describe(ODesc* d) const;
 
 protected:
-	Timer()	{}
+	friend class TW_TimerMgr;
+
+	Timer()	{ wheel_next = 0; wheel_link = 0; wheel_slot = -1; }
 
 	unsigned int type:8;
+
+	// Intrusive links used by TW_TimerMgr; wheel_link points at
+	// whatever points at us, so unlinking doesn't need the slot head.
+	Timer* wheel_next;
+	Timer** wheel_link;
+	int wheel_slot;
 };
 
 class TimerMgr {
@@ -174,6 +187,77 @@ protected:
 	struct cq_handle *cq;
 };
 
+// A hierarchical timing wheel.  Timers are hashed by their expiration
+// tick into one of several wheels of increasingly coarse granularity,
+// each a ring of intrusive lists, so adding and canceling a timer are
+// constant time.  As the clock advances, the slots of the coarser wheels
+// are cascaded down into the finer ones; once a timer's tick has been
+// reached it moves into a small priority queue, from which timers are
+// dispatched in exact time order just as with PQ_TimerMgr.
+class TW_TimerMgr : public TimerMgr {
+public:
+	explicit TW_TimerMgr(const Tag& arg_tag);
+	~TW_TimerMgr() override;
+
+	void Add(Timer* timer) override;
+	void Expire() override;
+
+	int Size() const override { return num_timers; }
+	int PeakSize() const override { return peak_num_timers; }
+	uint64 CumulativeNum() const override { return cumulative_num; }
+
+protected:
+	int DoAdvance(double t, int max_expire) override;
+	void Remove(Timer* timer) override;
+
+	// Granularity of the finest wheel.
+	static constexpr double TICKS_PER_SEC = 1000.0;
+
+	// Each wheel has 2^SLOT_BITS slots; a timer more than
+	// 2^(SLOT_BITS * LEVELS) ticks out goes onto the overflow list.
+	static constexpr int SLOT_BITS = 8;
+	static constexpr int SLOTS = 1 << SLOT_BITS;
+	static constexpr int LEVELS = 4;
+	static constexpr int OVERFLOW_SLOT = SLOTS * LEVELS;
+	static constexpr int BITMAP_WORDS = SLOTS / 64;
+
+	uint64 TickOf(double t) const;
+
+	// Files the timer under the wheel slot for its tick relative to
+	// the current one, or into the ready queue if that tick is due.
+	void Place(Timer* timer);
+
+	void Link(Timer* timer, int slot);
+	void Unlink(Timer* timer);
+
+	// Returns the first occupied slot index of the given wheel at or
+	// after "from", or -1 if there's none.
+	int NextOccupied(int level, int from) const;
+
+	// Moves everything in the given slot back through Place().
+	void Cascade(int slot);
+
+	// Advances the current tick, cascading slots along the way.
+	void AdvanceTo(uint64 target);
+
+	// Returns the next tick after the current one at which some slot
+	// needs attention, or target if there's none before that.
+	uint64 NextEventTick(uint64 target) const;
+
+	// Moves every pending timer into the ready queue.
+	void Flush();
+
+	Timer* slots[OVERFLOW_SLOT + 1];
+	uint64 occupied[LEVELS][BITMAP_WORDS];
+
+	PriorityQueue* ready;
+	uint64 cur_tick;
+
+	int num_timers;
+	int peak_num_timers;
+	uint64 cumulative_num;
+};
+
 extern TimerMgr* timer_mgr;
 
 #endif
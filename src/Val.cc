@@ -45,6 +45,20 @@ using ordered_map = tsl::ordered_map<Key, T, Hash, KeyEqual, AllocatorPair, Valu
 
 using ZeekJson = nlohmann::basic_json<ordered_map>;
 
+DEFINE_POOL_ALLOCATOR(Val)
+DEFINE_POOL_ALLOCATOR(IntervalVal)
+DEFINE_POOL_ALLOCATOR(PortVal)
+DEFINE_POOL_ALLOCATOR(AddrVal)
+DEFINE_POOL_ALLOCATOR(SubNetVal)
+DEFINE_POOL_ALLOCATOR(StringVal)
+DEFINE_POOL_ALLOCATOR(PatternVal)
+DEFINE_POOL_ALLOCATOR(ListVal)
+DEFINE_POOL_ALLOCATOR(TableEntryVal)
+DEFINE_POOL_ALLOCATOR(TableVal)
+DEFINE_POOL_ALLOCATOR(RecordVal)
+DEFINE_POOL_ALLOCATOR(EnumVal)
+DEFINE_POOL_ALLOCATOR(VectorVal)
+
 Val::Val(Func* f)
 	{
 	val.func_val = f;
@@ -1403,7 +1417,6 @@ void TableVal::Init(TableType* t)
 	table_type = t;
 	expire_func = 0;
 	expire_time = 0;
-	expire_cookie = 0;
 	timer = 0;
 	def_val = 0;
 
@@ -1422,6 +1435,7 @@ TableVal::~TableVal()
 	if ( timer )
 		timer_mgr->Cancel(timer);
 
+	ClearExpireIndex();
 	Unref(table_type);
 	delete table_hash;
 	delete AsTable();
@@ -1435,11 +1449,38 @@ TableVal::~TableVal()
 void TableVal::RemoveAll()
 	{
 	// Here we take the brute force approach.
+	ClearExpireIndex();
 	delete AsTable();
 	val.table_val = new PDict<TableEntryVal>;
 	val.table_val->SetDeleteFunc(table_entry_val_delete_func);
 	}
 
+void TableVal::ClearExpireIndex()
+	{
+	for ( auto& b : expire_buckets )
+		for ( auto k : b.second )
+			delete k;
+
+	expire_buckets.clear();
+	}
+
+void TableVal::RebuildExpireIndex()
+	{
+	ClearExpireIndex();
+
+	if ( ! expire_time )
+		return;
+
+	PDict<TableEntryVal>* tbl = AsNonConstTable();
+	IterCookie* c = tbl->InitForIteration();
+
+	HashKey* k;
+	TableEntryVal* v;
+
+	while ( (v = tbl->NextEntry(k, c)) )
+		FileForExpiration(k, v);
+	}
+
 int TableVal::RecursiveSize() const
 	{
 	int n = AsTable()->Length();
@@ -1503,6 +1544,8 @@ void TableVal::CheckExpireAttr(attr_tag at)
 		if ( timer )
 			timer_mgr->Cancel(timer);
 
+		RebuildExpireIndex();
+
 		// As network_time is not necessarily initialized yet,
 		// we set a timer which fires immediately.
 		timer = new TableValTimer(this, 1);
@@ -1556,6 +1599,21 @@ int TableVal::Assign(Val* index, HashKey* k, Val* new_val)
 	if ( old_entry_val && attrs && attrs->FindAttr(ATTR_EXPIRE_CREATE) )
 		new_entry_val->SetExpireAccess(old_entry_val->ExpireAccessTime());
 
+	if ( expire_time )
+		{
+		// The old entry's key already covers the new one.  If the
+		// new one got a later time, DoExpire() files it again when
+		// the old bucket comes up, as for any other access; filing
+		// a key per write instead would keep one per second of the
+		// timeout around for frequently written entries.
+		if ( old_entry_val )
+			new_entry_val->expire_bucket = old_entry_val->expire_bucket;
+		else
+			FileForExpiration(new HashKey(k_copy.Key(), k_copy.Size(),
+							k_copy.Hash()),
+					  new_entry_val);
+		}
+
 	if ( old_entry_val )
 		{
 		old_entry_val->Unref();
@@ -2268,31 +2326,62 @@ void TableVal::DoExpire(double t)
 		// error, it has been reported already.
 		return;
 
-	if ( ! expire_cookie )
-		{
-		expire_cookie = tbl->InitForIteration();
-		tbl->MakeRobustCookie(expire_cookie);
-		}
-
-	HashKey* k = 0;
-	TableEntryVal* v = 0;
-	TableEntryVal* v_saved = 0;
 	bool modified = false;
+	int visited = 0;
+
+	// Entries we file again during this round.  They only go into the
+	// index once we're done, as they may well land in a bucket that's
+	// still due and we don't want to look at them twice (in particular
+	// not call the &expire_func again) before the next round.
+	std::vector<std::pair<int, HashKey*>> refiled;
+
+	// Entries are filed by their access time at the time of filing, so
+	// the buckets that aren't due yet can't contain anything to expire.
+	// Entries accessed since they were filed get filed again under their
+	// new time when their old bucket comes up.
+	while ( visited < table_incremental_step )
+		{
+		auto b = expire_buckets.begin();
+
+		if ( b != expire_buckets.end() && b->first == 0 &&
+		     bro_start_network_time == 0 )
+			// These got inserted while network_time hadn't been
+			// initialized yet (e.g. in zeek_init()).  Their
+			// expire_access_time is correct, so we just need to
+			// wait.
+			++b;
+
+		if ( b == expire_buckets.end() ||
+		     bro_start_network_time + b->first + timeout >= t )
+			break;
 
-	for ( int i = 0; i < table_incremental_step &&
-			 (v = tbl->NextEntry(k, expire_cookie)); ++i )
-		{
-		if ( v->ExpireAccessTime() == 0 )
-			{
-			// This happens when we insert val while network_time
-			// hasn't been initialized yet (e.g. in zeek_init()), and
-			// also when bro_start_network_time hasn't been initialized
-			// (e.g. before first packet).  The expire_access_time is
-			// correct, so we just need to wait.
-			}
+		int bucket = b->first;
+		std::vector<HashKey*> keys = std::move(b->second);
+		expire_buckets.erase(b);
 
-		else if ( v->ExpireAccessTime() + timeout < t )
+		size_t i = 0;
+
+		for ( ; i < keys.size() && visited < table_incremental_step; ++i )
 			{
+			HashKey* k = keys[i];
+			TableEntryVal* v = tbl->Lookup(k);
+			++visited;
+
+			if ( ! v || v->expire_bucket != bucket )
+				{
+				// Deleted, or filed elsewhere in the meantime.
+				delete k;
+				continue;
+				}
+
+			if ( v->expire_access_time != bucket )
+				{
+				// Accessed since it was filed.
+				v->expire_bucket = v->expire_access_time;
+				refiled.emplace_back(v->expire_bucket, k);
+				continue;
+				}
+
 			if ( expire_func )
 				{
 				Val* idx = RecoverIndex(k);
@@ -2301,12 +2390,12 @@ void TableVal::DoExpire(double t)
 				// It's possible that the user-provided
 				// function modified or deleted the table
 				// value, so look it up again.
-				v_saved = v;
 				v = tbl->Lookup(k);
 
-				if ( ! v )
-					{ // user-provided function deleted it
-					v = v_saved;
+				if ( ! v || v->expire_bucket != bucket )
+					{
+					// User-provided function deleted or
+					// replaced it.
 					delete k;
 					continue;
 					}
@@ -2316,10 +2405,10 @@ void TableVal::DoExpire(double t)
 					// User doesn't want us to expire
 					// this now.
 					v->SetExpireAccess(network_time - timeout + secs);
-					delete k;
+					v->expire_bucket = v->expire_access_time;
+					refiled.emplace_back(v->expire_bucket, k);
 					continue;
 					}
-
 				}
 
 			if ( subnets )
@@ -2334,19 +2423,25 @@ void TableVal::DoExpire(double t)
 			Unref(v->Value());
 			delete v;
 			modified = true;
+			delete k;
 			}
 
-		delete k;
+		if ( i < keys.size() )
+			{
+			// Out of steps; put back what we didn't get to.
+			auto& rest = expire_buckets[bucket];
+			rest.insert(rest.end(), keys.begin() + i, keys.end());
+			}
 		}
 
+	for ( const auto& r : refiled )
+		expire_buckets[r.first].push_back(r.second);
+
 	if ( modified )
 		Modified();
 
-	if ( ! v )
-		{
-		expire_cookie = 0;
+	if ( visited < table_incremental_step )
 		InitTimer(table_expire_interval);
-		}
 	else
 		InitTimer(table_expire_delay);
 	}
@@ -2497,6 +2592,7 @@ Val* TableVal::DoClone(CloneState* state)
 	if ( expire_time )
 		{
 		tv->expire_time = expire_time->Ref();
+		tv->RebuildExpireIndex();
 
 		// As network_time is not necessarily initialized yet, we set
 		// a timer which fires immediately.
@@ -2606,11 +2702,61 @@ TableVal::TableRecordDependencies TableVal::parse_time_table_record_dependencies
 
 RecordVal::RecordTypeValMap RecordVal::parse_time_records;
 
+// Field lists of deleted records, kept for reuse by records with the same
+// number of fields. Allocated on first use so that records deleted during
+// shutdown don't outlive them.
+static const int MAX_POOLED_RECORD_FIELDS = 64;
+static const size_t MAX_FREE_RECORD_FIELD_LISTS = 1024;
+static vector<val_list*>* free_record_fields = nullptr;
+
+static val_list* new_record_fields(int n)
+	{
+	if ( n <= MAX_POOLED_RECORD_FIELDS && free_record_fields &&
+	     ! free_record_fields[n].empty() )
+		{
+		val_list* vl = free_record_fields[n].back();
+		free_record_fields[n].pop_back();
+		return vl;
+		}
+
+	return new val_list(n);
+	}
+
+static void delete_record_fields(val_list* vl)
+	{
+	for ( const auto& v : *vl )
+		Unref(v);
+
+	// Pool the list according to its capacity, which keeps the
+	// allocation of its entries.
+	int n = vl->max();
+
+	if ( n > MAX_POOLED_RECORD_FIELDS )
+		{
+		delete vl;
+		return;
+		}
+
+	if ( ! free_record_fields )
+		free_record_fields = new vector<val_list*>[MAX_POOLED_RECORD_FIELDS + 1];
+
+	if ( free_record_fields[n].size() >= MAX_FREE_RECORD_FIELD_LISTS )
+		{
+		delete vl;
+		return;
+		}
+
+	while ( vl->length() )
+		vl->pop_back();
+
+	free_record_fields[n].push_back(vl);
+	}
+
 RecordVal::RecordVal(RecordType* t, bool init_fields) : Val(t)
 	{
 	origin = nullptr;
 	int n = t->NumFields();
-	val_list* vl = val.val_list_val = new val_list(n);
+	val_list* vl = val.val_list_val = new_record_fields(n);
 
 	if ( is_parsing )
 		parse_time_records[t].emplace_back(this->Ref()->AsRecordVal());
@@ -2661,7 +2807,7 @@ RecordVal::RecordVal(RecordType* t, bool init_fields) : Val(t)
 
 RecordVal::~RecordVal()
 	{
-	delete_vals(AsNonConstRecord());
+	delete_record_fields(AsNonConstRecord());
 	}
 
 void RecordVal::Assign(int field, Val* new_val)
@@ -3350,9 +3496,105 @@ bool can_cast_value_to_type(const BroType* s, BroType* t)
 	return false;
 	}
 
+namespace {
+
+// Per-thread cache of the arrays of small val_lists, one free list for
+// each capacity.  A freed array holds the next free one in its first
+// entry.  There's deliberately no destructor: val_lists in global objects
+// may get freed after the main thread's cache went away, and the cached
+// arrays go away with the process anyway.
+class ValListCache {
+public:
+	static constexpr int MAX_CACHED_CAPACITY = 8;
+	static constexpr int MAX_CACHED_PER_CAPACITY = 1024;
+
+	ValListCache()
+		{
+		for ( int i = 0; i <= MAX_CACHED_CAPACITY; ++i )
+			{
+			free_arrays[i] = nullptr;
+			num_free[i] = 0;
+			}
+		}
+
+	Val** Get(int n)
+		{
+		if ( n > 0 && n <= MAX_CACHED_CAPACITY && free_arrays[n] )
+			{
+			Val** a = free_arrays[n];
+			free_arrays[n] = reinterpret_cast<Val**>(a[0]);
+			--num_free[n];
+			return a;
+			}
+
+		return (Val**) safe_malloc(n * sizeof(Val*));
+		}
+
+	void Put(Val** a, int n)
+		{
+		if ( ! a )
+			return;
+
+		if ( n <= 0 || n > MAX_CACHED_CAPACITY ||
+		     num_free[n] >= MAX_CACHED_PER_CAPACITY )
+			{
+			free(a);
+			return;
+			}
+
+		a[0] = reinterpret_cast<Val*>(free_arrays[n]);
+		free_arrays[n] = a;
+		++num_free[n];
+		}
+
+private:
+	Val** free_arrays[MAX_CACHED_CAPACITY + 1];
+	int num_free[MAX_CACHED_CAPACITY + 1];
+};
+
+thread_local ValListCache val_list_cache;
+
+}
+
+template<> Val** List<Val*>::AllocEntries(int n)
+	{
+	return val_list_cache.Get(n);
+	}
+
+template<> Val** List<Val*>::ReallocEntries(Val** e, int old_n, int new_n)
+	{
+	if ( old_n > ValListCache::MAX_CACHED_CAPACITY &&
+	     new_n > ValListCache::MAX_CACHED_CAPACITY )
+		// Neither comes from the cache, so realloc() may be able to
+		// do this in place.
+		return (Val**) safe_realloc((void*) e, new_n * sizeof(Val*));
+
+	Val** ne = new_n > 0 ? val_list_cache.Get(new_n) : nullptr;
+
+	if ( ne && e )
+		memcpy(ne, e, std::min(old_n, new_n) * sizeof(Val*));
+
+	val_list_cache.Put(e, old_n);
+	return ne;
+	}
+
+template<> void List<Val*>::FreeEntries(Val** e, int n)
+	{
+	val_list_cache.Put(e, n);
+	}
+
 ValManager::ValManager()
 	{
 	empty_string = new StringVal("");
+	interned_strings = new StringVal*[MAX_INTERNED_STRINGS];
+	interned_string_used = new bool[MAX_INTERNED_STRINGS];
+
+	for ( auto i = 0; i < MAX_INTERNED_STRINGS; ++i )
+		{
+		interned_strings[i] = 0;
+		interned_string_used[i] = false;
+		}
+
 	b_false = Val::MakeBool(false);
 	b_true = Val::MakeBool(true);
 	counts = new Val*[PREALLOCATED_COUNTS];
@@ -3377,6 +3619,13 @@ ValManager::ValManager()
 ValManager::~ValManager()
 	{
 	Unref(empty_string);
+
+	for ( auto i = 0; i < MAX_INTERNED_STRINGS; ++i )
+		Unref(interned_strings[i]);
+
+	delete [] interned_strings;
+	delete [] interned_string_used;
+
 	Unref(b_true);
 	Unref(b_false);
 
@@ -3400,6 +3649,62 @@ StringVal* ValManager::GetEmptyString() const
 	return empty_string;
 	}
 
+StringVal* ValManager::GetInternedString(int length, const char* s,
+					bool to_upper)
+	{
+	if ( length > MAX_INTERNED_STRING_LEN )
+		{
+		StringVal* sv = new StringVal(length, s);
+		return to_upper ? sv->ToUpper() : sv;
+		}
+
+	char upper[MAX_INTERNED_STRING_LEN];
+
+	if ( to_upper )
+		{
+		for ( int i = 0; i < length; ++i )
+			{
+			unsigned char c = s[i];
+			upper[i] = islower(c) ? toupper(c) : c;
+			}
+
+		s = upper;
+		}
+
+	// Each string has just the one slot it hashes to.  The hash is
+	// keyed, so remote input can't aim at the slots of particular
+	// strings.
+	int i = HashKey::HashBytes(s, length) & (MAX_INTERNED_STRINGS - 1);
+	StringVal* sv = interned_strings[i];
+
+	if ( sv && sv->Len() == length && memcmp(sv->Bytes(), s, length) == 0 )
+		{
+		interned_string_used[i] = true;
+		::Ref(sv);
+		return sv;
+		}
+
+	StringVal* new_sv = new StringVal(length, s);
+
+	if ( sv && interned_string_used[i] )
+		{
+		// The current string has been asked for since the last time
+		// another one wanted its slot, so it stays for now.  Strings
+		// that keep coming up hold on to their slots that way, while
+		// a one-off string needs to find the slot unused again before
+		// it gets it - and then loses it just as easily.
+		interned_string_used[i] = false;
+		return new_sv;
+		}
+
+	Unref(sv);
+	interned_strings[i] = new_sv;
+	interned_string_used[i] = false;
+	::Ref(new_sv);
+
+	return new_sv;
+	}
+
 PortVal* ValManager::GetPort(uint32 port_num, TransportProto port_type) const
 	{
 	if ( port_num >= 65536 )
@@ -5,6 +5,7 @@
 
 #include <vector>
 #include <list>
+#include <map>
 #include <array>
 #include <unordered_map>
 
@@ -21,6 +22,7 @@
 #include "IPAddr.h"
 #include "DebugLogger.h"
 #include "RE.h"
+#include "PoolAllocator.h"
 
 // We have four different port name spaces: TCP, UDP, ICMP, and UNKNOWN.
 // We distinguish between them based on the bits specified in the *_PORT_MASK
@@ -86,6 +88,8 @@ typedef union {
 
 class Val : public BroObj {
 public:
+	DECLARE_POOL_ALLOCATOR(Val)
+
 	ZEEK_DEPRECATED("Remove in v3.1: use val_mgr->GetBool, GetFalse/GetTrue, GetInt, or GetCount instead")
 	Val(bool b, TypeTag t)
 		{
@@ -484,6 +488,27 @@ public:
 
 	StringVal* GetEmptyString() const;
 
+	// Maximum length of strings that GetInternedString() shares, and
+	// the maximum number of strings it shares (a power of two).
+	static constexpr int MAX_INTERNED_STRING_LEN = 64;
+	static constexpr int MAX_INTERNED_STRINGS = 4096;
+
+	// Returns a string value that's shared with all other callers asking
+	// for the same string, which turns allocating a new value into a
+	// table lookup. Meant for the short strings of small vocabularies
+	// that analyzers pass to events over and over, like protocol commands
+	// and MIME types. Callers must not modify the value. Strings that are
+	// too long are always returned as new values. The table is a cache:
+	// strings that aren't asked for anymore get replaced by new ones, so
+	// whatever shows up on the wire first can't take it over for good.
+	//
+	// If to_upper is true, the string is converted to upper case first.
+	StringVal* GetInternedString(int length, const char* s,
+					bool to_upper = false);
+
+	StringVal* GetInternedString(const char* s)
+		{ return GetInternedString(strlen(s), s); }
+
 	// Port number given in host order.
 	PortVal* GetPort(uint32 port_num, TransportProto port_type) const;
 
@@ -494,6 +519,8 @@ private:
 
 	std::array<std::array<PortVal*, 65536>, NUM_PORT_SPACES> ports;
 	StringVal* empty_string;
+	StringVal** interned_strings;	// Direct-mapped by keyed hash.
+	bool* interned_string_used;	// Asked for since last contested.
 	Val* b_true;
 	Val* b_false;
 	Val** counts;
@@ -511,6 +538,8 @@ extern ValManager* val_mgr;
 
 class IntervalVal : public Val {
 public:
+	DECLARE_POOL_ALLOCATOR(IntervalVal)
+
 	IntervalVal(double quantity, double units);
 
 protected:
@@ -522,6 +551,8 @@ protected:
 
 class PortVal : public Val {
 public:
+	DECLARE_POOL_ALLOCATOR(PortVal)
+
 	// Port number given in host order.
 	ZEEK_DEPRECATED("Remove in v3.1: use val_mgr->GetPort() instead")
 	PortVal(uint32 p, TransportProto port_type);
@@ -568,6 +599,8 @@ protected:
 
 class AddrVal : public Val {
 public:
+	DECLARE_POOL_ALLOCATOR(AddrVal)
+
 	explicit AddrVal(const char* text);
 	explicit AddrVal(const std::string& text);
 	~AddrVal() override;
@@ -592,6 +625,8 @@ protected:
 
 class SubNetVal : public Val {
 public:
+	DECLARE_POOL_ALLOCATOR(SubNetVal)
+
 	explicit SubNetVal(const char* text);
 	SubNetVal(const char* text, int width);
 	SubNetVal(uint32 addr, int width); // IPv4.
@@ -620,6 +655,8 @@ protected:
 
 class StringVal : public Val {
 public:
+	DECLARE_POOL_ALLOCATOR(StringVal)
+
 	explicit StringVal(BroString* s);
 	explicit StringVal(const char* s);
 	explicit StringVal(const string& s);
@@ -654,6 +691,8 @@ protected:
 
 class PatternVal : public Val {
 public:
+	DECLARE_POOL_ALLOCATOR(PatternVal)
+
 	explicit PatternVal(RE_Matcher* re);
 	~PatternVal() override;
 
@@ -675,6 +714,8 @@ protected:
 // element in their index.
 class ListVal : public Val {
 public:
+	DECLARE_POOL_ALLOCATOR(ListVal)
+
 	explicit ListVal(TypeTag t);
 	~ListVal() override;
 
@@ -722,12 +763,15 @@ extern double bro_start_network_time;
 
 class TableEntryVal {
 public:
+	DECLARE_POOL_ALLOCATOR(TableEntryVal)
+
 	explicit TableEntryVal(Val* v)
 		{
 		val = v;
 		last_access_time = network_time;
 		expire_access_time =
 			int(network_time - bro_start_network_time);
+		expire_bucket = expire_access_time;
 		}
 
 	TableEntryVal* Clone(Val::CloneState* state)
@@ -760,6 +804,11 @@ protected:
 	// to save a few bytes, as we do not need a high resolution for these
 	// anyway.
 	int expire_access_time;
+
+	// The value of expire_access_time under which the entry is filed in
+	// its table's expiration index. Lags behind expire_access_time when
+	// the entry has been accessed since; see TableVal::DoExpire().
+	int expire_bucket;
 };
 
 class TableValTimer : public Timer {
@@ -780,6 +829,8 @@ class Frame;
 
 class TableVal : public Val, public notifier::Modifiable {
 public:
+	DECLARE_POOL_ALLOCATOR(TableVal)
+
 	explicit TableVal(TableType* t, Attributes* attrs = 0);
 	~TableVal() override;
 
@@ -926,6 +977,20 @@ protected:
 	void RebuildTable(ParseTimeTableState ptts);
 
 	void CheckExpireAttr(attr_tag at);
+
+	// Adds an entry to the expiration index, under its current access
+	// time. Takes ownership of the key.
+	void FileForExpiration(HashKey* k, TableEntryVal* v)
+		{
+		v->expire_bucket = v->expire_access_time;
+		expire_buckets[v->expire_bucket].push_back(k);
+		}
+
+	// Files all entries of the table anew, or just drops the index if
+	// the table doesn't expire entries.
+	void RebuildExpireIndex();
+	void ClearExpireIndex();
+
 	int ExpandCompoundAndInit(val_list* vl, int k, Val* new_val);
 	int CheckAndAssign(Val* index, Val* new_val);
 
@@ -952,8 +1017,15 @@ protected:
 	Expr* expire_time;
 	Expr* expire_func;
 	TableValTimer* timer;
-	IterCookie* expire_cookie;
 	PrefixTable* subnets;
+
+	// The keys of the table's entries, by the access time under which
+	// they have last been filed (see TableEntryVal::expire_bucket), so
+	// that expiration only needs to look at the entries that may be due.
+	// Only maintained for tables with an expiration attribute. Keys of
+	// entries that got deleted or filed elsewhere in the meantime stay
+	// in their bucket until it's processed.
+	std::map<int, std::vector<HashKey*>> expire_buckets;
 	Val* def_val;
 
 	static TableRecordDependencies parse_time_table_record_dependencies;
@@ -962,6 +1034,8 @@ protected:
 
 class RecordVal : public Val, public notifier::Modifiable {
 public:
+	DECLARE_POOL_ALLOCATOR(RecordVal)
+
 	explicit RecordVal(RecordType* t, bool init_fields = true);
 	~RecordVal() override;
 
@@ -1030,6 +1104,8 @@ protected:
 
 class EnumVal : public Val {
 public:
+	DECLARE_POOL_ALLOCATOR(EnumVal)
+
 
 	ZEEK_DEPRECATED("Remove in v3.1: use t->GetVal(i) instead")
 	EnumVal(int i, EnumType* t) : Val(t)
@@ -1057,6 +1133,8 @@ protected:
 
 class VectorVal : public Val, public notifier::Modifiable {
 public:
+	DECLARE_POOL_ALLOCATOR(VectorVal)
+
 	explicit VectorVal(VectorType* t);
 	~VectorVal() override;
 
@@ -89,10 +89,10 @@ void FTP_Analyzer::DeliverStream(int length, const u_char* data, bool orig)
 		if ( cmd_len == 0 )
 			{
 			// Weird("FTP command missing", end_of_line - orig_line, orig_line);
-			cmd_str = new StringVal("<missing>");
+			cmd_str = val_mgr->GetInternedString("<missing>");
 			}
 		else
-			cmd_str = (new StringVal(cmd_len, cmd))->ToUpper();
+			cmd_str = val_mgr->GetInternedString(cmd_len, cmd, true);
 
 		vl = val_list{
 			BuildConnVal(),
@@ -183,7 +183,8 @@ void FTP_Analyzer::DeliverStream(int length, const u_char* data, bool orig)
 		f = ftp_reply;
 		}
 
-	ConnectionEvent(f, std::move(vl));
+	// The check at the top makes sure there's a handler for f.
+	ConnectionEventFast(f, std::move(vl));
 
 	ForwardStream(length, data, orig);
 	}
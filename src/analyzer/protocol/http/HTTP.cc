@@ -1314,7 +1314,7 @@ int HTTP_Analyzer::HTTP_RequestLine(const char* line, const char* end_of_line)
 	if ( rest == end_of_method )
 		goto error;
 
-	request_method = new StringVal(end_of_method - line, line);
+	request_method = val_mgr->GetInternedString(end_of_method - line, line);
 
 	if ( ! ParseRequest(rest, end_of_line) )
 		{
@@ -1438,7 +1438,7 @@ void HTTP_Analyzer::HTTP_Event(const char* category, StringVal* detail)
 		// DEBUG_MSG("%.6f http_event\n", network_time);
 		ConnectionEventFast(http_event, {
 			BuildConnVal(),
-			new StringVal(category),
+			val_mgr->GetInternedString(category),
 			detail,
 		});
 		}
@@ -1484,7 +1484,7 @@ void HTTP_Analyzer::HTTP_Request()
 			request_method,
 			TruncateURI(request_URI->AsStringVal()),
 			TruncateURI(unescaped_URI->AsStringVal()),
-			new StringVal(fmt("%.1f", request_version)),
+			val_mgr->GetInternedString(fmt("%.1f", request_version)),
 		});
 		}
 	}
@@ -1495,11 +1495,11 @@ void HTTP_Analyzer::HTTP_Reply()
 		{
 		ConnectionEventFast(http_reply, {
 			BuildConnVal(),
-			new StringVal(fmt("%.1f", reply_version)),
+			val_mgr->GetInternedString(fmt("%.1f", reply_version)),
 			val_mgr->GetCount(reply_code),
 			reply_reason_phrase ?
 				reply_reason_phrase->Ref() :
-				new StringVal("<empty>"),
+				val_mgr->GetInternedString("<empty>"),
 		});
 		}
 	else
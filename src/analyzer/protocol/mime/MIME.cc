@@ -549,8 +549,8 @@ void MIME_Entity::init()
 
 	need_to_parse_parameters = 0;
 
-	content_type_str = new StringVal("TEXT");
-	content_subtype_str = new StringVal("PLAIN");
+	content_type_str = val_mgr->GetInternedString("TEXT");
+	content_subtype_str = val_mgr->GetInternedString("PLAIN");
 
 	content_encoding_str = 0;
 	multipart_boundary = 0;
@@ -798,9 +798,9 @@ int MIME_Entity::ParseContentTypeField(MIME_Header* h)
 	len -= offset;
 
 	Unref(content_type_str);
-	content_type_str = (new StringVal(ty.length, ty.data))->ToUpper();
+	content_type_str = val_mgr->GetInternedString(ty.length, ty.data, true);
 	Unref(content_subtype_str);
-	content_subtype_str = (new StringVal(subty.length, subty.data))->ToUpper();
+	content_subtype_str = val_mgr->GetInternedString(subty.length, subty.data, true);
 
 	ParseContentType(ty, subty);
 
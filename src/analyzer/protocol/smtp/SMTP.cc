@@ -354,7 +354,7 @@ void SMTP_Analyzer::ProcessLine(int length, const char* line, bool orig)
 					BuildConnVal(),
 					val_mgr->GetBool(orig),
 					val_mgr->GetCount(reply_code),
-					new StringVal(cmd),
+					val_mgr->GetInternedString(cmd),
 					new StringVal(end_of_line - line, line),
 					val_mgr->GetBool((pending_reply > 0)),
 				});
@@ -858,7 +858,7 @@ void SMTP_Analyzer::RequestEvent(int cmd_len, const char* cmd,
 		ConnectionEventFast(smtp_request, {
 			BuildConnVal(),
 			val_mgr->GetBool(orig_is_sender),
-			(new StringVal(cmd_len, cmd))->ToUpper(),
+			val_mgr->GetInternedString(cmd_len, cmd, true),
 			new StringVal(arg_len, arg),
 		});
 	}
@@ -1,6 +1,7 @@
 #include <algorithm>
 
 #include "ContentLine.h"
+#include "LineScan.h"
 #include "analyzer/protocol/tcp/TCP.h"
 
 #include "events.bif.h"
@@ -235,12 +236,36 @@ void ContentLine_Analyzer::DoDeliver(int len, const u_char* data)
 int ContentLine_Analyzer::DoDeliverOnce(int len, const u_char* data)
 	{
 	const u_char* data_start = data;
+	const u_char* data_end = data + len;
 
 	if ( len <= 0 )
 		return 0;
 
 	for ( ; len > 0; --len, ++data )
 		{
+		// Copy any run of characters that need no special treatment
+		// in one go.  The byte following it, if any, goes through
+		// the checks below.
+		int n = find_line_special(data, data_end) - data;
+		n = min(n, min(buf_len, max_line_length) - offset);
+
+		if ( n > 0 )
+			{
+			memcpy(buf + offset, data, n);
+			offset += n;
+
+			if ( last_char == '\r' )
+				if ( ! suppress_weirds && Conn()->FlagEvent(SINGULAR_CR) )
+					Conn()->Weird("line_terminated_with_single_CR");
+
+			last_char = data[n - 1];
+			data += n;
+			len -= n;
+
+			if ( len == 0 )
+				break;
+			}
+
 		if ( offset >= buf_len )
 			InitBuffer(buf_len * 2);
 
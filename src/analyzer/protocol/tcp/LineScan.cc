@@ -0,0 +1,111 @@
+#include "LineScan.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define HAVE_AVX2_TARGET
+#endif
+
+using namespace analyzer::tcp;
+
+static inline bool is_line_special(u_char c)
+	{
+	return c == '\r' || c == '\n' || c == '\0';
+	}
+
+static const u_char* find_scalar(const u_char* data, const u_char* end)
+	{
+	while ( data < end && ! is_line_special(*data) )
+		++data;
+
+	return data;
+	}
+
+#if defined(__SSE2__)
+
+static const u_char* find_sse2(const u_char* data, const u_char* end)
+	{
+	const __m128i cr = _mm_set1_epi8('\r');
+	const __m128i lf = _mm_set1_epi8('\n');
+	const __m128i nul = _mm_setzero_si128();
+
+	for ( ; end - data >= 16; data += 16 )
+		{
+		__m128i v = _mm_loadu_si128((const __m128i*) data);
+		__m128i m = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, cr),
+		                                      _mm_cmpeq_epi8(v, lf)),
+		                         _mm_cmpeq_epi8(v, nul));
+		int mask = _mm_movemask_epi8(m);
+
+		if ( mask )
+			return data + __builtin_ctz(mask);
+		}
+
+	return find_scalar(data, end);
+	}
+
+#endif
+
+#if defined(HAVE_AVX2_TARGET)
+
+__attribute__((target("avx2")))
+static const u_char* find_avx2(const u_char* data, const u_char* end)
+	{
+	const __m256i cr = _mm256_set1_epi8('\r');
+	const __m256i lf = _mm256_set1_epi8('\n');
+	const __m256i nul = _mm256_setzero_si256();
+
+	for ( ; end - data >= 32; data += 32 )
+		{
+		__m256i v = _mm256_loadu_si256((const __m256i*) data);
+		__m256i m = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, cr),
+		                                            _mm256_cmpeq_epi8(v, lf)),
+		                            _mm256_cmpeq_epi8(v, nul));
+		unsigned int mask = _mm256_movemask_epi8(m);
+
+		if ( mask )
+			return data + __builtin_ctz(mask);
+		}
+
+	return find_sse2(data, end);
+	}
+
+#endif
+
+typedef const u_char* (*find_func)(const u_char* data, const u_char* end);
+
+struct LineScanner {
+	find_func find;
+	const char* name;
+};
+
+static LineScanner select_scanner()
+	{
+#if defined(HAVE_AVX2_TARGET)
+	__builtin_cpu_init();
+
+	if ( __builtin_cpu_supports("avx2") )
+		return { find_avx2, "avx2" };
+#endif
+
+#if defined(__SSE2__)
+	return { find_sse2, "sse2" };
+#else
+	return { find_scalar, "scalar" };
+#endif
+	}
+
+static const LineScanner scanner = select_scanner();
+
+const u_char* analyzer::tcp::find_line_special(const u_char* data, const u_char* end)
+	{
+	return scanner.find(data, end);
+	}
+
+const char* analyzer::tcp::line_scan_impl()
+	{
+	return scanner.name;
+	}
@@ -0,0 +1,22 @@
+// Finds the characters that ContentLine_Analyzer needs to look at
+// individually, so that it can copy everything in between in bulk.
+
+#ifndef ANALYZER_PROTOCOL_TCP_LINESCAN_H
+#define ANALYZER_PROTOCOL_TCP_LINESCAN_H
+
+#include <sys/types.h>
+
+namespace analyzer { namespace tcp {
+
+// Returns a pointer to the first CR, LF or NUL in [data, end), or end
+// if there's none.  Uses the widest vector instructions the CPU
+// supports, as determined at startup.
+const u_char* find_line_special(const u_char* data, const u_char* end);
+
+// Returns the name of the implementation find_line_special() uses:
+// "avx2", "sse2" or "scalar".
+const char* line_scan_impl();
+
+} } // namespace analyzer::*
+
+#endif
@@ -32,6 +32,7 @@ TCP_Reassembler::TCP_Reassembler(analyzer::Analyzer* arg_dst_analyzer,
 	skip_deliveries = 0;
 	did_EOF = 0;
 	seq_to_skip = 0;
+	direct_seq = direct_upper = 0;
 	in_delivery = false;
 
 	if ( tcp_max_old_segments )
@@ -71,6 +72,8 @@ TCP_Reassembler* TCP_Reassembler::clone(Analyzer* arg_dst_analyzer, TCP_Analyzer
 	copy->did_EOF = did_EOF;
 	copy->skip_deliveries = skip_deliveries;
 	copy-> seq_to_skip = seq_to_skip;
+	copy->direct_seq = direct_seq;
+	copy->direct_upper = direct_upper;
 	copy->in_delivery = in_delivery;
 	copy->flags = flags;
 	copy->record_contents_file = f;
@@ -420,27 +423,79 @@ void TCP_Reassembler::BlockInserted(DataBlock* start_block)
 			}
 		}
 
-	TCP_Endpoint* e = endp;
+	if ( ! HoldDeliveredData() )
+		TrimToSeq(last_reassem_seq);
+
+	// Note: don't make an EOF check here, because then we'd miss it
+	// for FIN packets that don't carry any payload (and thus
+	// endpoint->DataSent is not called).  Instead, do the check in
+	// TCP_Connection::NextPacket.
+	}
+
+bool TCP_Reassembler::HoldDeliveredData() const
+	{
+	const TCP_Endpoint* e = endp;
 
 	if ( ! e->peer->HasContents() )
 		// Our endpoint's peer doesn't do reassembly and so
 		// (presumably) isn't processing acks.  So don't hold
-		// the now-delivered data.
-		TrimToSeq(last_reassem_seq);
+		// the delivered data.
+		return false;
 
-	else if ( e->NoDataAcked() && tcp_max_initial_window &&
-		  e->Size() > static_cast<uint64>(tcp_max_initial_window) )
+	if ( e->NoDataAcked() && tcp_max_initial_window &&
+	     e->Size() > static_cast<uint64>(tcp_max_initial_window) )
 		// We've sent quite a bit of data, yet none of it has
 		// been acked.  Presume that we're not seeing the peer's
 		// acks (perhaps due to filtering or split routing) and
 		// don't hang onto the data further, as we may wind up
 		// carrying it all the way until this connection ends.
+		return false;
+
+	// Keep it until it's acked, to compare it against
+	// retransmissions.
+	return true;
+	}
+
+bool TCP_Reassembler::DeliverDirectly(uint64 seq, int len, const u_char* data)
+	{
+	// Data continuing the stream right where we are, with nothing
+	// else pending, can go to the analyzers straight from the packet.
+	// We only need a copy if we have to keep the data around after
+	// delivering it: for the contents file, as an old block, or for
+	// reporting inconsistent retransmissions.
+	if ( len <= 0 || blocks || seq != last_reassem_seq ||
+	     seq < trim_seq || max_old_blocks || record_contents_file )
+		return false;
+
+	if ( rexmit_inconsistency && HoldDeliveredData() )
+		return false;
+
+	last_reassem_seq += len;
+	DeliverBlock(seq, len, data);
+
+	if ( ! HoldDeliveredData() )
+		{
 		TrimToSeq(last_reassem_seq);
+		return true;
+		}
 
-	// Note: don't make an EOF check here, because then we'd miss it
-	// for FIN packets that don't carry any payload (and thus
-	// endpoint->DataSent is not called).  Instead, do the check in
-	// TCP_Connection::NextPacket.
+	// Otherwise we leave trim_seq where it is, so that the acks for
+	// this data get accounted for just as if we had buffered it, and
+	// remember the range for HeldDirectBytes().
+	if ( direct_upper <= trim_seq )
+		direct_seq = seq;
+
+	direct_upper = last_reassem_seq;
+
+	return true;
+	}
+
+uint64 TCP_Reassembler::HeldDirectBytes() const
+	{
+	if ( direct_upper <= trim_seq )
+		return 0;
+
+	return direct_upper - std::max(direct_seq, trim_seq);
 	}
 
 void TCP_Reassembler::Overlap(const u_char* b1, const u_char* b2, uint64 n)
@@ -506,8 +561,27 @@ int TCP_Reassembler::DataSent(double t, uint64 seq, int len,
 		len -= amount_acked;
 		}
 
+	if ( seq < last_reassem_seq && upper_seq > last_reassem_seq &&
+	     ! rexmit_inconsistency )
+		{
+		// Part of this is a retransmission of data we've already
+		// delivered.  That data may have gone out directly without
+		// being buffered, in which case the reassembler would take
+		// the old part for new data sitting below last_reassem_seq
+		// and never deliver the rest.  Nobody compares
+		// retransmissions against the original, so just skip what
+		// we've already passed along.
+		uint64 amount_delivered = last_reassem_seq - seq;
+		seq += amount_delivered;
+		data += amount_delivered;
+		len -= amount_delivered;
+		}
+
 	flags = arg_flags;
-	NewBlock(t, seq, len, data);
+
+	if ( ! DeliverDirectly(seq, len, data) )
+		NewBlock(t, seq, len, data);
+
 	flags = TCP_Flags();
 
 	if ( Endpoint()->NoDataAcked() && tcp_max_above_hole_without_any_acks &&
@@ -519,7 +593,8 @@ int TCP_Reassembler::DataSent(double t, uint64 seq, int len,
 		}
 
 	if ( tcp_excessive_data_without_further_acks &&
-	     size_of_all_blocks > static_cast<uint64>(tcp_excessive_data_without_further_acks) )
+	     size_of_all_blocks + HeldDirectBytes() >
+	     static_cast<uint64>(tcp_excessive_data_without_further_acks) )
 		{
 		tcp_analyzer->Weird("excessive_data_without_further_acks");
 		ClearBlocks();
@@ -99,6 +99,21 @@ private:
 	void RecordGap(uint64 start_seq, uint64 upper_seq, BroFile* f);
 
 	void BlockInserted(DataBlock* b) override;
+
+	// Returns true if data needs to be held on to after delivery,
+	// until the peer acks it.
+	bool HoldDeliveredData() const;
+
+	// Delivers in-order data without buffering it, if nothing needs
+	// the copy. Returns false if the data needs to go through
+	// NewBlock() instead.
+	bool DeliverDirectly(uint64 seq, int len, const u_char* data);
+
+	// Returns how many bytes delivered by DeliverDirectly() we're
+	// still waiting to see acked. They aren't buffered, but count
+	// towards tcp_excessive_data_without_further_acks as if they were.
+	uint64 HeldDirectBytes() const;
+
 	void Overlap(const u_char* b1, const u_char* b2, uint64 n) override;
 
 	TCP_Endpoint* endp;
@@ -110,6 +125,11 @@ private:
 
 	uint64 seq_to_skip;
 
+	// The range of directly delivered data held until acked. It's
+	// always contiguous, and below any blocks.
+	uint64 direct_seq;
+	uint64 direct_upper;
+
 	bool in_delivery;
 	analyzer::tcp::TCP_Flags flags;
 
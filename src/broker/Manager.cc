@@ -1494,6 +1494,7 @@ StoreHandleVal* Manager::MakeMaster(const string& name, broker::backend type,
 	Ref(handle);
 
 	data_stores.emplace(name, handle);
+	iosource_mgr->RegisterFd(handle->proxy.mailbox().descriptor(), this);
 
 	if ( bstate->endpoint.use_real_time() )
 		return handle;
@@ -1530,6 +1531,7 @@ StoreHandleVal* Manager::MakeClone(const string& name, double resync_interval,
 	Ref(handle);
 
 	data_stores.emplace(name, handle);
+	iosource_mgr->RegisterFd(handle->proxy.mailbox().descriptor(), this);
 
 	return handle;
 	}
@@ -1560,6 +1562,7 @@ bool Manager::CloseStore(const string& name)
 		++i;
 		}
 
+	iosource_mgr->UnregisterFd(s->second->proxy.mailbox().descriptor());
 	Unref(s->second);
 	data_stores.erase(s);
 	return true;
@@ -428,14 +428,17 @@ void file_analysis::OCSP::ParseRequest(OCSP_REQUEST* req)
 	int req_count = OCSP_request_onereq_count(req);
 	for ( int i=0; i<req_count; i++ )
 		{
-		val_list rvl(5);
-		rvl.push_back(GetFile()->GetVal()->Ref());
+		mgr.QueueEventLazy(ocsp_request_certificate, [&]()
+			{
+			val_list rvl(5);
+			rvl.push_back(GetFile()->GetVal()->Ref());
 
-		OCSP_ONEREQ *one_req = OCSP_request_onereq_get0(req, i);
-		OCSP_CERTID *cert_id = OCSP_onereq_get0_id(one_req);
+			OCSP_ONEREQ *one_req = OCSP_request_onereq_get0(req, i);
+			OCSP_CERTID *cert_id = OCSP_onereq_get0_id(one_req);
 
-		ocsp_add_cert_id(cert_id, &rvl, bio);
-		mgr.QueueEvent(ocsp_request_certificate, std::move(rvl));
+			ocsp_add_cert_id(cert_id, &rvl, bio);
+			return rvl;
+			});
 		}
 
 	BIO_free(bio);
@@ -451,8 +454,6 @@ void file_analysis::OCSP::ParseResponse(OCSP_RESPONSE *resp)
 	const STACK_OF(X509)* certs = nullptr;
 
 	int resp_count, num_ext = 0;
-	VectorVal *certs_vector = nullptr;
-	int len = 0;
 
  	char buf[OCSP_STRING_BUF_SIZE];
 	memset(buf, 0, sizeof(buf));
@@ -477,8 +478,6 @@ void file_analysis::OCSP::ParseResponse(OCSP_RESPONSE *resp)
 	//int len = BIO_read(bio, buf, sizeof(buf));
 	//BIO_reset(bio);
 
-	val_list vl(8);
-
 	// get the basic response
 	basic_resp = OCSP_response_get1_basic(resp);
 	if ( !basic_resp )
@@ -496,37 +495,6 @@ void file_analysis::OCSP::ParseResponse(OCSP_RESPONSE *resp)
 		}
 #endif
 
-	vl.push_back(GetFile()->GetVal()->Ref());
-	vl.push_back(status_val);
-
-#if ( OPENSSL_VERSION_NUMBER < 0x10100000L ) || defined(LIBRESSL_VERSION_NUMBER)
-	vl.push_back(val_mgr->GetCount((uint64)ASN1_INTEGER_get(resp_data->version)));
-#else
-	vl.push_back(parse_basic_resp_data_version(basic_resp));
-#endif
-
-	// responderID
-	if ( OCSP_RESPID_bio(basic_resp, bio) )
-		{
-		len = BIO_read(bio, buf, sizeof(buf));
-		vl.push_back(new StringVal(len, buf));
-		BIO_reset(bio);
-		}
-	else
-		{
-		reporter->Weird("OpenSSL failed to get OCSP responder id");
-		vl.push_back(val_mgr->GetEmptyString());
-		}
-
-	// producedAt
-#if ( OPENSSL_VERSION_NUMBER < 0x10100000L ) || defined(LIBRESSL_VERSION_NUMBER)
-	produced_at = resp_data->producedAt;
-#else
-	produced_at = OCSP_resp_get0_produced_at(basic_resp);
-#endif
-
-	vl.push_back(new Val(GetTimeFromAsn1(produced_at, GetFile(), reporter), TYPE_TIME));
-
 	// responses
 
 	resp_count = OCSP_resp_count(basic_resp);
@@ -538,9 +506,6 @@ void file_analysis::OCSP::ParseResponse(OCSP_RESPONSE *resp)
 		if ( !single_resp )
 			continue;
 
-		val_list rvl(10);
-		rvl.push_back(GetFile()->GetVal()->Ref());
-
 		// cert id
 		const OCSP_CERTID* cert_id = nullptr;
 
@@ -550,55 +515,61 @@ void file_analysis::OCSP::ParseResponse(OCSP_RESPONSE *resp)
 		cert_id = OCSP_SINGLERESP_get0_id(single_resp);
 #endif
 
-		ocsp_add_cert_id(cert_id, &rvl, bio);
-		BIO_reset(bio);
-
-		// certStatus
-		int status = V_OCSP_CERTSTATUS_UNKNOWN;
-		int reason = OCSP_REVOKED_STATUS_NOSTATUS;
-		ASN1_GENERALIZEDTIME* revoke_time = nullptr;
-		ASN1_GENERALIZEDTIME* this_update = nullptr;
-		ASN1_GENERALIZEDTIME* next_update = nullptr;
-
-		if ( ! OCSP_resp_find_status(basic_resp,
-		                             const_cast<OCSP_CERTID*>(cert_id),
-		                             &status, &reason, &revoke_time,
-		                             &this_update, &next_update) )
-			reporter->Weird("OpenSSL failed to find status of OCSP response");
-
-		const char* cert_status_str = OCSP_cert_status_str(status);
-		rvl.push_back(new StringVal(strlen(cert_status_str), cert_status_str));
-
-		// revocation time and reason if revoked
-		if ( status == V_OCSP_CERTSTATUS_REVOKED )
+		mgr.QueueEventLazy(ocsp_response_certificate, [&]()
 			{
-			rvl.push_back(new Val(GetTimeFromAsn1(revoke_time, GetFile(), reporter), TYPE_TIME));
-
-			if ( reason != OCSP_REVOKED_STATUS_NOSTATUS )
+			val_list rvl(10);
+			rvl.push_back(GetFile()->GetVal()->Ref());
+
+			ocsp_add_cert_id(cert_id, &rvl, bio);
+			BIO_reset(bio);
+
+			// certStatus
+			int status = V_OCSP_CERTSTATUS_UNKNOWN;
+			int reason = OCSP_REVOKED_STATUS_NOSTATUS;
+			ASN1_GENERALIZEDTIME* revoke_time = nullptr;
+			ASN1_GENERALIZEDTIME* this_update = nullptr;
+			ASN1_GENERALIZEDTIME* next_update = nullptr;
+
+			if ( ! OCSP_resp_find_status(basic_resp,
+			                             const_cast<OCSP_CERTID*>(cert_id),
+			                             &status, &reason, &revoke_time,
+			                             &this_update, &next_update) )
+				reporter->Weird("OpenSSL failed to find status of OCSP response");
+
+			const char* cert_status_str = OCSP_cert_status_str(status);
+			rvl.push_back(new StringVal(strlen(cert_status_str), cert_status_str));
+
+			// revocation time and reason if revoked
+			if ( status == V_OCSP_CERTSTATUS_REVOKED )
 				{
-				const char* revoke_reason = OCSP_crl_reason_str(reason);
-				rvl.push_back(new StringVal(strlen(revoke_reason), revoke_reason));
+				rvl.push_back(new Val(GetTimeFromAsn1(revoke_time, GetFile(), reporter), TYPE_TIME));
+
+				if ( reason != OCSP_REVOKED_STATUS_NOSTATUS )
+					{
+					const char* revoke_reason = OCSP_crl_reason_str(reason);
+					rvl.push_back(new StringVal(strlen(revoke_reason), revoke_reason));
+					}
+				else
+					rvl.push_back(new StringVal(0, ""));
 				}
 			else
+				{
+				rvl.push_back(new Val(0.0, TYPE_TIME));
 				rvl.push_back(new StringVal(0, ""));
-			}
-		else
-			{
-			rvl.push_back(new Val(0.0, TYPE_TIME));
-			rvl.push_back(new StringVal(0, ""));
-			}
+				}
 
-		if ( this_update )
-			rvl.push_back(new Val(GetTimeFromAsn1(this_update, GetFile(), reporter), TYPE_TIME));
-		else
-			rvl.push_back(new Val(0.0, TYPE_TIME));
+			if ( this_update )
+				rvl.push_back(new Val(GetTimeFromAsn1(this_update, GetFile(), reporter), TYPE_TIME));
+			else
+				rvl.push_back(new Val(0.0, TYPE_TIME));
 
-		if ( next_update )
-			rvl.push_back(new Val(GetTimeFromAsn1(next_update, GetFile(), reporter), TYPE_TIME));
-		else
-			rvl.push_back(new Val(0.0, TYPE_TIME));
+			if ( next_update )
+				rvl.push_back(new Val(GetTimeFromAsn1(next_update, GetFile(), reporter), TYPE_TIME));
+			else
+				rvl.push_back(new Val(0.0, TYPE_TIME));
 
-		mgr.QueueEvent(ocsp_response_certificate, std::move(rvl));
+			return rvl;
+			});
 
 		num_ext = OCSP_SINGLERESP_get_ext_count(single_resp);
 		for ( int k = 0; k < num_ext; ++k )
@@ -611,44 +582,84 @@ void file_analysis::OCSP::ParseResponse(OCSP_RESPONSE *resp)
 			}
 		}
 
+	// The response's own event comes after those of its certificates.
+	mgr.QueueEventLazy(ocsp_response_bytes, [&]()
+		{
+		val_list vl(8);
+		int len = 0;
+
+		vl.push_back(GetFile()->GetVal()->Ref());
+		vl.push_back(status_val->Ref());
+
 #if ( OPENSSL_VERSION_NUMBER < 0x10100000L ) || defined(LIBRESSL_VERSION_NUMBER)
-	i2a_ASN1_OBJECT(bio, basic_resp->signatureAlgorithm->algorithm);
-	len = BIO_read(bio, buf, sizeof(buf));
-	vl.push_back(new StringVal(len, buf));
-	BIO_reset(bio);
+		vl.push_back(val_mgr->GetCount((uint64)ASN1_INTEGER_get(resp_data->version)));
 #else
-	vl.push_back(parse_basic_resp_sig_alg(basic_resp, bio, buf, sizeof(buf)));
+		vl.push_back(parse_basic_resp_data_version(basic_resp));
 #endif
 
-	//i2a_ASN1_OBJECT(bio, basic_resp->signature);
-	//len = BIO_read(bio, buf, sizeof(buf));
-	//ocsp_resp_record->Assign(7, new StringVal(len, buf));
-	//BIO_reset(bio);
+		// responderID
+		if ( OCSP_RESPID_bio(basic_resp, bio) )
+			{
+			len = BIO_read(bio, buf, sizeof(buf));
+			vl.push_back(new StringVal(len, buf));
+			BIO_reset(bio);
+			}
+		else
+			{
+			reporter->Weird("OpenSSL failed to get OCSP responder id");
+			vl.push_back(val_mgr->GetEmptyString());
+			}
+
+		// producedAt
+#if ( OPENSSL_VERSION_NUMBER < 0x10100000L ) || defined(LIBRESSL_VERSION_NUMBER)
+		produced_at = resp_data->producedAt;
+#else
+		produced_at = OCSP_resp_get0_produced_at(basic_resp);
+#endif
 
-	certs_vector = new VectorVal(internal_type("x509_opaque_vector")->AsVectorType());
-	vl.push_back(certs_vector);
+		vl.push_back(new Val(GetTimeFromAsn1(produced_at, GetFile(), reporter), TYPE_TIME));
 
 #if ( OPENSSL_VERSION_NUMBER < 0x10100000L ) || defined(LIBRESSL_VERSION_NUMBER)
-	certs = basic_resp->certs;
+		i2a_ASN1_OBJECT(bio, basic_resp->signatureAlgorithm->algorithm);
+		len = BIO_read(bio, buf, sizeof(buf));
+		vl.push_back(new StringVal(len, buf));
+		BIO_reset(bio);
 #else
-	certs = OCSP_resp_get0_certs(basic_resp);
+		vl.push_back(parse_basic_resp_sig_alg(basic_resp, bio, buf, sizeof(buf)));
 #endif
 
-	if ( certs )
-		{
-		int num_certs = sk_X509_num(certs);
-		for ( int i=0; i<num_certs; i++ )
+		//i2a_ASN1_OBJECT(bio, basic_resp->signature);
+		//len = BIO_read(bio, buf, sizeof(buf));
+		//ocsp_resp_record->Assign(7, new StringVal(len, buf));
+		//BIO_reset(bio);
+
+		VectorVal* certs_vector = new VectorVal(internal_type("x509_opaque_vector")->AsVectorType());
+		vl.push_back(certs_vector);
+
+#if ( OPENSSL_VERSION_NUMBER < 0x10100000L ) || defined(LIBRESSL_VERSION_NUMBER)
+		certs = basic_resp->certs;
+#else
+		certs = OCSP_resp_get0_certs(basic_resp);
+#endif
+
+		if ( certs )
 			{
-			::X509 *this_cert = X509_dup(helper_sk_X509_value(certs, i));
-			//::X509 *this_cert = X509_dup(sk_X509_value(certs, i));
-			if (this_cert)
-				certs_vector->Assign(i, new file_analysis::X509Val(this_cert));
-			else
-				reporter->Weird("OpenSSL returned null certificate");
-			}
-	  }
+			int num_certs = sk_X509_num(certs);
+			for ( int i=0; i<num_certs; i++ )
+				{
+				::X509 *this_cert = X509_dup(helper_sk_X509_value(certs, i));
+				//::X509 *this_cert = X509_dup(sk_X509_value(certs, i));
+				if (this_cert)
+					certs_vector->Assign(i, new file_analysis::X509Val(this_cert));
+				else
+					reporter->Weird("OpenSSL returned null certificate");
+				}
+		  }
+
+		return vl;
+		});
 
-	mgr.QueueEvent(ocsp_response_bytes, std::move(vl));
+	Unref(status_val);
 
 	// ok, now that we are done with the actual certificate - let's parse extensions :)
 	num_ext = OCSP_BASICRESP_get_ext_count(basic_resp);
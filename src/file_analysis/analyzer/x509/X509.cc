@@ -1,6 +1,7 @@
 // See the file "COPYING" in the main distribution directory for copyright.
 
 #include <string>
+#include <vector>
 
 #include "X509.h"
 #include "Event.h"
@@ -57,11 +58,14 @@ bool file_analysis::X509::EndOfFile()
 	RecordVal* cert_record = ParseCertificate(cert_val, GetFile());
 
 	// and send the record on to scriptland
-	mgr.QueueEvent(x509_certificate, {
-		GetFile()->GetVal()->Ref(),
-		cert_val->Ref(),
-		cert_record->Ref(), // we Ref it here, because we want to keep a copy around for now...
-	});
+	mgr.QueueEventLazy(x509_certificate, [&]()
+		{
+		return val_list{
+			GetFile()->GetVal()->Ref(),
+			cert_val->Ref(),
+			cert_record->Ref(), // we Ref it here, because we want to keep a copy around for now...
+		};
+		});
 
 	// after parsing the certificate - parse the extensions...
 
@@ -273,10 +277,13 @@ void file_analysis::X509::ParseSAN(X509_EXTENSION* ext)
 		return;
 		}
 
-	VectorVal* names = 0;
-	VectorVal* emails = 0;
-	VectorVal* uris = 0;
-	VectorVal* ips = 0;
+	// The names get collected first, so that the weirds below get
+	// reported whether or not anything handles the event.
+	std::vector<std::string> names;
+	std::vector<std::string> emails;
+	std::vector<std::string> uris;
+	std::vector<IPAddr> ips;
+	bool have_ips = false;
 
 	unsigned int otherfields = 0;
 
@@ -298,45 +305,34 @@ void file_analysis::X509::ParseSAN(X509_EXTENSION* ext)
 #else
 			const char* name = (const char*) ASN1_STRING_get0_data(gen->d.ia5);
 #endif
-			StringVal* bs = new StringVal(name);
 
 			switch ( gen->type )
 				{
 				case GEN_DNS:
-					if ( names == 0 )
-						names = new VectorVal(internal_type("string_vec")->AsVectorType());
-
-					names->Assign(names->Size(), bs);
+					names.push_back(name);
 					break;
 
 				case GEN_URI:
-					if ( uris == 0 )
-						uris = new VectorVal(internal_type("string_vec")->AsVectorType());
-
-					uris->Assign(uris->Size(), bs);
+					uris.push_back(name);
 					break;
 
 				case GEN_EMAIL:
-					if ( emails == 0 )
-						emails = new VectorVal(internal_type("string_vec")->AsVectorType());
-
-					emails->Assign(emails->Size(), bs);
+					emails.push_back(name);
 					break;
 				}
 			}
 
 		else if ( gen->type == GEN_IPADD )
 			{
-				if ( ips == 0 )
-					ips = new VectorVal(internal_type("addr_vec")->AsVectorType());
+				have_ips = true;
 
 				uint32* addr = (uint32*) gen->d.ip->data;
 
 				if( gen->d.ip->length == 4 )
-					ips->Assign(ips->Size(), new AddrVal(*addr));
+					ips.push_back(IPAddr(IPv4, addr, IPAddr::Network));
 
 				else if ( gen->d.ip->length == 16 )
-					ips->Assign(ips->Size(), new AddrVal(addr));
+					ips.push_back(IPAddr(IPv6, addr, IPAddr::Network));
 
 				else
 					{
@@ -354,27 +350,48 @@ void file_analysis::X509::ParseSAN(X509_EXTENSION* ext)
 			}
 		}
 
+	GENERAL_NAMES_free(altname);
+
+	mgr.QueueEventLazy(x509_ext_subject_alternative_name, [&]()
+		{
+		auto string_vec = [](const std::vector<std::string>& strs)
+			{
+			VectorVal* v = new VectorVal(internal_type("string_vec")->AsVectorType());
+
+			for ( const auto& s : strs )
+				v->Assign(v->Size(), new StringVal(s));
+
+			return v;
+			};
+
 		RecordVal* sanExt = new RecordVal(BifType::Record::X509::SubjectAlternativeName);
 
-		if ( names != 0 )
-			sanExt->Assign(0, names);
+		if ( ! names.empty() )
+			sanExt->Assign(0, string_vec(names));
 
-		if ( uris != 0 )
-			sanExt->Assign(1, uris);
+		if ( ! uris.empty() )
+			sanExt->Assign(1, string_vec(uris));
 
-		if ( emails != 0 )
-			sanExt->Assign(2, emails);
+		if ( ! emails.empty() )
+			sanExt->Assign(2, string_vec(emails));
 
-		if ( ips != 0 )
-			sanExt->Assign(3, ips);
+		if ( have_ips )
+			{
+			VectorVal* v = new VectorVal(internal_type("addr_vec")->AsVectorType());
+
+			for ( const auto& a : ips )
+				v->Assign(v->Size(), new AddrVal(a));
+
+			sanExt->Assign(3, v);
+			}
 
 		sanExt->Assign(4, val_mgr->GetBool(otherfields));
 
-		mgr.QueueEvent(x509_ext_subject_alternative_name, {
+		return val_list{
 			GetFile()->GetVal()->Ref(),
 			sanExt,
+		};
 		});
-	GENERAL_NAMES_free(altname);
 	}
 
 StringVal* file_analysis::X509::KeyCurve(EVP_PKEY *key)
@@ -244,50 +244,56 @@ void file_analysis::X509Common::ParseExtension(X509_EXTENSION* ex, EventHandlerP
 	if ( X509_EXTENSION_get_critical(ex) != 0 )
 		critical = 1;
 
-	BIO *bio = BIO_new(BIO_s_mem());
-	if( ! X509V3_EXT_print(bio, ex, 0, 0))
+	// send off generic extension event
+	//
+	// and then look if we have a specialized event for the extension we just
+	// parsed. And if we have it, we send the specialized event on top of the
+	// generic event that we just had. I know, that is... kind of not nice,
+	// but I am not sure if there is a better way to do it...
+	//
+	// Printing the extension is the expensive part, so we only do it if
+	// the generic event is handled.
+
+	mgr.QueueEventLazy(h, [&]()
 		{
-		unsigned char *buf = nullptr;
-		int len = i2d_ASN1_OCTET_STRING(X509_EXTENSION_get_data(ex), &buf);
-		if ( len >=0 )
+		BIO *bio = BIO_new(BIO_s_mem());
+		if( ! X509V3_EXT_print(bio, ex, 0, 0))
 			{
-			BIO_write(bio, buf, len);
-			OPENSSL_free(buf);
+			unsigned char *buf = nullptr;
+			int len = i2d_ASN1_OCTET_STRING(X509_EXTENSION_get_data(ex), &buf);
+			if ( len >=0 )
+				{
+				BIO_write(bio, buf, len);
+				OPENSSL_free(buf);
+				}
 			}
-		}
 
-	StringVal* ext_val = GetExtensionFromBIO(bio, GetFile());
+		StringVal* ext_val = GetExtensionFromBIO(bio, GetFile());
 
-	if ( ! ext_val )
-		ext_val = new StringVal(0, "");
+		if ( ! ext_val )
+			ext_val = new StringVal(0, "");
 
-	RecordVal* pX509Ext = new RecordVal(BifType::Record::X509::Extension);
-	pX509Ext->Assign(0, new StringVal(name));
+		RecordVal* pX509Ext = new RecordVal(BifType::Record::X509::Extension);
+		pX509Ext->Assign(0, new StringVal(name));
 
-	if ( short_name and strlen(short_name) > 0 )
-		pX509Ext->Assign(1, new StringVal(short_name));
+		if ( short_name and strlen(short_name) > 0 )
+			pX509Ext->Assign(1, new StringVal(short_name));
 
-	pX509Ext->Assign(2, new StringVal(oid));
-	pX509Ext->Assign(3, val_mgr->GetBool(critical));
-	pX509Ext->Assign(4, ext_val);
+		pX509Ext->Assign(2, new StringVal(oid));
+		pX509Ext->Assign(3, val_mgr->GetBool(critical));
+		pX509Ext->Assign(4, ext_val);
 
-	// send off generic extension event
-	//
-	// and then look if we have a specialized event for the extension we just
-	// parsed. And if we have it, we send the specialized event on top of the
-	// generic event that we just had. I know, that is... kind of not nice,
-	// but I am not sure if there is a better way to do it...
+		if ( h == ocsp_extension )
+			return val_list{
+				GetFile()->GetVal()->Ref(),
+				pX509Ext,
+				val_mgr->GetBool(global ? 1 : 0),
+			};
 
-	if ( h == ocsp_extension )
-		mgr.QueueEvent(h, {
-			GetFile()->GetVal()->Ref(),
-			pX509Ext,
-			val_mgr->GetBool(global ? 1 : 0),
-		});
-	else
-		mgr.QueueEvent(h, {
+		return val_list{
 			GetFile()->GetVal()->Ref(),
 			pX509Ext,
+		};
 		});
 
 	// let individual analyzers parse more.
@@ -85,6 +85,19 @@ public:
 		return fds.empty();
 		}
 
+	/**
+	 * @return iterators over the file descriptors in the set.
+	 */
+	std::set<int>::const_iterator begin() const
+		{
+		return fds.begin();
+		}
+
+	std::set<int>::const_iterator end() const
+		{
+		return fds.end();
+		}
+
 	/**
 	 * @return the greatest file descriptor of all that have been added to the
 	 * set, or -1 if the set is empty.
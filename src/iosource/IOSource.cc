@@ -0,0 +1,16 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "IOSource.h"
+#include "Manager.h"
+
+using namespace iosource;
+
+void IOSource::Activate()
+	{
+	manager->Activate(this);
+	}
+
+double IOSource::GetPollInterval()
+	{
+	return Manager::DEFAULT_POLL_INTERVAL;
+	}
@@ -13,6 +13,8 @@ extern "C" {
 
 namespace iosource {
 
+class Manager;
+
 /**
  * Interface class for components providing/consuming data inside Bro's main
  * loop.
@@ -22,7 +24,14 @@ public:
 	/**
 	 * Constructor.
 	 */
-	IOSource()	{ idle = false; closed = false; }
+	IOSource()
+		{
+		idle = false;
+		closed = false;
+		manager = 0;
+		order = 0;
+		active = false;
+		}
 
 	/**
 	 * Destructor.
@@ -55,6 +64,14 @@ public:
 	 * Returns select'able file descriptors for this source. Leaves the
 	 * passed values untouched if not available.
 	 *
+	 * The manager asks only once, on its first look for input after the
+	 * source registered, and keeps watching the descriptors returned
+	 * then; it doesn't ask again when the source comes back from idling.
+	 * Only sources that don't return any descriptors get asked on every
+	 * round. A source that opens new descriptors later on must pass them
+	 * to Manager::RegisterFd(), and must call Manager::UnregisterFd()
+	 * before closing one while it stays registered.
+	 *
 	 * @param read Pointer to container where to insert a read descriptor.
 	 *
 	 * @param write Pointer to container where to insert a write descriptor.
@@ -63,6 +80,19 @@ public:
 	 */
 	virtual void GetFds(FD_Set* read, FD_Set* write, FD_Set* except) = 0;
 
+	/**
+	 * Returns how long the manager may go without asking a source that
+	 * doesn't have any file descriptors whether it has input, in seconds.
+	 * The manager waits at most that long for other sources' descriptors
+	 * while this one is idle. It's not used for sources with descriptors.
+	 *
+	 * Can be overridden by derived classes. The default is
+	 * Manager::DEFAULT_POLL_INTERVAL.
+	 *
+	 * @return The interval.
+	 */
+	virtual double GetPollInterval();
+
 	/**
 	 * Returns the timestamp (in \a global network time) associated with
 	 * next data item from this source.  If the source wants the data
@@ -121,7 +151,13 @@ protected:
 	 *
 	 * @param is_idle True if the source is idle currently.
 	 */
-	void SetIdle(bool is_idle)	{ idle = is_idle; }
+	void SetIdle(bool is_idle)
+		{
+		idle = is_idle;
+
+		if ( ! idle && ! active && manager )
+			Activate();
+		}
 
 	/*
 	 * Callback for derived class to call when they have shutdown.
@@ -131,8 +167,18 @@ protected:
 	void SetClosed(bool is_closed)	{ closed = is_closed; }
 
 private:
+	friend class Manager;
+
+	// Puts us back onto the manager's list of sources to check.
+	void Activate();
+
 	bool idle;
 	bool closed;
+
+	// Set up by the manager when registering the source.
+	Manager* manager;
+	int order;
+	bool active;
 };
 
 }
@@ -4,6 +4,8 @@
 #include <sys/time.h>
 #include <unistd.h>
 #include <assert.h>
+#include <errno.h>
+#include <string.h>
 
 #include <algorithm>
 
@@ -47,129 +49,141 @@ void Manager::RemoveAll()
 
 IOSource* Manager::FindSoonest(double* ts)
 	{
-	// Remove sources which have gone dry. For simplicity, we only
-	// remove at most one each time.
-	for ( SourceList::iterator i = sources.begin();
-	      i != sources.end(); ++i )
-		if ( ! (*i)->src->IsOpen() )
-			{
-			(*i)->src->Done();
-			delete *i;
-			sources.erase(i);
-			break;
-			}
-
-	// Ideally, we would always call select on the fds to see which
-	// are ready, and return the soonest. Unfortunately, that'd mean
-	// one select-call per packet, which we can't afford in high-volume
-	// environments.  Thus, we call select only every SELECT_FREQUENCY
-	// call (or if all sources report that they are dry).
+	// Ideally, we would always check which fds are ready, and return
+	// the soonest. Even though the set of fds is kept with the kernel,
+	// that'd still mean a system call per packet, which we can't afford
+	// in high-volume environments.  Thus, we check only every
+	// POLL_FREQUENCY call (or if all sources report that they are dry).
 
 	++call_count;
 
 	IOSource* soonest_src = 0;
 	double soonest_ts = 1e20;
 	double soonest_local_network_time = 1e20;
-	bool all_idle = true;
+	double poll_interval = -1;	// Of the sources we have to poll.
+	int timeout = 0;
 
 	// Find soonest source of those which tell us they have something to
 	// process.
-	for ( SourceList::iterator i = sources.begin(); i != sources.end(); ++i )
+	for ( size_t i = 0; i < active_sources.size(); )
 		{
-		if ( ! (*i)->src->IsIdle() )
+		IOSource* src = active_sources[i];
+
+		if ( src->IsIdle() || ! src->IsOpen() )
 			{
-			all_idle = false;
-			double local_network_time = 0;
-			double ts = (*i)->src->NextTimestamp(&local_network_time);
-			if ( ts >= 0 && ts < soonest_ts )
-				{
-				soonest_ts = ts;
-				soonest_src = (*i)->src;
-				soonest_local_network_time =
-					local_network_time ?
-						local_network_time : ts;
-				}
+			src->active = false;
+			active_sources.erase(active_sources.begin() + i);
+			continue;
+			}
+
+		double local_network_time = 0;
+		double ts = src->NextTimestamp(&local_network_time);
+		if ( ts >= 0 && ts < soonest_ts )
+			{
+			soonest_ts = ts;
+			soonest_src = src;
+			soonest_local_network_time =
+				local_network_time ?
+					local_network_time : ts;
 			}
+
+		++i;
 		}
 
-	// If we found one and aren't going to select this time,
+	// If we found one and aren't going to poll this time,
 	// return it.
-	int maxx = 0;
-
-	if ( soonest_src && (call_count % SELECT_FREQUENCY) != 0 )
+	if ( soonest_src && (call_count % POLL_FREQUENCY) != 0 )
 		goto finished;
 
-	// Select on the join of all file descriptors.
-	fd_set fd_read, fd_write, fd_except;
-
-	FD_ZERO(&fd_read);
-	FD_ZERO(&fd_write);
-	FD_ZERO(&fd_except);
-
-	for ( SourceList::iterator i = sources.begin();
-	      i != sources.end(); ++i )
+	for ( SourceList::iterator i = sources.begin(); i != sources.end(); )
 		{
 		Source* src = (*i);
 
-		if ( ! src->src->IsIdle() )
-			// No need to select on sources which we know to
-			// be ready.
+		// Remove sources which have gone dry.
+		if ( ! src->src->IsOpen() )
+			{
+			if ( src->src->active )
+				active_sources.erase(std::find(active_sources.begin(),
+							       active_sources.end(),
+							       src->src));
+
+			RemoveFds(src);
+			src->src->Done();
+			delete src;
+			i = sources.erase(i);
+			continue;
+			}
+
+		++i;
+
+		// Sources that haven't given us any fds need to be asked
+		// each time, which may also bring them out of idling.  If they
+		// come up with fds after all, we watch those from now on.
+		if ( src->fds_fetched &&
+		     (! src->polled || ! src->src->IsIdle()) )
 			continue;
 
-		src->Clear();
 		src->src->GetFds(&src->fd_read, &src->fd_write, &src->fd_except);
-		src->SetFds(&fd_read, &fd_write, &fd_except, &maxx);
-		}
+		src->fds_fetched = true;
+		AddFds(src);
 
-	// We can't block indefinitely even when all sources are dry:
-	// we're doing some IOSource-independent stuff in the main loop,
-	// so we need to return from time to time. (Instead of no time-out
-	// at all, we use a very small one. This lets FreeBSD trigger a
-	// BPF buffer switch on the next read when the hold buffer is empty
-	// while the store buffer isn't filled yet.
+		if ( src->polled )
+			{
+			double interval = src->src->GetPollInterval();
 
-	struct timeval timeout;
+			if ( poll_interval < 0 || interval < poll_interval )
+				poll_interval = interval;
+			}
+		}
 
-	if ( all_idle )
+	if ( active_sources.empty() )
 		{
-		// Interesting: when all sources are dry, simply sleeping a
-		// bit *without* watching for any fd becoming ready may
-		// decrease CPU load. I guess that's because it allows
-		// the kernel's packet buffers to fill. - Robin
-		timeout.tv_sec = 0;
-		timeout.tv_usec = 20; // SELECT_TIMEOUT;
-		select(0, 0, 0, 0, &timeout);
+		// Wait for an fd to become ready, but not beyond the point
+		// at which the sources we have to poll want to be asked
+		// again.
+		if ( poll_interval < 0 )
+			timeout = POLL_TIMEOUT;
+
+		else if ( poll_interval >= 0.001 )
+			timeout = std::min(int(poll_interval * 1000), POLL_TIMEOUT);
+
+		else if ( poll_interval > 0 )
+			// Shorter than the poller's resolution.
+			// Interesting: when all sources are dry, simply
+			// sleeping a bit *without* watching for any fd
+			// becoming ready may decrease CPU load. I guess
+			// that's because it allows the kernel's packet
+			// buffers to fill. - Robin
+			usleep(int(poll_interval * 1e6));
 		}
 
-	if ( ! maxx )
-		// No selectable fd at all.
-		goto finished;
-
-	timeout.tv_sec = 0;
-	timeout.tv_usec = 0;
+	ready.clear();
 
-	if ( select(maxx + 1, &fd_read, &fd_write, &fd_except, &timeout) > 0 )
+	if ( poller.Wait(timeout, &ready) > 0 )
 		{ // Find soonest.
-		for ( SourceList::iterator i = sources.begin();
-		      i != sources.end(); ++i )
+		for ( std::vector<int>::const_iterator i = ready.begin();
+		      i != ready.end(); ++i )
 			{
-			Source* src = (*i);
+			Source* src = *i < int(fd_sources.size()) ? fd_sources[*i] : 0;
+
+			if ( ! src || ! src->src->IsIdle() )
+				continue;
 
-			if ( ! src->src->IsIdle() )
+			// A source may have more than one fd ready.
+			if ( src->last_checked == call_count )
 				continue;
 
-			if ( src->Ready(&fd_read, &fd_write, &fd_except) )
+			src->last_checked = call_count;
+
+			double local_network_time = 0;
+			double ts = src->src->NextTimestamp(&local_network_time);
+			if ( ts >= 0.0 && ts < soonest_ts )
 				{
-				double local_network_time = 0;
-				double ts = src->src->NextTimestamp(&local_network_time);
-				if ( ts >= 0.0 && ts < soonest_ts )
-					{
-					soonest_ts = ts;
-					soonest_src = src->src;
-					soonest_local_network_time =
-						local_network_time ?
-							local_network_time : ts;
-					}
+				soonest_ts = ts;
+				soonest_src = src->src;
+				soonest_local_network_time =
+					local_network_time ?
+						local_network_time : ts;
 				}
 			}
 		}
@@ -179,6 +193,112 @@ finished:
 	return soonest_src;
 	}
 
+void Manager::Activate(IOSource* src)
+	{
+	src->active = true;
+
+	std::vector<IOSource*>::iterator i = active_sources.begin();
+	while ( i != active_sources.end() && (*i)->order < src->order )
+		++i;
+
+	active_sources.insert(i, src);
+	}
+
+void Manager::AddFds(Source* src)
+	{
+	int n = 0;
+
+	for ( int fd : src->fd_read )
+		{
+		RegisterFd(fd, src->src, Poller::READ);
+		++n;
+		}
+
+	for ( int fd : src->fd_write )
+		{
+		RegisterFd(fd, src->src, Poller::WRITE);
+		++n;
+		}
+
+	for ( int fd : src->fd_except )
+		{
+		RegisterFd(fd, src->src, Poller::EXCEPT);
+		++n;
+		}
+
+	src->polled = (n == 0);
+	}
+
+void Manager::RemoveFds(Source* src)
+	{
+	FD_Set* sets[] = { &src->fd_read, &src->fd_write, &src->fd_except };
+
+	for ( FD_Set* set : sets )
+		for ( int fd : *set )
+			{
+			// The fd may already belong to another source if
+			// this one closed it and the number got reused.
+			if ( fd < int(fd_sources.size()) && fd_sources[fd] == src )
+				UnregisterFd(fd);
+			}
+
+	src->Clear();
+	}
+
+void Manager::RegisterFd(int fd, IOSource* src, int what)
+	{
+	Source* s = 0;
+
+	for ( SourceList::iterator i = sources.begin(); i != sources.end(); ++i )
+		if ( (*i)->src == src )
+			{
+			s = *i;
+			break;
+			}
+
+	if ( ! s )
+		{
+		reporter->InternalWarning("fd %d registered for unknown IO source %s",
+					  fd, src->Tag());
+		return;
+		}
+
+	// If another source still has the fd, it closed it without telling
+	// us and the number got reused since. Don't let the poller mistake
+	// the new descriptor for the old one.
+	if ( fd < int(fd_sources.size()) && fd_sources[fd] && fd_sources[fd] != s )
+		poller.Remove(fd);
+
+	if ( ! poller.Add(fd, what) )
+		{
+		reporter->Error("cannot watch fd %d for IO source %s: %s",
+				fd, src->Tag(), strerror(errno));
+		return;
+		}
+
+	if ( fd >= int(fd_sources.size()) )
+		fd_sources.resize(fd + 1);
+
+	fd_sources[fd] = s;
+
+	if ( what & Poller::READ )
+		s->fd_read.Insert(fd);
+	if ( what & Poller::WRITE )
+		s->fd_write.Insert(fd);
+	if ( what & Poller::EXCEPT )
+		s->fd_except.Insert(fd);
+
+	s->polled = false;
+	}
+
+void Manager::UnregisterFd(int fd)
+	{
+	poller.Remove(fd);
+
+	if ( fd < int(fd_sources.size()) )
+		fd_sources[fd] = 0;
+	}
+
 void Manager::Register(IOSource* src, bool dont_count)
 	{
 	// First see if we already have registered that source. If so, just
@@ -195,14 +315,27 @@ void Manager::Register(IOSource* src, bool dont_count)
 			}
 		}
 
+	src->manager = this;
+	src->order = next_order++;
+
 	src->Init();
 	Source* s = new Source;
 	s->src = src;
 	s->dont_count = dont_count;
+	s->polled = true;
+	s->fds_fetched = false;
+	s->last_checked = 0;
 	if ( dont_count )
 		++dont_counts;
 
 	sources.push_back(s);
+
+	if ( ! src->IsIdle() && ! src->active )
+		Activate(src);
+
+	// Sources hand us their fds once, on the next poll round; we keep
+	// watching those until they're gone. We don't ask right away since
+	// some sources register themselves before they're fully set up.
 	}
 
 void Manager::Register(PktSrc* src)
@@ -317,11 +450,3 @@ PktDumper* Manager::OpenPktDumper(const string& path, bool append)
 
 	return pd;
 	}
-
-void Manager::Source::SetFds(fd_set* read, fd_set* write, fd_set* except,
-                             int* maxx) const
-	{
-	*maxx = std::max(*maxx, fd_read.Set(read));
-	*maxx = std::max(*maxx, fd_write.Set(write));
-	*maxx = std::max(*maxx, fd_except.Set(except));
-	}
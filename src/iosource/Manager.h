@@ -5,7 +5,9 @@
 
 #include <string>
 #include <list>
+#include <vector>
 #include "iosource/FD_Set.h"
+#include "iosource/Poller.h"
 
 namespace iosource {
 
@@ -21,7 +23,7 @@ public:
 	/**
 	 * Constructor.
 	 */
-	Manager()	{ call_count = 0; dont_counts = 0; }
+	Manager()	{ call_count = 0; dont_counts = 0; next_order = 0; }
 
 	/**
 	 * Destructor.
@@ -42,6 +44,33 @@ public:
 	 */
 	void Register(IOSource* src, bool dont_count = false);
 
+	/**
+	 * Starts watching a file descriptor on behalf of a registered
+	 * source. The manager collects the descriptors a source returns from
+	 * IOSource::GetFds() once, the first time it looks for input after
+	 * the source got registered; sources whose set of descriptors
+	 * changes later on need to tell the manager about any new ones
+	 * through this method.
+	 *
+	 * @param fd The file descriptor.
+	 *
+	 * @param src The source that wants to process input when \a fd
+	 * becomes ready.
+	 *
+	 * @param what The conditions to watch for, or'ed together from
+	 * Poller::READ, Poller::WRITE, and Poller::EXCEPT.
+	 */
+	void RegisterFd(int fd, IOSource* src, int what = Poller::READ);
+
+	/**
+	 * Stops watching a file descriptor previously passed to
+	 * RegisterFd(). Sources must call this before closing a descriptor
+	 * while they themselves remain registered.
+	 *
+	 * @param fd The file descriptor.
+	 */
+	void UnregisterFd(int fd);
+
 	/**
 	 * Returns the packet source with the soonest available input. This
 	 * may block for a little while if all are dry.
@@ -96,23 +125,46 @@ public:
 	 */
 	PktDumper* OpenPktDumper(const std::string& path, bool append);
 
+	/**
+	 * Seconds to wait at most before asking an idle source without any
+	 * file descriptors for input again, unless the source says
+	 * otherwise through IOSource::GetPollInterval().
+	 */
+	static constexpr double DEFAULT_POLL_INTERVAL = 0.001;
+
 private:
 	/**
 	 * When looking for a source with something to process, every
-	 * SELECT_FREQUENCY calls we will go ahead and block on a select().
+	 * POLL_FREQUENCY calls we will go ahead and check which descriptors
+	 * are ready, even if some source already has input.
 	 */
-	static const int SELECT_FREQUENCY = 25;
+	static const int POLL_FREQUENCY = 25;
 
 	/**
-	 * Microseconds to wait in an empty select if no source is ready.
+	 * Milliseconds to wait at most for a descriptor to become ready
+	 * when all sources are dry. We can't block indefinitely since the
+	 * main loop does some IOSource-independent work, like expiring
+	 * timers, but any ready descriptor ends the wait right away.
 	 */
-	static const int SELECT_TIMEOUT = 50;
+	static const int POLL_TIMEOUT = 10;
+
+
+	struct Source;
+
+	friend class IOSource;
 
 	void Register(PktSrc* src);
 	void RemoveAll();
 
+	// Called when a source stops idling.
+	void Activate(IOSource* src);
+
+	void AddFds(Source* src);
+	void RemoveFds(Source* src);
+
 	unsigned int call_count;
 	int dont_counts;
+	int next_order;
 
 	struct Source {
 		IOSource* src;
@@ -121,12 +173,17 @@ private:
 		FD_Set fd_except;
 		bool dont_count;
 
-		bool Ready(fd_set* read, fd_set* write, fd_set* except) const
-			{ return fd_read.Ready(read) || fd_write.Ready(write) ||
-			         fd_except.Ready(except); }
+		// True if the source hasn't given us any descriptors to
+		// wait on, so that we need to keep asking it.
+		bool polled;
+
+		// True once we've asked the source for its descriptors. We
+		// do that on the first poll round after registering it, as
+		// sources may not be ready to hand them out any earlier.
+		bool fds_fetched;
 
-		void SetFds(fd_set* read, fd_set* write, fd_set* except,
-		            int* maxx) const;
+		// The call to FindSoonest() that last looked at it.
+		unsigned int last_checked;
 
 		void Clear()
 			{ fd_read.Clear(); fd_write.Clear(); fd_except.Clear(); }
@@ -135,6 +192,16 @@ private:
 	typedef std::list<Source*> SourceList;
 	SourceList sources;
 
+	// The sources that aren't idle, in the order they were registered.
+	// These are the ones we check each time without waiting on fds.
+	std::vector<IOSource*> active_sources;
+
+	// Indexed by descriptor.
+	std::vector<Source*> fd_sources;
+
+	Poller poller;
+	std::vector<int> ready;
+
 	typedef std::list<PktDumper *> PktDumperList;
 
 	PktSrcList pkt_srcs;
@@ -49,15 +49,26 @@ void Packet::Init(int arg_link_type, pkt_timeval *arg_ts, uint32 arg_caplen,
 	l2_dst = 0;
 
 	l2_valid = false;
+	l2_pending = (data != 0);
 
-	if ( data && cap_len < hdr_size )
+	if ( ! defer_l2 )
+		ProcessDeferredLayer2();
+	}
+
+void Packet::ProcessDeferredLayer2()
+	{
+	if ( ! l2_pending )
+		return;
+
+	l2_pending = false;
+
+	if ( cap_len < hdr_size )
 		{
 		Weird("truncated_link_header");
 		return;
 		}
 
-	if ( data )
-		ProcessLayer2();
+	ProcessLayer2();
 	}
 
 void Packet::Weird(const char* name)
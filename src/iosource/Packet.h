@@ -52,7 +52,7 @@ public:
 	Packet(int link_type, pkt_timeval *ts, uint32 caplen,
 	       uint32 len, const u_char *data, int copy = false,
 	       std::string tag = std::string(""))
-	           : data(0), l2_src(0), l2_dst(0)
+	           : data(0), l2_src(0), l2_dst(0), defer_l2(false)
 	       {
 	       Init(link_type, ts, caplen, len, data, copy, tag);
 	       }
@@ -60,7 +60,7 @@ public:
 	/**
 	 * Default constructor. For internal use only.
 	 */
-	Packet() : data(0), l2_src(0), l2_dst(0)
+	Packet() : data(0), l2_src(0), l2_dst(0), defer_l2(false)
 		{
 		pkt_timeval ts = {0, 0};
 		Init(0, &ts, 0, 0, 0);
@@ -101,6 +101,27 @@ public:
 		uint32 len, const u_char *data, int copy = false,
 		std::string tag = std::string(""));
 
+	/**
+	 * Controls whether Init() parses the layer 2 header right away (the
+	 * default), or leaves that to a later call to
+	 * ProcessDeferredLayer2(). Packet sources that extract packets in
+	 * batches use this so that any weirds get reported once a packet
+	 * actually comes up for processing, not when it's read.
+	 *
+	 * @param defer True to defer layer 2 parsing in subsequent calls to
+	 * Init().
+	 */
+	void SetDeferLayer2(bool defer)
+		{
+		defer_l2 = defer;
+		}
+
+	/**
+	 * Parses the layer 2 header if Init() has deferred doing so. Does
+	 * nothing otherwise.
+	 */
+	void ProcessDeferredLayer2();
+
 	/**
 	 * Returns true if parsing the layer 2 fields failed, including when
 	 * no data was passed into the constructor in the first place.
@@ -211,6 +232,13 @@ private:
 
 	// True if L2 processing succeeded.
 	bool l2_valid;
+
+	// True if Init() is to leave L2 processing to
+	// ProcessDeferredLayer2().
+	bool defer_l2;
+
+	// True if L2 processing has been deferred and not yet happened.
+	bool l2_pending;
 };
 
 #endif // packet_h
@@ -0,0 +1,219 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek-config.h"
+
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "PktReader.h"
+#include "PktSrc.h"
+
+using namespace iosource;
+
+thread_local PktReader* PktReader::current = 0;
+
+PktReader::PktReader(PktSrc* arg_src, size_t arg_batch_size)
+	{
+	src = arg_src;
+	batch_size = arg_batch_size;
+
+	for ( size_t i = 0; i < RING_SIZE; ++i )
+		{
+		ring[i].pkts = new Packet[batch_size];
+		ring[i].len = 0;
+		ring[i].filter_epoch = 0;
+
+		for ( size_t j = 0; j < batch_size; ++j )
+			ring[i].pkts[j].SetDeferLayer2(true);
+		}
+
+	read_pos = write_pos = 0;
+	pending = 0;
+	stopping = false;
+	finished = false;
+	source_closed = false;
+	waiting_for_space = false;
+	}
+
+PktReader::~PktReader()
+	{
+	Stop();
+
+	for ( size_t i = 0; i < RING_SIZE; ++i )
+		delete [] ring[i].pkts;
+	}
+
+void PktReader::Start()
+	{
+	thread = std::thread(&PktReader::Run, this);
+	}
+
+void PktReader::Stop()
+	{
+	if ( ! thread.joinable() )
+		return;
+
+		{
+		std::lock_guard<std::mutex> lock(space_mutex);
+		stopping = true;
+		}
+
+	space_cond.notify_one();
+	thread.join();
+	}
+
+PktReader::Batch* PktReader::Next()
+	{
+	if ( pending == 0 )
+		{
+		// The reader fires the flare when it hands over a batch while
+		// the ring is empty, so we can only put it out once we've
+		// checked that it's still empty afterwards.
+		flare.Extinguish();
+
+		if ( pending == 0 )
+			return 0;
+		}
+
+	return &ring[read_pos];
+	}
+
+void PktReader::Release()
+	{
+	Batch* b = &ring[read_pos];
+	b->len = 0;
+	b->weirds.clear();
+	b->error.clear();
+
+	read_pos = (read_pos + 1) % RING_SIZE;
+	--pending;
+
+	if ( waiting_for_space )
+		{
+			{
+			std::lock_guard<std::mutex> lock(space_mutex);
+			}
+
+		space_cond.notify_one();
+		}
+	}
+
+void PktReader::AddWeird(const std::string& msg)
+	{
+	ring[write_pos].weirds.push_back(msg);
+	}
+
+void PktReader::AddError(const std::string& msg)
+	{
+	ring[write_pos].error = msg;
+	}
+
+void PktReader::Run()
+	{
+	current = this;
+
+	while ( ! stopping )
+		{
+		if ( pending == RING_SIZE )
+			{
+			WaitForSpace();
+			continue;
+			}
+
+		Batch* b = &ring[write_pos];
+		size_t n;
+		bool open;
+
+			{
+			std::lock_guard<std::mutex> lock(src->SourceMutex());
+
+			b->filter_epoch = src->filter_epoch;
+			n = src->ExtractNextPackets(b->pkts, batch_size);
+
+			if ( n )
+				{
+				Copy(b, n);
+				src->DoneWithPacket();
+				}
+
+			open = src->IsOpen() && ! source_closed;
+			}
+
+		b->len = n;
+
+		if ( n || ! b->weirds.empty() || ! b->error.empty() )
+			Publish();
+
+		if ( ! open )
+			break;
+
+		if ( ! n )
+			WaitForInput();
+		}
+
+	finished = true;
+	flare.Fire();
+	}
+
+void PktReader::Copy(Batch* b, size_t n)
+	{
+	size_t total = 0;
+
+	for ( size_t i = 0; i < n; ++i )
+		total += b->pkts[i].cap_len;
+
+	if ( b->data.size() < total )
+		b->data.resize(total);
+
+	u_char* p = b->data.data();
+
+	for ( size_t i = 0; i < n; ++i )
+		{
+		Packet* pkt = &b->pkts[i];
+		memcpy(p, pkt->data, pkt->cap_len);
+
+		// Re-initializing resets what the source may have set beyond
+		// Init(), which can only be the VLAN it took off the packet.
+		uint32 vlan = pkt->vlan;
+		pkt->Init(pkt->link_type, &pkt->ts, pkt->cap_len, pkt->len, p,
+			  false, pkt->tag);
+		pkt->vlan = vlan;
+
+		p += pkt->cap_len;
+		}
+	}
+
+void PktReader::WaitForSpace()
+	{
+	std::unique_lock<std::mutex> lock(space_mutex);
+	waiting_for_space = true;
+	space_cond.wait(lock, [this] { return pending < RING_SIZE || stopping; });
+	waiting_for_space = false;
+	}
+
+void PktReader::WaitForInput()
+	{
+	int fd = src->props.selectable_fd;
+
+	if ( fd < 0 )
+		{
+		usleep(1000);
+		return;
+		}
+
+	// Time out now and then to check whether we're to stop.
+	struct pollfd pfd;
+	pfd.fd = fd;
+	pfd.events = POLLIN;
+	pfd.revents = 0;
+	poll(&pfd, 1, 10);
+	}
+
+void PktReader::Publish()
+	{
+	write_pos = (write_pos + 1) % RING_SIZE;
+
+	if ( pending++ == 0 )
+		flare.Fire();
+	}
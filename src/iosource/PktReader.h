@@ -0,0 +1,182 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#ifndef IOSOURCE_PKTREADER_H
+#define IOSOURCE_PKTREADER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Flare.h"
+#include "Packet.h"
+
+namespace iosource {
+
+class PktSrc;
+
+/**
+ * Reads a packet source on a thread of its own, handing the packets over
+ * to the main thread in batches.
+ *
+ * The thread extracts batches through PktSrc::ExtractNextPackets() and
+ * copies their data, so that the source can reuse its buffers right away.
+ * It then hands them over through a fixed-size ring. If the ring is
+ * full, the thread waits for the main thread to catch up; until then,
+ * the source's own buffers absorb the backlog.
+ *
+ * While the thread is running, it's the only one calling into the source,
+ * except for calls made while holding PktSrc::SourceMutex().
+ */
+class PktReader {
+public:
+	/**
+	 * A batch of packets handed over to the main thread.
+	 */
+	struct Batch {
+		// The packets; the first "len" of these are valid.
+		Packet* pkts;
+		size_t len;
+
+		// Weirds that the source reported while extracting the batch.
+		// They're reported without their packets.
+		std::vector<std::string> weirds;
+
+		// The last error the source reported while extracting the
+		// batch, if any.
+		std::string error;
+
+		// The source's filter epoch when the batch was extracted.
+		unsigned int filter_epoch;
+
+		// Holds copies of the packets' data.
+		std::vector<u_char> data;
+	};
+
+	/**
+	 * Constructor. The thread doesn't start until Start() is called.
+	 *
+	 * @param src The source to read from. It must be open.
+	 *
+	 * @param batch_size The maximum number of packets per batch.
+	 */
+	PktReader(PktSrc* src, size_t batch_size);
+
+	/**
+	 * Destructor. Stops the thread if it's still running.
+	 */
+	~PktReader();
+
+	/**
+	 * Starts the thread.
+	 */
+	void Start();
+
+	/**
+	 * Stops the thread and waits for it to finish. Batches that haven't
+	 * been taken yet are discarded.
+	 */
+	void Stop();
+
+	/**
+	 * Returns the next batch, or null if none is ready yet. The batch
+	 * stays valid until Release() is called. Must only be called from
+	 * the main thread, and not again before releasing the previous batch.
+	 */
+	Batch* Next();
+
+	/**
+	 * Hands the batch returned by Next() back to the reader thread.
+	 */
+	void Release();
+
+	/**
+	 * Returns true once the source has closed and all of its batches
+	 * have been taken.
+	 */
+	bool Finished() const
+		{ return finished && pending == 0; }
+
+	/**
+	 * Returns a file descriptor that becomes ready when Next() may have
+	 * a batch, or Finished() may have turned true.
+	 */
+	int FD() const	{ return flare.FD(); }
+
+	/**
+	 * Returns true if called from the reader thread.
+	 */
+	bool InReaderThread() const
+		{ return current == this; }
+
+	/**
+	 * Records a weird reported by the source from within the reader
+	 * thread. It'll be passed on along with the current batch.
+	 */
+	void AddWeird(const std::string& msg);
+
+	/**
+	 * Records an error reported by the source from within the reader
+	 * thread. It'll be passed on along with the current batch.
+	 */
+	void AddError(const std::string& msg);
+
+	/**
+	 * Signals that the source closed itself from within the reader
+	 * thread. The thread will finish once it has handed over what it
+	 * has.
+	 */
+	void SourceClosed()	{ source_closed = true; }
+
+private:
+	// The number of batches in the ring.
+	static const size_t RING_SIZE = 64;
+
+	// The thread's main loop.
+	void Run();
+
+	// Copies the data of the first "n" packets into the batch's buffer.
+	void Copy(Batch* b, size_t n);
+
+	// Waits until there's room in the ring, or we're asked to stop.
+	void WaitForSpace();
+
+	// Waits a bit for the source to have more input.
+	void WaitForInput();
+
+	// Passes the batch being filled on to the main thread.
+	void Publish();
+
+	PktSrc* src;
+	size_t batch_size;
+	std::thread thread;
+
+	// The reader running on the current thread, if any. The thread sets
+	// this itself; comparing against thread.get_id() would race with
+	// Start() assigning the std::thread while the thread already runs.
+	static thread_local PktReader* current;
+
+	Batch ring[RING_SIZE];
+	size_t read_pos;	// next batch for the main thread
+	size_t write_pos;	// next batch for the reader thread to fill
+
+	// Number of batches handed over and not yet released.
+	std::atomic<size_t> pending;
+
+	std::atomic<bool> stopping;
+	std::atomic<bool> finished;
+	bool source_closed;
+
+	// For waiting until there's room in the ring.
+	std::mutex space_mutex;
+	std::condition_variable space_cond;
+	std::atomic<bool> waiting_for_space;
+
+	bro::Flare flare;
+};
+
+}
+
+#endif
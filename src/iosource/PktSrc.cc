@@ -7,9 +7,12 @@
 
 #include "util.h"
 #include "PktSrc.h"
+#include "PktReader.h"
 #include "Hash.h"
 #include "Net.h"
+#include "NetVar.h"
 #include "Sessions.h"
+#include "Var.h"
 #include "broker/Manager.h"
 #include "iosource/Manager.h"
 
@@ -27,7 +30,16 @@ PktSrc::Properties::Properties()
 
 PktSrc::PktSrc()
 	{
+	for ( size_t i = 0; i < BATCH_SIZE; ++i )
+		batch[i].SetDeferLayer2(true);
+
+	pkts = batch;
+	batch_pos = batch_len = 0;
+	reader = 0;
+	filter_epoch = batch_filter_epoch = 0;
+	filter_index = -1;
 	have_packet = false;
+	current_packet = 0;
 	errbuf = "";
 	SetClosed(true);
 
@@ -39,6 +51,8 @@ PktSrc::PktSrc()
 
 PktSrc::~PktSrc()
 	{
+	delete reader;
+
 	for ( auto code : filters )
 		delete code;
 	}
@@ -117,6 +131,13 @@ void PktSrc::Opened(const Properties& arg_props)
 
 void PktSrc::Closed()
 	{
+	if ( reader && reader->InReaderThread() )
+		{
+		// We'll close once the main thread has seen all packets.
+		reader->SourceClosed();
+		return;
+		}
+
 	SetClosed(true);
 
 	DBG_LOG(DBG_PKTIO, "Closed source %s", props.path.c_str());
@@ -124,6 +145,15 @@ void PktSrc::Closed()
 
 void PktSrc::Error(const std::string& msg)
 	{
+	if ( reader && reader->InReaderThread() )
+		{
+		// The main thread may be looking at errbuf, and the debug
+		// log isn't thread-safe, so this takes the same route as the
+		// packets.
+		reader->AddError(msg);
+		return;
+		}
+
 	// We don't report this immediately, Bro will ask us for the error
 	// once it notices we aren't open.
 	errbuf = msg;
@@ -139,6 +169,12 @@ void PktSrc::Info(const std::string& msg)
 
 void PktSrc::Weird(const std::string& msg, const Packet* p)
 	{
+	if ( reader && reader->InReaderThread() )
+		{
+		reader->AddWeird(msg);
+		return;
+		}
+
 	sessions->Weird(msg.c_str(), p, 0);
 	}
 
@@ -160,7 +196,7 @@ double PktSrc::CheckPseudoTime()
 	if ( ! ExtractNextPacketInternal() )
 		return 0;
 
-	double pseudo_time = current_packet.time - first_timestamp;
+	double pseudo_time = current_packet->time - first_timestamp;
 	double ct = (current_time(true) - first_wallclock) * pseudo_realtime;
 
 	return pseudo_time <= ct ? bro_start_time + pseudo_time : 0;
@@ -169,10 +205,26 @@ double PktSrc::CheckPseudoTime()
 void PktSrc::Init()
 	{
 	Open();
+
+	if ( BifConst::threaded_packet_sources && IsOpen() )
+		{
+		reader = new PktReader(this, BATCH_SIZE);
+		reader->Start();
+		}
 	}
 
 void PktSrc::Done()
 	{
+	if ( batch_len )
+		DoneWithBatch();
+
+	if ( reader )
+		{
+		reader->Stop();
+		delete reader;
+		reader = 0;
+		}
+
 	if ( IsOpen() )
 		Close();
 	}
@@ -188,20 +240,19 @@ void PktSrc::GetFds(iosource::FD_Set* read, iosource::FD_Set* write,
 		return;
 		}
 
-	if ( IsOpen() && props.selectable_fd >= 0 )
-		read->Insert(props.selectable_fd);
-
-	// TODO: This seems like a hack that should be removed, but doing so
-	// causes the main run loop to spin more frequently and increase cpu usage.
-	// See also commit 9cd85be308.
-	if ( read->Empty() )
-		read->Insert(0);
+	if ( reader )
+		read->Insert(reader->FD());
 
-	if ( write->Empty() )
-		write->Insert(0);
+	// Without a selectable fd, the manager keeps polling us instead.
+	else if ( IsOpen() && props.selectable_fd >= 0 )
+		read->Insert(props.selectable_fd);
+	}
 
-	if ( except->Empty() )
-		except->Insert(0);
+double PktSrc::GetPollInterval()
+	{
+	// Without a selectable fd, or in pseudo-realtime mode, we need to
+	// be asked often to keep up with the traffic.
+	return 20e-6;
 	}
 
 double PktSrc::NextTimestamp(double* local_network_time)
@@ -223,7 +274,7 @@ double PktSrc::NextTimestamp(double* local_network_time)
 		return -1.0;
 		}
 
-	return current_packet.time;
+	return current_packet->time;
 	}
 
 void PktSrc::Process()
@@ -234,22 +285,78 @@ void PktSrc::Process()
 	if ( ! ExtractNextPacketInternal() )
 		return;
 
-	if ( current_packet.Layer2Valid() )
+	DispatchCurrentPacket();
+
+	// For live input, we work through the rest of the batch right away
+	// rather than going back to the main loop for each packet. Offline,
+	// we stick to one packet at a time so that other sources still get
+	// interleaved in timestamp order.
+	if ( props.is_live && ! pseudo_realtime )
+		{
+		while ( batch_pos < batch_len && IsOpen() && ! terminating &&
+			! signal_val && ExtractNextPacketInternal() )
+			DispatchCurrentPacket();
+		}
+
+	if ( batch_len && batch_pos == batch_len )
+		DoneWithBatch();
+	}
+
+void PktSrc::DispatchCurrentPacket()
+	{
+	if ( current_packet->Layer2Valid() )
 		{
 		if ( pseudo_realtime )
 			{
 			current_pseudo = CheckPseudoTime();
-			net_packet_dispatch(current_pseudo, &current_packet, this);
+			net_packet_dispatch(current_pseudo, current_packet, this);
 			if ( ! first_wallclock )
 				first_wallclock = current_time(true);
 			}
 
 		else
-			net_packet_dispatch(current_packet.time, &current_packet, this);
+			net_packet_dispatch(current_packet->time, current_packet, this);
 		}
 
 	have_packet = 0;
-	DoneWithPacket();
+	}
+
+void PktSrc::DoneWithBatch()
+	{
+	batch_pos = batch_len = 0;
+
+	if ( reader )
+		reader->Release();
+	else
+		DoneWithPacket();
+	}
+
+size_t PktSrc::TakeBatch()
+	{
+	PktReader::Batch* b;
+
+	while ( (b = reader->Next()) )
+		{
+		for ( const auto& w : b->weirds )
+			Weird(w, 0);
+
+		if ( ! b->error.empty() )
+			Error(b->error);
+
+		if ( b->len )
+			{
+			pkts = b->pkts;
+			batch_filter_epoch = b->filter_epoch;
+			return b->len;
+			}
+
+		reader->Release();
+		}
+
+	if ( reader->Finished() )
+		Closed();
+
+	return 0;
 	}
 
 const char* PktSrc::Tag()
@@ -275,16 +382,43 @@ bool PktSrc::ExtractNextPacketInternal()
 	if ( pseudo_realtime )
 		current_wallclock = current_time(true);
 
-	if ( ExtractNextPacket(&current_packet) )
+	if ( batch_len && batch_pos == batch_len )
+		DoneWithBatch();
+
+	if ( ! batch_len )
+		{
+		if ( reader )
+			batch_len = TakeBatch();
+		else
+			{
+			// Offline, we process one packet per main loop
+			// iteration anyway, and a batch of one lets the
+			// source hand it over without copying.
+			pkts = batch;
+			batch_filter_epoch = filter_epoch;
+			batch_len = ExtractNextPackets(batch,
+					props.is_live ? BATCH_SIZE : 1);
+			}
+		}
+
+	while ( batch_pos < batch_len )
 		{
-		if ( current_packet.time < 0 )
+		current_packet = &pkts[batch_pos++];
+
+		if ( batch_filter_epoch != filter_epoch &&
+		     ! MatchesNewFilter(current_packet) )
+			continue;
+
+		current_packet->ProcessDeferredLayer2();
+
+		if ( current_packet->time < 0 )
 			{
-			Weird("negative_packet_timestamp", &current_packet);
+			Weird("negative_packet_timestamp", current_packet);
 			return 0;
 			}
 
 		if ( ! first_timestamp )
-			first_timestamp = current_packet.time;
+			first_timestamp = current_packet->time;
 
 		SetIdle(false);
 		have_packet = true;
@@ -301,6 +435,11 @@ bool PktSrc::ExtractNextPacketInternal()
 	return 0;
 	}
 
+size_t PktSrc::ExtractNextPackets(Packet* arg_batch, size_t n)
+	{
+	return ExtractNextPacket(&arg_batch[0]) ? 1 : 0;
+	}
+
 bool PktSrc::PrecompileBPFFilter(int index, const std::string& filter)
 	{
 	if ( index < 0 )
@@ -361,11 +500,33 @@ bool PktSrc::ApplyBPFFilter(int index, const struct pcap_pkthdr *hdr, const u_ch
 	return pcap_offline_filter(code->GetProgram(), hdr, pkt);
 	}
 
+void PktSrc::FilterChanged(int index)
+	{
+	++filter_epoch;
+	filter_index = index;
+	}
+
+bool PktSrc::MatchesNewFilter(const Packet* pkt)
+	{
+	BPF_Program* code = GetBPFFilter(filter_index);
+
+	if ( ! code || code->MatchesAnything() )
+		return true;
+
+	struct pcap_pkthdr hdr;
+	hdr.ts.tv_sec = pkt->ts.tv_sec;
+	hdr.ts.tv_usec = pkt->ts.tv_usec;
+	hdr.caplen = pkt->cap_len;
+	hdr.len = pkt->len;
+
+	return pcap_offline_filter(code->GetProgram(), &hdr, pkt->data);
+	}
+
 bool PktSrc::GetCurrentPacket(const Packet** pkt)
 	{
 	if ( ! have_packet )
 		return false;
 
-	*pkt = &current_packet;
+	*pkt = current_packet;
 	return true;
 	}
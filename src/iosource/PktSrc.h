@@ -3,6 +3,7 @@
 #ifndef IOSOURCE_PKTSRC_PKTSRC_H
 #define IOSOURCE_PKTSRC_PKTSRC_H
 
+#include <mutex>
 #include <vector>
 
 #include "IOSource.h"
@@ -12,6 +13,8 @@
 
 namespace iosource {
 
+class PktReader;
+
 /**
  * Base class for packet sources.
  */
@@ -153,6 +156,19 @@ public:
 	 * @return True if it maches. 	 */
 	bool ApplyBPFFilter(int index, const struct pcap_pkthdr *hdr, const u_char *pkt);
 
+	/**
+	 * Signals that a new filter is active. Packets that have been
+	 * extracted already, but not processed yet, went through the old
+	 * one, so they'll be checked against the new one as they come up.
+	 *
+	 * This is primarily a helper for packet source implementations
+	 * whose  SetFilter() activates a filter precompiled by 
+	 * PrecompileBPFFilter().
+	 *
+	 * @param index The index of the filter now active.
+	 */
+	void FilterChanged(int index);
+
 	/**
 	 * Returns the packet currently being processed, if available.
 	 *
@@ -163,6 +179,14 @@ public:
 	 */
 	bool GetCurrentPacket(const Packet** hdr);
 
+	/**
+	 * Returns a mutex that serializes calls into the source when it's
+	 * read on a thread of its own (see \c threaded_packet_sources).
+	 * Code on the main thread must hold it while calling Statistics(),
+	 * PrecompileFilter(), or SetFilter().
+	 */
+	std::mutex& SourceMutex()	{ return source_mutex; }
+
 	// PacketSource interace for derived classes to override.
 
 	/**
@@ -207,6 +231,7 @@ public:
 
 protected:
 	friend class Manager;
+	friend class PktReader;
 
 	// Methods to use by derived classes.
 
@@ -329,7 +354,32 @@ protected:
 	virtual bool ExtractNextPacket(Packet* pkt) = 0;
 
 	/**
-	 * Signals that the data of previously extracted packet will no
+	 * Provides up to \a n packets from the source at once. Sources that
+	 * can hand over several packets cheaply should override this; the
+	 * default implementation calls \a ExtractNextPacket() once.
+	 *
+	 * The packets have been set up to defer their layer 2 processing
+	 * (see Packet::SetDeferLayer2()); implementations fill them in
+	 * with Packet::Init() as usual, which leaves that to the time each
+	 * packet comes up for processing.
+	 *
+	 * @param batch Array of packet structures to fill in, in order. The
+	 * callee keeps ownership of the data but must guarantee that it
+	 * stays available at least until \a DoneWithPacket() is called,
+	 * which happens once for the whole batch after its last packet has
+	 * been processed. It is guaranteed that no two calls to this
+	 * method will happen without \a DoneWithPacket() in between.
+	 *
+	 * @param n The number of elements in *batch*; at least one.
+	 *
+	 * @return The number of packets filled in. Zero if no packet is
+	 * available or an error occured (which must be flagged via
+	 * Error()).
+	 */
+	virtual size_t ExtractNextPackets(Packet* batch, size_t n);
+
+	/**
+	 * Signals that the data of previously extracted packets will no
 	 * longer be needed.
 	 */
 	virtual void DoneWithPacket() = 0;
@@ -342,19 +392,55 @@ private:
 	// Internal helper for ExtractNextPacket().
 	bool ExtractNextPacketInternal();
 
+	// Takes the next batch from the reader thread, returning its size.
+	size_t TakeBatch();
+
+	// Passes the current packet on for processing.
+	void DispatchCurrentPacket();
+
+	// Returns true if the packet passes the filter that's been
+	// activated since it was extracted.
+	bool MatchesNewFilter(const Packet* pkt);
+
+	// Signals the derived class that we're done with the current
+	// batch.
+	void DoneWithBatch();
+
 	// IOSource interface implementation.
 	void Init() override;
 	void Done() override;
 	void GetFds(iosource::FD_Set* read, iosource::FD_Set* write,
 	                    iosource::FD_Set* except) override;
+	double GetPollInterval() override;
 	double NextTimestamp(double* local_network_time) override;
 	void Process() override;
 	const char* Tag() override;
 
 	Properties props;
 
+	// Maximum number of packets to extract at once.
+	static const size_t BATCH_SIZE = 32;
+
+	// Packets extracted but not yet processed are
+	// pkts[batch_pos..batch_len-1]. "pkts" points to "batch" unless
+	// the batch comes from the reader thread.
+	Packet batch[BATCH_SIZE];
+	Packet* pkts;
+	size_t batch_pos;
+	size_t batch_len;
+
+	// Set if the source is read on a separate thread.
+	PktReader* reader;
+	std::mutex source_mutex;
+
+	// Bumped by FilterChanged(). A batch extracted under an older
+	// epoch gets its packets checked against filter_index.
+	unsigned int filter_epoch;
+	int filter_index;
+	unsigned int batch_filter_epoch;
+
 	bool have_packet;
-	Packet current_packet;
+	Packet* current_packet;
 
 	// For BPF filtering support.
 	std::vector<BPF_Program *> filters;
@@ -0,0 +1,232 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "Poller.h"
+#include "Reporter.h"
+
+using namespace iosource;
+
+#ifdef HAVE_SYS_EPOLL_H
+
+static uint32_t to_epoll(int what)
+	{
+	uint32_t events = 0;
+
+	if ( what & Poller::READ )
+		events |= EPOLLIN;
+	if ( what & Poller::WRITE )
+		events |= EPOLLOUT;
+	if ( what & Poller::EXCEPT )
+		events |= EPOLLPRI;
+
+	return events;
+	}
+
+Poller::Poller()
+	{
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+	if ( epoll_fd < 0 )
+		reporter->FatalError("cannot create epoll instance: %s",
+				     strerror(errno));
+
+	events.resize(16);
+	}
+
+Poller::~Poller()
+	{
+	close(epoll_fd);
+	}
+
+bool Poller::Add(int fd, int what)
+	{
+	auto i = watched.find(fd);
+	bool known = (i != watched.end());
+	int new_what = what;
+
+	if ( known )
+		{
+		if ( (i->second | what) == i->second )
+			return true;
+
+		what |= i->second;
+		}
+
+	if ( known && std::find(always_ready.begin(), always_ready.end(), fd) !=
+		      always_ready.end() )
+		{
+		watched[fd] = what;
+		return true;
+		}
+
+	struct epoll_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = to_epoll(what);
+	ev.data.fd = fd;
+
+	int rc = epoll_ctl(epoll_fd, known ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, fd, &ev);
+
+	if ( rc < 0 && known && errno == ENOENT )
+		{
+		// The descriptor we watched got closed without being
+		// removed, and the number has been reused since.  The
+		// kernel dropped the old one, so start over with the new.
+		what = new_what;
+		ev.events = to_epoll(what);
+		rc = epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+		}
+
+	if ( rc < 0 )
+		{
+		if ( errno != EPERM )
+			return false;
+
+		// Not pollable, like a regular file.
+		always_ready.push_back(fd);
+		}
+
+	watched[fd] = what;
+
+	if ( events.size() < watched.size() )
+		events.resize(watched.size() * 2);
+
+	return true;
+	}
+
+void Poller::Remove(int fd)
+	{
+	if ( ! watched.erase(fd) )
+		return;
+
+	auto i = std::find(always_ready.begin(), always_ready.end(), fd);
+
+	if ( i != always_ready.end() )
+		{
+		always_ready.erase(i);
+		return;
+		}
+
+	// This fails if the descriptor has already been closed, in which
+	// case the kernel has dropped it already.
+	struct epoll_event ev;
+	epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+	}
+
+int Poller::Wait(int timeout, std::vector<int>* ready)
+	{
+	if ( ! always_ready.empty() )
+		timeout = 0;
+
+	int n = epoll_wait(epoll_fd, events.data(), events.size(), timeout);
+
+	if ( n < 0 )
+		{
+		if ( errno != EINTR )
+			reporter->Error("epoll_wait failed: %s", strerror(errno));
+
+		n = 0;
+		}
+
+	for ( int i = 0; i < n; ++i )
+		ready->push_back(events[i].data.fd);
+
+	ready->insert(ready->end(), always_ready.begin(), always_ready.end());
+	return n + always_ready.size();
+	}
+
+#else
+
+static short to_poll(int what)
+	{
+	short events = 0;
+
+	if ( what & Poller::READ )
+		events |= POLLIN;
+	if ( what & Poller::WRITE )
+		events |= POLLOUT;
+	if ( what & Poller::EXCEPT )
+		events |= POLLPRI;
+
+	return events;
+	}
+
+Poller::Poller()
+	{
+	}
+
+Poller::~Poller()
+	{
+	}
+
+bool Poller::Add(int fd, int what)
+	{
+	auto i = watched.find(fd);
+
+	if ( i != watched.end() )
+		what |= i->second;
+
+	watched[fd] = what;
+
+	for ( auto& p : pollfds )
+		if ( p.fd == fd )
+			{
+			p.events = to_poll(what);
+			return true;
+			}
+
+	struct pollfd p;
+	p.fd = fd;
+	p.events = to_poll(what);
+	p.revents = 0;
+	pollfds.push_back(p);
+
+	return true;
+	}
+
+void Poller::Remove(int fd)
+	{
+	if ( ! watched.erase(fd) )
+		return;
+
+	for ( auto i = pollfds.begin(); i != pollfds.end(); ++i )
+		if ( i->fd == fd )
+			{
+			*i = pollfds.back();
+			pollfds.pop_back();
+			break;
+			}
+	}
+
+int Poller::Wait(int timeout, std::vector<int>* ready)
+	{
+	int n = poll(pollfds.data(), pollfds.size(), timeout);
+
+	if ( n < 0 )
+		{
+		if ( errno != EINTR )
+			reporter->Error("poll failed: %s", strerror(errno));
+
+		return 0;
+		}
+
+	if ( n == 0 )
+		return 0;
+
+	int found = 0;
+
+	for ( const auto& p : pollfds )
+		if ( p.revents )
+			{
+			ready->push_back(p.fd);
+			++found;
+			}
+
+	return found;
+	}
+
+#endif
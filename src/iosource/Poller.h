@@ -0,0 +1,102 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#ifndef IOSOURCE_POLLER_H
+#define IOSOURCE_POLLER_H
+
+#include "zeek-config.h"
+
+#include <map>
+#include <vector>
+
+#ifdef HAVE_SYS_EPOLL_H
+#include <sys/epoll.h>
+#else
+#include <poll.h>
+#endif
+
+namespace iosource {
+
+/**
+ * A persistent set of file descriptors to wait on.  Descriptors are
+ * registered once rather than handed to the kernel on every wait; on Linux
+ * this is backed by epoll, elsewhere by a poll() set that's kept across
+ * calls.
+ */
+class Poller {
+public:
+	/**
+	 * Conditions to wait for, to be or'ed together.
+	 */
+	enum {
+		READ = 1,
+		WRITE = 2,
+		EXCEPT = 4,
+	};
+
+	/**
+	 * Constructor.  The set is initially empty.
+	 */
+	Poller();
+
+	/**
+	 * Destructor.
+	 */
+	~Poller();
+
+	/**
+	 * Starts watching a file descriptor.  If it's already watched, the
+	 * conditions are added to the ones it's watched for.
+	 *
+	 * @param fd The file descriptor.
+	 *
+	 * @param what The conditions to watch for.
+	 *
+	 * @return False if the descriptor couldn't be added.
+	 */
+	bool Add(int fd, int what);
+
+	/**
+	 * Stops watching a file descriptor.  Does nothing if it wasn't
+	 * watched.
+	 *
+	 * @param fd The file descriptor.
+	 */
+	void Remove(int fd);
+
+	/**
+	 * Waits for any of the watched descriptors to become ready.
+	 *
+	 * @param timeout Milliseconds to wait at most; zero returns
+	 * immediately.
+	 *
+	 * @param ready Vector to which to append the ready descriptors.
+	 * A descriptor appears at most once per call.
+	 *
+	 * @return The number of descriptors appended.
+	 */
+	int Wait(int timeout, std::vector<int>* ready);
+
+	/**
+	 * @return The number of watched descriptors.
+	 */
+	int Size() const	{ return watched.size(); }
+
+private:
+	// Maps watched descriptors to the conditions they're watched for.
+	std::map<int, int> watched;
+
+#ifdef HAVE_SYS_EPOLL_H
+	// Descriptors that epoll refuses, e.g. regular files.  select()
+	// considers those always ready, and so do we.
+	std::vector<int> always_ready;
+
+	int epoll_fd;
+	std::vector<struct epoll_event> events;
+#else
+	std::vector<struct pollfd> pollfds;
+#endif
+};
+
+}
+
+#endif
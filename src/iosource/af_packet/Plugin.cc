@@ -0,0 +1,30 @@
+// See the file  in the main distribution directory for copyright.
+
+#include "zeek-config.h"
+
+#include "plugin/Plugin.h"
+
+#ifdef HAVE_LINUX
+#include "Source.h"
+#endif
+
+namespace plugin {
+namespace Zeek_AF_Packet {
+
+class Plugin : public plugin::Plugin {
+public:
+	plugin::Configuration Configure()
+		{
+#ifdef HAVE_LINUX
+		AddComponent(new ::iosource::PktSrcComponent("AF_PacketReader", "af_packet", ::iosource::PktSrcComponent::LIVE, ::iosource::af_packet::AF_PacketSource::Instantiate));
+#endif
+
+		plugin::Configuration config;
+		config.name = "Zeek::AF_Packet";
+		config.description = "Packet acquisition via AF_PACKET ring buffers";
+		return config;
+		}
+} plugin;
+
+}
+}
@@ -0,0 +1,397 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "zeek-config.h"
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+extern "C" {
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+}
+
+#include "Source.h"
+#include "iosource/Packet.h"
+
+#include "af_packet.bif.h"
+
+using namespace iosource::af_packet;
+
+AF_PacketSource::~AF_PacketSource()
+	{
+	Close();
+	}
+
+AF_PacketSource::AF_PacketSource(const std::string& path, bool is_live)
+	{
+	props.path = path;
+	props.is_live = is_live;
+
+	fd = -1;
+	is_loopback = false;
+
+	ring = 0;
+	ring_size = block_size = 0;
+	num_blocks = 0;
+
+	current_block = 0;
+	next_hdr = 0;
+	pkts_left = 0;
+	have_block = false;
+	}
+
+void AF_PacketSource::Open()
+	{
+	if ( props.path.empty() )
+		{
+		Error("no interface given");
+		return;
+		}
+
+	unsigned int ifindex = if_nametoindex(props.path.c_str());
+
+	if ( ! ifindex )
+		{
+		Error(fmt("unknown interface %s", props.path.c_str()));
+		return;
+		}
+
+	fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+
+	if ( fd < 0 )
+		{
+		SystemError("socket");
+		return;
+		}
+
+	struct ifreq ifr;
+	memset(&ifr, 0, sizeof(ifr));
+	strncpy(ifr.ifr_name, props.path.c_str(), sizeof(ifr.ifr_name) - 1);
+
+	if ( ioctl(fd, SIOCGIFFLAGS, &ifr) < 0 )
+		{
+		SystemError("SIOCGIFFLAGS");
+		return;
+		}
+
+	is_loopback = (ifr.ifr_flags & IFF_LOOPBACK);
+
+	// The ring must be set up before binding, so that we don't miss
+	// anything in between.
+	if ( ! OpenRing() )
+		return;
+
+	struct sockaddr_ll sll;
+	memset(&sll, 0, sizeof(sll));
+	sll.sll_family = AF_PACKET;
+	sll.sll_protocol = htons(ETH_P_ALL);
+	sll.sll_ifindex = ifindex;
+
+	if ( bind(fd, (struct sockaddr*) &sll, sizeof(sll)) < 0 )
+		{
+		SystemError("bind");
+		return;
+		}
+
+	struct packet_mreq mreq;
+	memset(&mreq, 0, sizeof(mreq));
+	mreq.mr_ifindex = ifindex;
+	mreq.mr_type = PACKET_MR_PROMISC;
+
+	if ( setsockopt(fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) < 0 )
+		{
+		SystemError("PACKET_ADD_MEMBERSHIP");
+		return;
+		}
+
+	if ( BifConst::AF_Packet::enable_fanout && ! JoinFanout() )
+		return;
+
+	props.selectable_fd = fd;
+	props.link_type = DLT_EN10MB;
+	props.netmask = NETMASK_UNKNOWN;
+	props.is_live = true;
+
+	Opened(props);
+	}
+
+bool AF_PacketSource::OpenRing()
+	{
+	int version = TPACKET_V3;
+
+	if ( setsockopt(fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0 )
+		{
+		SystemError("PACKET_VERSION");
+		return false;
+		}
+
+	block_size = BifConst::AF_Packet::block_size;
+	size_t page_size = getpagesize();
+
+	if ( ! block_size || block_size % page_size )
+		{
+		Error(fmt("AF_Packet::block_size must be a multiple of the page size (%zu)",
+			  page_size));
+		Close();
+		return false;
+		}
+
+	num_blocks = BifConst::AF_Packet::buffer_size / block_size;
+
+	if ( ! num_blocks )
+		{
+		Error("AF_Packet::buffer_size must be at least AF_Packet::block_size");
+		Close();
+		return false;
+		}
+
+	// With TPACKET_V3, frames are of variable size; the kernel still
+	// wants to see a nominal one that evenly divides the blocks.
+	unsigned int frame_size = TPACKET_ALIGNMENT << 7;
+
+	struct tpacket_req3 req;
+	memset(&req, 0, sizeof(req));
+	req.tp_block_size = block_size;
+	req.tp_block_nr = num_blocks;
+	req.tp_frame_size = frame_size;
+	req.tp_frame_nr = (block_size / frame_size) * num_blocks;
+	req.tp_retire_blk_tov = BifConst::AF_Packet::block_timeout * 1000;
+
+	if ( ! req.tp_retire_blk_tov )
+		// Zero would have the kernel pick a timeout itself.
+		req.tp_retire_blk_tov = 1;
+
+	if ( setsockopt(fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0 )
+		{
+		SystemError("PACKET_RX_RING");
+		return false;
+		}
+
+	ring_size = block_size * num_blocks;
+	void* m = mmap(0, ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	if ( m == MAP_FAILED )
+		{
+		SystemError("mmap");
+		return false;
+		}
+
+	ring = reinterpret_cast<u_char*>(m);
+	current_block = 0;
+	have_block = false;
+	pkts_left = 0;
+
+	return true;
+	}
+
+bool AF_PacketSource::JoinFanout()
+	{
+	int mode;
+
+	switch ( BifConst::AF_Packet::fanout_mode->AsEnum() ) {
+	case 1:
+		mode = PACKET_FANOUT_CPU;
+		break;
+
+	case 2:
+		mode = PACKET_FANOUT_QM;
+		break;
+
+	default:
+		// Reassemble IP fragments first so that they all hash alike.
+		mode = PACKET_FANOUT_HASH | PACKET_FANOUT_FLAG_DEFRAG;
+		break;
+	}
+
+	int arg = (BifConst::AF_Packet::fanout_id & 0xffff) | (mode << 16);
+
+	if ( setsockopt(fd, SOL_PACKET, PACKET_FANOUT, &arg, sizeof(arg)) < 0 )
+		{
+		SystemError("PACKET_FANOUT");
+		return false;
+		}
+
+	return true;
+	}
+
+void AF_PacketSource::Close()
+	{
+	if ( fd < 0 )
+		return;
+
+	if ( ring )
+		{
+		munmap(ring, ring_size);
+		ring = 0;
+		}
+
+	close(fd);
+	fd = -1;
+
+	have_block = false;
+	next_hdr = 0;
+	pkts_left = 0;
+
+	Closed();
+	}
+
+void AF_PacketSource::SystemError(const char* where)
+	{
+	Error(fmt("%s failed on %s: %s", where, props.path.c_str(), strerror(errno)));
+	Close();
+	}
+
+bool AF_PacketSource::ExtractNextPacket(Packet* pkt)
+	{
+	return ExtractNextPackets(pkt, 1) > 0;
+	}
+
+size_t AF_PacketSource::ExtractNextPackets(Packet* batch, size_t n)
+	{
+	if ( ! ring )
+		return 0;
+
+	if ( ! have_block )
+		{
+		struct tpacket_block_desc* block = CurrentBlock();
+
+		if ( ! (block->hdr.bh1.block_status & TP_STATUS_USER) )
+			// Still the kernel's.
+			return 0;
+
+		have_block = true;
+		pkts_left = block->hdr.bh1.num_pkts;
+		next_hdr = reinterpret_cast<struct tpacket3_hdr*>(
+			reinterpret_cast<u_char*>(block) +
+			block->hdr.bh1.offset_to_first_pkt);
+		}
+
+	size_t i = 0;
+
+	while ( i < n && pkts_left )
+		{
+		struct tpacket3_hdr* hdr = next_hdr;
+		u_char* p = reinterpret_cast<u_char*>(hdr);
+
+		--pkts_left;
+		next_hdr = reinterpret_cast<struct tpacket3_hdr*>(p + hdr->tp_next_offset);
+
+		if ( is_loopback )
+			{
+			// On loopback, we'd see everything twice: going out,
+			// and coming back in. Like libpcap, skip the former.
+			const struct sockaddr_ll* sll =
+				reinterpret_cast<const struct sockaddr_ll*>(
+					p + TPACKET_ALIGN(sizeof(struct tpacket3_hdr)));
+
+			if ( sll->sll_pkttype == PACKET_OUTGOING )
+				continue;
+			}
+
+		pkt_timeval ts = { hdr->tp_sec, static_cast<suseconds_t>(hdr->tp_nsec / 1000) };
+		Packet* pkt = &batch[i++];
+		pkt->Init(props.link_type, &ts, hdr->tp_snaplen, hdr->tp_len, p + hdr->tp_mac);
+
+		// The kernel strips the VLAN tag off if the NIC hasn't already.
+		if ( hdr->tp_status & TP_STATUS_VLAN_VALID )
+			pkt->vlan = hdr->hv1.tp_vlan_tci & 0x0fff;
+
+		++stats.received;
+		stats.bytes_received += hdr->tp_len;
+		}
+
+	if ( ! i && ! pkts_left )
+		{
+		// The block didn't have anything for us. Return it right
+		// away and see if the next one does.
+		ReleaseBlock();
+		return ExtractNextPackets(batch, n);
+		}
+
+	return i;
+	}
+
+void AF_PacketSource::DoneWithPacket()
+	{
+	// The packets handed over so far all point into the current block,
+	// so it can go back only once we've worked through all of it.
+	if ( have_block && ! pkts_left )
+		ReleaseBlock();
+	}
+
+void AF_PacketSource::ReleaseBlock()
+	{
+	CurrentBlock()->hdr.bh1.block_status = TP_STATUS_KERNEL;
+	__sync_synchronize();
+
+	current_block = (current_block + 1) % num_blocks;
+	have_block = false;
+	next_hdr = 0;
+	}
+
+bool AF_PacketSource::PrecompileFilter(int index, const std::string& filter)
+	{
+	return PktSrc::PrecompileBPFFilter(index, filter);
+	}
+
+bool AF_PacketSource::SetFilter(int index)
+	{
+	if ( fd < 0 )
+		return true; // Prevent error message
+
+	BPF_Program* code = GetBPFFilter(index);
+
+	if ( ! code )
+		{
+		Error(fmt("No precompiled filter for index %d", index));
+		return false;
+		}
+
+	// The kernel's and libpcap's BPF programs have the same layout.
+	struct bpf_program* prog = code->GetProgram();
+	struct sock_fprog fprog;
+	fprog.len = prog->bf_len;
+	fprog.filter = reinterpret_cast<struct sock_filter*>(prog->bf_insns);
+
+	if ( setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &fprog, sizeof(fprog)) < 0 )
+		{
+		SystemError("SO_ATTACH_FILTER");
+		return false;
+		}
+
+	// Packets we've already handed over went through the old one.
+	FilterChanged(index);
+	return true;
+	}
+
+void AF_PacketSource::Statistics(Stats* s)
+	{
+	if ( fd >= 0 )
+		{
+		// Reading the kernel's counters resets them.
+		struct tpacket_stats_v3 kstats;
+		socklen_t len = sizeof(kstats);
+
+		if ( getsockopt(fd, SOL_PACKET, PACKET_STATISTICS, &kstats, &len) == 0 )
+			{
+			stats.link += kstats.tp_packets;
+			stats.dropped += kstats.tp_drops;
+			}
+		}
+
+	s->received = stats.received;
+	s->bytes_received = stats.bytes_received;
+	s->link = stats.link;
+	s->dropped = stats.dropped;
+	}
+
+iosource::PktSrc* AF_PacketSource::Instantiate(const std::string& path, bool is_live)
+	{
+	return new AF_PacketSource(path, is_live);
+	}
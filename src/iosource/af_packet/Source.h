@@ -0,0 +1,79 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#ifndef IOSOURCE_PKTSRC_AF_PACKET_SOURCE_H
+#define IOSOURCE_PKTSRC_AF_PACKET_SOURCE_H
+
+extern "C" {
+#include <linux/if_packet.h>
+}
+
+#include "../PktSrc.h"
+
+namespace iosource {
+namespace af_packet {
+
+/**
+ * A live packet source reading from a Linux AF_PACKET socket through a
+ * TPACKET_V3 ring buffer. The kernel fills the ring block by block and
+ * packets are passed on straight out of the ring, without copying; a block
+ * goes back to the kernel once all of its packets have been processed.
+ */
+class AF_PacketSource : public iosource::PktSrc {
+public:
+	AF_PacketSource(const std::string& path, bool is_live);
+	~AF_PacketSource() override;
+
+	static PktSrc* Instantiate(const std::string& path, bool is_live);
+
+protected:
+	// PktSrc interface.
+	void Open() override;
+	void Close() override;
+	bool ExtractNextPacket(Packet* pkt) override;
+	size_t ExtractNextPackets(Packet* batch, size_t n) override;
+	void DoneWithPacket() override;
+	bool PrecompileFilter(int index, const std::string& filter) override;
+	bool SetFilter(int index) override;
+	void Statistics(Stats* stats) override;
+
+private:
+	// Sets up the ring buffer, returning false on error.
+	bool OpenRing();
+
+	// Joins the fanout group, returning false on error.
+	bool JoinFanout();
+
+	// Reports an error with errno's description, and closes the source.
+	void SystemError(const char* where);
+
+	// Returns the current block's descriptor.
+	struct tpacket_block_desc* CurrentBlock() const
+		{ return reinterpret_cast<struct tpacket_block_desc*>(ring + current_block * block_size); }
+
+	// Hands the current block back to the kernel and moves on to the
+	// next one.
+	void ReleaseBlock();
+
+	Properties props;
+	Stats stats;
+
+	int fd;
+	bool is_loopback;
+
+	u_char* ring;
+	size_t ring_size;
+	size_t block_size;
+	unsigned int num_blocks;
+
+	// The block we're currently reading from, and the next packet in
+	// it if it has been handed to us.
+	unsigned int current_block;
+	struct tpacket3_hdr* next_hdr;
+	uint32 pkts_left;
+	bool have_block;
+};
+
+}
+}
+
+#endif
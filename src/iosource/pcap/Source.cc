@@ -18,6 +18,7 @@ using namespace iosource::pcap;
 PcapSource::~PcapSource()
 	{
 	Close();
+	delete [] buffer;
 	}
 
 PcapSource::PcapSource(const std::string& path, bool is_live)
@@ -26,8 +27,11 @@ PcapSource::PcapSource(const std::string& path, bool is_live)
 	props.is_live = is_live;
 	pd = 0;
 	memset(&current_hdr, 0, sizeof(current_hdr));
-	memset(&last_hdr, 0, sizeof(last_hdr));
-	last_data = 0;
+	buffer = 0;
+	buffer_size = buffer_used = 0;
+	batch = 0;
+	batch_len = 0;
+	pending_empty_header = false;
 	}
 
 void PcapSource::Open()
@@ -45,7 +49,6 @@ void PcapSource::Close()
 
 	pcap_close(pd);
 	pd = 0;
-	last_data = 0;
 
 	Closed();
 	}
@@ -202,7 +205,6 @@ bool PcapSource::ExtractNextPacket(Packet* pkt)
 		return false;
 		}
 
-	last_data = data;
 	pkt->Init(props.link_type, &current_hdr.ts, current_hdr.caplen, current_hdr.len, data);
 
 	if ( current_hdr.len == 0 || current_hdr.caplen == 0 )
@@ -211,14 +213,114 @@ bool PcapSource::ExtractNextPacket(Packet* pkt)
 		return false;
 		}
 
-	last_hdr = current_hdr;
-	last_data = data;
 	++stats.received;
 	stats.bytes_received += current_hdr.len;
 
 	return true;
 	}
 
+size_t PcapSource::ExtractNextPackets(Packet* arg_batch, size_t n)
+	{
+	if ( ! pd )
+		return 0;
+
+	if ( n == 1 )
+		// A single packet can stay where libpcap has it, as it leaves
+		// that alone until the next call.
+		return ExtractNextPacket(&arg_batch[0]) ? 1 : 0;
+
+	if ( pending_empty_header )
+		{
+		// Ended the previous batch, whose packets have been processed
+		// by now.
+		pending_empty_header = false;
+		Weird("empty_pcap_header", 0);
+		}
+
+	size_t want = n * BifConst::Pcap::snaplen;
+
+	if ( buffer_size < want )
+		{
+		delete [] buffer;
+		buffer = new u_char[want];
+		buffer_size = want;
+		}
+
+	buffer_used = 0;
+	batch = arg_batch;
+	batch_len = 0;
+
+	int rc = pcap_dispatch(pd, n, AddToBatch, reinterpret_cast<u_char*>(this));
+	batch = 0;
+
+	if ( rc == PCAP_ERROR_BREAK )
+		// We stopped early at an empty header.
+		return batch_len;
+
+	if ( rc < 0 )
+		{
+		PcapError("pcap_dispatch");
+		return 0;
+		}
+
+	if ( rc == 0 && ! props.is_live )
+		// The file has been exhausted. (For a network interface, this
+		// just means nothing has arrived.)
+		Close();
+
+	return batch_len;
+	}
+
+void PcapSource::AddToBatch(u_char* user, const struct pcap_pkthdr* hdr,
+			    const u_char* data)
+	{
+	PcapSource* src = reinterpret_cast<PcapSource*>(user);
+	Packet* pkt = &src->batch[src->batch_len];
+	pkt_timeval ts = hdr->ts;
+
+	if ( hdr->len == 0 || hdr->caplen == 0 )
+		{
+		if ( src->batch_len )
+			{
+			// The weird has to come after the packets before it
+			// have been processed, and before the ones after it.
+			// So we end the batch here and report it when asked
+			// for the next one.
+			src->pending_empty_header = true;
+			pcap_breakloop(src->pd);
+			return;
+			}
+
+		pkt->Init(src->props.link_type, &ts, hdr->caplen, hdr->len,
+			  data);
+		pkt->ProcessDeferredLayer2();
+		src->Weird("empty_pcap_header", pkt);
+		return;
+		}
+
+	const u_char* copy = src->Buffer(data, hdr->caplen);
+
+	// Anything that doesn't fit into the buffer anymore (only possible
+	// if the snaplen is larger than we asked for) gets a copy of its own.
+	pkt->Init(src->props.link_type, &ts, hdr->caplen, hdr->len,
+		  copy ? copy : data, ! copy);
+
+	++src->stats.received;
+	src->stats.bytes_received += hdr->len;
+	++src->batch_len;
+	}
+
+const u_char* PcapSource::Buffer(const u_char* data, uint32 caplen)
+	{
+	if ( buffer_used + caplen > buffer_size )
+		return 0;
+
+	u_char* p = buffer + buffer_used;
+	memcpy(p, data, caplen);
+	buffer_used += caplen;
+	return p;
+	}
+
 void PcapSource::DoneWithPacket()
 	{
 	// Nothing to do.
@@ -261,6 +363,9 @@ bool PcapSource::SetFilter(int index)
 			PcapError();
 			return false;
 			}
+
+		// Packets we've already handed over went through the old one.
+		FilterChanged(index);
 		}
 
 #ifndef HAVE_LINUX
@@ -20,6 +20,7 @@ protected:
 	void Open() override;
 	void Close() override;
 	bool ExtractNextPacket(Packet* pkt) override;
+	size_t ExtractNextPackets(Packet* batch, size_t n) override;
 	void DoneWithPacket() override;
 	bool PrecompileFilter(int index, const std::string& filter) override;
 	bool SetFilter(int index) override;
@@ -31,14 +32,35 @@ private:
 	void PcapError(const char* where = 0);
 	void SetHdrSize();
 
+	// Callback for pcap_dispatch(), filling in the next packet of the
+	// current batch.
+	static void AddToBatch(u_char* user, const struct pcap_pkthdr* hdr,
+			       const u_char* data);
+
+	// Copies a packet's data into the buffer, returning null if it
+	// doesn't fit anymore.
+	const u_char* Buffer(const u_char* data, uint32 caplen);
+
 	Properties props;
 	Stats stats;
 
 	pcap_t *pd;
 
 	struct pcap_pkthdr current_hdr;
-	struct pcap_pkthdr last_hdr;
-	const u_char* last_data;
+
+	// libpcap may reuse its buffer once we return from a callback, so
+	// pcap_dispatch() copies the batch's packets in here.
+	u_char* buffer;
+	size_t buffer_size;
+	size_t buffer_used;
+
+	// The batch currently being filled by pcap_dispatch().
+	Packet* batch;
+	size_t batch_len;
+
+	// Set if a batch ended at a packet with an empty header, which we
+	// still need to report.
+	bool pending_empty_header;
 };
 
 }
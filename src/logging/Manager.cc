@@ -45,10 +45,29 @@ struct Manager::Filter {
 	int num_fields;
 	threading::Field** fields;
 
-	// Vector indexed by field number. Each element is a list of record
-	// indices defining a path leading to the value across potential
-	// sub-records.
-	vector<list<int> > indices;
+	// How to find a field's value in a log record, computed once by
+	// TraverseRecord().
+	struct FieldPlan {
+		// Record indices defining a path leading to the value across
+		// potential sub-records.
+		vector<int> path;
+
+		// True if the path starts at the record returned by ext_func
+		// rather than at the log record itself.
+		bool ext;
+
+		// The number of sub-records along the path, counting the
+		// outer one, that are the same as for the previous field.
+		// Their lookups can be reused.
+		int reuse;
+	};
+
+	// Vector indexed by field number.
+	vector<FieldPlan> plan;
+
+	// Sub-records along the current field's path; scratch space for
+	// RecordToFilterVals(), sized for the longest path.
+	vector<Val*> path_vals;
 
 	~Filter();
 };
@@ -381,7 +400,8 @@ bool Manager::DisableStream(EnumVal* id)
 
 // Helper for recursive record field unrolling.
 bool Manager::TraverseRecord(Stream* stream, Filter* filter, RecordType* rt,
-			    TableVal* include, TableVal* exclude, string path, list<int> indices)
+			    TableVal* include, TableVal* exclude, string path,
+			    const vector<int>& indices, bool ext)
 	{
 	// Only include extensions for the outer record.
 	int num_ext_fields = (indices.size() == 0) ? filter->num_ext_fields : 0;
@@ -408,8 +428,9 @@ bool Manager::TraverseRecord(Stream* stream, Filter* filter, RecordType* rt,
 		if ( ! rtype->FieldDecl(i)->FindAttr(ATTR_LOG) )
 			continue;
 
-		list<int> new_indices = indices;
+		vector<int> new_indices = indices;
 		new_indices.push_back(i);
+		bool new_ext = ext || j < num_ext_fields;
 
 		// Build path name.
 		string new_path;
@@ -433,7 +454,8 @@ bool Manager::TraverseRecord(Stream* stream, Filter* filter, RecordType* rt,
 						      include,
 						      exclude,
 						      new_path,
-						      new_indices) )
+						      new_indices,
+						      new_ext) )
 					return false;
 
 				continue;
@@ -492,7 +514,28 @@ bool Manager::TraverseRecord(Stream* stream, Filter* filter, RecordType* rt,
 			}
 
 		// Alright, we want this field.
-		filter->indices.push_back(new_indices);
+		Filter::FieldPlan fp;
+		fp.path = new_indices;
+		fp.ext = new_ext;
+		fp.reuse = 0;
+
+		if ( ! filter->plan.empty() && filter->plan.back().ext == new_ext )
+			{
+			// The outer record is shared, and so are the sub-records
+			// up to where the paths diverge.
+			const vector<int>& prev = filter->plan.back().path;
+			size_t n = std::min(prev.size(), new_indices.size()) - 1;
+
+			fp.reuse = 1;
+
+			for ( size_t k = 0; k < n && prev[k] == new_indices[k]; ++k )
+				++fp.reuse;
+			}
+
+		filter->plan.push_back(fp);
+
+		if ( new_indices.size() > filter->path_vals.size() )
+			filter->path_vals.resize(new_indices.size());
 
 		void* tmp =
 			realloc(filter->fields,
@@ -615,7 +658,7 @@ bool Manager::AddFilter(EnumVal* id, RecordVal* fval)
 	if ( ! TraverseRecord(stream, filter, stream->columns,
 			      include ? include->AsTableVal() : 0,
 			      exclude ? exclude->AsTableVal() : 0,
-			      "", list<int>()) )
+			      "", vector<int>(), false) )
 		{
 		delete filter;
 		return false;
@@ -911,7 +954,7 @@ bool Manager::Write(EnumVal* id, RecordVal* columns)
 
 		// Alright, can do the write now.
 
-		threading::Value** vals = RecordToFilterVals(stream, filter, columns);
+		threading::Value** vals = RecordToFilterVals(stream, filter, columns, writer);
 
 		if ( ! PLUGIN_HOOK_WITH_RESULT(HOOK_LOG_WRITE,
 		                               HookLogWrite(filter->writer->Type()->AsEnumType()->Lookup(filter->writer->InternalInt()),
@@ -920,8 +963,9 @@ bool Manager::Write(EnumVal* id, RecordVal* columns)
 		                                            filter->fields, vals),
 		                               true) )
 			{
+			// The values stay in the writer's arena until its
+			// next flush.
 			Unref(columns);
-			DeleteVals(filter->num_fields, vals);
 
 #ifdef DEBUG
 			DBG_LOG(DBG_LOGGING, "Hook prevented writing to filter '%s' on stream '%s'",
@@ -930,9 +974,8 @@ bool Manager::Write(EnumVal* id, RecordVal* columns)
 			return true;
 			}
 
-		// Write takes ownership of vals.
 		assert(writer);
-		writer->Write(filter->num_fields, vals);
+		writer->WriteFromArena(filter->num_fields, vals);
 
 #ifdef DEBUG
 		DBG_LOG(DBG_LOGGING, "Wrote record to filter '%s' on stream '%s'",
@@ -945,15 +988,15 @@ bool Manager::Write(EnumVal* id, RecordVal* columns)
 	return true;
 	}
 
-threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
+threading::Value* Manager::ValToLogVal(threading::ValueArena* arena, Val* val, BroType* ty)
 	{
 	if ( ! ty )
 		ty = val->Type();
 
 	if ( ! val )
-		return new threading::Value(ty->Tag(), false);
+		return arena->NewValue(ty->Tag(), false);
 
-	threading::Value* lval = new threading::Value(ty->Tag());
+	threading::Value* lval = arena->NewValue(ty->Tag());
 
 	switch ( lval->type ) {
 	case TYPE_BOOL:
@@ -968,14 +1011,14 @@ threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
 
 		if ( s )
 			{
-			lval->val.string_val.data = copy_string(s);
+			lval->val.string_val.data = arena->CopyString(s);
 			lval->val.string_val.length = strlen(s);
 			}
 
 		else
 			{
 			val->Type()->Error("enum type does not contain value", val);
-			lval->val.string_val.data = copy_string("");
+			lval->val.string_val.data = arena->CopyString("");
 			lval->val.string_val.length = 0;
 			}
 		break;
@@ -1008,10 +1051,7 @@ threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
 	case TYPE_STRING:
 		{
 		const BroString* s = val->AsString();
-		char* buf = new char[s->Len()];
-		memcpy(buf, s->Bytes(), s->Len());
-
-		lval->val.string_val.data = buf;
+		lval->val.string_val.data = arena->CopyString((const char*) s->Bytes(), s->Len());
 		lval->val.string_val.length = s->Len();
 		break;
 		}
@@ -1020,7 +1060,7 @@ threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
 		{
 		const BroFile* f = val->AsFile();
 		string s = f->Name();
-		lval->val.string_val.data = copy_string(s.c_str());
+		lval->val.string_val.data = arena->CopyString(s.c_str(), s.size());
 		lval->val.string_val.length = s.size();
 		break;
 		}
@@ -1031,7 +1071,7 @@ threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
 		const Func* f = val->AsFunc();
 		f->Describe(&d);
 		const char* s = d.Description();
-		lval->val.string_val.data = copy_string(s);
+		lval->val.string_val.data = arena->CopyString(s);
 		lval->val.string_val.length = strlen(s);
 		break;
 		}
@@ -1045,10 +1085,10 @@ threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
 			set = new ListVal(TYPE_INT);
 
 		lval->val.set_val.size = set->Length();
-		lval->val.set_val.vals = new threading::Value* [lval->val.set_val.size];
+		lval->val.set_val.vals = arena->NewValueArray(lval->val.set_val.size);
 
 		for ( int i = 0; i < lval->val.set_val.size; i++ )
-			lval->val.set_val.vals[i] = ValToLogVal(set->Index(i));
+			lval->val.set_val.vals[i] = ValToLogVal(arena, set->Index(i));
 
 		Unref(set);
 		break;
@@ -1059,12 +1099,12 @@ threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
 		VectorVal* vec = val->AsVectorVal();
 		lval->val.vector_val.size = vec->Size();
 		lval->val.vector_val.vals =
-			new threading::Value* [lval->val.vector_val.size];
+			arena->NewValueArray(lval->val.vector_val.size);
 
 		for ( int i = 0; i < lval->val.vector_val.size; i++ )
 			{
 			lval->val.vector_val.vals[i] =
-				ValToLogVal(vec->Lookup(i),
+				ValToLogVal(arena, vec->Lookup(i),
 					    vec->Type()->YieldType());
 			}
 
@@ -1079,7 +1119,7 @@ threading::Value* Manager::ValToLogVal(Val* val, BroType* ty)
 	}
 
 threading::Value** Manager::RecordToFilterVals(Stream* stream, Filter* filter,
-				    RecordVal* columns)
+				    RecordVal* columns, WriterFrontend* writer)
 	{
 	RecordVal* ext_rec = nullptr;
 	if ( filter->num_ext_fields > 0 )
@@ -1090,43 +1130,63 @@ threading::Value** Manager::RecordToFilterVals(Stream* stream, Filter* filter,
 			ext_rec = res->AsRecordVal();
 		}
 
-	threading::Value** vals = new threading::Value*[filter->num_fields];
+	// Only get the arena now, the extension function above might have
+	// written to this writer as well and made it flush its buffer.
+	threading::ValueArena* arena = writer->Arena();
+	threading::Value** vals = arena->NewValueArray(filter->num_fields);
+
+	Val** path_vals = filter->path_vals.data();
+	int valid = 0;	// Number of path_vals entries left by the previous field.
 
 	for ( int i = 0; i < filter->num_fields; ++i )
 		{
-		Val* val;
-		if ( i < filter->num_ext_fields )
+		const Filter::FieldPlan& fp = filter->plan[i];
+		int n = fp.path.size();
+		int d = std::min(valid, fp.reuse);
+
+		if ( d == 0 )
 			{
-			if ( ! ext_rec )
+			path_vals[0] = fp.ext ? ext_rec : columns;
+
+			if ( ! path_vals[0] )
 				{
 				// executing function did not return record. Send empty for all vals.
-				vals[i] = new threading::Value(filter->fields[i]->type, false);
+				vals[i] = arena->NewValue(filter->fields[i]->type, false);
+				valid = 0;
 				continue;
 				}
 
-			val = ext_rec;
+			d = 1;
 			}
-		else
-			val = columns;
 
 		// For each field, first find the right value, which can
-		// potentially be nested inside other records.
-		list<int>& indices = filter->indices[i];
+		// potentially be nested inside other records. We start from
+		// the deepest sub-record we already know.
+		Val* val = path_vals[d - 1];
 
-		for ( list<int>::iterator j = indices.begin(); j != indices.end(); ++j )
+		for ( int k = d - 1; k < n; ++k )
 			{
-			val = val->AsRecordVal()->Lookup(*j);
+			val = val->AsRecordVal()->Lookup(fp.path[k]);
 
 			if ( ! val )
 				{
 				// Value, or any of its parents, is not set.
-				vals[i] = new threading::Value(filter->fields[i]->type, false);
+				vals[i] = arena->NewValue(filter->fields[i]->type, false);
+				d = k + 1;
 				break;
 				}
+
+			if ( k + 1 < n )
+				path_vals[k + 1] = val;
 			}
 
 		if ( val )
-			vals[i] = ValToLogVal(val);
+			{
+			vals[i] = ValToLogVal(arena, val);
+			d = n;
+			}
+
+		valid = d;
 		}
 
 	if ( ext_rec )
@@ -1247,7 +1307,8 @@ WriterFrontend* Manager::CreateWriter(EnumVal* id, EnumVal* writer, WriterBacken
 
 void Manager::DeleteVals(int num_fields, threading::Value** vals)
 	{
-	// Note this code is duplicated in WriterBackend::DeleteVals().
+	// Note this code is duplicated in WriterFrontend::DeleteVals()
+	// and WriteBatch::~WriteBatch().
 	for ( int i = 0; i < num_fields; i++ )
 		delete vals[i];
 
@@ -258,12 +258,13 @@ private:
 	struct WriterInfo;
 
 	bool TraverseRecord(Stream* stream, Filter* filter, RecordType* rt,
-			    TableVal* include, TableVal* exclude, string path, list<int> indices);
+			    TableVal* include, TableVal* exclude, string path,
+			    const vector<int>& indices, bool ext);
 
 	threading::Value** RecordToFilterVals(Stream* stream, Filter* filter,
-				    RecordVal* columns);
+				    RecordVal* columns, WriterFrontend* writer);
 
-	threading::Value* ValToLogVal(Val* val, BroType* ty = 0);
+	threading::Value* ValToLogVal(threading::ValueArena* arena, Val* val, BroType* ty = 0);
 	Stream* FindStream(EnumVal* id);
 	void RemoveDisabledWriters(Stream* stream);
 	void InstallRotationTimer(WriterInfo* winfo);
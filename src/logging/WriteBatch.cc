@@ -0,0 +1,47 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include "WriteBatch.h"
+
+using namespace logging;
+
+WriteBatch::WriteBatch(int arg_num_fields)
+	{
+	num_fields = arg_num_fields;
+	}
+
+WriteBatch::~WriteBatch()
+	{
+	Clear();
+	}
+
+void WriteBatch::Clear()
+	{
+	for ( auto vals : owned )
+		{
+		for ( int i = 0; i < num_fields; i++ )
+			delete vals[i];
+
+		delete [] vals;
+		}
+
+	rows.clear();
+	owned.clear();
+	arena.Reset();
+	}
+
+WriteBatch* WriteBatchRecycler::Get(int num_fields)
+	{
+	WriteBatch* batch = spare.exchange(nullptr);
+
+	if ( batch && batch->NumFields() == num_fields )
+		return batch;
+
+	delete batch;
+	return new WriteBatch(num_fields);
+	}
+
+void WriteBatchRecycler::Put(WriteBatch* batch)
+	{
+	batch->Clear();
+	delete spare.exchange(batch);
+	}
@@ -0,0 +1,135 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#ifndef LOGGING_WRITEBATCH_H
+#define LOGGING_WRITEBATCH_H
+
+#include <atomic>
+#include <vector>
+
+#include "threading/SerialTypes.h"
+#include "threading/ValueArena.h"
+
+namespace logging  {
+
+/**
+ * A batch of log writes that a WriterFrontend collects and then passes on
+ * to its backend thread in one message.
+ *
+ * The batch is a table of values with one row per write and one column
+ * per log field. Rows normally live in the batch's arena: a producer
+ * obtains the arena through WriterFrontend::Arena(), builds the values of
+ * a record from it, and hands the row to the frontend. The whole batch is
+ * then released at once when the backend is done with it, or recycled
+ * for the next batch (see WriteBatchRecycler). Rows that were allocated on
+ * the heap may be added as well; the batch deletes them individually.
+ */
+class WriteBatch {
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param num_fields The number of values in each row.
+	 */
+	explicit WriteBatch(int num_fields);
+
+	/**
+	 * Destructor. Releases all rows.
+	 */
+	~WriteBatch();
+
+	/**
+	 * Removes all rows, keeping the memory allocated for them to fill
+	 * the batch again.
+	 */
+	void Clear();
+
+	/**
+	 * Returns the arena that values for this batch come from.
+	 */
+	threading::ValueArena* Arena()	{ return &arena; }
+
+	/**
+	 * Appends a row built from Arena().
+	 */
+	void Add(threading::Value** vals)	{ rows.push_back(vals); }
+
+	/**
+	 * Appends a row that was allocated with new, along with all its
+	 * values. The batch takes ownership.
+	 */
+	void AddOwned(threading::Value** vals)
+		{
+		rows.push_back(vals);
+		owned.push_back(vals);
+		}
+
+	/**
+	 * Returns the number of values in each row.
+	 */
+	int NumFields() const	{ return num_fields; }
+
+	/**
+	 * Returns the number of rows in the batch.
+	 */
+	int NumWrites() const	{ return rows.size(); }
+
+	/**
+	 * Returns the values of one write.
+	 */
+	threading::Value** Row(int write) const	{ return rows[write]; }
+
+	/**
+	 * Returns a single value.
+	 */
+	threading::Value* Get(int write, int field) const
+		{ return rows[write][field]; }
+
+private:
+	WriteBatch(const WriteBatch& other);	// Disabled.
+	WriteBatch& operator=(const WriteBatch& other);	// Disabled.
+
+	int num_fields;
+	std::vector<threading::Value**> rows;
+	std::vector<threading::Value**> owned;	// Subset of rows to delete.
+	threading::ValueArena arena;
+};
+
+/**
+ * Hands written batches back from a writer thread to its frontend, so
+ * that the frontend can fill them again rather than allocating new ones.
+ *
+ * Frontend and backend share an instance. It keeps a single spare batch,
+ * which is enough for the usual case of the backend keeping up: each
+ * batch it finishes becomes the frontend's next one.
+ */
+class WriteBatchRecycler {
+public:
+	/**
+	 * Constructor.
+	 */
+	WriteBatchRecycler() : spare(nullptr)	{ }
+
+	/**
+	 * Destructor. Deletes the spare batch, if any.
+	 */
+	~WriteBatchRecycler()	{ delete spare.load(); }
+
+	/**
+	 * Returns an empty batch, reusing the spare one if available. Must
+	 * only be called by the frontend.
+	 */
+	WriteBatch* Get(int num_fields);
+
+	/**
+	 * Takes a batch that has been written out and clears it for reuse.
+	 * Must only be called by the backend.
+	 */
+	void Put(WriteBatch* batch);
+
+private:
+	std::atomic<WriteBatch*> spare;
+};
+
+}
+
+#endif
@@ -125,6 +125,7 @@ WriterBackend::WriterBackend(WriterFrontend* arg_frontend) : MsgThread()
 	buffering = true;
 	frontend = arg_frontend;
 	info = new WriterInfo(frontend->Info());
+	recycler = frontend->Recycler();
 	rotation_counter = 0;
 
 	SetName(frontend->Name());
@@ -143,20 +144,6 @@ WriterBackend::~WriterBackend()
 	delete info;
 	}
 
-void WriterBackend::DeleteVals(int num_writes, Value*** vals)
-	{
-	for ( int j = 0; j < num_writes; ++j )
-		{
-		// Note this code is duplicated in Manager::DeleteVals().
-		for ( int i = 0; i < num_fields; i++ )
-			delete vals[j][i];
-
-		delete [] vals[j];
-		}
-
-	delete [] vals;
-	}
-
 bool WriterBackend::FinishedRotation(const char* new_name, const char* old_name,
 				     double open, double close, bool terminating)
 	{
@@ -195,11 +182,11 @@ bool WriterBackend::Init(int arg_num_fields, const Field* const* arg_fields)
 	return true;
 	}
 
-bool WriterBackend::Write(int arg_num_fields, int num_writes, Value*** vals)
+bool WriterBackend::Write(int arg_num_fields, WriteBatch* batch)
 	{
 	// Double-check that the arguments match. If we get this from remote,
 	// something might be mixed up.
-	if ( num_fields != arg_num_fields )
+	if ( num_fields != arg_num_fields || num_fields != batch->NumFields() )
 		{
 
 #ifdef DEBUG
@@ -208,25 +195,29 @@ bool WriterBackend::Write(int arg_num_fields, int num_writes, Value*** vals)
 		Debug(DBG_LOGGING, msg);
 #endif
 
-		DeleteVals(num_writes, vals);
+		delete batch;
 		DisableFrontend();
 		return false;
 		}
 
+	int num_writes = batch->NumWrites();
+
 	// Double-check all the types match.
 	for ( int j = 0; j < num_writes; j++ )
 		{
+		Value** vals = batch->Row(j);
+
 		for ( int i = 0; i < num_fields; ++i )
 			{
-			if ( vals[j][i]->type != fields[i]->type )
+			if ( vals[i]->type != fields[i]->type )
 				{
 #ifdef DEBUG
 				const char* msg = Fmt("Field #%d type doesn't match in WriterBackend::Write() (%d vs. %d)",
-						      i, vals[j][i]->type, fields[i]->type);
+						      i, vals[i]->type, fields[i]->type);
 				Debug(DBG_LOGGING, msg);
 #endif
 				DisableFrontend();
-				DeleteVals(num_writes, vals);
+				delete batch;
 				return false;
 				}
 			}
@@ -235,17 +226,9 @@ bool WriterBackend::Write(int arg_num_fields, int num_writes, Value*** vals)
 	bool success = true;
 
 	if ( ! Failed() )
-		{
-		for ( int j = 0; j < num_writes; j++ )
-			{
-			success = DoWrite(num_fields, fields, vals[j]);
+		success = DoWriteBatch(num_fields, fields, *batch);
 
-			if ( ! success )
-				break;
-			}
-		}
-
-	DeleteVals(num_writes, vals);
+	recycler->Put(batch);
 
 	if ( ! success )
 		DisableFrontend();
@@ -253,6 +236,18 @@ bool WriterBackend::Write(int arg_num_fields, int num_writes, Value*** vals)
 	return success;
 	}
 
+bool WriterBackend::DoWriteBatch(int num_fields, const Field* const* fields,
+				 const WriteBatch& batch)
+	{
+	for ( int j = 0; j < batch.NumWrites(); j++ )
+		{
+		if ( ! DoWrite(num_fields, fields, batch.Row(j)) )
+			return false;
+		}
+
+	return true;
+	}
+
 bool WriterBackend::SetBuf(bool enabled)
 	{
 	if ( enabled == buffering )
@@ -5,9 +5,12 @@
 #ifndef LOGGING_WRITERBACKEND_H
 #define LOGGING_WRITERBACKEND_H
 
+#include <memory>
+
 #include "threading/MsgThread.h"
 
 #include "Component.h"
+#include "WriteBatch.h"
 
 namespace broker { class data; }
 
@@ -134,21 +137,21 @@ public:
 	bool Init(int num_fields, const threading::Field* const* fields);
 
 	/**
-	 * Writes one log entry.
+	 * Writes a batch of log entries.
 	 *
 	 * @param num_fields: The number of log fields for this stream. The
 	 * value must match what was passed to Init().
 	 *
-	 * @param An array of size \a num_fields with the log values. Their
-	 * types musst match with the field passed to Init(). The method
-	 * takes ownership of \a vals..
+	 * @param batch The log values, with one row of \a num_fields values
+	 * per entry. Their types musst match with the field passed to
+	 * Init(). The method takes ownership of \a batch.
 	 *
 	 * Returns false if an error occured, in which case the writer must
 	 * not be used any further.
 	 *
 	 * @return False if an error occured.
 	 */
-	bool Write(int num_fields, int num_writes, threading::Value*** vals);
+	bool Write(int num_fields, WriteBatch* batch);
 
 	/**
 	 * Sets the buffering status for the writer, assuming the writer
@@ -281,6 +284,20 @@ protected:
 	virtual bool DoWrite(int num_fields, const threading::Field* const*  fields,
 			     threading::Value** vals) = 0;
 
+	/**
+	 * Writer-specific output method implementing recording of a batch
+	 * of log entries. The batch remains owned by the caller.
+	 *
+	 * A writer implementation may override this method to process the
+	 * entries as a whole, e.g., to format all of them into one buffer
+	 * and write that out at once. The default implementation passes
+	 * them to DoWrite() one by one. Return values are handled as with
+	 * DoWrite(); a writer failing in the middle of a batch may, but
+	 * doesn't need to, have recorded the entries before that.
+	 */
+	virtual bool DoWriteBatch(int num_fields, const threading::Field* const* fields,
+				  const WriteBatch& batch);
+
 	/**
 	 * Writer-specific method implementing a change of fthe buffering
 	 * state.  If buffering is disabled, the writer should attempt to
@@ -371,11 +388,6 @@ protected:
 	virtual bool DoHeartbeat(double network_time, double current_time) = 0;
 
 private:
-	/**
-	 * Deletes the values as passed into Write().
-	 */
-	void DeleteVals(int num_writes, threading::Value*** vals);
-
 	// Frontend that instantiated us. This object must not be access from
 	// this class, it's running in a different thread!
 	WriterFrontend* frontend;
@@ -384,6 +396,7 @@ private:
 	int num_fields;	// Number of log fields.
 	const threading::Field* const*  fields;	// Log fields.
 	bool buffering;	// True if buffering is enabled.
+	std::shared_ptr<WriteBatchRecycler> recycler;	// Returns batches to frontend.
 
 	int rotation_counter; // Tracks FinishedRotation() calls.
 };
@@ -55,16 +55,15 @@ private:
 class WriteMessage : public threading::InputMessage<WriterBackend>
 {
 public:
-	WriteMessage(WriterBackend* backend, int num_fields, int num_writes, Value*** vals)
+	WriteMessage(WriterBackend* backend, int num_fields, WriteBatch* batch)
 		: threading::InputMessage<WriterBackend>("Write", backend),
-		num_fields(num_fields), num_writes(num_writes), vals(vals)	{}
+		num_fields(num_fields), batch(batch)	{}
 
-	virtual bool Process() { return Object()->Write(num_fields, num_writes, vals); }
+	virtual bool Process() { return Object()->Write(num_fields, batch); }
 
 private:
 	int num_fields;
-	int num_writes;
-	Value ***vals;
+	WriteBatch* batch;
 };
 
 class SetBufMessage : public threading::InputMessage<WriterBackend>
@@ -110,7 +109,7 @@ WriterFrontend::WriterFrontend(const WriterBackend::WriterInfo& arg_info, EnumVa
 	local = arg_local;
 	remote = arg_remote;
 	write_buffer = 0;
-	write_buffer_pos = 0;
+	recycler = std::make_shared<WriteBatchRecycler>();
 	info = new WriterBackend::WriterInfo(arg_info);
 
 	num_fields = 0;
@@ -135,6 +134,7 @@ WriterFrontend::~WriterFrontend()
 	{
 	Unref(stream);
 	Unref(writer);
+	delete write_buffer;
 	delete info;
 	delete [] name;
 	}
@@ -178,19 +178,15 @@ void WriterFrontend::Init(int arg_num_fields, const Field* const * arg_fields)
 
 	}
 
-void WriterFrontend::Write(int arg_num_fields, Value** vals)
+bool WriterFrontend::PrepareWrite(int arg_num_fields, Value** vals)
 	{
 	if ( disabled )
-		{
-		DeleteVals(arg_num_fields, vals);
-		return;
-		}
+		return false;
 
 	if ( arg_num_fields != num_fields )
 		{
 		reporter->Warning("WriterFrontend %s expected %d fields in write, got %d. Skipping line.", name, num_fields, arg_num_fields);
-		DeleteVals(arg_num_fields, vals);
-		return;
+		return false;
 		}
 
 	if ( remote )
@@ -202,39 +198,79 @@ void WriterFrontend::Write(int arg_num_fields, Value** vals)
 				vals);
 		}
 
-	if ( ! backend )
+	return backend != 0;
+	}
+
+void WriterFrontend::Write(int arg_num_fields, Value** vals)
+	{
+	if ( ! PrepareWrite(arg_num_fields, vals) )
 		{
 		DeleteVals(arg_num_fields, vals);
 		return;
 		}
 
 	if ( ! write_buffer )
+		write_buffer = recycler->Get(num_fields);
+
+	write_buffer->AddOwned(vals);
+	BufferedWrite();
+	}
+
+threading::ValueArena* WriterFrontend::Arena()
+	{
+	if ( ! write_buffer )
+		write_buffer = recycler->Get(num_fields);
+
+	return write_buffer->Arena();
+	}
+
+void WriterFrontend::WriteFromArena(int arg_num_fields, Value** vals)
+	{
+	assert(write_buffer);
+
+	if ( ! PrepareWrite(arg_num_fields, vals) )
 		{
-		// Need new buffer.
-		write_buffer = new Value**[WRITER_BUFFER_SIZE];
-		write_buffer_pos = 0;
+		// Nothing else refers to the arena if the buffer is still
+		// empty, so we can recycle it right away. That keeps it from
+		// growing for writers that never send anything to a backend.
+		if ( ! write_buffer->NumWrites() )
+			write_buffer->Arena()->Reset();
+
+		return;
 		}
 
-	write_buffer[write_buffer_pos++] = vals;
+	write_buffer->Add(vals);
+	BufferedWrite();
+	}
 
-	if ( write_buffer_pos >= WRITER_BUFFER_SIZE || ! buf || terminating )
+void WriterFrontend::BufferedWrite()
+	{
+	if ( write_buffer->NumWrites() >= WRITER_BUFFER_SIZE || ! buf || terminating )
 		// Buffer full (or no bufferin desired or termiating).
 		FlushWriteBuffer();
-
 	}
 
 void WriterFrontend::FlushWriteBuffer()
 	{
-	if ( ! write_buffer_pos )
+	if ( ! write_buffer )
 		// Nothing to do.
 		return;
 
+	if ( ! write_buffer->NumWrites() )
+		{
+		// Recycle anything allocated for writes that didn't
+		// happen in the end.
+		write_buffer->Arena()->Reset();
+		return;
+		}
+
 	if ( backend )
-		backend->SendIn(new WriteMessage(backend, num_fields, write_buffer_pos, write_buffer));
+		// Passes ownership to child thread.
+		backend->SendIn(new WriteMessage(backend, num_fields, write_buffer));
+	else
+		delete write_buffer;
 
-	// Clear buffer (no delete, we pass ownership to child thread.)
 	write_buffer = 0;
-	write_buffer_pos = 0;
 	}
 
 void WriterFrontend::SetBuf(bool enabled)
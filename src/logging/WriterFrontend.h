@@ -3,6 +3,8 @@
 #ifndef LOGGING_WRITERFRONTEND_H
 #define LOGGING_WRITERFRONTEND_H
 
+#include <memory>
+
 #include "WriterBackend.h"
 
 #include "threading/MsgThread.h"
@@ -95,6 +97,25 @@ public:
 	 */
 	void Write(int num_fields, threading::Value** vals);
 
+	/**
+	 * Returns the arena backing the current write buffer. A caller may
+	 * build a record's values from it and then pass them to
+	 * WriteFromArena(), which avoids allocating them individually. The
+	 * values must be handed over right away, before anything else may
+	 * flush the buffer.
+	 *
+	 * This method must only be called from the main thread.
+	 */
+	threading::ValueArena* Arena();
+
+	/**
+	 * Writes out a record whose values were allocated from Arena().
+	 * Other than how the values are owned, this works like Write().
+	 *
+	 * This method must only be called from the main thread.
+	 */
+	void WriteFromArena(int num_fields, threading::Value** vals);
+
 	/**
 	 * Sets the buffering state.
 	 *
@@ -185,10 +206,18 @@ public:
 	 */
 	const threading::Field* const * Fields() const	{ return fields; }
 
+	/**
+	 * Returns the recycler through which the backend hands written
+	 * batches back.
+	 */
+	std::shared_ptr<WriteBatchRecycler> Recycler() const	{ return recycler; }
+
 protected:
 	friend class Manager;
 
 	void DeleteVals(int num_fields, threading::Value** vals);
+	bool PrepareWrite(int num_fields, threading::Value** vals);
+	void BufferedWrite();
 
 	EnumVal* stream;
 	EnumVal* writer;
@@ -207,8 +236,8 @@ protected:
 
 	// Buffer for bulk writes.
 	static const int WRITER_BUFFER_SIZE = 1000;
-	int write_buffer_pos;	// Position of next write in buffer.
-	threading::Value*** write_buffer;	// Buffer of size WRITER_BUFFER_SIZE.
+	WriteBatch* write_buffer;	// Holds up to WRITER_BUFFER_SIZE writes.
+	std::shared_ptr<WriteBatchRecycler> recycler;	// Shared with backend.
 };
 
 }
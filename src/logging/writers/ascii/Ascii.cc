@@ -416,6 +416,65 @@ write_error:
 	return false;
 	}
 
+bool Ascii::DoWriteBatch(int num_fields, const Field* const * fields,
+			 const WriteBatch& batch)
+	{
+	if ( ! fd )
+		DoInit(Info(), NumFields(), Fields());
+
+	// We format all lines into one buffer and write it out with a
+	// single call, except that any line starting with the meta prefix
+	// needs its first character escaped; we split the output there.
+	desc.Clear();
+
+	bool success = true;
+	int done = 0;	// Offset up to which the buffer has been written.
+	int end = 0;	// Offset up to which the buffer has complete lines.
+
+	for ( int j = 0; j < batch.NumWrites(); j++ )
+		{
+		if ( ! formatter->Describe(&desc, num_fields, fields, batch.Row(j)) )
+			{
+			// Still write out the lines before this one.
+			success = false;
+			break;
+			}
+
+		desc.AddRaw("\n", 1);
+
+		const char* bytes = (const char*)desc.Bytes();
+		const char* line = bytes + end;
+
+		if ( strncmp(line, meta_prefix.data(), meta_prefix.size()) == 0 )
+			{
+			char hex[4] = {'\\', 'x', '0', '0'};
+			bytetohex(line[0], hex + 2);
+
+			if ( ! InternalWrite(fd, bytes + done, end - done) )
+				goto write_error;
+
+			if ( ! InternalWrite(fd, hex, 4) )
+				goto write_error;
+
+			done = end + 1;
+			}
+
+		end = desc.Len();
+		}
+
+	if ( ! InternalWrite(fd, (const char*)desc.Bytes() + done, end - done) )
+		goto write_error;
+
+	if ( ! IsBuf() )
+		fsync(fd);
+
+	return success;
+
+write_error:
+	Error(Fmt("error writing to %s: %s", fname.c_str(), Strerror(errno)));
+	return false;
+	}
+
 bool Ascii::DoRotate(const char* rotated_path, double open, double close, bool terminating)
 	{
 	// Don't rotate special files or if there's not one currently open.
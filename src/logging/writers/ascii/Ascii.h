@@ -27,6 +27,8 @@ protected:
 			    const threading::Field* const* fields) override;
 	bool DoWrite(int num_fields, const threading::Field* const* fields,
 			     threading::Value** vals) override;
+	bool DoWriteBatch(int num_fields, const threading::Field* const* fields,
+			  const WriteBatch& batch) override;
 	bool DoSetBuf(bool enabled) override;
 	bool DoRotate(const char* rotated_path, double open,
 			      double close, bool terminating) override;
@@ -201,6 +201,7 @@ void usage(int code = 1)
 	fprintf(stderr, "    $ZEEK_LOG_SUFFIX               | ASCII log file extension (.%s)\n", logging::writer::Ascii::LogExt().c_str());
 	fprintf(stderr, "    $ZEEK_PROFILER_FILE            | Output file for script execution statistics (not set)\n");
 	fprintf(stderr, "    $ZEEK_DISABLE_ZEEKYGEN         | Disable Zeekygen documentation support (%s)\n", zeekenv("ZEEK_DISABLE_ZEEKYGEN") ? "set" : "not set");
+	fprintf(stderr, "    $ZEEK_TIMER_MGR                | Timer manager to use, 'pq' or 'wheel' (%s)\n", zeekenv("ZEEK_TIMER_MGR") ? zeekenv("ZEEK_TIMER_MGR") : "pq");
 	fprintf(stderr, "    $ZEEK_DNS_RESOLVER             | IPv4/IPv6 address of DNS resolver to use (%s)\n", zeekenv("ZEEK_DNS_RESOLVER") ? zeekenv("ZEEK_DNS_RESOLVER") : "not set, will use first IPv4 address from /etc/resolv.conf");
 
 	fprintf(stderr, "\n");
@@ -343,6 +344,9 @@ void terminate_bro()
 
 	plugin_mgr->FinishPlugins();
 
+	if ( rule_matcher )
+		rule_matcher->SaveDFAs();
+
 	delete zeekygen_mgr;
 	delete timer_mgr;
 	delete event_registry;
@@ -708,8 +712,15 @@ int main(int argc, char** argv)
 	createCurrentDoc("1.0");		// Set a global XML document
 #endif
 
-	timer_mgr = new PQ_TimerMgr("<GLOBAL>");
-	// timer_mgr = new CQ_TimerMgr();
+	const char* timer_mgr_type = zeekenv("ZEEK_TIMER_MGR");
+
+	if ( ! timer_mgr_type || streq(timer_mgr_type, "pq") )
+		timer_mgr = new PQ_TimerMgr("<GLOBAL>");
+	else if ( streq(timer_mgr_type, "wheel") )
+		timer_mgr = new TW_TimerMgr("<GLOBAL>");
+	else
+		reporter->FatalError("unknown timer manager '%s' in ZEEK_TIMER_MGR",
+				     timer_mgr_type);
 
 	zeekygen_mgr = new zeekygen::Manager(zeekygen_config, bro_argv[0]);
 
@@ -893,6 +904,12 @@ int main(int argc, char** argv)
 			exit(1);
 			}
 
+		const char* dfa_cache =
+			internal_val("signature_dfa_cache")->AsString()->CheckString();
+
+		if ( *dfa_cache )
+			rule_matcher->LoadDFAs(dfa_cache);
+
 		if ( rule_debug )
 			rule_matcher->PrintDebug();
 
@@ -782,7 +782,13 @@ protected:
 	 * @param fields threading::Field description of the fields being logged.
 	 *
 	 * @param vals threading::Values containing the values being written. Values
-	 *             can be modified in the Hook.
+	 *             can be modified in the Hook, but only in place: they are
+	 *             allocated from the writer's ValueArena and stay owned by
+	 *             it until the batch they belong to has been written. Never
+	 *             delete or replace a Value, or the strings, sets and vectors
+	 *             it points to; memory swapped in by the hook would be read
+	 *             by the writer thread after the hook returns, and arena
+	 *             memory handed to delete would be freed twice.
 	 *
 	 * @return true if log line should be written, false if log line should be
 	 *         skipped and not passed on to the writer.
@@ -1,12 +1,11 @@
 #ifndef THREADING_QUEUE_H
 #define THREADING_QUEUE_H
 
+#include <atomic>
+#include <chrono>
 #include <mutex>
 #include <condition_variable>
-#include <queue>
-#include <deque>
 #include <stdint.h>
-#include <sys/time.h>
 
 #include "Reporter.h"
 #include "BasicThread.h"
@@ -18,13 +17,18 @@ namespace threading {
 /**
  * A thread-safe single-reader single-writer queue.
  *
- * The implementation uses multiple queues and reads/writes in rotary fashion
- * in an attempt to limit contention.
+ * The queue is lock-free: messages go into a chain of fixed-size ring
+ * blocks, with the writer filling the last block and the reader draining
+ * the first. Once the writer finds its block full, it links in a new one
+ * rather than waiting for the reader, so Put() never blocks; that matters
+ * because the main thread writes to one queue of a thread while the thread
+ * may itself be waiting for it to drain the other.
  *
- * All Queue instances must be instantiated by Bro's main thread.
+ * A mutex is only involved when the reader has run out of input and goes
+ * to sleep in Get(); the writer checks for that after each Put() and only
+ * then takes the mutex to wake it up.
  *
- * TODO: Unclear how critical performance is for this qeueue. We could likely
- * optimize it further if helpful.
+ * All Queue instances must be instantiated by Bro's main thread.
  */
 template<typename T>
 class Queue
@@ -47,30 +51,29 @@ public:
 	/**
 	 * Retrieves one element. This may block for a little while of no
 	 * input is available and eventually return with a null element if
-	 * nothing shows up.
+	 * nothing shows up. Must only be called by the reader.
 	 */
 	T Get();
 
 	/**
-	 * Queues one element.
+	 * Queues one element. Must only be called by the writer.
 	 */
 	void Put(T data);
 
 	/**
-	 * Returns true if the next Get() operation will succeed.
+	 * Returns true if the next Get() operation will succeed. Must only be
+	 * called by the reader.
 	 */
 	bool Ready();
 
 	/**
 	 * Returns true if the next Get() operation might succeed. This
 	 * function may occasionally return a value not indicating the actual
-	 * state, but won't do so very often. Note that this means that it can
-	 * consistently return false even if there is something in the Queue.
-	 * You have to check real queue status from time to time to be sure that
-	 * it is empty. In other words, this method helps to avoid locking the queue
-	 * frequently, but doesn't allow you to forgo it completely.
+	 * state, but won't do so very often. Unlike Ready(), it may be called
+	 * from any thread.
 	 */
-	bool MaybeReady() { return (num_reads != num_writes); }
+	bool MaybeReady()
+		{ return num_reads.load(std::memory_order_relaxed) != num_writes.load(std::memory_order_relaxed); }
 
 	/**
 	 * Wake up the reader if it's currently blocked for input. This is
@@ -101,23 +104,46 @@ public:
 	void GetStats(Stats* stats);
 
 private:
-	static const int NUM_QUEUES = 8;
+	// The number of messages per block.
+	static const int BLOCK_SIZE = 512;
+
+	struct Block {
+		T slots[BLOCK_SIZE];
+
+		// Number of slots the writer has filled so far.
+		std::atomic<int> filled;
+
+		// Number of slots the reader has taken so far; reader only.
+		int taken;
+
+		// The block the writer moved on to once this one was full.
+		std::atomic<Block*> next;
+	};
+
+	// Returns an empty block, reusing the spare one if there is one.
+	Block* NewBlock();
 
-	std::vector<std::unique_lock<std::mutex>> LocksForAllQueues();
+	// Takes the next element if there is one.
+	bool Pop(T* data);
 
-	std::mutex mutex[NUM_QUEUES];	// Mutex protected shared accesses.
-	std::condition_variable has_data[NUM_QUEUES];	// Signals when data becomes available
-	std::queue<T> messages[NUM_QUEUES];	// Actually holds the queued messages
+	Block* read_block;	// Block the next read takes from (reader only).
+	Block* write_block;	// Block the next write goes to (writer only).
 
-	int read_ptr;	// Where the next operation will read from
-	int write_ptr;	// Where the next operation will write to
+	// The last block the reader finished with, kept for the writer to
+	// reuse so that a queue in steady use doesn't keep allocating.
+	std::atomic<Block*> spare;
+
+	// For letting the reader sleep while there's nothing to read.
+	std::mutex mutex;
+	std::condition_variable has_data;
+	std::atomic<bool> sleeping;
 
 	BasicThread* reader;
 	BasicThread* writer;
 
 	// Statistics.
-	uint64_t num_reads;
-	uint64_t num_writes;
+	std::atomic<uint64_t> num_reads;
+	std::atomic<uint64_t> num_writes;
 };
 
 inline static std::unique_lock<std::mutex> acquire_lock(std::mutex& m)
@@ -137,8 +163,9 @@ inline static std::unique_lock<std::mutex> acquire_lock(std::mutex& m)
 template<typename T>
 inline Queue<T>::Queue(BasicThread* arg_reader, BasicThread* arg_writer)
 	{
-	read_ptr = 0;
-	write_ptr = 0;
+	spare = nullptr;
+	read_block = write_block = NewBlock();
+	sleeping = false;
 	num_reads = num_writes = 0;
 	reader = arg_reader;
 	writer = arg_writer;
@@ -147,116 +174,166 @@ inline Queue<T>::Queue(BasicThread* arg_reader, BasicThread* arg_writer)
 template<typename T>
 inline Queue<T>::~Queue()
 	{
+	Block* b = read_block;
+
+	while ( b )
+		{
+		Block* next = b->next.load();
+		delete b;
+		b = next;
+		}
+
+	delete spare.load();
 	}
 
 template<typename T>
-inline T Queue<T>::Get()
+inline typename Queue<T>::Block* Queue<T>::NewBlock()
 	{
-	auto lock = acquire_lock(mutex[read_ptr]);
+	Block* b = spare.exchange(nullptr, std::memory_order_acquire);
 
-	int old_read_ptr = read_ptr;
+	if ( ! b )
+		b = new Block;
 
-	if ( messages[read_ptr].empty() && ! ((reader && reader->Killed()) || (writer && writer->Killed())) )
+	b->filled.store(0, std::memory_order_relaxed);
+	b->taken = 0;
+	b->next.store(nullptr, std::memory_order_relaxed);
+
+	return b;
+	}
+
+template<typename T>
+inline bool Queue<T>::Pop(T* data)
+	{
+	Block* b = read_block;
+
+	if ( b->taken == BLOCK_SIZE )
 		{
-		if ( has_data[read_ptr].wait_for(lock, std::chrono::seconds(5)) == std::cv_status::timeout )
-			return nullptr;
-		}
+		Block* next = b->next.load(std::memory_order_acquire);
 
-	if ( messages[read_ptr].empty() )
-		return nullptr;
+		if ( ! next )
+			return false;
 
-	T data = messages[read_ptr].front();
-	messages[read_ptr].pop();
+		// The writer has moved on, so it's done with the old one.
+		read_block = next;
+		delete spare.exchange(b, std::memory_order_release);
+		b = next;
+		}
 
-	read_ptr = (read_ptr + 1) % NUM_QUEUES;
-	++num_reads;
+	if ( b->taken == b->filled.load(std::memory_order_acquire) )
+		return false;
 
-	return data;
+	*data = b->slots[b->taken++];
+	num_reads.fetch_add(1, std::memory_order_release);
+	return true;
 	}
 
 template<typename T>
-inline void Queue<T>::Put(T data)
+inline T Queue<T>::Get()
 	{
-	auto lock = acquire_lock(mutex[write_ptr]);
+	T data;
 
-	int old_write_ptr = write_ptr;
+	if ( Pop(&data) )
+		return data;
 
-	bool need_signal = messages[write_ptr].empty();
+	if ( (reader && reader->Killed()) || (writer && writer->Killed()) )
+		return nullptr;
 
-	messages[write_ptr].push(data);
+	auto lock = acquire_lock(mutex);
 
-	write_ptr = (write_ptr + 1) % NUM_QUEUES;
-	++num_writes;
+	// Announce that we're going to sleep before checking once more; the
+	// writer publishes before checking whether to wake us, so one of us
+	// is bound to see the other.
+	sleeping.store(true);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
 
-	if ( need_signal )
+	if ( Pop(&data) )
 		{
-		lock.unlock();
-		has_data[old_write_ptr].notify_one();
+		sleeping.store(false, std::memory_order_relaxed);
+		return data;
 		}
-	}
 
+	has_data.wait_for(lock, std::chrono::seconds(5));
+	sleeping.store(false, std::memory_order_relaxed);
+	lock.unlock();
 
-template<typename T>
-inline bool Queue<T>::Ready()
-	{
-	auto lock = acquire_lock(mutex[read_ptr]);
-
-	bool ret = (messages[read_ptr].size());
+	if ( Pop(&data) )
+		return data;
 
-	return ret;
+	return nullptr;
 	}
 
 template<typename T>
-inline std::vector<std::unique_lock<std::mutex>> Queue<T>::LocksForAllQueues()
+inline void Queue<T>::Put(T data)
 	{
-	std::vector<std::unique_lock<std::mutex>> locks;
+	Block* b = write_block;
+	int i = b->filled.load(std::memory_order_relaxed);
 
-	try
+	if ( i == BLOCK_SIZE )
 		{
-		for ( int i = 0; i < NUM_QUEUES; i++ )
-			locks.emplace_back(std::unique_lock<std::mutex>(mutex[i]));
+		// Never wait for the reader; chain a new block instead.
+		Block* next = NewBlock();
+		b->next.store(next, std::memory_order_release);
+		write_block = b = next;
+		i = 0;
 		}
 
-	catch ( const std::system_error& e )
+	// Counting first means the reader can't count more than we do.
+	num_writes.fetch_add(1, std::memory_order_release);
+	b->slots[i] = data;
+	b->filled.store(i + 1, std::memory_order_release);
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if ( sleeping.load(std::memory_order_relaxed) )
 		{
-		reporter->FatalErrorWithCore("cannot lock all mutexes: %s", e.what());
-		// Never gets here.
-		throw std::exception();
-		}
+		// Taking the mutex makes sure the reader is actually waiting
+		// by the time we notify it.
+			{
+			auto lock = acquire_lock(mutex);
+			}
 
-	return locks;
+		has_data.notify_one();
+		}
 	}
 
 template<typename T>
-inline uint64_t Queue<T>::Size()
+inline bool Queue<T>::Ready()
 	{
-	// Need to lock all queues.
-	auto locks = LocksForAllQueues();
+	Block* b = read_block;
 
-	uint64_t size = 0;
+	if ( b->taken == BLOCK_SIZE )
+		{
+		Block* next = b->next.load(std::memory_order_acquire);
+		return next && next->filled.load(std::memory_order_acquire) > 0;
+		}
 
-	for ( int i = 0; i < NUM_QUEUES; i++ )
-		size += messages[i].size();
+	return b->taken < b->filled.load(std::memory_order_acquire);
+	}
 
-	return size;
+template<typename T>
+inline uint64_t Queue<T>::Size()
+	{
+	// Reading this one first means we can't see more reads than writes.
+	uint64_t reads = num_reads.load(std::memory_order_acquire);
+	uint64_t writes = num_writes.load(std::memory_order_acquire);
+	return writes - reads;
 	}
 
 template<typename T>
 inline void Queue<T>::GetStats(Stats* stats)
 	{
-	// To be safe, we look all queues. That's probably unneccessary, but
-	// doesn't really hurt.
-	auto locks = LocksForAllQueues();
-
-	stats->num_reads = num_reads;
-	stats->num_writes = num_writes;
+	stats->num_reads = num_reads.load(std::memory_order_acquire);
+	stats->num_writes = num_writes.load(std::memory_order_acquire);
 	}
 
 template<typename T>
 inline void Queue<T>::WakeUp()
 	{
-	for ( int i = 0; i < NUM_QUEUES; i++ )
-		has_data[i].notify_all();
+		{
+		auto lock = acquire_lock(mutex);
+		}
+
+	has_data.notify_all();
 	}
 
 }
@@ -0,0 +1,102 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#include <stdlib.h>
+
+#include "ValueArena.h"
+#include "util.h"
+
+using namespace threading;
+
+ValueArena::ValueArena(size_t arg_block_size)
+	{
+	blocks = 0;
+	free_blocks = 0;
+	next = 0;
+	avail = 0;
+	block_size = arg_block_size;
+	capacity = 0;
+	}
+
+ValueArena::~ValueArena()
+	{
+	Reset();
+
+	while ( free_blocks )
+		{
+		Block* b = free_blocks;
+		free_blocks = b->next;
+		free(b);
+		}
+	}
+
+void* ValueArena::AllocateSlow(size_t size)
+	{
+	size_t bsize = block_size;
+
+	if ( size > bsize - HEADER_SIZE )
+		// Oversized request, give it a block of its own.
+		bsize = size + HEADER_SIZE;
+
+	Block* b;
+
+	if ( bsize == block_size && free_blocks )
+		{
+		b = free_blocks;
+		free_blocks = b->next;
+		}
+	else
+		{
+		b = (Block*) safe_malloc(bsize);
+		b->size = bsize;
+		capacity += bsize;
+		}
+
+	char* data = reinterpret_cast<char*>(b) + HEADER_SIZE;
+
+	if ( bsize != block_size && blocks )
+		{
+		// Keep carving from the current block, there may well
+		// be space left in it.
+		b->next = blocks->next;
+		blocks->next = b;
+		return data;
+		}
+
+	b->next = blocks;
+	blocks = b;
+
+	next = data + size;
+	avail = bsize - HEADER_SIZE - size;
+	return data;
+	}
+
+char* ValueArena::CopyString(const char* data, int len)
+	{
+	char* s = static_cast<char*>(Allocate(len + 1));
+	memcpy(s, data, len);
+	s[len] = '\0';
+	return s;
+	}
+
+void ValueArena::Reset()
+	{
+	while ( blocks )
+		{
+		Block* b = blocks;
+		blocks = b->next;
+
+		if ( b->size == block_size )
+			{
+			b->next = free_blocks;
+			free_blocks = b;
+			}
+		else
+			{
+			capacity -= b->size;
+			free(b);
+			}
+		}
+
+	next = 0;
+	avail = 0;
+	}
@@ -0,0 +1,130 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+
+#ifndef THREADING_VALUEARENA_H
+#define THREADING_VALUEARENA_H
+
+#include <cstddef>
+#include <new>
+#include <string.h>
+
+#include "SerialTypes.h"
+
+namespace threading {
+
+/**
+ * A bump allocator for Value instances and everything they point to.
+ *
+ * The arena hands out memory from a list of large blocks and only ever
+ * releases all of it at once. Values created here must therefore not be
+ * deleted individually: their destructors never run, and any strings or
+ * nested value arrays they reference need to come from the same arena.
+ *
+ * An arena isn't thread-safe, but it can be handed over to another thread
+ * along with the values it holds, as the logging framework does when
+ * passing a batch of writes to a writer thread.
+ */
+class ValueArena {
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param block_size The size of the blocks the arena carves its
+	 * memory from. Larger requests get a block of their own.
+	 */
+	explicit ValueArena(size_t block_size = DEFAULT_BLOCK_SIZE);
+
+	/**
+	 * Destructor. Releases all memory without running any destructors.
+	 */
+	~ValueArena();
+
+	/**
+	 * Returns \a size bytes of uninitialized memory, aligned suitably
+	 * for any of the types a Value may point to.
+	 */
+	void* Allocate(size_t size)
+		{
+		size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+		if ( size > avail )
+			return AllocateSlow(size);
+
+		void* p = next;
+		next += size;
+		avail -= size;
+		return p;
+		}
+
+	/**
+	 * Creates a new value. The arguments are those of the Value
+	 * constructors.
+	 */
+	Value* NewValue(TypeTag type, bool present = true)
+		{ return new (Allocate(sizeof(Value))) Value(type, present); }
+
+	/**
+	 * Creates a new value of a container type. The arguments are those
+	 * of the Value constructors.
+	 */
+	Value* NewValue(TypeTag type, TypeTag subtype, bool present = true)
+		{ return new (Allocate(sizeof(Value))) Value(type, subtype, present); }
+
+	/**
+	 * Returns an array of \a n value pointers, e.g. for a log record or
+	 * the elements of a set. The entries are left uninitialized.
+	 */
+	Value** NewValueArray(int n)
+		{ return static_cast<Value**>(Allocate(n * sizeof(Value*))); }
+
+	/**
+	 * Copies \a len bytes into the arena. The copy gets a terminating
+	 * null byte, which isn't included in \a len.
+	 */
+	char* CopyString(const char* data, int len);
+
+	/**
+	 * Convenience version of CopyString() for a null-terminated string.
+	 */
+	char* CopyString(const char* s)
+		{ return CopyString(s, strlen(s)); }
+
+	/**
+	 * Discards everything allocated so far. The arena holds on to its
+	 * regular-sized blocks, so refilling it to a similar size doesn't
+	 * need to go back to the heap.
+	 */
+	void Reset();
+
+	/**
+	 * Returns the total number of bytes the arena has obtained from the
+	 * heap, including blocks kept for reuse.
+	 */
+	size_t Capacity() const	{ return capacity; }
+
+	static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+private:
+	struct Block {
+		Block* next;
+		size_t size;
+	};
+
+	static const size_t ALIGNMENT = alignof(std::max_align_t);
+	static const size_t HEADER_SIZE = (sizeof(Block) + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+	void* AllocateSlow(size_t size);
+
+	ValueArena(const ValueArena& other);	// Disabled.
+	ValueArena& operator=(const ValueArena& other);	// Disabled.
+
+	Block* blocks;	// Blocks in use, current one first.
+	Block* free_blocks;	// Blocks kept by Reset().
+	char* next;	// Next free byte in the current block.
+	size_t avail;	// Bytes left in the current block.
+	size_t block_size;
+	size_t capacity;
+};
+
+}
+
+#endif
@@ -0,0 +1,61 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Small helpers shared by the micro-benchmarks in this directory.
+
+#ifndef benchmark_h
+#define benchmark_h
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+namespace bench {
+
+// Monotonic wall-clock time in seconds.
+inline double now()
+	{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+	}
+
+// Reports the cost of "n" operations that took "secs" in total.
+inline void report(const char* impl, const char* what, long n, double secs)
+	{
+	printf("%-10s %-28s %10ld ops %9.3f s %9.1f ns/op\n",
+	       impl, what, n, secs, n ? secs * 1e9 / n : 0.0);
+	}
+
+// Returns the value of a numeric command-line option "-x N", or the
+// default.
+inline long arg(int argc, char** argv, const char* opt, long def)
+	{
+	for ( int i = 1; i + 1 < argc; ++i )
+		if ( ! strcmp(argv[i], opt) )
+			return atol(argv[i + 1]);
+
+	return def;
+	}
+
+// A fast, deterministic PRNG so runs are comparable.
+class Random {
+public:
+	explicit Random(uint64_t seed = 42) : state(seed ? seed : 1)	{ }
+
+	uint64_t Next()
+		{
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state;
+		}
+
+private:
+	uint64_t state;
+};
+
+}
+
+#endif
@@ -0,0 +1,257 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Stand-ins for the parts of libzeek that the script interpreter refers
+// to beyond its values, types, expressions and statements, so that
+// bytecode-equiv can be linked on its own.  Runtime errors are recorded
+// instead of logged, and then thrown like the real Reporter does.
+
+#include "zeek-config.h"
+
+#include <stdarg.h>
+
+#include <string>
+
+#include "Debug.h"
+#include "Desc.h"
+#include "Event.h"
+#include "EventRegistry.h"
+#include "Expr.h"
+#include "File.h"
+#include "Func.h"
+#include "Net.h"
+#include "NetVar.h"
+#include "Reporter.h"
+#include "Timer.h"
+#include "plugin/Manager.h"
+#include "threading/SerialTypes.h"
+#include "broker/Data.h"
+#include "zeekygen/IdentifierInfo.h"
+#include "zeekygen/Manager.h"
+#include "zeekygen/utils.h"
+
+std::string last_runtime_error;
+bool construction_error = false;
+
+Reporter* reporter = 0;
+ValManager* val_mgr = 0;
+EventRegistry* event_registry = 0;
+TimerMgr* timer_mgr = 0;
+plugin::Manager* plugin_mgr = 0;
+zeekygen::Manager* zeekygen_mgr = 0;
+
+PDict<Filemap> g_dbgfilemaps;
+vector<Func*> Func::unique_ids;
+
+double network_time = 0.0;
+double bro_start_network_time = 0.0;
+bool is_parsing = false;
+bool in_debug = false;
+
+double table_expire_interval = 0.0;
+double table_expire_delay = 0.0;
+int table_incremental_step = 0;
+
+bro_uint_t max_dfa_state_mem = 0;
+
+Reporter::Reporter()
+	{
+	errors = 0;
+	via_events = false;
+	in_error_handler = 0;
+	}
+
+Reporter::~Reporter()
+	{
+	}
+
+static std::string format(const char* fmt, va_list ap)
+	{
+	char buf[1024];
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	return buf;
+	}
+
+void Reporter::ExprRuntimeError(const Expr* expr, const char* fmt, ...)
+	{
+	ODesc d;
+	expr->Describe(&d);
+
+	va_list ap;
+	va_start(ap, fmt);
+	last_runtime_error = format(fmt, ap) + " (" + d.Description() + ")";
+	va_end(ap);
+
+	throw InterpreterException();
+	}
+
+void Reporter::RuntimeError(const Location* location, const char* fmt, ...)
+	{
+	va_list ap;
+	va_start(ap, fmt);
+	last_runtime_error = format(fmt, ap);
+	va_end(ap);
+
+	throw InterpreterException();
+	}
+
+// The generator only builds well-typed bodies, so this flags a bug in
+// it.
+void Reporter::Error(const char* fmt, ...)
+	{
+	va_list ap;
+	va_start(ap, fmt);
+	fprintf(stderr, "error: %s\n", format(fmt, ap).c_str());
+	va_end(ap);
+
+	construction_error = true;
+	}
+
+// Expression statements warn about their value being ignored.
+void Reporter::Warning(const char* fmt, ...)
+	{
+	}
+
+void Reporter::InternalWarning(const char* fmt, ...)
+	{
+	va_list ap;
+	va_start(ap, fmt);
+	fprintf(stderr, "internal warning: %s\n", format(fmt, ap).c_str());
+	va_end(ap);
+	}
+
+void Reporter::FatalError(const char* fmt, ...)
+	{
+	va_list ap;
+	va_start(ap, fmt);
+	fprintf(stderr, "fatal error: %s\n", format(fmt, ap).c_str());
+	va_end(ap);
+	abort();
+	}
+
+void Reporter::InternalError(const char* fmt, ...)
+	{
+	va_list ap;
+	va_start(ap, fmt);
+	fprintf(stderr, "internal error: %s\n", format(fmt, ap).c_str());
+	va_end(ap);
+	abort();
+	}
+
+std::string render_call_stack()
+	{
+	return "";
+	}
+
+bool pre_execute_stmt(Stmt* stmt, Frame* f)
+	{
+	return true;
+	}
+
+bool post_execute_stmt(Stmt* stmt, Frame* f, Val* result, stmt_flow_type* flow)
+	{
+	return true;
+	}
+
+bool StmtLocMapping::StartsAfter(const StmtLocMapping* m2)
+	{
+	return false;
+	}
+
+void plugin::Manager::HookBroObjDtor(void* obj) const
+	{
+	}
+
+bool BroFunc::StrengthenClosureReference(Frame* f)
+	{
+	return false;
+	}
+
+EventHandler::EventHandler(const char* arg_name)
+	{
+	abort();
+	}
+
+void EventHandler::SetLocalHandler(Func* f)
+	{
+	}
+
+EventHandler* EventRegistry::Lookup(const char* name)
+	{
+	return 0;
+	}
+
+void EventRegistry::Register(EventHandlerPtr handler)
+	{
+	}
+
+const char* BroFile::Name() const
+	{
+	return 0;
+	}
+
+double BroFile::Size()
+	{
+	return 0;
+	}
+
+int BroFile::Write(const char* data, int len)
+	{
+	return 0;
+	}
+
+// Patterns are only ever constants here, which the parser would have
+// compiled; the generated bodies don't use any.
+void RE_set_input(const char* str)
+	{
+	}
+
+int RE_parse()
+	{
+	return 1;
+	}
+
+void RE_done_with_scan()
+	{
+	}
+
+BroType* bro_broker::DataVal::script_data_type = 0;
+
+Val* bro_broker::DataVal::castTo(BroType* t)
+	{
+	abort();
+	}
+
+bool bro_broker::DataVal::canCastTo(BroType* t) const
+	{
+	return false;
+	}
+
+bool threading::Value::IsCompatibleType(BroType* t, bool atomic_only)
+	{
+	return false;
+	}
+
+std::string zeekygen::IdentifierInfo::GetDeclaringScriptForField(const std::string& field) const
+	{
+	return "";
+	}
+
+std::vector<std::string> zeekygen::IdentifierInfo::GetFieldComments(const std::string& field) const
+	{
+	return {};
+	}
+
+std::vector<std::string> zeekygen::IdentifierInfo::GetComments() const
+	{
+	return {};
+	}
+
+bool zeekygen::prettify_params(std::string& s)
+	{
+	return false;
+	}
+
+std::string zeekygen::redef_indication(const std::string& from_script)
+	{
+	return "";
+	}
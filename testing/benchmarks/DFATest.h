@@ -0,0 +1,180 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Helpers for exercising the DFA matcher on hand-built NFAs, without
+// going through the regular-expression parser.
+
+#ifndef dfatest_h
+#define dfatest_h
+
+#include <vector>
+
+#include "RE.h"
+#include "DFA.h"
+#include "NFA.h"
+#include "CCL.h"
+#include "EquivClass.h"
+
+// Builds a matcher from NFAs put together with the helpers below, the
+// same way Specific_RE_Matcher::CompileSet() does for parsed patterns.
+class TestMatcher : public Specific_RE_Matcher {
+public:
+	TestMatcher() : Specific_RE_Matcher(MATCH_EXACTLY, 1)	{ rem = this; }
+
+	NFA_Machine* Char(int c)
+		{
+		return new NFA_Machine(new NFA_State(c, EC()));
+		}
+
+	// .*
+	NFA_Machine* AnyStar()
+		{
+		CCL* ccl = NewCCL();
+		ccl->Negate();
+		EC()->CCL_Use(ccl);
+
+		NFA_Machine* m = new NFA_Machine(new NFA_State(ccl));
+		m->MakeClosure();
+		return m;
+		}
+
+	// [chars], or [chars]+ if plus is set.
+	NFA_Machine* Set(const char* chars, bool plus)
+		{
+		CCL* ccl = NewCCL();
+
+		for ( const char* p = chars; *p; ++p )
+			ccl->Add(*p);
+
+		EC()->CCL_Use(ccl);
+
+		NFA_Machine* m = new NFA_Machine(new NFA_State(ccl));
+
+		if ( plus )
+			m->MakePositiveClosure();
+
+		return m;
+		}
+
+	// Appends the literal s to m, which may be null.
+	NFA_Machine* Lit(NFA_Machine* m, const char* s)
+		{
+		for ( ; *s; ++s )
+			{
+			NFA_Machine* c = Char((u_char) *s);
+
+			if ( m )
+				m->AppendMachine(c);
+			else
+				m = c;
+			}
+
+		return m;
+		}
+
+	// Pattern i accepts with index i + 1.
+	void Build(const std::vector<NFA_Machine*>& pats)
+		{
+		NFA_Machine* set = 0;
+
+		for ( size_t i = 0; i < pats.size(); ++i )
+			{
+			pats[i]->FinalState()->SetAccept(i + 1);
+			set = set ? make_alternate(pats[i], set) : pats[i];
+			}
+
+		NFA_Machine* m = new NFA_Machine(new NFA_State(SYM_BOL, EC()));
+		m->MakeOptional();
+		m->AppendMachine(set);
+
+		EC()->BuildECs();
+		ConvertCCLs();
+
+		dfa = new DFA_Machine(m, EC());
+		Unref(m);
+
+		ecs = EC()->EquivClasses();
+		}
+
+private:
+	// CCLs register with whatever matcher rem points to.
+	CCL* NewCCL()
+		{
+		rem = this;
+		return new CCL();
+		}
+};
+
+// The plain stepping loop of RE_Match_State::Match(), without any of
+// the shortcuts, to compare against.
+class RefMatchState {
+public:
+	RefMatchState(DFA_Machine* arg_dfa, int* arg_ecs)
+		: dfa(arg_dfa), ecs(arg_ecs), current(0), pos(-1)	{ }
+
+	const AcceptingMatchSet& AcceptedMatches() const	{ return accepted; }
+
+	void Clear()
+		{
+		current = pos == -1 ? 0 : dfa->StartState();
+		}
+
+	bool Match(const u_char* bv, int n, bool bol, bool eol)
+		{
+		if ( pos == -1 )
+			{
+			current = dfa->StartState();
+			Accept(current->Accept());
+			}
+
+		if ( ! current )
+			return false;
+
+		pos = 0;
+		size_t old_size = accepted.size();
+
+		int m = bol ? n + 1 : n;
+		int e = eol ? -1 : 0;
+
+		while ( --m >= e )
+			{
+			int ec;
+
+			if ( m == n )
+				ec = ecs[SYM_BOL];
+			else if ( m == -1 )
+				ec = ecs[SYM_EOL];
+			else
+				ec = ecs[*(bv++)];
+
+			DFA_State* next = current->Xtion(ec, dfa);
+
+			if ( ! next )
+				{
+				current = 0;
+				break;
+				}
+
+			Accept(next->Accept());
+			++pos;
+			current = next;
+			}
+
+		return accepted.size() != old_size;
+		}
+
+private:
+	void Accept(const AcceptingSet* as)
+		{
+		if ( as )
+			for ( auto a : *as )
+				accepted.insert({a, (MatchPos) pos});
+		}
+
+	DFA_Machine* dfa;
+	int* ecs;
+	DFA_State* current;
+	int pos;
+	AcceptingMatchSet accepted;
+};
+
+#endif
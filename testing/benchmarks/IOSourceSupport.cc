@@ -0,0 +1,146 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Stand-ins for the parts of libzeek that iosource/Manager.cc refers to,
+// so that iosource-bench can be linked on its own.  Opening packet
+// sources and dumpers through plugins isn't supported.
+
+#include "zeek-config.h"
+
+#include <stdarg.h>
+
+#include "Reporter.h"
+#include "iosource/Component.h"
+#include "iosource/PktDumper.h"
+#include "iosource/PktSrc.h"
+#include "plugin/Manager.h"
+
+Reporter* reporter = 0;
+plugin::Manager* plugin_mgr = 0;
+
+static void report(const char* prefix, const char* fmt, va_list ap)
+	{
+	fprintf(stderr, "%s: ", prefix);
+	vfprintf(stderr, fmt, ap);
+	fprintf(stderr, "\n");
+	}
+
+void Reporter::Error(const char* fmt, ...)
+	{
+	va_list ap;
+	va_start(ap, fmt);
+	report("error", fmt, ap);
+	va_end(ap);
+	}
+
+void Reporter::FatalError(const char* fmt, ...)
+	{
+	va_list ap;
+	va_start(ap, fmt);
+	report("fatal error", fmt, ap);
+	va_end(ap);
+	exit(1);
+	}
+
+void Reporter::InternalWarning(const char* fmt, ...)
+	{
+	va_list ap;
+	va_start(ap, fmt);
+	report("internal warning", fmt, ap);
+	va_end(ap);
+	}
+
+plugin::Manager::plugin_list* plugin::Manager::ActivePluginsInternal()
+	{
+	static plugin_list plugins;
+	return &plugins;
+	}
+
+plugin::Plugin::component_list plugin::Plugin::Components() const
+	{
+	return component_list();
+	}
+
+plugin::Component::~Component()
+	{
+	}
+
+iosource::Component::~Component()
+	{
+	}
+
+iosource::PktSrcComponent::~PktSrcComponent()
+	{
+	}
+
+bool iosource::PktSrcComponent::HandlesPrefix(const std::string& prefix) const
+	{
+	return false;
+	}
+
+bool iosource::PktSrcComponent::DoesLive() const
+	{
+	return false;
+	}
+
+bool iosource::PktSrcComponent::DoesTrace() const
+	{
+	return false;
+	}
+
+iosource::PktSrcComponent::factory_callback iosource::PktSrcComponent::Factory() const
+	{
+	return 0;
+	}
+
+void iosource::PktSrcComponent::DoDescribe(ODesc* d) const
+	{
+	}
+
+iosource::PktDumperComponent::~PktDumperComponent()
+	{
+	}
+
+bool iosource::PktDumperComponent::HandlesPrefix(const std::string& prefix) const
+	{
+	return false;
+	}
+
+iosource::PktDumperComponent::factory_callback iosource::PktDumperComponent::Factory() const
+	{
+	return 0;
+	}
+
+void iosource::PktDumperComponent::DoDescribe(ODesc* d) const
+	{
+	}
+
+bool iosource::PktSrc::IsError() const
+	{
+	return true;
+	}
+
+void iosource::PktSrc::Error(const std::string& msg)
+	{
+	}
+
+void iosource::PktDumper::Init()
+	{
+	}
+
+void iosource::PktDumper::Done()
+	{
+	}
+
+bool iosource::PktDumper::IsOpen() const
+	{
+	return false;
+	}
+
+bool iosource::PktDumper::IsError() const
+	{
+	return true;
+	}
+
+void iosource::PktDumper::Error(const std::string& msg)
+	{
+	}
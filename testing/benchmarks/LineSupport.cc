@@ -0,0 +1,157 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Stand-ins for the parts of libzeek that ContentLine.cc refers to, so that
+// line-bench can run the real ContentLine_Analyzer without a Connection.
+// Lines the analyzer forwards go to line_sink().
+
+#include "zeek-config.h"
+
+#include "analyzer/Analyzer.h"
+#include "analyzer/protocol/tcp/TCP.h"
+#include "Reporter.h"
+
+using namespace analyzer;
+
+Reporter* reporter = 0;
+
+void (*line_sink)(int len, const u_char* data) = 0;
+
+analyzer::ID Analyzer::id_counter = 0;
+
+::Tag::Tag()
+	{
+	type = 0;
+	subtype = 0;
+	val = 0;
+	}
+
+::Tag::~Tag()
+	{
+	}
+
+Analyzer::Analyzer(const char* name, Connection* arg_conn)
+	{
+	conn = arg_conn;
+	parent = 0;
+	signature = 0;
+	output_handler = 0;
+	orig_supporters = resp_supporters = 0;
+	protocol_confirmed = false;
+	timers_canceled = true;
+	skip = finished = removing = false;
+	id = ++id_counter;
+	}
+
+Analyzer::Analyzer(const Analyzer& a)
+	{
+	abort();
+	}
+
+Analyzer::~Analyzer()
+	{
+	}
+
+void Analyzer::Init()
+	{
+	}
+
+void Analyzer::Done()
+	{
+	}
+
+void Analyzer::ForwardPacket(int len, const u_char* data, bool is_orig,
+			uint64 seq, const IP_Hdr* ip, int caplen)
+	{
+	}
+
+void Analyzer::ForwardStream(int len, const u_char* data, bool is_orig)
+	{
+	}
+
+void Analyzer::ForwardUndelivered(uint64 seq, int len, bool is_orig)
+	{
+	}
+
+void Analyzer::ForwardEndOfData(bool orig)
+	{
+	}
+
+void Analyzer::DeliverPacket(int len, const u_char* data, bool is_orig,
+			uint64 seq, const IP_Hdr* ip, int caplen)
+	{
+	}
+
+void Analyzer::DeliverStream(int len, const u_char* data, bool is_orig)
+	{
+	}
+
+void Analyzer::Undelivered(uint64 seq, int len, bool is_orig)
+	{
+	}
+
+void Analyzer::EndOfData(bool is_orig)
+	{
+	}
+
+void Analyzer::FlipRoles()
+	{
+	}
+
+Analyzer* Analyzer::FindChild(ID arg_id)
+	{
+	return 0;
+	}
+
+Analyzer* Analyzer::FindChild(Tag arg_tag)
+	{
+	return 0;
+	}
+
+void Analyzer::ProtocolConfirmation(Tag arg_tag)
+	{
+	}
+
+void Analyzer::ProtocolViolation(const char* reason, const char* data, int len)
+	{
+	}
+
+void Analyzer::UpdateConnVal(RecordVal *conn_val)
+	{
+	}
+
+unsigned int Analyzer::MemoryAllocation() const
+	{
+	return 0;
+	}
+
+void Analyzer::Weird(const char* name, const char* addl)
+	{
+	}
+
+void SupportAnalyzer::ForwardPacket(int len, const u_char* data, bool is_orig,
+			uint64 seq, const IP_Hdr* ip, int caplen)
+	{
+	}
+
+void SupportAnalyzer::ForwardStream(int len, const u_char* data, bool is_orig)
+	{
+	line_sink(len, data);
+	}
+
+void SupportAnalyzer::ForwardUndelivered(uint64 seq, int len, bool is_orig)
+	{
+	}
+
+void Reporter::AnalyzerError(analyzer::Analyzer* a, const char* fmt, ...)
+	{
+	abort();
+	}
+
+void Connection::Weird(const char* name, const char* addl)
+	{
+	}
+
+analyzer::Analyzer* Connection::FindAnalyzer(const char* name)
+	{
+	return 0;
+	}
@@ -0,0 +1,22 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Stand-ins for the parts of libzeek that threading/Queue.h refers to, so
+// that queue-bench can be linked on its own.
+
+#include "zeek-config.h"
+
+#include <stdarg.h>
+
+#include "Reporter.h"
+
+Reporter* reporter = 0;
+
+void Reporter::FatalErrorWithCore(const char* fmt, ...)
+	{
+	va_list ap;
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fprintf(stderr, "\n");
+	abort();
+	}
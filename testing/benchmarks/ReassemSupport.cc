@@ -0,0 +1,42 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Stand-ins for the parts of libzeek that Reassem.cc refers to, so that
+// reassem-bench can be linked on its own.
+
+#include "zeek-config.h"
+
+#include "Obj.h"
+#include "Desc.h"
+
+Location start_location("<start>", 0, 0, 0, 0);
+Location end_location("<end>", 0, 0, 0, 0);
+
+double network_time = 0.0;
+
+extern "C" void out_of_memory(const char* where)
+	{
+	fprintf(stderr, "out of memory in %s\n", where);
+	abort();
+	}
+
+void bad_ref(int type)
+	{
+	abort();
+	}
+
+BroObj::~BroObj()
+	{
+	}
+
+bool BroObj::SetLocationInfo(const Location* start, const Location* end)
+	{
+	return true;
+	}
+
+void BroObj::UpdateLocationEndInfo(const Location& end)
+	{
+	}
+
+void ODesc::Add(const char* s, int do_indent)
+	{
+	}
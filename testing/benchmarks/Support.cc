@@ -0,0 +1,23 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Minimal definitions of the pieces of libzeek that the benchmarked
+// sources refer to, so that each benchmark can be linked on its own.
+
+#include "zeek-config.h"
+
+#include "Hash.h"
+
+extern "C" void out_of_memory(const char* where)
+	{
+	fprintf(stderr, "out of memory in %s\n", where);
+	abort();
+	}
+
+HashKey::HashKey(const void* arg_key, int arg_size, hash_t arg_hash)
+	{
+	size = arg_size;
+	hash = arg_hash;
+	key = new char[size];
+	memcpy(key, arg_key, size);
+	is_our_dynamic = 1;
+	}
@@ -0,0 +1,49 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Stand-ins for the parts of libzeek that Timer.cc refers to, so that
+// timer-bench can be linked on its own.
+
+#include "zeek-config.h"
+
+#include <stdarg.h>
+
+#include "Timer.h"
+#include "Desc.h"
+#include "Reporter.h"
+#include "broker/Manager.h"
+
+TimerMgr* timer_mgr = 0;
+double network_time = 0.0;
+
+Reporter* reporter = 0;
+bro_broker::Manager* broker_mgr = 0;
+
+void Reporter::InternalError(const char* fmt, ...)
+	{
+	va_list ap;
+	va_start(ap, fmt);
+	vfprintf(stderr, fmt, ap);
+	va_end(ap);
+	fprintf(stderr, "\n");
+	abort();
+	}
+
+void bro_broker::Manager::AdvanceTime(double seconds_since_unix_epoch)
+	{
+	}
+
+// Broker's headers define a few constant topics that need this to
+// initialize.
+broker::topic broker::operator/(const broker::topic& lhs,
+                                const broker::topic& rhs)
+	{
+	return lhs;
+	}
+
+void ODesc::Add(const char* s, int do_indent)
+	{
+	}
+
+void ODesc::Add(double d, bool no_exp)
+	{
+	}
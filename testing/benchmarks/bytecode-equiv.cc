@@ -0,0 +1,814 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Checks that function bodies compiled to bytecode execute like their
+// AST.  Each round generates a random, well-typed body over locals and
+// globals of the types the bytecode handles natively (count, int,
+// double, bool, string, addr, time, interval and a record), mixed with
+// constructs that stay in the AST: |x|, ?:, ++/--, field assignments,
+// "local" declarations and switch statements.  The body runs once via
+// Stmt::Exec() and once via BytecodeBody::Exec(), on identical frames,
+// and the two runs have to agree on:
+//
+//   - the flow and the value the body leaves with;
+//   - the runtime error raised, including the expression it names;
+//   - the values of all locals, the record's fields and all globals;
+//   - how often each statement was executed.
+//
+// Bodies are built with the AST constructors, as the parser would, so
+// the script parser isn't needed.
+//
+//     bytecode-equiv [-r rounds] [-s seed]
+
+#include "zeek-config.h"
+
+#include <string>
+#include <vector>
+
+#include "Bytecode.h"
+#include "Expr.h"
+#include "Stmt.h"
+#include "Frame.h"
+#include "Scope.h"
+#include "Reporter.h"
+
+#include "Benchmark.h"
+
+// Set by the Reporter stand-ins, see BytecodeSupport.cc.
+extern std::string last_runtime_error;
+extern bool construction_error;
+
+enum Kind {
+	K_COUNT, K_INT, K_DOUBLE, K_BOOL, K_STRING, K_ADDR, K_TIME,
+	K_INTERVAL, NUM_KINDS
+};
+
+static const TypeTag kind_tag[NUM_KINDS] = {
+	TYPE_COUNT, TYPE_INT, TYPE_DOUBLE, TYPE_BOOL, TYPE_STRING, TYPE_ADDR,
+	TYPE_TIME, TYPE_INTERVAL,
+};
+
+static const int LOCALS_PER_KIND = 2;
+static const int MAX_LOOP_DEPTH = 3;
+static const int LOOP_LIMIT = 6;
+
+// Frame layout: the locals of each kind, then the loop counters, then
+// the record.
+static const int COUNTER_OFFSET = NUM_KINDS * LOCALS_PER_KIND;
+static const int RECORD_OFFSET = COUNTER_OFFSET + MAX_LOOP_DEPTH;
+static const int FRAME_SIZE = RECORD_OFFSET + 1;
+
+static ID* locals[NUM_KINDS][LOCALS_PER_KIND];
+static ID* counters[MAX_LOOP_DEPTH];
+static ID* rec;
+static ID* globals[NUM_KINDS];	// Some kinds only.
+static RecordType* rec_type;
+
+static const Kind global_kinds[] = { K_COUNT, K_DOUBLE, K_STRING, K_BOOL };
+
+// NameExprs and InitStmts hold a reference to their ID, and field
+// expressions own their field name, as the parser hands them over.
+static Expr* name_expr(ID* id)
+	{
+	::Ref(id);
+	return new NameExpr(id);
+	}
+
+static ID* make_id(const char* name, bool global, BroType* t, int offset)
+	{
+	ID* id = new ID(name, global ? SCOPE_GLOBAL : SCOPE_FUNCTION, false);
+	id->SetType(t);
+
+	if ( ! global )
+		id->SetOffset(offset);
+
+	return id;
+	}
+
+// type R: record {
+//	a: count;
+//	b: string &optional;
+//	c: addr &default=127.0.0.1;
+//	d: double &optional;
+// };
+static void make_record_type()
+	{
+	type_decl_list* fields = new type_decl_list();
+	fields->append(new TypeDecl(base_type(TYPE_COUNT), "a"));
+
+	attr_list* opt = new attr_list();
+	opt->append(new Attr(ATTR_OPTIONAL));
+	fields->append(new TypeDecl(base_type(TYPE_STRING), "b", opt, true));
+
+	attr_list* def = new attr_list();
+	def->append(new Attr(ATTR_DEFAULT,
+			     new ConstExpr(new AddrVal("127.0.0.1"))));
+	fields->append(new TypeDecl(base_type(TYPE_ADDR), "c", def, true));
+
+	attr_list* opt2 = new attr_list();
+	opt2->append(new Attr(ATTR_OPTIONAL));
+	fields->append(new TypeDecl(base_type(TYPE_DOUBLE), "d", opt2, true));
+
+	rec_type = new RecordType(fields);
+	}
+
+static void make_ids()
+	{
+	static const char* kind_names[NUM_KINDS] = {
+		"c", "i", "d", "b", "s", "a", "t", "iv",
+	};
+
+	char buf[32];
+
+	for ( int k = 0; k < NUM_KINDS; ++k )
+		for ( int j = 0; j < LOCALS_PER_KIND; ++j )
+			{
+			snprintf(buf, sizeof(buf), "%s%d", kind_names[k], j);
+			locals[k][j] = make_id(buf, false,
+					base_type(kind_tag[k]),
+					k * LOCALS_PER_KIND + j);
+			}
+
+	for ( int j = 0; j < MAX_LOOP_DEPTH; ++j )
+		{
+		snprintf(buf, sizeof(buf), "k%d", j);
+		counters[j] = make_id(buf, false, base_type(TYPE_COUNT),
+				      COUNTER_OFFSET + j);
+		}
+
+	rec = make_id("r", false, rec_type->Ref(), RECORD_OFFSET);
+
+	for ( auto k : global_kinds )
+		{
+		snprintf(buf, sizeof(buf), "g%s", kind_names[k]);
+		globals[k] = make_id(buf, true, base_type(kind_tag[k]), 0);
+		}
+	}
+
+// Generates random bodies.  Values come from a separate generator, so
+// that both runs of a round can recreate the same initial state.
+class BodyGen {
+public:
+	explicit BodyGen(uint64_t seed) : rnd(seed)	{ }
+
+	Stmt* Body();
+
+	// All statements generated, for the access counts.
+	const std::vector<Stmt*>& Stmts() const	{ return stmts; }
+
+private:
+	int Rand(int n)		{ return rnd.Next() % n; }
+	bool OneIn(int n)	{ return Rand(n) == 0; }
+
+	Expr* Gen(Kind k, int depth);
+	Expr* Leaf(Kind k);
+	Expr* Composite(Kind k, int depth);
+	Expr* Numeric(int depth);
+	Expr* Local(Kind k)	{ return name_expr(locals[k][Rand(LOCALS_PER_KIND)]); }
+	Expr* Field(const char* f)	{ return new FieldExpr(name_expr(rec), copy_string(f)); }
+	Expr* Check(Expr* e);
+
+	Stmt* Statement(int depth, int loop_depth);
+	Stmt* List(int depth, int loop_depth, int max_len);
+	Stmt* Loop(int depth, int loop_depth);
+	Stmt* Switch(int depth, int loop_depth);
+	Stmt* Assign(Expr* lhs, Expr* rhs);
+	Stmt* Track(Stmt* s)	{ stmts.push_back(s); return s; }
+
+	bench::Random rnd;
+	std::vector<Stmt*> stmts;
+};
+
+Expr* BodyGen::Check(Expr* e)
+	{
+	if ( construction_error || e->IsError() )
+		{
+		ODesc d;
+		e->Describe(&d);
+		fprintf(stderr, "generated an ill-typed expression: %s\n",
+			d.Description());
+		abort();
+		}
+
+	return e;
+	}
+
+Expr* BodyGen::Gen(Kind k, int depth)
+	{
+	if ( depth <= 0 || OneIn(4) )
+		return Check(Leaf(k));
+
+	return Check(Composite(k, depth - 1));
+	}
+
+Expr* BodyGen::Leaf(Kind k)
+	{
+	int r = Rand(8);
+
+	switch ( k ) {
+	case K_COUNT:
+		if ( r == 0 )
+			return Field("a");
+		if ( r == 1 )
+			return name_expr(globals[K_COUNT]);
+		if ( r == 2 )
+			return new SizeExpr(Leaf(K_STRING));
+		if ( r < 5 )
+			return new ConstExpr(val_mgr->GetCount(
+				OneIn(10) ? (bro_uint_t(1) << 40) + Rand(5) : Rand(8)));
+		break;
+
+	case K_INT:
+		if ( r < 3 )
+			return new ConstExpr(val_mgr->GetInt(Rand(15) - 7));
+		break;
+
+	case K_DOUBLE:
+		if ( r == 0 )
+			return Field("d");
+		if ( r == 1 )
+			return name_expr(globals[K_DOUBLE]);
+		if ( r < 4 )
+			{
+			static const double ds[] = { 0.0, 0.5, -1.25, 3.0, 1e10 };
+			return new ConstExpr(new Val(ds[Rand(5)], TYPE_DOUBLE));
+			}
+		break;
+
+	case K_BOOL:
+		if ( r == 0 )
+			return new HasFieldExpr(name_expr(rec),
+						copy_string(OneIn(2) ? "b" : "d"));
+		if ( r == 1 )
+			return name_expr(globals[K_BOOL]);
+		if ( r < 4 )
+			return new ConstExpr(val_mgr->GetBool(Rand(2)));
+		break;
+
+	case K_STRING:
+		if ( r == 0 )
+			return Field("b");
+		if ( r == 1 )
+			return name_expr(globals[K_STRING]);
+		if ( r < 4 )
+			{
+			static const char* ss[] = { "", "a", "zeek", "a-global" };
+			return new ConstExpr(new StringVal(ss[Rand(4)]));
+			}
+		break;
+
+	case K_ADDR:
+		if ( r == 0 )
+			return Field("c");
+		if ( r < 3 )
+			{
+			static const char* as[] = { "10.0.0.1", "127.0.0.1", "::1" };
+			return new ConstExpr(new AddrVal(as[Rand(3)]));
+			}
+		break;
+
+	case K_INTERVAL:
+		if ( r < 2 )
+			return new ConstExpr(new IntervalVal(Rand(3) * 60.0, 1.0));
+		break;
+
+	default:
+		break;
+	}
+
+	return Local(k);
+	}
+
+// A count, int or double expression.
+Expr* BodyGen::Numeric(int depth)
+	{
+	static const Kind numeric[] = { K_COUNT, K_INT, K_DOUBLE };
+	return Gen(numeric[Rand(3)], depth);
+	}
+
+Expr* BodyGen::Composite(Kind k, int depth)
+	{
+	if ( OneIn(12) )
+		return new CondExpr(Gen(K_BOOL, depth), Gen(k, depth), Gen(k, depth));
+
+	int r = Rand(8);
+
+	switch ( k ) {
+	case K_COUNT:
+		switch ( r ) {
+		case 0:	return new AddExpr(Gen(k, depth), Gen(k, depth));
+		case 1:	return new SubExpr(Gen(k, depth), Gen(k, depth));
+		case 2:	return new TimesExpr(Gen(k, depth), Gen(k, depth));
+		case 3:	return new DivideExpr(Gen(k, depth), Gen(k, depth));
+		case 4:	return new ModExpr(Gen(k, depth), Gen(k, depth));
+		case 5:
+			{
+			static const BroExprTag bits[] = { EXPR_AND, EXPR_OR, EXPR_XOR };
+			return new BitExpr(bits[Rand(3)], Gen(k, depth), Gen(k, depth));
+			}
+		case 6:	return new IncrExpr(OneIn(2) ? EXPR_INCR : EXPR_DECR, Local(k));
+		default:	return new SizeExpr(Gen(K_STRING, depth));
+		}
+
+	case K_INT:
+		{
+		// Mixing in counts coerces them.
+		Expr* e1 = Gen(OneIn(3) ? K_COUNT : K_INT, depth);
+		Expr* e2 = Gen(OneIn(3) ? K_COUNT : K_INT, depth);
+
+		if ( e1->Type()->Tag() == TYPE_COUNT &&
+		     e2->Type()->Tag() == TYPE_COUNT )
+			{
+			Unref(e2);
+			return new NegExpr(e1);
+			}
+
+		switch ( r ) {
+		case 0:	Unref(e2); return new NegExpr(e1);
+		case 1:	return new AddExpr(e1, e2);
+		case 2:	return new SubExpr(e1, e2);
+		case 3:	return new TimesExpr(e1, e2);
+		case 4:	return new DivideExpr(e1, e2);
+		case 5:	return new ModExpr(e1, e2);
+		case 6:	Unref(e1); Unref(e2); return new IncrExpr(EXPR_INCR, Local(k));
+		default:	return new AddExpr(e1, e2);
+		}
+		}
+
+	case K_DOUBLE:
+		switch ( r ) {
+		case 0:	return new NegExpr(Gen(k, depth));
+		case 1:	return new AddExpr(Gen(k, depth), Numeric(depth));
+		case 2:	return new SubExpr(Numeric(depth), Gen(k, depth));
+		case 3:	return new TimesExpr(Gen(k, depth), Numeric(depth));
+		case 4:	return new DivideExpr(Numeric(depth), Gen(k, depth));
+		case 5:	return new DivideExpr(Gen(K_INTERVAL, depth), Gen(K_INTERVAL, depth));
+		default:	return new AddExpr(Gen(k, depth), Gen(k, depth));
+		}
+
+	case K_BOOL:
+		switch ( r ) {
+		case 0:	return new NotExpr(Gen(k, depth));
+		case 1:
+		case 2:
+			return new BoolExpr(OneIn(2) ? EXPR_AND_AND : EXPR_OR_OR,
+					    Gen(k, depth), Gen(k, depth));
+		default:
+			{
+			static const BroExprTag rel[] = {
+				EXPR_LT, EXPR_LE, EXPR_GE, EXPR_GT,
+			};
+			static const Kind comparable[] = {
+				K_STRING, K_ADDR, K_TIME, K_INTERVAL, K_BOOL,
+			};
+
+			BroExprTag tag = OneIn(3) ? rel[Rand(4)] :
+						(OneIn(2) ? EXPR_EQ : EXPR_NE);
+			Expr* e1;
+			Expr* e2;
+
+			if ( OneIn(2) )
+				{
+				e1 = Numeric(depth);
+				e2 = Numeric(depth);
+				}
+			else
+				{
+				Kind ck = comparable[Rand(5)];
+
+				if ( ck == K_BOOL )
+					tag = OneIn(2) ? EXPR_EQ : EXPR_NE;
+
+				e1 = Gen(ck, depth);
+				e2 = Gen(ck, depth);
+				}
+
+			if ( tag == EXPR_EQ || tag == EXPR_NE )
+				return new EqExpr(tag, e1, e2);
+
+			return new RelExpr(tag, e1, e2);
+			}
+		}
+
+	case K_STRING:
+		{
+		// One operand is a constant, so that strings only grow
+		// linearly in loops.
+		Expr* c = new ConstExpr(new StringVal(OneIn(2) ? "-" : "ab"));
+
+		if ( OneIn(2) )
+			return new AddExpr(Gen(k, depth), c);
+
+		return new AddExpr(c, Gen(k, depth));
+		}
+
+	case K_TIME:
+		if ( OneIn(2) )
+			return new AddExpr(Gen(k, depth), Gen(K_INTERVAL, depth));
+
+		return new SubExpr(Gen(k, depth), Gen(K_INTERVAL, depth));
+
+	case K_INTERVAL:
+		switch ( r ) {
+		case 0:	return new SubExpr(Gen(K_TIME, depth), Gen(K_TIME, depth));
+		case 1:	return new TimesExpr(Gen(k, depth), Numeric(depth));
+		case 2:	return new DivideExpr(Gen(k, depth), Gen(K_DOUBLE, depth));
+		case 3:	return new NegExpr(Gen(k, depth));
+		default:	return new AddExpr(Gen(k, depth), Gen(k, depth));
+		}
+
+	default:
+		return Leaf(k);
+	}
+	}
+
+Stmt* BodyGen::Assign(Expr* lhs, Expr* rhs)
+	{
+	return Track(new ExprStmt(Check(new AssignExpr(lhs, rhs, 0))));
+	}
+
+Stmt* BodyGen::Statement(int depth, int loop_depth)
+	{
+	int r = Rand(20);
+	Kind k = Kind(Rand(NUM_KINDS));
+
+	if ( depth <= 0 && r >= 10 )
+		r = Rand(10);
+
+	switch ( r ) {
+	case 0:
+	case 1:
+	case 2:
+		return Assign(Local(k), Gen(k, 3));
+
+	case 3:
+		{
+		k = global_kinds[Rand(4)];
+		return Assign(name_expr(globals[k]), Gen(k, 3));
+		}
+
+	case 4:
+		if ( OneIn(2) )
+			return Assign(Field("a"), Gen(K_COUNT, 2));
+
+		if ( OneIn(2) )
+			return Assign(Field("b"), Gen(K_STRING, 2));
+
+		return Assign(Field("d"), Gen(K_DOUBLE, 2));
+
+	case 5:
+	case 6:
+		return Track(new ExprStmt(Gen(k, 3)));
+
+	case 7:
+		if ( loop_depth > 0 && OneIn(2) )
+			{
+			Stmt* s = OneIn(2) ? (Stmt*) new NextStmt() :
+						(Stmt*) new BreakStmt();
+			return Track(new IfStmt(Gen(K_BOOL, 2), Track(s),
+						Track(new NullStmt())));
+			}
+
+		return Track(new ReturnStmt(Gen(k, 2)));
+
+	case 8:
+		{
+		id_list* inits = new id_list();
+
+		ID* id = OneIn(4) ? rec : locals[k][Rand(LOCALS_PER_KIND)];
+		::Ref(id);
+		inits->append(id);
+
+		return Track(new InitStmt(inits));
+		}
+
+	case 9:
+		// A hook's "break".
+		if ( loop_depth == 0 && OneIn(4) )
+			return Track(new BreakStmt());
+
+		return Assign(Local(k), Gen(k, 1));
+
+	case 10:
+	case 11:
+	case 12:
+		return Track(new IfStmt(Gen(K_BOOL, 3),
+					List(depth - 1, loop_depth, 3),
+					OneIn(2) ? Track(new NullStmt()) :
+						List(depth - 1, loop_depth, 3)));
+
+	case 13:
+	case 14:
+	case 15:
+		if ( loop_depth < MAX_LOOP_DEPTH )
+			return Loop(depth - 1, loop_depth);
+
+		return List(depth - 1, loop_depth, 3);
+
+	case 16:
+		return Switch(depth - 1, loop_depth);
+
+	default:
+		return List(depth - 1, loop_depth, 4);
+	}
+	}
+
+Stmt* BodyGen::List(int depth, int loop_depth, int max_len)
+	{
+	StmtList* l = new StmtList();
+	Track(l);
+
+	int n = Rand(max_len + 1);
+
+	for ( int i = 0; i < n; ++i )
+		l->Stmts().append(Statement(depth, loop_depth));
+
+	return l;
+	}
+
+// k = 0; while ( k < LIMIT [&& cond] ) { ++k; ... }
+Stmt* BodyGen::Loop(int depth, int loop_depth)
+	{
+	ID* k = counters[loop_depth];
+
+	StmtList* l = new StmtList();
+	Track(l);
+
+	l->Stmts().append(Assign(name_expr(k),
+				 new ConstExpr(val_mgr->GetCount(0))));
+
+	Expr* cond = Check(new RelExpr(EXPR_LT, name_expr(k),
+				new ConstExpr(val_mgr->GetCount(LOOP_LIMIT))));
+
+	if ( OneIn(2) )
+		cond = Check(new BoolExpr(EXPR_AND_AND, cond, Gen(K_BOOL, 2)));
+
+	StmtList* body = new StmtList();
+	Track(body);
+
+	body->Stmts().append(Assign(name_expr(k),
+			     new AddExpr(name_expr(k),
+					 new ConstExpr(val_mgr->GetCount(1)))));
+
+	int n = 1 + Rand(4);
+
+	for ( int i = 0; i < n; ++i )
+		body->Stmts().append(Statement(depth, loop_depth + 1));
+
+	l->Stmts().append(Track(new WhileStmt(cond, body)));
+	return l;
+	}
+
+// switch ( count ) { case 0, 1: ...; break; default: ...; break; }
+Stmt* BodyGen::Switch(int depth, int loop_depth)
+	{
+	case_list* cases = new case_list();
+
+	for ( int i = 0; i < 2; ++i )
+		{
+		StmtList* body = (StmtList*) List(depth, loop_depth, 2);
+		body->Stmts().append(Track(new BreakStmt()));
+
+		ListExpr* labels = 0;
+
+		if ( i == 0 )
+			{
+			labels = new ListExpr(new ConstExpr(val_mgr->GetCount(0)));
+			labels->Append(new ConstExpr(val_mgr->GetCount(1)));
+			}
+
+		cases->append(new Case(labels, 0, body));
+		}
+
+	// Case's destructor doesn't cope with cases that have no type
+	// labels, so switches are never released.
+	Stmt* s = new SwitchStmt(Gen(K_COUNT, 2), cases);
+	::Ref(s);
+	return Track(s);
+	}
+
+Stmt* BodyGen::Body()
+	{
+	Stmt* body = List(3, 0, 8);
+
+	if ( construction_error )
+		{
+		fprintf(stderr, "generated an ill-formed body\n");
+		abort();
+		}
+
+	return body;
+	}
+
+// The initial values of the locals and globals.
+static void init_values(uint64_t seed, Frame* f)
+	{
+	bench::Random rnd(seed);
+
+	for ( int k = 0; k < NUM_KINDS; ++k )
+		for ( int j = 0; j < LOCALS_PER_KIND; ++j )
+			{
+			uint64_t r = rnd.Next();
+			Val* v = 0;
+
+			if ( r % 128 == 0 )
+				; // Unset.
+
+			else switch ( kind_tag[k] ) {
+			case TYPE_COUNT:	v = val_mgr->GetCount(r % 10); break;
+			case TYPE_INT:		v = val_mgr->GetInt(int(r % 21) - 10); break;
+			case TYPE_DOUBLE:	v = new Val((r % 9) * 0.75 - 2, TYPE_DOUBLE); break;
+			case TYPE_BOOL:		v = val_mgr->GetBool(r % 2); break;
+			case TYPE_STRING:	v = new StringVal(r % 2 ? "a" : "zeek"); break;
+			case TYPE_ADDR:		v = new AddrVal(r % 2 ? "10.0.0.1" : "192.168.0.1"); break;
+			case TYPE_TIME:		v = new Val(1000.0 + r % 100, TYPE_TIME); break;
+			case TYPE_INTERVAL:	v = new IntervalVal(r % 300, 1.0); break;
+			default:		break;
+			}
+
+			f->SetElement(k * LOCALS_PER_KIND + j, v);
+			}
+
+	for ( int j = 0; j < MAX_LOOP_DEPTH; ++j )
+		f->SetElement(COUNTER_OFFSET + j, val_mgr->GetCount(0));
+
+	RecordVal* r = new RecordVal(rec_type);
+	r->Assign(0, val_mgr->GetCount(rnd.Next() % 5));
+
+	if ( rnd.Next() % 4 )
+		r->Assign(1, new StringVal("x"));
+
+	if ( rnd.Next() % 4 )
+		r->Assign(3, new Val(2.5, TYPE_DOUBLE));
+
+	f->SetElement(RECORD_OFFSET, r);
+
+	globals[K_COUNT]->SetVal(val_mgr->GetCount(rnd.Next() % 10));
+	globals[K_DOUBLE]->SetVal(new Val(1.5, TYPE_DOUBLE));
+	globals[K_STRING]->SetVal(new StringVal("global"));
+	globals[K_BOOL]->SetVal(rnd.Next() % 8 ? val_mgr->GetBool(1) : 0);
+	}
+
+// Describes a value exactly, including how it's boxed.
+static std::string describe(const Val* v)
+	{
+	if ( ! v )
+		return "<unset>";
+
+	ODesc d;
+	v->Describe(&d);
+
+	std::string s = d.Description();
+	s += " (";
+	s += type_name(v->Type()->Tag());
+
+	if ( v->Type()->InternalType() == TYPE_INTERNAL_DOUBLE )
+		{
+		char buf[64];
+		snprintf(buf, sizeof(buf), " %a", v->InternalDouble());
+		s += buf;
+		}
+
+	if ( dynamic_cast<const IntervalVal*>(v) )
+		s += " IntervalVal";
+
+	s += ")";
+	return s;
+	}
+
+struct Outcome {
+	std::string result;
+	int flow;
+	std::string error;
+	std::vector<std::string> state;
+	std::vector<uint32> accesses;
+};
+
+static Outcome run(const Stmt* body, const BytecodeBody* code,
+		   const std::vector<Stmt*>& stmts, uint64_t seed)
+	{
+	Frame* f = new Frame(FRAME_SIZE, 0, 0);
+	init_values(seed, f);
+
+	std::vector<uint32> before;
+
+	for ( auto s : stmts )
+		before.push_back(s->GetAccessCount());
+
+	Outcome o;
+	stmt_flow_type flow = FLOW_NEXT;
+	last_runtime_error.clear();
+
+	try
+		{
+		Val* result = code ? code->Exec(f, flow) : body->Exec(f, flow);
+		o.result = describe(result);
+		Unref(result);
+		}
+
+	catch ( InterpreterException& )
+		{
+		o.error = last_runtime_error;
+		}
+
+	o.flow = o.error.empty() ? flow : -1;
+
+	for ( int i = 0; i < FRAME_SIZE; ++i )
+		o.state.push_back(describe(f->NthElement(i)));
+
+	for ( auto k : global_kinds )
+		o.state.push_back(describe(globals[k]->ID_Val()));
+
+	for ( size_t i = 0; i < stmts.size(); ++i )
+		o.accesses.push_back(stmts[i]->GetAccessCount() - before[i]);
+
+	Unref(f);
+	return o;
+	}
+
+static bool compare(long round, const Stmt* body, const Outcome& ast,
+		    const Outcome& bc)
+	{
+	std::string what;
+
+	if ( ast.error != bc.error )
+		what = "error: " + ast.error + " vs. " + bc.error;
+
+	else if ( ast.result != bc.result || ast.flow != bc.flow )
+		what = "result: " + ast.result + " vs. " + bc.result;
+
+	else if ( ast.state != bc.state )
+		{
+		for ( size_t i = 0; i < ast.state.size(); ++i )
+			if ( ast.state[i] != bc.state[i] )
+				{
+				what = "slot " + std::to_string(i) + ": " +
+					ast.state[i] + " vs. " + bc.state[i];
+				break;
+				}
+		}
+
+	else if ( ast.accesses != bc.accesses )
+		what = "statement access counts";
+
+	if ( what.empty() )
+		return true;
+
+	ODesc d;
+	body->Describe(&d);
+	printf("round %ld: mismatch in %s\n%s\n", round, what.c_str(),
+	       d.Description());
+	return false;
+	}
+
+int main(int argc, char** argv)
+	{
+	long rounds = bench::arg(argc, argv, "-r", 20000);
+	long seed = bench::arg(argc, argv, "-s", 1);
+
+	reporter = new Reporter();
+	val_mgr = new ValManager();
+	make_record_type();
+	make_ids();
+
+	// ReturnStmt checks its expression against the function's.
+	ID* func = new ID("body", SCOPE_GLOBAL, false);
+	func->SetType(new FuncType(new RecordType(new type_decl_list()),
+				   base_type(TYPE_ANY), FUNC_FLAVOR_FUNCTION));
+	push_scope(func, 0);
+
+	long compiled = 0, errors = 0, instructions = 0;
+
+	for ( long r = 0; r < rounds; ++r )
+		{
+		uint64_t round_seed = seed * 1000003 + r;
+		BodyGen gen(round_seed);
+		Stmt* body = gen.Body();
+
+		BytecodeBody* code = BytecodeBody::Compile(body);
+
+		if ( code )
+			{
+			Outcome ast = run(body, 0, gen.Stmts(), round_seed);
+			Outcome bc = run(body, code, gen.Stmts(), round_seed);
+
+			if ( ! compare(r, body, ast, bc) )
+				return 1;
+
+			++compiled;
+			instructions += code->NumInstructions();
+
+			if ( ! ast.error.empty() )
+				++errors;
+
+			delete code;
+			}
+
+		Unref(body);
+		}
+
+	printf("%ld rounds, %ld compiled bodies match (%ld instructions, "
+	       "%ld ending in runtime errors)\n",
+	       rounds, compiled, instructions, errors);
+
+	return 0;
+	}
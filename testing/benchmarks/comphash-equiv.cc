@@ -0,0 +1,238 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Checks CompositeHash's flat-key path against the generic one.  Each
+// round makes a random index type of two to six numbers, addresses,
+// subnets and strings, which CompositeHash keys with its flat layout,
+// and hashes random index values for it both ways:
+//
+//   keys     both paths produce byte-identical keys with the same hash,
+//            and both recover the original index from the key;
+//   checks   for index values of the wrong type, both paths reject the
+//            same ones and produce the same keys for the rest (those
+//            that merely coerce, such as count vs. int).
+//
+// The generic path is forced by hiding the type's flat fields.
+//
+//     comphash-equiv [-r rounds]
+
+#include "zeek-config.h"
+
+#include <string>
+#include <vector>
+
+#include "CompHash.h"
+#include "Val.h"
+#include "Type.h"
+#include "Desc.h"
+#include "Reporter.h"
+
+#include "Benchmark.h"
+
+static bench::Random rnd(3);
+
+static int random_int(int n)
+	{
+	return rnd.Next() % n;
+	}
+
+class TestHash : public CompositeHash {
+public:
+	explicit TestHash(TypeList* tl) : CompositeHash(tl)	{ }
+
+	bool IsFlat() const	{ return ! flat_fields.empty(); }
+
+	// Hides the flat fields, or brings them back.
+	void ToggleFlat()	{ flat_fields.swap(hidden); }
+
+private:
+	std::vector<FlatField> hidden;
+};
+
+class Color : public EnumType {
+public:
+	Color() : EnumType("color")
+		{
+		AddNameInternal("GLOBAL", "RED", 0, true);
+		AddNameInternal("GLOBAL", "GREEN", 1, true);
+		}
+};
+
+static Color* color;
+
+static const TypeTag tags[] = {
+	TYPE_COUNT, TYPE_INT, TYPE_DOUBLE, TYPE_TIME, TYPE_INTERVAL,
+	TYPE_PORT, TYPE_BOOL, TYPE_ENUM, TYPE_ADDR, TYPE_SUBNET, TYPE_STRING,
+};
+
+static const int NUM_TAGS = sizeof(tags) / sizeof(tags[0]);
+
+static Val* random_val(TypeTag t)
+	{
+	static const char* strs[] = {
+		"", "a", "zeek",
+		"abcdefghijklmnopqrstuvwxyz0123456789abcdefghijklmnopqrstuvwxyz",
+	};
+
+	static const char* addrs[] = {
+		"10.0.0.1", "0.0.0.0", "2001:db8::1", "::ffff:1.2.3.4",
+	};
+
+	switch ( t ) {
+	case TYPE_COUNT:
+		return val_mgr->GetCount(random_int(2) ? random_int(10) : rnd.Next());
+
+	case TYPE_INT:
+		return val_mgr->GetInt(random_int(2) ? random_int(10) - 5 :
+						       (bro_int_t) rnd.Next());
+
+	case TYPE_DOUBLE:
+		return new Val(random_int(100) * 0.25 - 3, TYPE_DOUBLE);
+
+	case TYPE_TIME:
+		return new Val(random_int(100) * 1.5, TYPE_TIME);
+
+	case TYPE_INTERVAL:
+		return new IntervalVal(random_int(100) - 50, 1.0);
+
+	case TYPE_PORT:
+		return val_mgr->GetPort(random_int(65536),
+					(TransportProto) random_int(4));
+
+	case TYPE_BOOL:
+		return val_mgr->GetBool(random_int(2));
+
+	case TYPE_ENUM:
+		return color->GetVal(random_int(2));
+
+	case TYPE_ADDR:
+		return new AddrVal(addrs[random_int(4)]);
+
+	case TYPE_SUBNET:
+		return new SubNetVal(addrs[random_int(4)], random_int(2) ? 8 : 32);
+
+	default:
+		return new StringVal(strs[random_int(4)]);
+	}
+	}
+
+static std::string desc(Val* v)
+	{
+	ODesc d;
+	v->Describe(&d);
+	return d.Description();
+	}
+
+static bool same_key(const HashKey* k1, const HashKey* k2)
+	{
+	if ( ! k1 || ! k2 )
+		return k1 == k2;
+
+	return k1->Size() == k2->Size() &&
+		memcmp(k1->Key(), k2->Key(), k1->Size()) == 0 &&
+		k1->Hash() == k2->Hash();
+	}
+
+int main(int argc, char** argv)
+	{
+	long rounds = bench::arg(argc, argv, "-r", 2000);
+
+	reporter = new Reporter();
+	init_random_seed(0, 0);
+	val_mgr = new ValManager();
+	color = new Color();
+
+	long keys = 0, rejected = 0;
+
+	for ( long r = 0; r < rounds; ++r )
+		{
+		int n = 2 + random_int(5);
+		std::vector<TypeTag> field_tags;
+		TypeList* tl = new TypeList();
+
+		for ( int i = 0; i < n; ++i )
+			{
+			TypeTag t = tags[random_int(NUM_TAGS)];
+			field_tags.push_back(t);
+			tl->Append(t == TYPE_ENUM ? color->Ref() : base_type(t));
+			}
+
+		TestHash h(tl);
+
+		if ( ! h.IsFlat() )
+			{
+			printf("round %ld: index type isn't flat\n", r);
+			return 1;
+			}
+
+		for ( int i = 0; i < 50; ++i )
+			{
+			// Every fourth index has one value of a random type.
+			bool ill_typed = random_int(4) == 0;
+			int bad_field = random_int(n);
+			ListVal* lv = new ListVal(TYPE_ANY);
+
+			for ( int j = 0; j < n; ++j )
+				lv->Append(random_val(ill_typed && j == bad_field ?
+						      tags[random_int(NUM_TAGS)] :
+						      field_tags[j]));
+
+			HashKey* k1 = h.ComputeHash(lv, 1);
+			h.ToggleFlat();
+			HashKey* k2 = h.ComputeHash(lv, 1);
+			ListVal* r2 = k1 ? h.RecoverVals(k1) : 0;
+			h.ToggleFlat();
+			ListVal* r1 = k1 ? h.RecoverVals(k1) : 0;
+
+			if ( ! same_key(k1, k2) )
+				{
+				printf("%s: round %ld: keys differ for %s (%s, %s)\n",
+				       ill_typed ? "checks" : "keys", r,
+				       desc(lv).c_str(), k1 ? "key" : "rejected",
+				       k2 ? "key" : "rejected");
+				return 1;
+				}
+
+			if ( ! k1 )
+				{
+				if ( ! ill_typed )
+					{
+					printf("keys: round %ld: rejected %s\n", r,
+					       desc(lv).c_str());
+					return 1;
+					}
+
+				++rejected;
+				}
+
+			else if ( ! ill_typed )
+				{
+				if ( desc(r1) != desc(lv) || desc(r2) != desc(lv) )
+					{
+					printf("keys: round %ld: recovered %s and %s from %s\n",
+					       r, desc(r1).c_str(), desc(r2).c_str(),
+					       desc(lv).c_str());
+					return 1;
+					}
+
+				++keys;
+				}
+
+			delete k1;
+			delete k2;
+			Unref(r1);
+			Unref(r2);
+			Unref(lv);
+			}
+		}
+
+	printf("keys: %ld rounds, %ld keys match\n", rounds, keys);
+	printf("checks: %ld ill-typed indices rejected by both\n", rejected);
+
+	if ( ! keys || ! rejected )
+		{
+		printf("checks: nothing compared\n");
+		return 1;
+		}
+
+	return 0;
+	}
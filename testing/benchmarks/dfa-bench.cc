@@ -0,0 +1,72 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Measures signature-style matching of unanchored literals over an
+// HTTP-like stream, with RE_Match_State::Match() and with the plain
+// stepping loop it skips ahead of.
+//
+//     dfa-bench [-m megabytes]
+
+#include "zeek-config.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "DFATest.h"
+
+#include "Benchmark.h"
+
+int main(int argc, char** argv)
+	{
+	long mb = bench::arg(argc, argv, "-m", 16);
+
+	static const char* words[] = {
+		"GET ", "Host: ", "image/", "Mozilla ", "keep-alive", "\r\n",
+		"0123", "abcd",
+	};
+
+	static const char* literals[] = {
+		"cmd.exe", "/etc/passwd", "<script>", "SELECT ",
+		"\x90\x90\x90\x90", "root:", "wget ", "union ",
+	};
+
+	bench::Random rnd(1);
+	std::vector<u_char> d(mb << 20);
+
+	for ( size_t i = 0; i < d.size(); )
+		for ( const char* w = words[rnd.Next() % 8]; *w && i < d.size(); ++w )
+			d[i++] = *w;
+
+	// As in a TCP stream of full-sized segments.
+	static const size_t chunk = 1460;
+
+	for ( int accel = 0; accel < 2; ++accel )
+		{
+		TestMatcher tm;
+		std::vector<NFA_Machine*> pats;
+
+		for ( auto l : literals )
+			pats.push_back(tm.Lit(tm.AnyStar(), l));
+
+		tm.Build(pats);
+
+		RE_Match_State st(&tm);
+		RefMatchState ref(tm.DFA(), tm.EC()->EquivClasses());
+
+		double t = bench::now();
+
+		for ( size_t i = 0; i < d.size(); i += chunk )
+			{
+			size_t n = std::min(chunk, d.size() - i);
+
+			if ( accel )
+				st.Match(&d[i], n, i == 0, false, false);
+			else
+				ref.Match(&d[i], n, i == 0, false);
+			}
+
+		bench::report(accel ? "match" : "stepping", "bytes", d.size(),
+			      bench::now() - t);
+		}
+
+	return 0;
+	}
@@ -0,0 +1,296 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Checks the DFA matcher's shortcuts against the plain stepping loop on
+// random payloads, split into random chunks:
+//
+//   accel   skipping over self-looping states finds the same matches at
+//           the same positions;
+//   evict   a machine whose state cache keeps evicting, shared by several
+//           interleaved match states, matches like an unbounded one;
+//   save    a machine restored from another's saved states has the same
+//           states, computes no new ones for the same input and matches
+//           the same; data saved for other patterns is rejected, and
+//           truncated data or a bogus state count handled safely.
+//
+//     dfa-equiv [-r rounds]
+
+#include "zeek-config.h"
+
+#include <string>
+#include <vector>
+
+#include "DFATest.h"
+
+#include "Benchmark.h"
+
+extern bro_uint_t max_dfa_state_mem;
+
+static bench::Random rnd(7);
+
+static int random_int(int n)
+	{
+	return rnd.Next() % n;
+	}
+
+// Mostly bytes that keep the DFA in its self-looping states, or mostly
+// pattern bytes, or the former with some binary noise.
+static std::vector<u_char> random_payload(int len)
+	{
+	static const char alpha[] = "abcxyzf\n\r.Q";
+
+	std::vector<u_char> d(len);
+	int bias = random_int(3);
+
+	for ( auto& b : d )
+		{
+		int r = random_int(1000);
+
+		if ( bias == 0 || r >= 990 )
+			b = alpha[random_int(sizeof(alpha) - 1)];
+		else
+			b = 'Q' + random_int(4);
+
+		if ( bias == 2 && r >= 995 )
+			b = random_int(256);
+		}
+
+	return d;
+	}
+
+static void build(TestMatcher& tm, int round)
+	{
+	std::vector<NFA_Machine*> pats;
+
+	// .*abc
+	pats.push_back(tm.Lit(tm.AnyStar(), "abc"));
+
+	// .*x[yz]+
+	pats.push_back(tm.Lit(tm.AnyStar(), "x"));
+	pats.back()->AppendMachine(tm.Set("yz", true));
+
+	// foo
+	pats.push_back(tm.Lit(0, "foo"));
+
+	// .*[abcxyz][abf][cxyzf][a\nz][Qf], which makes for many states.
+	NFA_Machine* m = tm.AnyStar();
+	m->AppendMachine(tm.Set("abcxyz", false));
+	m->AppendMachine(tm.Set("abf", false));
+	m->AppendMachine(tm.Set("cxyzf", false));
+	m->AppendMachine(tm.Set("a\nz", false));
+	m->AppendMachine(tm.Set("Qf", false));
+	pats.push_back(m);
+
+	if ( round % 2 )
+		// .*\n\n
+		pats.push_back(tm.Lit(tm.AnyStar(), "\n\n"));
+
+	tm.Build(pats);
+	}
+
+static bool check_accel(int round)
+	{
+	TestMatcher tm;
+	build(tm, round);
+
+	RE_Match_State st(&tm);
+	RefMatchState ref(tm.DFA(), tm.EC()->EquivClasses());
+
+	int num_chunks = 1 + random_int(20);
+
+	for ( int c = 0; c < num_chunks; ++c )
+		{
+		auto d = random_payload(random_int(2000));
+		bool bol = c == 0;
+		bool eol = c == num_chunks - 1;
+
+		bool r1 = st.Match(d.data(), d.size(), bol, eol, false);
+		bool r2 = ref.Match(d.data(), d.size(), bol, eol);
+
+		if ( r1 != r2 || st.AcceptedMatches() != ref.AcceptedMatches() )
+			{
+			printf("accel: mismatch in round %d, chunk %d\n", round, c);
+			return false;
+			}
+		}
+
+	return true;
+	}
+
+static bool check_evict(int round, unsigned long* evictions)
+	{
+	bro_uint_t budget = 2000 + random_int(20000);
+
+	// The limit applies when states are computed, which for the
+	// reference machine has to be never.
+	TestMatcher tm, rm;
+	max_dfa_state_mem = budget;
+	build(tm, round);
+	max_dfa_state_mem = 0;
+	build(rm, round);
+
+	static const int NUM_STATES = 3;
+	std::vector<RE_Match_State*> st;
+	std::vector<RefMatchState> ref;
+	bool bol[NUM_STATES];
+
+	for ( int i = 0; i < NUM_STATES; ++i )
+		{
+		st.push_back(new RE_Match_State(&tm));
+		ref.push_back(RefMatchState(rm.DFA(), rm.EC()->EquivClasses()));
+		bol[i] = true;
+		}
+
+	bool ok = true;
+	int num_chunks = 1 + random_int(40);
+
+	for ( int c = 0; c < num_chunks && ok; ++c )
+		{
+		int i = random_int(NUM_STATES);
+		auto d = random_payload(random_int(1500));
+		bool eol = random_int(10) == 0;
+		bool clear = random_int(15) == 0;
+
+		if ( clear )
+			ref[i].Clear();
+
+		max_dfa_state_mem = budget;
+		bool r1 = st[i]->Match(d.data(), d.size(), bol[i], eol, clear);
+		max_dfa_state_mem = 0;
+		bool r2 = ref[i].Match(d.data(), d.size(), bol[i], eol);
+		bol[i] = false;
+
+		if ( r1 != r2 ||
+		     st[i]->AcceptedMatches() != ref[i].AcceptedMatches() )
+			{
+			printf("evict: mismatch in round %d, chunk %d\n", round, c);
+			ok = false;
+			}
+		}
+
+	DFA_State_Cache::Stats stats;
+	tm.DFA()->Cache()->GetStats(&stats);
+	*evictions += stats.evictions;
+
+	for ( auto s : st )
+		delete s;
+
+	return ok;
+	}
+
+static bool check_save(int round)
+	{
+	std::vector<u_char> d(20000);
+
+	for ( auto& b : d )
+		b = random_int(4) ? "abcxyzf\n\r.Q"[random_int(11)] : random_int(256);
+
+	TestMatcher a;
+	build(a, round);
+
+	RE_Match_State warm(&a);
+	warm.Match(d.data(), d.size(), true, true, false);
+
+	std::string buf;
+	a.DFA()->Save(&buf);
+
+	TestMatcher b;
+	build(b, round);
+
+	if ( ! b.DFA()->Load((const u_char*) buf.data(), buf.size()) )
+		{
+		printf("save: round %d failed to load\n", round);
+		return false;
+		}
+
+	if ( b.DFA()->NumStates() != a.DFA()->NumStates() )
+		{
+		printf("save: round %d loaded %d states, saved %d\n", round,
+		       b.DFA()->NumStates(), a.DFA()->NumStates());
+		return false;
+		}
+
+	DFA_State_Cache::Stats before, after;
+	b.DFA()->Cache()->GetStats(&before);
+
+	RE_Match_State st(&b);
+	RefMatchState ref(a.DFA(), a.EC()->EquivClasses());
+	st.Match(d.data(), d.size(), true, true, false);
+	ref.Match(d.data(), d.size(), true, true);
+
+	b.DFA()->Cache()->GetStats(&after);
+
+	if ( after.dfa_states != before.dfa_states )
+		{
+		printf("save: round %d computed new states after loading\n", round);
+		return false;
+		}
+
+	if ( st.AcceptedMatches() != ref.AcceptedMatches() )
+		{
+		printf("save: mismatch in round %d\n", round);
+		return false;
+		}
+
+	// The next round's patterns differ.
+	TestMatcher c;
+	build(c, round + 1);
+
+	if ( c.DFA()->Load((const u_char*) buf.data(), buf.size()) )
+		{
+		printf("save: round %d accepted data for other patterns\n", round);
+		return false;
+		}
+
+	TestMatcher e;
+	build(e, round);
+	e.DFA()->Load((const u_char*) buf.data(), random_int(buf.size()));
+
+	// A state count the data can't hold must be rejected up front,
+	// not used to size the state tables.
+	std::string huge = buf;
+	int32_t count = 0x7fffffff;
+	memcpy(&huge[(2 + NUM_SYM) * sizeof(count)], &count, sizeof(count));
+
+	TestMatcher h;
+	build(h, round);
+
+	if ( h.DFA()->Load((const u_char*) huge.data(), huge.size()) )
+		{
+		printf("save: round %d accepted a bogus state count\n", round);
+		return false;
+		}
+
+	return true;
+	}
+
+int main(int argc, char** argv)
+	{
+	long rounds = bench::arg(argc, argv, "-r", 200);
+	unsigned long evictions = 0;
+
+	for ( long r = 0; r < rounds; ++r )
+		if ( ! check_accel(r) )
+			return 1;
+
+	printf("accel: %ld rounds match\n", rounds);
+
+	for ( long r = 0; r < rounds; ++r )
+		if ( ! check_evict(r, &evictions) )
+			return 1;
+
+	printf("evict: %ld rounds match, %lu evictions\n", rounds, evictions);
+
+	if ( ! evictions )
+		{
+		printf("evict: no evictions, budgets too large\n");
+		return 1;
+		}
+
+	for ( long r = 0; r < rounds; ++r )
+		if ( ! check_save(r) )
+			return 1;
+
+	printf("save: %ld rounds match\n", rounds);
+
+	return 0;
+	}
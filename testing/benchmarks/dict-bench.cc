@@ -0,0 +1,148 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Compares the open-addressing Dictionary against the chained table it
+// replaced, on keys shaped like the ones the connection tables use.
+//
+//     dict-bench [-n entries] [-r rounds]
+
+#include "zeek-config.h"
+
+#include <vector>
+
+#include "Dict.h"
+#include "siphash24.h"
+
+#include "Benchmark.h"
+#include "ChainedDict.h"
+
+// A connection-ID-sized key.
+struct Key {
+	uint32 addr[8];
+	uint32 ports;
+};
+
+static const uint8_t hash_key[SIPHASH_KEYLEN] = { 0 };
+
+static hash_t hash_of(const Key& k)
+	{
+	hash_t h;
+	siphash(&h, (const uint8_t*) &k, sizeof(k), hash_key);
+	return h;
+	}
+
+static std::vector<Key> make_keys(long n, uint64_t seed)
+	{
+	bench::Random rnd(seed);
+	std::vector<Key> keys(n);
+
+	for ( auto& k : keys )
+		{
+		for ( int i = 0; i < 8; ++i )
+			k.addr[i] = uint32(rnd.Next());
+
+		k.ports = uint32(rnd.Next());
+		}
+
+	return keys;
+	}
+
+// Dictionaries take ownership of the keys they're handed, the same way
+// they do with HashKey::TakeKey().
+static void* dup_key(const Key& k)
+	{
+	char* copy = new char[sizeof(k)];
+	memcpy(copy, &k, sizeof(k));
+	return copy;
+	}
+
+template<typename D>
+static void run(const char* impl, const std::vector<Key>& keys,
+                const std::vector<hash_t>& hashes,
+                const std::vector<Key>& misses,
+                const std::vector<hash_t>& miss_hashes)
+	{
+	long n = keys.size();
+	D d;
+
+	double t = bench::now();
+	for ( long i = 0; i < n; ++i )
+		d.Insert(dup_key(keys[i]), sizeof(Key), hashes[i],
+			 (void*) (intptr_t) (i + 1), 0);
+	bench::report(impl, "insert", n, bench::now() - t);
+
+	long found = 0;
+	t = bench::now();
+	for ( long i = 0; i < n; ++i )
+		found += d.Lookup(&keys[i], sizeof(Key), hashes[i]) != 0;
+	bench::report(impl, "lookup (hit)", n, bench::now() - t);
+
+	t = bench::now();
+	for ( long i = 0; i < n; ++i )
+		found += d.Lookup(&misses[i], sizeof(Key), miss_hashes[i]) != 0;
+	bench::report(impl, "lookup (miss)", n, bench::now() - t);
+
+	if ( found != n )
+		fprintf(stderr, "%s: lookups found %ld of %ld\n", impl, found, n);
+
+	long visited = 0;
+	t = bench::now();
+	auto c = d.InitForIteration();
+	HashKey* h;
+	while ( d.NextEntry(h, c, 0) )
+		++visited;
+	bench::report(impl, "iterate", visited, bench::now() - t);
+
+	// Walk the table with a robust cookie, the way table expiration
+	// does, while removing every other entry and inserting the misses.
+	visited = 0;
+	long mi = 0;
+	t = bench::now();
+	c = d.InitForIteration();
+	d.MakeRobustCookie(c);
+	for ( long i = 0; d.NextEntry(h, c, 0); ++i )
+		{
+		++visited;
+
+		if ( i % 2 && i < n )
+			d.Remove(&keys[i], sizeof(Key), hashes[i]);
+		else if ( mi < n )
+			{
+			d.Insert(dup_key(misses[mi]), sizeof(Key),
+				 miss_hashes[mi], (void*) 1, 0);
+			++mi;
+			}
+		}
+	bench::report(impl, "iterate while mutating", visited,
+		      bench::now() - t);
+
+	t = bench::now();
+	for ( long i = 0; i < n; ++i )
+		d.Remove(&keys[i], sizeof(Key), hashes[i]);
+	for ( long i = 0; i < mi; ++i )
+		d.Remove(&misses[i], sizeof(Key), miss_hashes[i]);
+	bench::report(impl, "remove", n + mi, bench::now() - t);
+	}
+
+int main(int argc, char** argv)
+	{
+	long n = bench::arg(argc, argv, "-n", 1000000);
+	long rounds = bench::arg(argc, argv, "-r", 3);
+
+	std::vector<Key> keys = make_keys(n, 1);
+	std::vector<Key> misses = make_keys(n, 2);
+	std::vector<hash_t> hashes, miss_hashes;
+
+	for ( long i = 0; i < n; ++i )
+		{
+		hashes.push_back(hash_of(keys[i]));
+		miss_hashes.push_back(hash_of(misses[i]));
+		}
+
+	for ( long r = 0; r < rounds; ++r )
+		{
+		run<ChainedDictionary>("chained", keys, hashes, misses, miss_hashes);
+		run<Dictionary>("open", keys, hashes, misses, miss_hashes);
+		}
+
+	return 0;
+	}
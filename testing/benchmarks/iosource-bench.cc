@@ -0,0 +1,326 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Stress test for the IOSource manager: hundreds of mostly idle sources,
+// each waiting on a pipe that a background thread writes to now and then,
+// plus one hot source that always has input, like a busy packet source.
+// Checks that every byte written gets processed, and reports the cost of
+// FindSoonest() and how quickly idle sources get woken up.  In the second
+// phase the hot source goes away, so the manager should block rather
+// than spin; the CPU time used during that phase shows whether it does.
+// The third phase repeats that with an idle source that has no fds, like
+// the threading manager, which must not make the manager spin either.
+// Finally, a source gets registered with the fd numbers of one that
+// closed them without telling the manager.
+//
+//     iosource-bench [-s idle sources] [-n iterations] [-w writes]
+
+#include "zeek-config.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "iosource/Manager.h"
+#include "iosource/IOSource.h"
+
+#include "Benchmark.h"
+
+static std::atomic<double> last_write;
+static double max_latency = 0;
+static double sum_latency = 0;
+static long num_processed = 0;
+
+class PipeSource : public iosource::IOSource {
+public:
+	PipeSource()
+		{
+		if ( pipe(fds) < 0 )
+			{
+			perror("pipe");
+			exit(1);
+			}
+
+		fcntl(fds[0], F_SETFL, O_NONBLOCK);
+		SetIdle(true);
+		}
+
+	~PipeSource() override
+		{
+		close(fds[0]);
+		close(fds[1]);
+		}
+
+	void Write()
+		{
+		char c = 0;
+		if ( write(fds[1], &c, 1) != 1 )
+			perror("write");
+		}
+
+	void GetFds(iosource::FD_Set* read, iosource::FD_Set* write,
+		    iosource::FD_Set* except) override
+		{
+		read->Insert(fds[0]);
+		++fds_asked;
+		}
+
+	double NextTimestamp(double* network_time) override
+		{
+		// Whatever's there is due right away.
+		return 0;
+		}
+
+	void Process() override
+		{
+		char buf[64];
+		ssize_t n = read(fds[0], buf, sizeof(buf));
+
+		if ( n <= 0 )
+			return;
+
+		double lat = bench::now() - last_write;
+		sum_latency += lat;
+		if ( lat > max_latency )
+			max_latency = lat;
+
+		num_processed += n;
+		}
+
+	const char* Tag() override	{ return "pipe"; }
+
+	// Closes the pipe behind the manager's back.
+	void Close()
+		{
+		close(fds[0]);
+		close(fds[1]);
+		fds[0] = fds[1] = -1;
+		}
+
+	int ReadFd() const	{ return fds[0]; }
+
+	static long fds_asked;
+
+private:
+	int fds[2];
+};
+
+long PipeSource::fds_asked = 0;
+
+// An idle source without any fds, like the threading manager.
+class PolledSource : public iosource::IOSource {
+public:
+	PolledSource()	{ SetIdle(true); asked = 0; }
+
+	void GetFds(iosource::FD_Set* read, iosource::FD_Set* write,
+		    iosource::FD_Set* except) override
+		{
+		++asked;
+		}
+
+	double NextTimestamp(double* network_time) override
+		{
+		return -1;
+		}
+
+	void Process() override
+		{
+		}
+
+	const char* Tag() override	{ return "polled"; }
+
+	long asked;
+};
+
+class HotSource : public iosource::IOSource {
+public:
+	HotSource()	{ ts = 1; processed = 0; }
+
+	void GetFds(iosource::FD_Set* read, iosource::FD_Set* write,
+		    iosource::FD_Set* except) override
+		{
+		}
+
+	double NextTimestamp(double* network_time) override
+		{
+		return ts;
+		}
+
+	void Process() override
+		{
+		ts += 1e-6;
+		++processed;
+		}
+
+	void Stop()	{ SetClosed(true); }
+
+	const char* Tag() override	{ return "hot"; }
+
+	double ts;
+	long processed;
+};
+
+static double cpu_time()
+	{
+	struct rusage r;
+	getrusage(RUSAGE_SELF, &r);
+	return r.ru_utime.tv_sec + r.ru_utime.tv_usec / 1e6 +
+		r.ru_stime.tv_sec + r.ru_stime.tv_usec / 1e6;
+	}
+
+// Writes to random pipes, pausing "gap" microseconds in between.
+static void writer(std::vector<PipeSource*>* pipes, long n, long gap)
+	{
+	bench::Random rnd(7);
+
+	for ( long i = 0; i < n; ++i )
+		{
+		usleep(gap);
+		last_write = bench::now();
+		(*pipes)[rnd.Next() % pipes->size()]->Write();
+		}
+	}
+
+// Runs the loop until either "n" iterations are done or, with n == 0,
+// all writes have been processed.
+static long run(iosource::Manager* mgr, long n, long writes)
+	{
+	long i;
+
+	for ( i = 0; n ? i < n : num_processed < writes; ++i )
+		{
+		double ts;
+		iosource::IOSource* src = mgr->FindSoonest(&ts);
+
+		if ( src )
+			src->Process();
+		}
+
+	return i;
+	}
+
+int main(int argc, char** argv)
+	{
+	long num_sources = bench::arg(argc, argv, "-s", 500);
+	long n = bench::arg(argc, argv, "-n", 20000000);
+	long writes = bench::arg(argc, argv, "-w", 2000);
+
+	struct rlimit rl;
+	getrlimit(RLIMIT_NOFILE, &rl);
+	rl.rlim_cur = rl.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &rl);
+
+	iosource::Manager mgr;
+	std::vector<PipeSource*> pipes;
+
+	for ( long i = 0; i < num_sources; ++i )
+		{
+		PipeSource* p = new PipeSource();
+		mgr.Register(p, true);
+		pipes.push_back(p);
+		}
+
+	// Some sources aren't fully set up when they register, so the
+	// manager must not ask for their fds right away.
+	if ( PipeSource::fds_asked )
+		{
+		fprintf(stderr, "fds requested during registration\n");
+		return 1;
+		}
+
+	HotSource* hot = new HotSource();
+	mgr.Register(hot);
+
+	// Phase 1: a hot source, with the idle ones waking up now and then.
+	std::thread w(writer, &pipes, writes, 50);
+
+	double t = bench::now();
+	run(&mgr, n, 0);
+	double secs = bench::now() - t;
+	w.join();
+
+	// Pick up whatever's left.
+	run(&mgr, 0, writes);
+
+	bench::report("hot", "FindSoonest", n, secs);
+	printf("%-10s %ld hot items, %ld of %ld writes processed, "
+	       "latency avg %.1f us max %.1f us\n", "hot", hot->processed,
+	       num_processed, writes, sum_latency / num_processed * 1e6,
+	       max_latency * 1e6);
+
+	if ( num_processed != writes )
+		return 1;
+
+	// Phase 2: everybody's idle and waits for the writer.
+	hot->Stop();
+	num_processed = 0;
+	sum_latency = max_latency = 0;
+
+	double cpu = cpu_time();
+	t = bench::now();
+	std::thread w2(writer, &pipes, writes, 1000);
+	long iterations = run(&mgr, 0, writes);
+	w2.join();
+	secs = bench::now() - t;
+	cpu = cpu_time() - cpu;
+
+	bench::report("idle", "FindSoonest", iterations, secs);
+	printf("%-10s %ld of %ld writes processed, latency avg %.1f us "
+	       "max %.1f us, %.0f%% CPU\n", "idle", num_processed, writes,
+	       sum_latency / num_processed * 1e6, max_latency * 1e6,
+	       secs ? cpu / secs * 100 : 0.0);
+
+	if ( num_processed != writes )
+		return 1;
+
+	// Phase 3: like phase 2, but with a source that has to be polled.
+	PolledSource* polled = new PolledSource();
+	mgr.Register(polled, true);
+	num_processed = 0;
+	sum_latency = max_latency = 0;
+
+	cpu = cpu_time();
+	t = bench::now();
+	std::thread w3(writer, &pipes, writes, 1000);
+	iterations = run(&mgr, 0, writes);
+	w3.join();
+	secs = bench::now() - t;
+	cpu = cpu_time() - cpu;
+
+	bench::report("polled", "FindSoonest", iterations, secs);
+	printf("%-10s %ld of %ld writes processed, %ld polls, latency avg "
+	       "%.1f us max %.1f us, %.0f%% CPU\n", "polled", num_processed,
+	       writes, polled->asked, sum_latency / num_processed * 1e6,
+	       max_latency * 1e6, secs ? cpu / secs * 100 : 0.0);
+
+	if ( num_processed != writes || ! polled->asked ||
+	     (secs && cpu / secs > 0.5) )
+		return 1;
+
+	// Phase 4: a new source ends up with the fd numbers of one that
+	// closed its fds without unregistering them.
+	int old_fd = pipes[0]->ReadFd();
+	pipes[0]->Close();
+
+	PipeSource* reused = new PipeSource();
+	mgr.Register(reused, true);
+
+	if ( reused->ReadFd() != old_fd )
+		printf("%-10s fd %d not reused, got %d\n", "reuse", old_fd,
+		       reused->ReadFd());
+
+	num_processed = 0;
+	last_write = bench::now();
+	reused->Write();
+	run(&mgr, 0, 1);
+	printf("%-10s write to reused fd %d processed\n", "reuse",
+	       reused->ReadFd());
+
+	// The manager doesn't delete sources it removes after they close.
+	delete hot;
+
+	return 0;
+	}
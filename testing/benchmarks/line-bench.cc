@@ -0,0 +1,216 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Splits multi-MB HTTP and SMTP streams into lines with the real
+// ContentLine_Analyzer, which copies the spans between terminators found
+// by find_line_special(), and compares it to examining every byte the way
+// DoDeliverOnce() used to.  LineSupport.cc stands in for the rest of
+// libzeek; the analyzer runs without a Connection, with weirds suppressed.
+//
+//     line-bench [-m stream size in MB] [-s segment size]
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "analyzer/protocol/tcp/ContentLine.h"
+#include "analyzer/protocol/tcp/LineScan.h"
+
+#include "Benchmark.h"
+
+extern void (*line_sink)(int len, const u_char* data);
+
+struct LineResult {
+	LineResult() : lines(0), hash(0)	{ }
+
+	void Add(int len, const u_char* data)
+		{
+		++lines;
+		hash = hash * 31 + len;
+
+		if ( len )
+			hash = hash * 31 + data[0] + data[len - 1];
+		}
+
+	long lines;
+	uint64_t hash;
+};
+
+static LineResult analyzer_result;
+
+static void analyzer_sink(int len, const u_char* data)
+	{
+	analyzer_result.Add(len, data);
+	}
+
+// The byte-at-a-time loop DoDeliverOnce() had before, for CRLF, bare CR
+// and LF, and NULs kept in the line.
+class Splitter {
+public:
+	Splitter() : offset(0), last_char(0)
+		{ buf.resize(1024 * 1024); }
+
+	void Deliver(int len, const u_char* data)
+		{
+		while ( len > 0 )
+			{
+			if ( last_char == '\r' && *data == '\n' )
+				{
+				last_char = *data;
+				--len; ++data;
+				continue;
+				}
+
+			int n = DeliverOnce(len, data);
+			len -= n;
+			data += n;
+			}
+		}
+
+	LineResult result;
+
+private:
+	int DeliverOnce(int len, const u_char* data)
+		{
+		const u_char* data_start = data;
+
+		for ( ; len > 0; --len, ++data )
+			{
+			int c = data[0];
+
+			switch ( c ) {
+			case '\r':
+				if ( len > 1 && data[1] == '\n' )
+					{
+					--len; ++data;
+					c = data[0];
+					}
+
+				last_char = c;
+				Emit();
+				return data + 1 - data_start;
+
+			case '\n':
+				last_char = c;
+				Emit();
+				return data + 1 - data_start;
+
+			default:
+				buf[offset++] = c;
+				last_char = c;
+				break;
+			}
+			}
+
+		return data - data_start;
+		}
+
+	void Emit()
+		{
+		result.Add(offset, &buf[0]);
+		offset = 0;
+		}
+
+	std::vector<u_char> buf;
+	int offset;
+	int last_char;
+};
+
+static std::string http_stream(size_t size, bench::Random& rnd)
+	{
+	std::string s;
+
+	while ( s.size() < size )
+		{
+		s += "GET /images/banner-";
+		s += std::to_string(rnd.Next() % 100000);
+		s += ".png HTTP/1.1\r\n"
+		     "Host: www.example.com\r\n"
+		     "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:68.0) Gecko/20100101 Firefox/68.0\r\n"
+		     "Accept: image/webp,*/*\r\n"
+		     "Accept-Language: en-US,en;q=0.5\r\n"
+		     "Accept-Encoding: gzip, deflate, br\r\n"
+		     "Referer: https://www.example.com/news/2019/06/index.html\r\n"
+		     "Cookie: session=";
+
+		for ( int i = 0; i < 40; ++i )
+			s += "0123456789abcdef"[rnd.Next() % 16];
+
+		s += "; theme=dark\r\n"
+		     "Connection: keep-alive\r\n"
+		     "\r\n";
+		}
+
+	return s;
+	}
+
+static std::string smtp_stream(size_t size, bench::Random& rnd)
+	{
+	std::string s = "DATA\r\n";
+
+	while ( s.size() < size )
+		{
+		// Base64 body lines, as in an attachment.
+		for ( int i = 0; i < 76; ++i )
+			s += "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/"[rnd.Next() % 64];
+
+		s += "\r\n";
+		}
+
+	return s + ".\r\n";
+	}
+
+static void run(const char* what, const std::string& stream, long seg_size)
+	{
+	const u_char* data = (const u_char*) stream.data();
+	long len = stream.size();
+
+	char label[64];
+	snprintf(label, sizeof(label), "%s/%zuMB", what, stream.size() >> 20);
+
+	Splitter sp;
+	double start = bench::now();
+
+	for ( long i = 0; i < len; i += seg_size )
+		sp.Deliver(std::min(seg_size, len - i), data + i);
+
+	double secs = bench::now() - start;
+	bench::report("bytewise", label, sp.result.lines, secs);
+
+	analyzer::tcp::ContentLine_Analyzer cl(0, true);
+	cl.SupressWeirds(true);
+
+	// DeliverStream() is protected in ContentLine_Analyzer.
+	analyzer::Analyzer* a = &cl;
+
+	analyzer_result = LineResult();
+	line_sink = analyzer_sink;
+	start = bench::now();
+
+	for ( long i = 0; i < len; i += seg_size )
+		a->DeliverStream(std::min(seg_size, len - i), data + i, true);
+
+	secs = bench::now() - start;
+	bench::report(analyzer::tcp::line_scan_impl(), label,
+	              analyzer_result.lines, secs);
+
+	if ( sp.result.lines != analyzer_result.lines ||
+	     sp.result.hash != analyzer_result.hash )
+		{
+		fprintf(stderr, "%s: results differ (%ld vs %ld lines)\n", what,
+		        sp.result.lines, analyzer_result.lines);
+		exit(1);
+		}
+	}
+
+int main(int argc, char** argv)
+	{
+	long mb = bench::arg(argc, argv, "-m", 16);
+	long seg_size = bench::arg(argc, argv, "-s", 1460);
+
+	bench::Random rnd;
+
+	run("http", http_stream(mb << 20, rnd), seg_size);
+	run("smtp", smtp_stream(mb << 20, rnd), seg_size);
+
+	return 0;
+	}
@@ -0,0 +1,208 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Compares the lock-free threading::Queue against the mutex-based queue it
+// replaced, used the way MsgThread uses them with many log streams.  In
+// the "in" direction, the main thread feeds one queue per thread, each
+// drained by its thread; in the "out" direction, every thread writes to
+// its own queue and the main thread polls all of them, like the threading
+// manager does.  Each direction runs twice: flat out to measure messages
+// per second, and then at a fixed total rate to measure latency.
+//
+//     queue-bench [-s streams] [-n messages per stream] [-r paced msgs/sec]
+
+#include "zeek-config.h"
+
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "threading/Queue.h"
+
+#include "Benchmark.h"
+#include "MutexQueue.h"
+
+struct Message {
+	double sent;
+};
+
+template<typename Q>
+struct Stream {
+	Stream(long n) : queue(0, 0), msgs(n)	{ latencies.reserve(n); }
+
+	Q queue;
+	std::vector<Message> msgs;
+	std::vector<double> latencies;
+};
+
+template<typename Q>
+using StreamList = std::vector<std::unique_ptr<Stream<Q>>>;
+
+// Busy-waits until "t", as sleeping is far too coarse for this.
+static void wait_until(double t)
+	{
+	while ( bench::now() < t )
+		;
+	}
+
+static void send(Message* m)
+	{
+	m->sent = bench::now();
+	}
+
+static void received(std::vector<double>* latencies, Message* m)
+	{
+	latencies->push_back(bench::now() - m->sent);
+	}
+
+// Drains one queue from its own thread, blocking when it's empty.
+template<typename Q>
+static void drain(Stream<Q>* s, long n)
+	{
+	for ( long got = 0; got < n; )
+		{
+		Message* m = s->queue.Get();
+
+		if ( ! m )
+			continue;
+
+		received(&s->latencies, m);
+		++got;
+		}
+	}
+
+// Feeds one queue from its own thread, spacing messages by "gap" seconds.
+template<typename Q>
+static void feed(Stream<Q>* s, long n, double gap)
+	{
+	double t = bench::now();
+
+	for ( long i = 0; i < n; ++i )
+		{
+		if ( gap )
+			wait_until(t + i * gap);
+
+		Message* m = &s->msgs[i];
+		send(m);
+		s->queue.Put(m);
+		}
+	}
+
+template<typename Q>
+static double run_in(StreamList<Q>& streams, long n, double gap)
+	{
+	std::vector<std::thread> threads;
+
+	for ( auto& s : streams )
+		threads.emplace_back(drain<Q>, s.get(), n);
+
+	double t = bench::now();
+	long k = 0;
+
+	for ( long i = 0; i < n; ++i )
+		for ( auto& s : streams )
+			{
+			if ( gap )
+				wait_until(t + k++ * gap);
+
+			Message* m = &s->msgs[i];
+			send(m);
+			s->queue.Put(m);
+			}
+
+	for ( auto& th : threads )
+		th.join();
+
+	return bench::now() - t;
+	}
+
+template<typename Q>
+static double run_out(StreamList<Q>& streams, long n, double gap)
+	{
+	std::vector<std::thread> threads;
+	double t = bench::now();
+
+	for ( auto& s : streams )
+		threads.emplace_back(feed<Q>, s.get(), n, gap * streams.size());
+
+	for ( long left = n * streams.size(); left; )
+		for ( auto& s : streams )
+			{
+			if ( ! s->queue.MaybeReady() )
+				continue;
+
+			while ( s->queue.Ready() )
+				{
+				received(&s->latencies, s->queue.Get());
+				--left;
+				}
+			}
+
+	double secs = bench::now() - t;
+
+	for ( auto& th : threads )
+		th.join();
+
+	return secs;
+	}
+
+template<typename Q>
+static void print_latencies(const char* impl, StreamList<Q>& streams)
+	{
+	std::vector<double> all;
+
+	for ( auto& s : streams )
+		all.insert(all.end(), s->latencies.begin(), s->latencies.end());
+
+	std::sort(all.begin(), all.end());
+
+	auto pct = [&all](double p) { return all[size_t(p * (all.size() - 1))] * 1e6; };
+
+	printf("%-10s latency p50 %.1f us p99 %.1f us p99.9 %.1f us max %.1f us\n",
+	       impl, pct(0.5), pct(0.99), pct(0.999), all.back() * 1e6);
+	}
+
+template<typename Q>
+static void run(const char* impl, const char* what, long num_streams, long n,
+		long rate, bool in)
+	{
+	for ( int paced = 0; paced < 2; ++paced )
+		{
+		// Paced runs last about two seconds.
+		long m = paced ? std::max(1L, rate * 2 / num_streams) : n;
+		double gap = paced ? 1.0 / rate : 0;
+
+		StreamList<Q> streams;
+
+		for ( long i = 0; i < num_streams; ++i )
+			streams.emplace_back(new Stream<Q>(m));
+
+		double secs = in ? run_in(streams, m, gap) : run_out(streams, m, gap);
+		long total = m * num_streams;
+
+		if ( paced )
+			print_latencies(impl, streams);
+		else
+			{
+			bench::report(impl, what, total, secs);
+			printf("%-10s %.0f msgs/sec\n", impl, total / secs);
+			}
+		}
+	}
+
+int main(int argc, char** argv)
+	{
+	long streams = bench::arg(argc, argv, "-s", 64);
+	long n = bench::arg(argc, argv, "-n", 100000);
+	long rate = bench::arg(argc, argv, "-r", 200000);
+
+	typedef threading::MutexQueue<Message*> OldQueue;
+	typedef threading::Queue<Message*> NewQueue;
+
+	run<OldQueue>("mutex", "main -> threads", streams, n, rate, true);
+	run<NewQueue>("lock-free", "main -> threads", streams, n, rate, true);
+	run<OldQueue>("mutex", "threads -> main", streams, n, rate, false);
+	run<NewQueue>("lock-free", "threads -> main", streams, n, rate, false);
+
+	return 0;
+	}
@@ -0,0 +1,107 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Feeds a Reassembler segments in orders that used to cost time linear in
+// the number of buffered blocks per segment: in order after an initial
+// hole, in reverse, and shuffled. Runs each for growing numbers of
+// segments; the per-segment cost should stay roughly flat.
+//
+//     reassem-bench [-n max segments] [-s segment size]
+
+#include "zeek-config.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "Reassem.h"
+
+#include "Benchmark.h"
+
+// Delivers in-order data the way TCP_Reassembler does, minus the
+// analyzers.
+class BenchReassembler : public Reassembler {
+public:
+	BenchReassembler() : Reassembler(0, REASSEM_TCP), delivered(0)	{ }
+
+	uint64 delivered;
+
+protected:
+	void BlockInserted(DataBlock* start_block) override
+		{
+		if ( start_block->seq > last_reassem_seq ||
+		     start_block->upper <= last_reassem_seq )
+			return;
+
+		for ( DataBlock* b = start_block;
+		      b && b->seq <= last_reassem_seq; b = b->next )
+			{
+			if ( b->seq == last_reassem_seq )
+				{
+				delivered += b->Size();
+				last_reassem_seq += b->Size();
+				}
+			}
+
+		TrimToSeq(last_reassem_seq);
+		}
+
+	void Overlap(const u_char* b1, const u_char* b2, uint64 n) override
+		{
+		}
+};
+
+static void run(const char* what, const std::vector<uint64>& order,
+		long seg_size, const u_char* payload)
+	{
+	BenchReassembler r;
+
+	double start = bench::now();
+
+	for ( uint64 i : order )
+		r.NewBlock(0, i * seg_size, seg_size, payload);
+
+	double secs = bench::now() - start;
+
+	if ( r.delivered != order.size() * seg_size )
+		{
+		fprintf(stderr, "%s: delivered %llu bytes, expected %llu\n", what,
+		        (unsigned long long) r.delivered,
+		        (unsigned long long) (order.size() * seg_size));
+		exit(1);
+		}
+
+	char label[64];
+	snprintf(label, sizeof(label), "%s/%zu", what, order.size());
+	bench::report("reassem", label, order.size(), secs);
+	}
+
+int main(int argc, char** argv)
+	{
+	long max_n = bench::arg(argc, argv, "-n", 100000);
+	long seg_size = bench::arg(argc, argv, "-s", 1460);
+
+	std::vector<u_char> payload(seg_size, 'x');
+	bench::Random rnd;
+
+	for ( long n = 1000; n <= max_n; n *= 10 )
+		{
+		std::vector<uint64> order;
+
+		// First segment last, so everything else queues up behind
+		// the hole.
+		for ( long i = 1; i < n; ++i )
+			order.push_back(i);
+		order.push_back(0);
+		run("hole-first", order, seg_size, payload.data());
+
+		std::reverse(order.begin(), order.end() - 1);
+		std::rotate(order.begin(), order.end() - 1, order.end());
+		std::reverse(order.begin(), order.end());
+		run("reverse", order, seg_size, payload.data());
+
+		for ( long i = n - 1; i > 0; --i )
+			std::swap(order[i], order[rnd.Next() % (i + 1)]);
+		run("shuffled", order, seg_size, payload.data());
+		}
+
+	return 0;
+	}
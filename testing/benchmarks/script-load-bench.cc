@@ -0,0 +1,194 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Measures what resolving @load's costs at startup, by walking the @load
+// graph of the scripts that come with Zeek the way the scanner does:
+// init-bare, init-default and then test-all-policy, as a stand-in for a
+// large site policy.  Scripts are read but not parsed, and @if's are
+// ignored, so everything reachable gets loaded.  This compares the
+// scanner's lookups before and after memoizing them:
+//
+//   plain      every @load resolves its script twice (once in the @load
+//              rule, once in load_files()), and already_scanned() walks
+//              the list of scanned files;
+//   memoized   resolutions are cached per search path and name, and
+//              already_scanned() checks a hash set of inode numbers.
+//
+//     script-load-bench [-r rounds] [-d scripts-dir]
+
+#include "zeek-config.h"
+
+#include <sys/stat.h>
+
+#include <fstream>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "util.h"
+
+#include "Benchmark.h"
+
+using std::string;
+
+class Loader {
+public:
+	Loader(bool arg_memoize, const string& arg_zeekpath)
+		: memoize(arg_memoize), zeekpath(arg_zeekpath),
+		  num_loads(0), num_scripts(0), num_missing(0)	{ }
+
+	void Load(const string& name, const string& current);
+
+	long num_loads;
+	long num_scripts;
+	long num_missing;	// generated ones (bifs), which aren't there
+
+private:
+	string Resolve(const string& name, const string& current);
+	bool AlreadyScanned(ino_t i);
+
+	bool memoize;
+	string zeekpath;
+
+	std::unordered_map<string, string> resolved;
+	std::list<ino_t> scanned_list;
+	std::unordered_set<ino_t> scanned_set;
+};
+
+string Loader::Resolve(const string& name, const string& current)
+	{
+	// As find_relative_script_file() does.
+	string path_set = name[0] == '.' ?
+		SafeDirname(current).result : zeekpath;
+
+	if ( ! memoize )
+		return find_script_file(name, path_set);
+
+	string key = path_set + '\0' + name;
+	auto it = resolved.find(key);
+
+	if ( it != resolved.end() )
+		return it->second;
+
+	string path = find_script_file(name, path_set);
+	resolved.emplace(std::move(key), path);
+	return path;
+	}
+
+bool Loader::AlreadyScanned(ino_t i)
+	{
+	if ( memoize )
+		{
+		if ( ! scanned_set.insert(i).second )
+			return true;
+		}
+	else
+		{
+		for ( auto j : scanned_list )
+			if ( j == i )
+				return true;
+
+		scanned_list.push_back(i);
+		}
+
+	return false;
+	}
+
+void Loader::Load(const string& name, const string& current)
+	{
+	++num_loads;
+
+	// The @load rule resolves the name for Zeekygen, and load_files()
+	// resolves it again.
+	(void) Resolve(name, current);
+	string path = Resolve(name, current);
+
+	if ( path.empty() )
+		{
+		++num_missing;
+		return;
+		}
+
+	if ( is_dir(path) )
+		path += "/__load__.zeek";
+
+	struct stat st;
+
+	if ( stat(path.c_str(), &st) < 0 || AlreadyScanned(st.st_ino) )
+		return;
+
+	++num_scripts;
+
+	std::ifstream in(path);
+	string line;
+
+	while ( std::getline(in, line) )
+		{
+		size_t p = line.find_first_not_of(" \t");
+
+		if ( p == string::npos || line.compare(p, 5, "@load") != 0 )
+			continue;
+
+		p += 5;
+
+		// Skips @load-sigs and @load-plugin.
+		if ( p >= line.size() || (line[p] != ' ' && line[p] != '\t') )
+			continue;
+
+		p = line.find_first_not_of(" \t", p);
+
+		if ( p == string::npos )
+			continue;
+
+		size_t e = line.find_first_of(" \t#", p);
+		Load(line.substr(p, e == string::npos ? e : e - p), path);
+		}
+	}
+
+static void walk(const char* impl, bool memoize, const string& scripts,
+		 long rounds)
+	{
+	string zeekpath = ".:" + scripts + ":" + scripts + "/policy:" +
+			  scripts + "/site";
+
+	long num_loads = 0;
+	double t = bench::now();
+
+	for ( long r = 0; r < rounds; ++r )
+		{
+		Loader loader(memoize, zeekpath);
+
+		loader.Load("base/init-bare", "");
+		loader.Load("base/init-default", "");
+		loader.Load("test-all-policy", "");
+
+		num_loads += loader.num_loads;
+
+		if ( r == 0 )
+			printf("%-10s %ld @load's, %ld scripts, %ld not found\n",
+			       impl, loader.num_loads, loader.num_scripts,
+			       loader.num_missing);
+		}
+
+	double secs = bench::now() - t;
+	bench::report(impl, "@load", num_loads, secs);
+	bench::report(impl, "startup", rounds, secs);
+	}
+
+int main(int argc, char** argv)
+	{
+	long rounds = bench::arg(argc, argv, "-r", 20);
+	string scripts = "../../scripts";
+
+	for ( int i = 1; i + 1 < argc; ++i )
+		if ( ! strcmp(argv[i], "-d") )
+			scripts = argv[i + 1];
+
+	// Warm up the file system caches for both.
+	walk("warmup", true, scripts, 1);
+
+	walk("plain", false, scripts, rounds);
+	walk("memoized", true, scripts, rounds);
+
+	return 0;
+	}
@@ -0,0 +1,207 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Compares the timing-wheel TimerMgr against PQ_TimerMgr by replaying the
+// timer traffic that connection tracking generates: every packet advances
+// the clock, new connections schedule attempt and inactivity timers, and
+// closing connections cancel theirs and schedule a deletion.
+//
+//     timer-bench [-n packets] [-p packets/sec] [-c packets per new conn]
+
+#include "zeek-config.h"
+
+#include <vector>
+
+#include "Timer.h"
+
+#include "Benchmark.h"
+
+// Defaults that matter here, as in init-bare.zeek.
+static const double tcp_attempt_delay = 5.0;
+static const double tcp_close_delay = 5.0;
+static const double tcp_inactivity_timeout = 300.0;
+static const double udp_inactivity_timeout = 60.0;
+static const int max_timer_expires = 300;
+
+struct Conn {
+	bool tcp;
+	double last_time;
+	int index;	// in the active list, or -1 once closed
+	Timer* attempt;
+	Timer* inactivity;
+};
+
+static std::vector<Conn*> active;
+static long num_dispatched;
+
+static void deactivate(Conn* c)
+	{
+	Conn* back = active.back();
+	back->index = c->index;
+	active[c->index] = back;
+	active.pop_back();
+	c->index = -1;
+	}
+
+class AttemptTimer : public Timer {
+public:
+	AttemptTimer(double t, Conn* arg_c)
+		: Timer(t, TIMER_TCP_ATTEMPT), c(arg_c)	{ }
+
+	void Dispatch(double t, int is_expire) override
+		{
+		++num_dispatched;
+		c->attempt = 0;
+		}
+
+private:
+	Conn* c;
+};
+
+class DeleteTimer : public Timer {
+public:
+	DeleteTimer(double t, Conn* arg_c)
+		: Timer(t, TIMER_TCP_DELETE), c(arg_c)	{ }
+
+	void Dispatch(double t, int is_expire) override
+		{
+		++num_dispatched;
+		delete c;
+		}
+
+private:
+	Conn* c;
+};
+
+class InactivityTimer : public Timer {
+public:
+	InactivityTimer(double t, Conn* arg_c)
+		: Timer(t, TIMER_CONN_INACTIVITY), c(arg_c)	{ }
+
+	void Dispatch(double t, int is_expire) override
+		{
+		++num_dispatched;
+		c->inactivity = 0;
+
+		double timeout = c->tcp ? tcp_inactivity_timeout :
+					  udp_inactivity_timeout;
+
+		if ( ! is_expire && c->last_time + timeout > t )
+			{
+			// Saw activity since; check again later, the same
+			// way Connection::InactivityTimer() does.
+			c->inactivity = new InactivityTimer(c->last_time + timeout, c);
+			timer_mgr->Add(c->inactivity);
+			return;
+			}
+
+		if ( c->attempt )
+			timer_mgr->Cancel(c->attempt);
+
+		deactivate(c);
+		delete c;
+		}
+
+private:
+	Conn* c;
+};
+
+template<typename M>
+static void replay(const char* impl, long n, long pps, long per_conn)
+	{
+	M mgr("<BENCH>");
+	timer_mgr = &mgr;
+
+	bench::Random rnd(1);
+	active.clear();
+	num_dispatched = 0;
+
+	double start = 1500000000.0;
+	double t = bench::now();
+
+	for ( long i = 0; i < n; ++i )
+		{
+		double now = start + double(i) / pps;
+		uint64_t r = rnd.Next();
+
+		if ( r % per_conn == 0 || active.empty() )
+			{
+			Conn* c = new Conn;
+			c->tcp = (r >> 8) % 10 < 7;
+			c->last_time = now;
+			c->index = active.size();
+			c->attempt = 0;
+
+			if ( c->tcp )
+				{
+				c->attempt = new AttemptTimer(now + tcp_attempt_delay, c);
+				mgr.Add(c->attempt);
+				}
+
+			double timeout = c->tcp ? tcp_inactivity_timeout :
+						  udp_inactivity_timeout;
+			c->inactivity = new InactivityTimer(now + timeout, c);
+			mgr.Add(c->inactivity);
+
+			active.push_back(c);
+			}
+
+		else
+			{
+			Conn* c = active[(r >> 8) % active.size()];
+			c->last_time = now;
+
+			// Once the handshake completes, the attempt timer goes.
+			if ( c->attempt && (r >> 40) % 4 == 0 )
+				{
+				mgr.Cancel(c->attempt);
+				c->attempt = 0;
+				}
+
+			// An orderly close cancels everything and leaves the
+			// connection around for a bit.
+			else if ( c->tcp && (r >> 48) % 16 == 0 )
+				{
+				if ( c->attempt )
+					mgr.Cancel(c->attempt);
+				if ( c->inactivity )
+					mgr.Cancel(c->inactivity);
+
+				c->attempt = c->inactivity = 0;
+				deactivate(c);
+				mgr.Add(new DeleteTimer(now + tcp_close_delay, c));
+				}
+			}
+
+		mgr.Advance(now, max_timer_expires);
+		}
+
+	double secs = bench::now() - t;
+	bench::report(impl, "replay (per packet)", n, secs);
+	bench::report(impl, "replay (per timer)", mgr.CumulativeNum(), secs);
+
+	printf("%-10s %ld timers dispatched, %d pending, peak %d\n",
+	       impl, num_dispatched, mgr.Size(), mgr.PeakSize());
+
+	t = bench::now();
+	long pending = mgr.Size();
+	mgr.Expire();
+	bench::report(impl, "expire all", pending, bench::now() - t);
+
+	timer_mgr = 0;
+	}
+
+int main(int argc, char** argv)
+	{
+	long n = bench::arg(argc, argv, "-n", 20000000);
+	long pps = bench::arg(argc, argv, "-p", 200000);
+	long per_conn = bench::arg(argc, argv, "-c", 20);
+	long rounds = bench::arg(argc, argv, "-r", 1);
+
+	for ( long r = 0; r < rounds; ++r )
+		{
+		replay<PQ_TimerMgr>("pq", n, pps, per_conn);
+		replay<TW_TimerMgr>("wheel", n, pps, per_conn);
+		}
+
+	return 0;
+	}
@@ -0,0 +1,177 @@
+// See the file "COPYING" in the main distribution directory for copyright.
+//
+// Checks that the timing-wheel TimerMgr dispatches exactly like
+// PQ_TimerMgr.  Both get the same randomized stream of adds, cancels and
+// clock advances, with timers in the past, within a tick, across every
+// wheel level and beyond the overflow horizon, and some timers adding
+// further ones when they fire.  Timer times are distinct, so the two
+// dispatch logs have to match line by line.
+//
+//     timer-equiv [-n operations] [-s seeds]
+
+#include "zeek-config.h"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "Timer.h"
+
+#include "Benchmark.h"
+
+static std::vector<std::string> dispatch_log;
+static std::map<long, Timer*> pending;
+static std::set<double> used_times;
+static long next_id;
+
+static double unique_time(double t)
+	{
+	while ( ! used_times.insert(t).second )
+		t += 1e-6;
+
+	return t;
+	}
+
+class EquivTimer : public Timer {
+public:
+	EquivTimer(double t, long arg_id)
+		: Timer(t, TIMER_SCHEDULE), id(arg_id)	{ }
+
+	void Dispatch(double t, int is_expire) override;
+
+private:
+	long id;
+};
+
+static void add_timer(double t)
+	{
+	long id = next_id++;
+	Timer* timer = new EquivTimer(unique_time(t), id);
+	pending[id] = timer;
+	timer_mgr->Add(timer);
+	}
+
+void EquivTimer::Dispatch(double t, int is_expire)
+	{
+	char buf[128];
+	snprintf(buf, sizeof(buf), "%ld %.6f %.6f %d",
+		 id, Time(), t, is_expire);
+	dispatch_log.push_back(buf);
+	pending.erase(id);
+
+	// Some re-arm themselves, possibly so soon that they fire again
+	// during the same advance.
+	if ( ! is_expire && id % 5 == 0 )
+		add_timer(Time() + (id % 3) * 0.0004);
+	}
+
+static double random_delay(bench::Random& rnd)
+	{
+	uint64_t r = rnd.Next();
+	double frac = double(r >> 11) / double(uint64_t(1) << 53);
+
+	switch ( r % 6 ) {
+	case 0:	return -frac;			// already due
+	case 1:	return frac * 0.001;		// within a tick
+	case 2:	return frac * 10;
+	case 3:	return frac * 3600;
+	case 4:	return frac * 86400 * 7;
+	default:	return frac * 86400 * 200;	// past the wheels
+	}
+	}
+
+template<typename M>
+static std::vector<std::string> replay(uint64_t seed, long n)
+	{
+	M mgr("<EQUIV>");
+	timer_mgr = &mgr;
+
+	bench::Random rnd(seed);
+	dispatch_log.clear();
+	pending.clear();
+	used_times.clear();
+	next_id = 0;
+
+	double now = 1500000000.0;
+	mgr.Advance(now, 0);
+
+	static const int max_expires[] = { 0, 1, 3, 300 };
+
+	for ( long i = 0; i < n; ++i )
+		{
+		uint64_t r = rnd.Next();
+
+		switch ( r % 8 ) {
+		case 0:
+		case 1:
+		case 2:
+			add_timer(mgr.Time() + random_delay(rnd));
+			break;
+
+		case 3:
+			if ( ! pending.empty() )
+				{
+				auto it = pending.begin();
+				std::advance(it, (r >> 8) % pending.size());
+				Timer* timer = it->second;
+				pending.erase(it);
+				mgr.Cancel(timer);
+				}
+			break;
+
+		case 4:
+			// Now and then, a long gap in the traffic.
+			now += ((r >> 8) % 64 == 0) ?
+				double((r >> 16) % (86400 * 60)) :
+				double((r >> 16) % 2000) / 1000;
+			// Fall through.
+
+		default:
+			{
+			int max_expire = max_expires[(r >> 40) % 4];
+			int num = mgr.Advance(now, max_expire);
+
+			char buf[64];
+			snprintf(buf, sizeof(buf), "advance %.6f %d %d",
+				 now, num, mgr.Size());
+			dispatch_log.push_back(buf);
+			break;
+			}
+		}
+		}
+
+	dispatch_log.push_back("expire");
+	mgr.Expire();
+
+	timer_mgr = 0;
+	return dispatch_log;
+	}
+
+int main(int argc, char** argv)
+	{
+	long n = bench::arg(argc, argv, "-n", 200000);
+	long seeds = bench::arg(argc, argv, "-s", 10);
+
+	for ( long s = 1; s <= seeds; ++s )
+		{
+		auto pq = replay<PQ_TimerMgr>(s, n);
+		auto wheel = replay<TW_TimerMgr>(s, n);
+
+		size_t i = 0;
+		while ( i < pq.size() && i < wheel.size() && pq[i] == wheel[i] )
+			++i;
+
+		if ( i < pq.size() || i < wheel.size() )
+			{
+			printf("seed %ld: logs differ at line %zu\n", s, i);
+			printf("  pq:    %s\n", i < pq.size() ? pq[i].c_str() : "<end>");
+			printf("  wheel: %s\n", i < wheel.size() ? wheel[i].c_str() : "<end>");
+			return 1;
+			}
+
+		printf("seed %ld: %zu log lines match\n", s, pq.size());
+		}
+
+	return 0;
+	}